@@ -0,0 +1,7 @@
+#define USE_FOO
+#include "conditional_header.h"
+
+void baz()
+{
+	foo();
+}
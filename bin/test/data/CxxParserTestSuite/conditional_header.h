@@ -0,0 +1,5 @@
+#ifdef USE_FOO
+void foo();
+#else
+void bar();
+#endif
@@ -0,0 +1,6 @@
+#include "conditional_header.h"
+
+void baz()
+{
+	bar();
+}
@@ -13,13 +13,23 @@
 #include "SourceLocationCollection.h"
 #include "SourceLocationFile.h"
 #include "StorageAccess.h"
+#include "TabId.h"
+#include "TaskLambda.h"
 #include "TextAccess.h"
 #include "logging.h"
 #include "tracing.h"
 #include "utility.h"
 #include "utilityString.h"
 
-CodeController::CodeController(StorageAccess* storageAccess): m_storageAccess(storageAccess) {}
+CodeController::CodeController(StorageAccess* storageAccess)
+	: m_storageAccess(storageAccess), m_fullTextSearchId(std::make_shared<std::atomic<Id>>(0))
+{
+}
+
+CodeController::~CodeController()
+{
+	cancelFullTextSearch();
+}
 
 Id CodeController::getSchedulerId() const
 {
@@ -44,6 +54,7 @@ void CodeController::handleMessage(MessageActivateErrors* message)
 		errors = m_storageAccess->getErrorsForFileLimited(message->filter, message->file);
 	}
 
+	cancelFullTextSearch();
 	m_collection = m_storageAccess->getErrorSourceLocations(errors);
 
 	m_files = getFilesForCollection(m_collection);
@@ -64,18 +75,76 @@ void CodeController::handleMessage(MessageActivateFullTextSearch* message)
 	TRACE("code fulltext");
 
 	saveOrRestoreViewMode(message);
+	cancelFullTextSearch();
 
-	m_collection = m_storageAccess->getFullTextSearchLocations(
-		message->searchTerm, message->caseSensitive);
+	m_collection = std::make_shared<SourceLocationCollection>();
+	m_files.clear();
+	clearReferences();
 
-	CodeView::CodeParams params;
-	params.clearSnippets = true;
-	params.useSingleFileCache = false;
+	const size_t maxResultCount = static_cast<size_t>(
+		std::max(ApplicationSettings::getInstance()->getCodeFullTextSearchMaxResultCount(), 0));
 
-	m_files = getFilesForCollection(m_collection);
-	createReferences();
-	expandVisibleFiles(params.useSingleFileCache);
-	showFiles(params, firstReferenceScrollParams(), !message->isReplayed());
+	if (message->isReplayed())
+	{
+		// replayed history is shown on flush, so the results are collected right away
+		m_storageAccess->searchFullTextLocations(
+			message->searchTerm,
+			message->caseSensitive,
+			maxResultCount,
+			[this](std::shared_ptr<SourceLocationCollection> batch) {
+				m_collection->addSourceLocationCopies(batch.get());
+				return true;
+			});
+
+		CodeView::CodeParams params;
+		params.clearSnippets = true;
+		params.useSingleFileCache = false;
+
+		m_files = getFilesForCollection(m_collection);
+		createReferences();
+		expandVisibleFiles(params.useSingleFileCache);
+		showFiles(params, firstReferenceScrollParams(), false);
+		return;
+	}
+
+	// the search runs in the background and passes its results on in batches, so the first ones
+	// show up without waiting for all files
+	const Id searchId = ++(*m_fullTextSearchId);
+	Task::dispatch(
+		TabId::background(),
+		std::make_shared<TaskLambda>([storageAccess = m_storageAccess,
+									  currentSearchId = m_fullTextSearchId,
+									  searchId,
+									  schedulerId = getSchedulerId(),
+									  searchTerm = message->searchTerm,
+									  caseSensitive = message->caseSensitive,
+									  maxResultCount]() {
+			if (*currentSearchId != searchId)
+			{
+				return;
+			}
+
+			const bool completed = storageAccess->searchFullTextLocations(
+				searchTerm,
+				caseSensitive,
+				maxResultCount,
+				[&](std::shared_ptr<SourceLocationCollection> batch) {
+					if (*currentSearchId != searchId)
+					{
+						return false;
+					}
+
+					MessageFullTextSearchResults(searchId, batch, false, schedulerId).dispatch();
+					return true;
+				});
+
+			if (completed)
+			{
+				MessageFullTextSearchResults(
+					searchId, std::make_shared<SourceLocationCollection>(), true, schedulerId)
+					.dispatch();
+			}
+		}));
 }
 
 void CodeController::handleMessage(MessageActivateLegend* message)
@@ -186,6 +255,7 @@ void CodeController::handleMessage(MessageActivateTokens* message)
 	TRACE("code activate");
 
 	saveOrRestoreViewMode(message);
+	cancelFullTextSearch();
 
 	CodeView* view = getView();
 	if (!message->tokenIds.size())
@@ -269,6 +339,7 @@ void CodeController::handleMessage(MessageActivateTrailEdge* message)
 
 	m_codeParams.activeTokenIds = message->edgeIds;
 
+	cancelFullTextSearch();
 	m_collection = m_storageAccess->getSourceLocationsForTokenIds(m_codeParams.activeTokenIds);
 
 	m_files = getFilesForActiveSourceLocations(m_collection.get(), 0);
@@ -454,6 +525,62 @@ void CodeController::handleMessage(MessageFocusOut* message)
 	getView()->deCoFocusTokenIds();
 }
 
+void CodeController::handleMessage(MessageFullTextSearchResults* message)
+{
+	TRACE("code fulltext results");
+
+	if (message->searchId != *m_fullTextSearchId)
+	{
+		return;
+	}
+
+	const size_t fileCountBefore = m_files.size();
+
+	message->collection->forEachSourceLocationFile(
+		[this](std::shared_ptr<SourceLocationFile> file) {
+			m_collection->addSourceLocationFile(file);
+
+			CodeFileParams params;
+			params.locationFile = file;
+			m_files.push_back(params);
+		});
+
+	if (m_files.empty())
+	{
+		if (message->isLastBatch)
+		{
+			CodeView::CodeParams params;
+			params.clearSnippets = true;
+			params.useSingleFileCache = false;
+			showFiles(params, CodeScrollParams(), true);
+		}
+		return;
+	}
+
+	if (!message->collection->getSourceLocationFileCount())
+	{
+		return;
+	}
+
+	// files of later batches get appended, so the current reference stays valid
+	const int referenceIndex = m_referenceIndex;
+	createReferences();
+	expandVisibleFiles(false, fileCountBefore);
+
+	if (!fileCountBefore)
+	{
+		CodeView::CodeParams params;
+		params.clearSnippets = true;
+		params.useSingleFileCache = false;
+		showFiles(params, firstReferenceScrollParams(), true);
+	}
+	else
+	{
+		m_referenceIndex = referenceIndex;
+		showFiles(m_codeParams, CodeScrollParams(), true);
+	}
+}
+
 void CodeController::handleMessage(MessageScrollToLine* message)
 {
 	getView()->scrollTo(
@@ -655,6 +782,7 @@ CodeView* CodeController::getView() const
 
 void CodeController::clear()
 {
+	cancelFullTextSearch();
 	getView()->clear();
 
 	m_collection = std::make_shared<SourceLocationCollection>();
@@ -765,9 +893,9 @@ std::vector<CodeSnippetParams> CodeController::getSnippetsForFile(
 			LOCATION_ERROR;
 	}
 
-	std::shared_ptr<TextAccess> textAccess = m_storageAccess->getFileContent(
+	// only the lines of the snippets are read, so files do not need to be loaded as a whole
+	const size_t lineCount = m_storageAccess->getFileContentLineCount(
 		activeSourceLocations->getFilePath(), showsErrors);
-	size_t lineCount = textAccess->getLineCount();
 
 	SnippetMerger fileScopedMerger(1, static_cast<int>(lineCount));
 	std::map<int, std::shared_ptr<SnippetMerger>> mergers;
@@ -841,9 +969,11 @@ std::vector<CodeSnippetParams> CodeController::getSnippetsForFile(
 			params.footer = activeSourceLocations->getFilePath().wstr();
 		}
 
-		for (const std::string& line: textAccess->getLines(
-				 static_cast<unsigned int>(params.startLineNumber),
-				 static_cast<unsigned int>(params.endLineNumber)))
+		for (const std::string& line: m_storageAccess->getFileContentLines(
+				 activeSourceLocations->getFilePath(),
+				 params.startLineNumber,
+				 params.endLineNumber,
+				 showsErrors))
 		{
 			params.code += line;
 		}
@@ -1255,7 +1385,7 @@ std::pair<int, int> CodeController::findClosestReferenceIndex(
 	return {referenceIndex, fileIndex};
 }
 
-void CodeController::expandVisibleFiles(bool useSingleFileCache)
+void CodeController::expandVisibleFiles(bool useSingleFileCache, size_t firstFileIndex)
 {
 	TRACE();
 
@@ -1269,7 +1399,7 @@ void CodeController::expandVisibleFiles(bool useSingleFileCache)
 	MessageChangeFileView::FileState state = inListMode ? MessageChangeFileView::FILE_SNIPPETS
 														: MessageChangeFileView::FILE_MAXIMIZED;
 
-	for (size_t i = 0; i < filesToExpand; i++)
+	for (size_t i = firstFileIndex; i < filesToExpand; i++)
 	{
 		setFileState(m_files[i], state, useSingleFileCache);
 	}
@@ -1561,6 +1691,11 @@ void CodeController::saveOrRestoreViewMode(MessageBase* message)
 	}
 }
 
+void CodeController::cancelFullTextSearch()
+{
+	(*m_fullTextSearchId)++;
+}
+
 void CodeController::showFirstActiveReference(Id tokenId, bool updateView)
 {
 	// iterate local references when same tokenId get reactivated (consecutive edge clicks)
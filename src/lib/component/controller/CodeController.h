@@ -1,6 +1,7 @@
 #ifndef CODE_CONTROLLER_H
 #define CODE_CONTROLLER_H
 
+#include <atomic>
 #include <map>
 #include <string>
 
@@ -23,6 +24,7 @@
 #include "MessageFocusChanged.h"
 #include "MessageFocusIn.h"
 #include "MessageFocusOut.h"
+#include "MessageFullTextSearchResults.h"
 #include "MessageListener.h"
 #include "MessageScrollCode.h"
 #include "MessageScrollToLine.h"
@@ -60,6 +62,7 @@ class CodeController
 	, public MessageListener<MessageFlushUpdates>
 	, public MessageListener<MessageFocusIn>
 	, public MessageListener<MessageFocusOut>
+	, public MessageListener<MessageFullTextSearchResults>
 	, public MessageListener<MessageScrollCode>
 	, public MessageListener<MessageScrollToLine>
 	, public MessageListener<MessageShowError>
@@ -69,7 +72,7 @@ class CodeController
 {
 public:
 	CodeController(StorageAccess* storageAccess);
-	virtual ~CodeController() = default;
+	virtual ~CodeController();
 
 	Id getSchedulerId() const override;
 
@@ -102,6 +105,7 @@ private:
 	void handleMessage(MessageFlushUpdates* message) override;
 	void handleMessage(MessageFocusIn* message) override;
 	void handleMessage(MessageFocusOut* message) override;
+	void handleMessage(MessageFullTextSearchResults* message) override;
 	void handleMessage(MessageScrollCode* message) override;
 	void handleMessage(MessageScrollToLine* message) override;
 	void handleMessage(MessageShowError* message) override;
@@ -151,7 +155,7 @@ private:
 		size_t currentColumnNumber,
 		bool next) const;
 
-	void expandVisibleFiles(bool useSingleFileCache);
+	void expandVisibleFiles(bool useSingleFileCache, size_t firstFileIndex = 0);
 	CodeFileParams* addSourceLocations(std::shared_ptr<SourceLocationFile> locationFile);
 	void setFileState(
 		const FilePath& filePath, MessageChangeFileView::FileState state, bool useSingleFileCache);
@@ -166,6 +170,9 @@ private:
 
 	void saveOrRestoreViewMode(MessageBase* message);
 
+	// Stops the running fulltext search and drops its remaining results.
+	void cancelFullTextSearch();
+
 	void showFirstActiveReference(Id tokenId, bool updateView);
 	void showFiles(CodeView::CodeParams params, CodeScrollParams scrollParams, bool updateView);
 
@@ -186,6 +193,9 @@ private:
 
 	std::vector<Reference> m_localReferences;
 	int m_localReferenceIndex = -1;
+
+	// id of the latest fulltext search, shared with the search task to notice cancellation
+	std::shared_ptr<std::atomic<Id>> m_fullTextSearchId;
 };
 
 #endif	  // CODE_CONTROLLER_H
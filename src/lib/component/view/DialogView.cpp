@@ -68,6 +68,7 @@ DatabasePolicy DialogView::finishedIndexingDialog(
 	size_t totalFileCount,
 	float time,
 	ErrorCountInfo errorInfo,
+	const IndexingScheduleInfo& scheduleInfo,
 	bool interrupted,
 	bool shallow)
 {
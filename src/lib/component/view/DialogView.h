@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "ErrorCountInfo.h"
+#include "IndexingScheduleInfo.h"
 #include "RefreshInfo.h"
 
 class Project;
@@ -71,6 +72,7 @@ public:
 		size_t totalFileCount,
 		float time,
 		ErrorCountInfo errorInfo,
+		const IndexingScheduleInfo& scheduleInfo,
 		bool interrupted,
 		bool shallow);
 
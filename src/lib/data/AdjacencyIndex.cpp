@@ -0,0 +1,245 @@
+#include "AdjacencyIndex.h"
+
+#include <iterator>
+#include <set>
+
+#include "tracing.h"
+
+AdjacencyIndex::AdjacencyIndex(): m_isBuilt(false), m_edgeCount(0), m_lastBuiltEdgeId(0) {}
+
+void AdjacencyIndex::clear()
+{
+	m_outgoing.clear();
+	m_incoming.clear();
+	m_removedIds.clear();
+	m_addedEdgeIds.clear();
+
+	m_isBuilt = false;
+	m_edgeCount = 0;
+	m_lastBuiltEdgeId = 0;
+}
+
+bool AdjacencyIndex::isBuilt() const
+{
+	return m_isBuilt;
+}
+
+void AdjacencyIndex::build(const std::vector<StorageEdge>& edges)
+{
+	TRACE();
+
+	clear();
+
+	m_outgoing.build(edges, true);
+	m_incoming.build(edges, false);
+
+	for (const StorageEdge& edge: edges)
+	{
+		m_lastBuiltEdgeId = std::max(m_lastBuiltEdgeId, edge.id);
+	}
+
+	m_edgeCount = edges.size();
+	m_isBuilt = true;
+}
+
+void AdjacencyIndex::addEdge(const StorageEdge& edge)
+{
+	if (!m_isBuilt || edge.id == 0 || m_addedEdgeIds.find(edge.id) != m_addedEdgeIds.end())
+	{
+		return;
+	}
+
+	// new edges always get a higher id, lower ids belong to edges that are already known unless
+	// they were removed before and the database reused their id
+	if (edge.id <= m_lastBuiltEdgeId && m_removedIds.find(edge.id) == m_removedIds.end())
+	{
+		return;
+	}
+
+	m_outgoing.add(edge.sourceNodeId, {edge.id, edge.targetNodeId, edge.type});
+	m_incoming.add(edge.targetNodeId, {edge.id, edge.sourceNodeId, edge.type});
+
+	m_addedEdgeIds.insert(edge.id);
+	m_edgeCount++;
+}
+
+void AdjacencyIndex::removeElements(const std::vector<Id>& elementIds)
+{
+	if (!m_isBuilt)
+	{
+		return;
+	}
+
+	// removed ids only hide built edges, added edges get dropped right away so that reused ids
+	// can be added again
+	m_removedIds.insert(elementIds.begin(), elementIds.end());
+
+	if (!m_addedEdgeIds.empty())
+	{
+		const std::unordered_set<Id> ids(elementIds.begin(), elementIds.end());
+		const size_t removedCount = m_outgoing.removeAdded(ids);
+		m_incoming.removeAdded(ids);
+
+		for (const Id id: ids)
+		{
+			m_addedEdgeIds.erase(id);
+		}
+		m_edgeCount -= removedCount;
+	}
+}
+
+size_t AdjacencyIndex::getEdgeCount() const
+{
+	return m_edgeCount;
+}
+
+std::vector<StorageEdge> AdjacencyIndex::getEdgesBySourceIds(
+	const std::vector<Id>& sourceIds, Edge::TypeMask typeMask) const
+{
+	std::vector<StorageEdge> edges;
+	addEdges(sourceIds, m_outgoing, true, typeMask, &edges);
+	return edges;
+}
+
+std::vector<StorageEdge> AdjacencyIndex::getEdgesByTargetIds(
+	const std::vector<Id>& targetIds, Edge::TypeMask typeMask) const
+{
+	std::vector<StorageEdge> edges;
+	addEdges(targetIds, m_incoming, false, typeMask, &edges);
+	return edges;
+}
+
+std::vector<StorageEdge> AdjacencyIndex::getEdgesBySourceOrTargetId(Id nodeId) const
+{
+	std::vector<StorageEdge> edges;
+	addEdges({nodeId}, m_outgoing, true, ~Edge::TypeMask(0), &edges);
+
+	// self loops are already part of the outgoing edges
+	const size_t outgoingCount = edges.size();
+	addEdges({nodeId}, m_incoming, false, ~Edge::TypeMask(0), &edges);
+	edges.erase(
+		std::remove_if(
+			edges.begin() + outgoingCount,
+			edges.end(),
+			[nodeId](const StorageEdge& edge) { return edge.sourceNodeId == nodeId; }),
+		edges.end());
+
+	return edges;
+}
+
+void AdjacencyIndex::Adjacency::clear()
+{
+	m_nodeIds.clear();
+	m_nodeIds.shrink_to_fit();
+	m_offsets.clear();
+	m_offsets.shrink_to_fit();
+	m_entries.clear();
+	m_entries.shrink_to_fit();
+	m_addedEntries.clear();
+}
+
+void AdjacencyIndex::Adjacency::build(const std::vector<StorageEdge>& edges, bool outgoing)
+{
+	clear();
+
+	for (const StorageEdge& edge: edges)
+	{
+		m_nodeIds.push_back(outgoing ? edge.sourceNodeId : edge.targetNodeId);
+	}
+	std::sort(m_nodeIds.begin(), m_nodeIds.end());
+	m_nodeIds.erase(std::unique(m_nodeIds.begin(), m_nodeIds.end()), m_nodeIds.end());
+	m_nodeIds.shrink_to_fit();
+
+	auto getIndex = [this](Id nodeId) {
+		return std::lower_bound(m_nodeIds.begin(), m_nodeIds.end(), nodeId) - m_nodeIds.begin();
+	};
+
+	m_offsets.assign(m_nodeIds.size() + 1, 0);
+	for (const StorageEdge& edge: edges)
+	{
+		m_offsets[getIndex(outgoing ? edge.sourceNodeId : edge.targetNodeId) + 1]++;
+	}
+	for (size_t i = 1; i < m_offsets.size(); i++)
+	{
+		m_offsets[i] += m_offsets[i - 1];
+	}
+
+	std::vector<size_t> positions(m_offsets.begin(), m_offsets.end() - 1);
+	m_entries.resize(edges.size());
+	for (const StorageEdge& edge: edges)
+	{
+		const Id nodeId = outgoing ? edge.sourceNodeId : edge.targetNodeId;
+		const Id otherNodeId = outgoing ? edge.targetNodeId : edge.sourceNodeId;
+		m_entries[positions[getIndex(nodeId)]++] = {edge.id, otherNodeId, edge.type};
+	}
+}
+
+void AdjacencyIndex::Adjacency::add(Id nodeId, const Entry& entry)
+{
+	m_addedEntries[nodeId].push_back(entry);
+}
+
+size_t AdjacencyIndex::Adjacency::removeAdded(const std::unordered_set<Id>& ids)
+{
+	size_t removedCount = 0;
+	for (auto it = m_addedEntries.begin(); it != m_addedEntries.end();)
+	{
+		std::vector<Entry>& entries = it->second;
+		const size_t count = entries.size();
+		if (ids.find(it->first) != ids.end())
+		{
+			entries.clear();
+		}
+		else
+		{
+			entries.erase(
+				std::remove_if(
+					entries.begin(),
+					entries.end(),
+					[&ids](const Entry& entry) {
+						return ids.find(entry.edgeId) != ids.end() ||
+							ids.find(entry.nodeId) != ids.end();
+					}),
+				entries.end());
+		}
+		removedCount += count - entries.size();
+
+		it = (entries.empty() ? m_addedEntries.erase(it) : std::next(it));
+	}
+	return removedCount;
+}
+
+bool AdjacencyIndex::isRemoved(Id nodeId, const Entry& entry) const
+{
+	return !m_removedIds.empty() &&
+		(m_removedIds.find(entry.edgeId) != m_removedIds.end() ||
+		 m_removedIds.find(entry.nodeId) != m_removedIds.end() ||
+		 m_removedIds.find(nodeId) != m_removedIds.end());
+}
+
+void AdjacencyIndex::addEdges(
+	const std::vector<Id>& nodeIds,
+	const Adjacency& adjacency,
+	bool outgoing,
+	Edge::TypeMask typeMask,
+	std::vector<StorageEdge>* edges) const
+{
+	// the same node may be requested more than once, but every edge is only returned once
+	const std::set<Id> uniqueNodeIds(nodeIds.begin(), nodeIds.end());
+	for (const Id nodeId: uniqueNodeIds)
+	{
+		adjacency.forEachEntry(nodeId, [&](const Entry& entry, bool added) {
+			if ((entry.type & typeMask) && (added || !isRemoved(nodeId, entry)))
+			{
+				if (outgoing)
+				{
+					edges->emplace_back(entry.edgeId, entry.type, nodeId, entry.nodeId);
+				}
+				else
+				{
+					edges->emplace_back(entry.edgeId, entry.type, entry.nodeId, nodeId);
+				}
+			}
+		});
+	}
+}
@@ -0,0 +1,104 @@
+#ifndef ADJACENCY_INDEX_H
+#define ADJACENCY_INDEX_H
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Edge.h"
+#include "StorageEdge.h"
+#include "types.h"
+
+// In-memory edge lookup in compressed sparse row layout. Every edge is stored once in the outgoing
+// list of its source node and once in the incoming list of its target node, tagged with its type.
+// Edges added or removed after the index was built are tracked separately until the next rebuild.
+// Removing ids hides the built edges touching them and drops the added ones.
+class AdjacencyIndex
+{
+public:
+	AdjacencyIndex();
+
+	void clear();
+	bool isBuilt() const;
+
+	void build(const std::vector<StorageEdge>& edges);
+
+	void addEdge(const StorageEdge& edge);
+	void removeElements(const std::vector<Id>& elementIds);
+
+	size_t getEdgeCount() const;
+
+	std::vector<StorageEdge> getEdgesBySourceIds(
+		const std::vector<Id>& sourceIds, Edge::TypeMask typeMask = ~Edge::TypeMask(0)) const;
+	std::vector<StorageEdge> getEdgesByTargetIds(
+		const std::vector<Id>& targetIds, Edge::TypeMask typeMask = ~Edge::TypeMask(0)) const;
+	std::vector<StorageEdge> getEdgesBySourceOrTargetId(Id nodeId) const;
+
+private:
+	struct Entry
+	{
+		Id edgeId;
+		Id nodeId;
+		int type;
+	};
+
+	class Adjacency
+	{
+	public:
+		void clear();
+		void build(const std::vector<StorageEdge>& edges, bool outgoing);
+		void add(Id nodeId, const Entry& entry);
+		size_t removeAdded(const std::unordered_set<Id>& ids);
+
+		template <typename FuncType>
+		void forEachEntry(Id nodeId, FuncType func) const
+		{
+			auto it = std::lower_bound(m_nodeIds.begin(), m_nodeIds.end(), nodeId);
+			if (it != m_nodeIds.end() && *it == nodeId)
+			{
+				const size_t index = it - m_nodeIds.begin();
+				for (size_t i = m_offsets[index]; i < m_offsets[index + 1]; i++)
+				{
+					func(m_entries[i], false);
+				}
+			}
+
+			auto addedIt = m_addedEntries.find(nodeId);
+			if (addedIt != m_addedEntries.end())
+			{
+				for (const Entry& entry: addedIt->second)
+				{
+					func(entry, true);
+				}
+			}
+		}
+
+	private:
+		std::vector<Id> m_nodeIds;
+		std::vector<size_t> m_offsets;
+		std::vector<Entry> m_entries;
+		std::unordered_map<Id, std::vector<Entry>> m_addedEntries;
+	};
+
+	bool isRemoved(Id nodeId, const Entry& entry) const;
+
+	void addEdges(
+		const std::vector<Id>& nodeIds,
+		const Adjacency& adjacency,
+		bool outgoing,
+		Edge::TypeMask typeMask,
+		std::vector<StorageEdge>* edges) const;
+
+	Adjacency m_outgoing;
+	Adjacency m_incoming;
+
+	std::unordered_set<Id> m_removedIds;
+	std::unordered_set<Id> m_addedEdgeIds;
+
+	bool m_isBuilt;
+	size_t m_edgeCount;
+	Id m_lastBuiltEdgeId;
+};
+
+#endif	  // ADJACENCY_INDEX_H
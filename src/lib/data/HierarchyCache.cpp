@@ -1,5 +1,7 @@
 #include "HierarchyCache.h"
 
+#include <algorithm>
+
 #include "utility.h"
 
 HierarchyCache::HierarchyNode::HierarchyNode(Id nodeId)
@@ -38,11 +40,29 @@ void HierarchyCache::HierarchyNode::addBase(HierarchyNode* base, Id edgeId)
 	m_baseEdgeIds.push_back(edgeId);
 }
 
+void HierarchyCache::HierarchyNode::removeBase(Id edgeId)
+{
+	for (size_t i = 0; i < m_baseEdgeIds.size(); i++)
+	{
+		if (m_baseEdgeIds[i] == edgeId)
+		{
+			m_bases.erase(m_bases.begin() + i);
+			m_baseEdgeIds.erase(m_baseEdgeIds.begin() + i);
+			return;
+		}
+	}
+}
+
 void HierarchyCache::HierarchyNode::addChild(HierarchyNode* child)
 {
 	m_children.push_back(child);
 }
 
+void HierarchyCache::HierarchyNode::removeChild(HierarchyNode* child)
+{
+	m_children.erase(std::remove(m_children.begin(), m_children.end(), child), m_children.end());
+}
+
 size_t HierarchyCache::HierarchyNode::getChildrenCount() const
 {
 	return m_children.size();
@@ -159,6 +179,11 @@ void HierarchyCache::createConnection(
 	HierarchyNode* from = createNode(fromId);
 	HierarchyNode* to = createNode(toId);
 
+	if (to->getParent() == from && to->getEdgeId() == edgeId)
+	{
+		return;
+	}
+
 	from->addChild(to);
 	to->setParent(from);
 
@@ -179,9 +204,43 @@ void HierarchyCache::createInheritance(Id edgeId, Id fromId, Id toId)
 	HierarchyNode* from = createNode(fromId);
 	HierarchyNode* to = createNode(toId);
 
+	from->removeBase(edgeId);
 	from->addBase(to, edgeId);
 }
 
+void HierarchyCache::removeConnection(Id edgeId, Id fromId, Id toId)
+{
+	HierarchyNode* from = getNode(fromId);
+	HierarchyNode* to = getNode(toId);
+
+	if (from && to && to->getParent() == from && to->getEdgeId() == edgeId)
+	{
+		from->removeChild(to);
+		to->setParent(nullptr);
+		to->setEdgeId(0);
+	}
+}
+
+void HierarchyCache::removeInheritance(Id edgeId, Id fromId)
+{
+	if (HierarchyNode* from = getNode(fromId))
+	{
+		from->removeBase(edgeId);
+	}
+}
+
+void HierarchyCache::updateNode(Id nodeId, bool visibleAsParent, bool implicit)
+{
+	if (HierarchyNode* node = getNode(nodeId))
+	{
+		if (node->getChildrenCount())
+		{
+			node->setIsVisible(visibleAsParent);
+		}
+		node->setIsImplicit(implicit);
+	}
+}
+
 Id HierarchyCache::getLastVisibleParentNodeId(Id nodeId) const
 {
 	HierarchyNode* node = nullptr;
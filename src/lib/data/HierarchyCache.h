@@ -17,6 +17,10 @@ public:
 		Id edgeId, Id fromId, Id toId, bool sourceVisible, bool sourceImplicit, bool targetImplicit);
 	void createInheritance(Id edgeId, Id fromId, Id toId);
 
+	void removeConnection(Id edgeId, Id fromId, Id toId);
+	void removeInheritance(Id edgeId, Id fromId);
+	void updateNode(Id nodeId, bool visibleAsParent, bool implicit);
+
 	Id getLastVisibleParentNodeId(Id nodeId) const;
 	size_t getIndexOfLastVisibleParentNode(Id nodeId) const;
 
@@ -51,8 +55,10 @@ private:
 		void setParent(HierarchyNode* parent);
 
 		void addBase(HierarchyNode* base, Id edgeId);
+		void removeBase(Id edgeId);
 
 		void addChild(HierarchyNode* child);
+		void removeChild(HierarchyNode* child);
 
 		size_t getChildrenCount() const;
 		size_t getNonImplicitChildrenCount() const;
@@ -0,0 +1,42 @@
+#ifndef INDEXING_SCHEDULE_INFO_H
+#define INDEXING_SCHEDULE_INFO_H
+
+#include <string>
+#include <vector>
+
+#include "StorageIndexingDuration.h"
+
+// Describes how the source files of an indexing run were ordered. Indexing cannot finish before its
+// longest source file, so the indexing time comes close to that duration if the long running source
+// files were started first.
+struct IndexingScheduleInfo
+{
+	IndexingScheduleInfo(): recordedFileCount(0), scheduledFileCount(0), longestFileDuration(0.0f)
+	{
+	}
+
+	IndexingScheduleInfo(
+		size_t recordedFileCount,
+		size_t scheduledFileCount,
+		const std::vector<StorageIndexingDuration>& durations)
+		: recordedFileCount(recordedFileCount)
+		, scheduledFileCount(scheduledFileCount)
+		, longestFileDuration(0.0f)
+	{
+		for (const StorageIndexingDuration& duration: durations)
+		{
+			if (duration.duration > longestFileDuration)
+			{
+				longestFilePath = duration.filePath;
+				longestFileDuration = duration.duration;
+			}
+		}
+	}
+
+	size_t recordedFileCount;	 // source files ordered by the durations of an earlier run
+	size_t scheduledFileCount;
+	std::wstring longestFilePath;
+	float longestFileDuration;	  // seconds
+};
+
+#endif	  // INDEXING_SCHEDULE_INFO_H
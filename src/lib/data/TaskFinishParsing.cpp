@@ -1,5 +1,7 @@
 #include "TaskFinishParsing.h"
 
+#include <algorithm>
+
 #include "Blackboard.h"
 #include "DialogView.h"
 #include "MessageIndexingFinished.h"
@@ -25,15 +27,45 @@ void TaskFinishParsing::terminate()
 
 void TaskFinishParsing::doEnter(std::shared_ptr<Blackboard> blackboard)
 {
-	m_storage->setMode(SqliteIndexStorage::STORAGE_MODE_READ);
+	std::vector<StorageIndexingDuration> indexingDurations;
+	if (blackboard->get("indexing_durations", indexingDurations))
+	{
+		m_storage->addIndexingDurations(indexingDurations);
+	}
+
+	// files that were not indexed yet are missing in an interrupted run, not removed
+	bool interruptedIndexing = false;
+	blackboard->get("interrupted_indexing", interruptedIndexing);
+	if (!interruptedIndexing)
+	{
+		m_storage->removeIndexingDurationsOfRemovedFiles();
+	}
+
+	if (m_storage->isBulkLoading())
+	{
+		// builds the indices of all modes, so none of them needs to be created on load
+		m_storage->finishBulkLoad([=](int progress) {
+			m_dialogView->showProgressDialog(
+				L"Finish Indexing", L"Building database indices", progress);
+		});
+		m_dialogView->hideProgressDialog();
+	}
+	else
+	{
+		m_storage->setMode(SqliteIndexStorage::STORAGE_MODE_READ);
+	}
 }
 
 Task::TaskState TaskFinishParsing::doUpdate(std::shared_ptr<Blackboard> blackboard)
 {
 	TimeStamp start = TimeStamp::now();
 
+	m_dialogView->showUnknownProgressDialog(L"Finish Indexing", L"Packing source locations");
+	m_storage->packSourceLocations();
 	m_dialogView->showUnknownProgressDialog(L"Finish Indexing", L"Optimizing database");
 	m_storage->optimizeMemory();
+	m_dialogView->showUnknownProgressDialog(L"Finish Indexing", L"Writing index snapshot");
+	m_storage->writeIndexSnapshot();
 	m_dialogView->hideUnknownProgressDialog();
 
 	double time = TimeStamp::durationSeconds(start);
@@ -65,6 +97,7 @@ Task::TaskState TaskFinishParsing::doUpdate(std::shared_ptr<Blackboard> blackboa
 	blackboard->get("shallow_indexing", shallowIndexing);
 
 	ErrorCountInfo errorInfo = m_storage->getErrorCount();
+	IndexingScheduleInfo scheduleInfo = getScheduleInfo(blackboard);
 
 	std::wstring status;
 	status += L"Finished indexing: ";
@@ -77,6 +110,7 @@ Task::TaskState TaskFinishParsing::doUpdate(std::shared_ptr<Blackboard> blackboa
 	{
 		status += L" (" + std::to_wstring(errorInfo.fatal) + L" fatal)";
 	}
+	status += getAutomaticPchStatus(blackboard);
 	MessageStatus(status, false, false).dispatch();
 
 	StorageStats stats = m_storage->getStorageStats();
@@ -87,6 +121,7 @@ Task::TaskState TaskFinishParsing::doUpdate(std::shared_ptr<Blackboard> blackboa
 		stats.fileCount,
 		static_cast<float>(time),
 		errorInfo,
+		scheduleInfo,
 		interruptedIndexing,
 		shallowIndexing);
 
@@ -109,6 +144,43 @@ Task::TaskState TaskFinishParsing::doUpdate(std::shared_ptr<Blackboard> blackboa
 	return STATE_SUCCESS;
 }
 
+std::wstring TaskFinishParsing::getAutomaticPchStatus(std::shared_ptr<Blackboard> blackboard) const
+{
+	int automaticPchSourceFileCount = 0;
+	blackboard->get("automatic_pch_source_file_count", automaticPchSourceFileCount);
+	if (automaticPchSourceFileCount <= 0)
+	{
+		return L"";
+	}
+
+	// only the cost of building the precompiled headers is known, the parsing time they save is
+	// not measured
+	float pchBuildTime = 0.0f;
+	blackboard->get("automatic_pch_build_time", pchBuildTime);
+
+	return L"; " + std::to_wstring(automaticPchSourceFileCount) +
+		L" source files with automatic precompiled headers, built in " +
+		utility::decodeFromUtf8(TimeStamp::secondsToString(pchBuildTime));
+}
+
+IndexingScheduleInfo TaskFinishParsing::getScheduleInfo(
+	std::shared_ptr<Blackboard> blackboard) const
+{
+	int scheduledSourceFileCount = 0;
+	blackboard->get("scheduled_source_file_count", scheduledSourceFileCount);
+
+	int recordedDurationSourceFileCount = 0;
+	blackboard->get("recorded_duration_source_file_count", recordedDurationSourceFileCount);
+
+	std::vector<StorageIndexingDuration> indexingDurations;
+	blackboard->get("indexing_durations", indexingDurations);
+
+	return IndexingScheduleInfo(
+		static_cast<size_t>(std::max(recordedDurationSourceFileCount, 0)),
+		static_cast<size_t>(std::max(scheduledSourceFileCount, 0)),
+		indexingDurations);
+}
+
 void TaskFinishParsing::doExit(std::shared_ptr<Blackboard> blackboard)
 {
 	m_storage.reset();
@@ -1,8 +1,10 @@
 #ifndef TASK_FINISH_PARSING_H
 #define TASK_FINISH_PARSING_H
 
+#include <string>
 #include <vector>
 
+#include "IndexingScheduleInfo.h"
 #include "Task.h"
 
 class DialogView;
@@ -23,6 +25,9 @@ private:
 	void doExit(std::shared_ptr<Blackboard> blackboard) override;
 	void doReset(std::shared_ptr<Blackboard> blackboard) override;
 
+	std::wstring getAutomaticPchStatus(std::shared_ptr<Blackboard> blackboard) const;
+	IndexingScheduleInfo getScheduleInfo(std::shared_ptr<Blackboard> blackboard) const;
+
 	std::shared_ptr<PersistentStorage> m_storage;
 	std::shared_ptr<DialogView> m_dialogView;
 };
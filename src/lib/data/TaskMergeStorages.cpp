@@ -1,9 +1,25 @@
 #include "TaskMergeStorages.h"
 
+#include <algorithm>
+
 #include "StorageProvider.h"
+#include "TimeStamp.h"
+#include "logging.h"
+
+const size_t TaskMergeStorages::s_defaultMaxSourceLocationCount = 500000;
+
+int TaskMergeStorages::getWorkerCount(int mergeWorkerCountSetting, int indexerThreadCount)
+{
+	if (mergeWorkerCountSetting > 0)
+	{
+		return mergeWorkerCountSetting;
+	}
+	return std::max(1, indexerThreadCount / 8);
+}
 
-TaskMergeStorages::TaskMergeStorages(std::shared_ptr<StorageProvider> storageProvider)
-	: m_storageProvider(storageProvider)
+TaskMergeStorages::TaskMergeStorages(
+	std::shared_ptr<StorageProvider> storageProvider, size_t maxSourceLocationCount)
+	: m_storageProvider(storageProvider), m_maxSourceLocationCount(maxSourceLocationCount)
 {
 }
 
@@ -11,30 +27,52 @@ void TaskMergeStorages::doEnter(std::shared_ptr<Blackboard> blackboard) {}
 
 Task::TaskState TaskMergeStorages::doUpdate(std::shared_ptr<Blackboard> blackboard)
 {
-	if (m_storageProvider->getStorageCount() > 2)	 // largest storage won't be touched here
+	// the largest storage won't be touched here, it is left for injection
+	std::shared_ptr<IntermediateStorage> target = m_storageProvider->consumeSecondLargestStorage();
+	if (!target)
 	{
-		std::shared_ptr<IntermediateStorage> target = m_storageProvider->consumeSecondLargestStorage();
-		std::shared_ptr<IntermediateStorage> source = m_storageProvider->consumeSecondLargestStorage();
-		if (target && source)
-		{
-			target->inject(source.get());
-			m_storageProvider->insert(target);
-			return STATE_SUCCESS;
-		}
-		else
+		return STATE_FAILURE;
+	}
+
+	const TimeStamp start = TimeStamp::now();
+	size_t mergedStorageCount = 0;
+	size_t mergedSourceLocationCount = 0;
+
+	// smaller storages are always merged into the larger one, so large storages are not copied
+	// again and other merge workers can fill their own targets in the meantime
+	while (mergedSourceLocationCount < m_maxSourceLocationCount)
+	{
+		std::shared_ptr<IntermediateStorage> source = m_storageProvider->consumeSmallestStorage();
+		if (!source)
 		{
-			if (target)
-			{
-				m_storageProvider->insert(target);
-			}
-			if (source)
-			{
-				m_storageProvider->insert(source);
-			}
+			break;
 		}
+
+		mergedSourceLocationCount += source->getSourceLocationCount();
+		target->inject(source.get());
+		mergedStorageCount++;
+	}
+
+	m_storageProvider->insert(target);
+
+	if (!mergedStorageCount)
+	{
+		return STATE_FAILURE;
 	}
 
-	return STATE_FAILURE;
+	const double time = TimeStamp::durationSeconds(start);
+	m_mergedStorageCount += mergedStorageCount;
+	m_mergedSourceLocationCount += mergedSourceLocationCount;
+	m_mergeTime += time;
+
+	LOG_INFO_STREAM(
+		<< "merged " << mergedStorageCount << " storages with " << mergedSourceLocationCount
+		<< " source locations in " << TimeStamp::secondsToString(time) << ", total "
+		<< m_mergedStorageCount << " storages at "
+		<< static_cast<size_t>(m_mergedSourceLocationCount / std::max(m_mergeTime, 0.001))
+		<< " source locations per second");
+
+	return STATE_SUCCESS;
 }
 
 void TaskMergeStorages::doExit(std::shared_ptr<Blackboard> blackboard) {}
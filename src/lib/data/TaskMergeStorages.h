@@ -10,15 +10,31 @@ class StorageProvider;
 class TaskMergeStorages: public Task
 {
 public:
-	TaskMergeStorages(std::shared_ptr<StorageProvider> storageProvider);
+	// mergeWorkerCountSetting is the "indexing/merge_worker_count" setting, with 0 there is one
+	// worker per eight indexer threads and at least one.
+	static int getWorkerCount(int mergeWorkerCountSetting, int indexerThreadCount);
+
+	// each update stops merging once maxSourceLocationCount source locations were merged into the
+	// target, so the target is offered to the injector again in between
+	TaskMergeStorages(
+		std::shared_ptr<StorageProvider> storageProvider,
+		size_t maxSourceLocationCount = s_defaultMaxSourceLocationCount);
 
 private:
+	static const size_t s_defaultMaxSourceLocationCount;
+
 	void doEnter(std::shared_ptr<Blackboard> blackboard) override;
 	TaskState doUpdate(std::shared_ptr<Blackboard> blackboard) override;
 	void doExit(std::shared_ptr<Blackboard> blackboard) override;
 	void doReset(std::shared_ptr<Blackboard> blackboard) override;
 
 	std::shared_ptr<StorageProvider> m_storageProvider;
+	const size_t m_maxSourceLocationCount;
+
+	// throughput over all updates, logged after each update that merged storages
+	size_t m_mergedStorageCount = 0;
+	size_t m_mergedSourceLocationCount = 0;
+	double m_mergeTime = 0.0;
 };
 
 #endif	  // TASK_MERGE_STORAGES_H
@@ -1,8 +1,69 @@
 #include "FullTextSearchIndex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cwctype>
+#include <fstream>
 #include <limits>
+#include <thread>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
+#include "FileSystem.h"
 #include "logging.h"
 #include "tracing.h"
+#include "utilityApp.h"
+
+namespace
+{
+const char INDEX_MAGIC[8] = {'S', 'R', 'C', 'T', 'F', 'T', 'S', 'I'};
+
+size_t alignOffset(size_t offset)
+{
+	return (offset + 7) & ~size_t(7);
+}
+
+void writePadding(std::ofstream& fileStream, size_t size)
+{
+	const char zeros[8] = {};
+	fileStream.write(zeros, alignOffset(size) - size);
+}
+}	 // namespace
+
+const uint32_t FullTextSearchIndex::s_indexVersion = 1;
+
+FullTextSearchIndex::Shard::Shard(
+	std::string text, std::vector<Id> fileIds, std::vector<int> fileOffsets)
+	: array(std::move(text)), fileIds(std::move(fileIds)), fileOffsets(std::move(fileOffsets))
+{
+}
+
+FullTextSearchIndex::Shard::Shard(
+	const char* text,
+	const int* array,
+	int size,
+	std::vector<Id> fileIds,
+	std::vector<int> fileOffsets,
+	std::shared_ptr<const void> mapping)
+	: array(text, array, size, std::move(mapping))
+	, fileIds(std::move(fileIds))
+	, fileOffsets(std::move(fileOffsets))
+{
+}
+
+FilePath FullTextSearchIndex::getIndexFilePath(const FilePath& indexDbFilePath)
+{
+	return FilePath(indexDbFilePath.wstr() + L"_fulltext");
+}
+
+FullTextSearchIndex::FullTextSearchIndex(size_t minimumShardByteSize, size_t maximumShardByteSize)
+	: m_minimumShardByteSize(std::max<size_t>(1, minimumShardByteSize))
+	, m_maximumShardByteSize(std::min<size_t>(
+		  maximumShardByteSize, static_cast<size_t>(std::numeric_limits<int>::max() - 1)))
+{
+}
 
 void FullTextSearchIndex::addFile(Id fileId, const std::wstring& fileContent)
 {
@@ -11,16 +72,45 @@ void FullTextSearchIndex::addFile(Id fileId, const std::wstring& fileContent)
 		LOG_ERROR("empty file not added to fulltextsearch index");
 	}
 
-	if (static_cast<int>(fileContent.size()) >= std::numeric_limits<int>::max())
+	std::string text = encodeLowercase(fileContent);
+	if (text.size() > m_maximumShardByteSize)
 	{
 		LOG_ERROR("file too big not added to fulltextsearch index");
+		return;
 	}
 
-	FullTextSearchFile fts_file(fileId, SuffixArray(fileContent));
-
 	{
 		std::lock_guard<std::mutex> lock(m_filesMutex);
-		m_files.push_back(fts_file);
+		m_addedFiles.push_back({fileId, std::move(text)});
+	}
+}
+
+void FullTextSearchIndex::removeFiles(const std::set<Id>& fileIds)
+{
+	std::lock_guard<std::mutex> lock(m_filesMutex);
+	m_addedFiles.erase(
+		std::remove_if(
+			m_addedFiles.begin(),
+			m_addedFiles.end(),
+			[&fileIds](const File& file) { return fileIds.find(file.fileId) != fileIds.end(); }),
+		m_addedFiles.end());
+
+	// the remaining files of affected shards are indexed again with the next search
+	for (auto it = m_shards.begin(); it != m_shards.end();)
+	{
+		const Shard& shard = **it;
+		const bool containsRemovedFile = std::any_of(
+			shard.fileIds.begin(), shard.fileIds.end(), [&fileIds](Id fileId) {
+				return fileIds.find(fileId) != fileIds.end();
+			});
+		if (!containsRemovedFile)
+		{
+			++it;
+			continue;
+		}
+
+		addShardFiles(shard, fileIds);
+		it = m_shards.erase(it);
 	}
 }
 
@@ -29,32 +119,509 @@ std::vector<FullTextSearchResult> FullTextSearchIndex::searchForTerm(const std::
 	TRACE();
 
 	std::vector<FullTextSearchResult> ret;
+	const std::string encodedTerm = encodeLowercase(term);
+	if (encodedTerm.empty())
+	{
+		return ret;
+	}
+
 	{
 		std::lock_guard<std::mutex> lock(m_filesMutex);
-		for (auto& f: m_files)
+		if (!m_addedFiles.empty())
 		{
-			FullTextSearchResult hit;
-			hit.fileId = f.fileId;
-			hit.positions = f.array.searchForTerm(term);
-			std::sort(hit.positions.begin(), hit.positions.end());
-			if (!hit.positions.empty())
-			{
-				ret.push_back(hit);
-			}
+			buildShards();
+		}
+
+		for (const std::shared_ptr<Shard>& shard: m_shards)
+		{
+			searchShard(*shard, encodedTerm, ret);
 		}
 	}
 
 	return ret;
 }
 
+void FullTextSearchIndex::forEachFileText(
+	std::function<void(Id fileId, const char* begin, const char* end)> func) const
+{
+	TRACE();
+
+	std::lock_guard<std::mutex> lock(m_filesMutex);
+	if (!m_addedFiles.empty())
+	{
+		buildShards();
+	}
+
+	std::atomic<size_t> nextShardIndex(0);
+	std::vector<std::thread> threads;
+	const size_t threadCount = std::max(1, utility::getIdealThreadCount());
+	for (size_t i = 0; i < std::min(threadCount, m_shards.size()); i++)
+	{
+		threads.emplace_back([&]() {
+			for (size_t shardIndex = nextShardIndex++; shardIndex < m_shards.size();
+				 shardIndex = nextShardIndex++)
+			{
+				const Shard& shard = *m_shards[shardIndex];
+				const char* text = shard.array.getText();
+				for (size_t j = 0; j < shard.fileIds.size(); j++)
+				{
+					func(
+						shard.fileIds[j],
+						text + shard.fileOffsets[j],
+						text + shard.fileOffsets[j + 1]);
+				}
+			}
+		});
+	}
+	for (std::thread& thread: threads)
+	{
+		thread.join();
+	}
+}
+
 size_t FullTextSearchIndex::fileCount() const
 {
 	std::lock_guard<std::mutex> lock(m_filesMutex);
-	return m_files.size();
+	size_t count = m_addedFiles.size();
+	for (const std::shared_ptr<Shard>& shard: m_shards)
+	{
+		count += shard->fileIds.size();
+	}
+	return count;
+}
+
+size_t FullTextSearchIndex::shardCount() const
+{
+	std::lock_guard<std::mutex> lock(m_filesMutex);
+	return m_shards.size();
 }
 
 void FullTextSearchIndex::clear()
 {
 	std::lock_guard<std::mutex> lock(m_filesMutex);
-	m_files.clear();
+	m_addedFiles.clear();
+	m_shards.clear();
+}
+
+bool FullTextSearchIndex::load(
+	const FilePath& filePath, const std::string& timestamp, const std::string& codecName)
+{
+	TRACE();
+
+	if (timestamp.empty() || timestamp.size() >= sizeof(Header::timestamp) ||
+		codecName.size() >= sizeof(Header::codecName) || !filePath.exists())
+	{
+		return false;
+	}
+
+	std::shared_ptr<boost::interprocess::mapped_region> region;
+	try
+	{
+		boost::interprocess::file_mapping file(
+			filePath.str().c_str(), boost::interprocess::read_only);
+		region = std::make_shared<boost::interprocess::mapped_region>(
+			file, boost::interprocess::read_only);
+	}
+	catch (boost::interprocess::interprocess_exception& e)
+	{
+		LOG_WARNING(
+			"Unable to map fulltext search index \"" + filePath.str() +
+			"\": " + std::string(e.what()));
+		return false;
+	}
+
+	const char* data = static_cast<const char*>(region->get_address());
+	const size_t size = region->get_size();
+
+	Header header;
+	if (size < sizeof(Header))
+	{
+		LOG_WARNING("Discarding malformed fulltext search index \"" + filePath.str() + "\"");
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(Header));
+	header.timestamp[sizeof(header.timestamp) - 1] = '\0';
+	header.codecName[sizeof(header.codecName) - 1] = '\0';
+
+	if (std::memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+		header.indexVersion != s_indexVersion || header.wideCharSize != sizeof(wchar_t) ||
+		std::string(header.timestamp) != timestamp || std::string(header.codecName) != codecName)
+	{
+		LOG_INFO("Discarding outdated fulltext search index \"" + filePath.str() + "\"");
+		return false;
+	}
+
+	std::vector<std::shared_ptr<Shard>> shards;
+	size_t offset = alignOffset(sizeof(Header));
+	for (uint64_t i = 0; i < header.shardCount; i++)
+	{
+		ShardHeader shardHeader;
+		if (offset + sizeof(ShardHeader) > size)
+		{
+			break;
+		}
+		std::memcpy(&shardHeader, data + offset, sizeof(ShardHeader));
+		offset += sizeof(ShardHeader);
+
+		const uint64_t fileCount = shardHeader.fileCount;
+		const uint64_t textSize = shardHeader.textSize;
+		if (textSize > static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+			fileCount > textSize)
+		{
+			break;
+		}
+
+		const size_t fileIdsOffset = offset;
+		const size_t fileOffsetsOffset = alignOffset(fileIdsOffset + fileCount * sizeof(uint64_t));
+		const size_t textOffset = alignOffset(
+			fileOffsetsOffset + (fileCount + 1) * sizeof(int32_t));
+		const size_t arrayOffset = alignOffset(textOffset + textSize);
+		offset = alignOffset(arrayOffset + textSize * sizeof(int32_t));
+		if (offset > size)
+		{
+			break;
+		}
+
+		std::vector<Id> fileIds(fileCount);
+		for (size_t j = 0; j < fileCount; j++)
+		{
+			uint64_t fileId;
+			std::memcpy(&fileId, data + fileIdsOffset + j * sizeof(uint64_t), sizeof(uint64_t));
+			fileIds[j] = static_cast<Id>(fileId);
+		}
+
+		std::vector<int> fileOffsets(fileCount + 1);
+		std::memcpy(fileOffsets.data(), data + fileOffsetsOffset, fileOffsets.size() * sizeof(int));
+		if (fileOffsets.front() != 0 || fileOffsets.back() != static_cast<int>(textSize) ||
+			!std::is_sorted(fileOffsets.begin(), fileOffsets.end()))
+		{
+			break;
+		}
+
+		shards.push_back(std::make_shared<Shard>(
+			data + textOffset,
+			reinterpret_cast<const int*>(data + arrayOffset),
+			static_cast<int>(textSize),
+			std::move(fileIds),
+			std::move(fileOffsets),
+			region));
+	}
+
+	if (shards.size() != header.shardCount)
+	{
+		LOG_WARNING("Discarding malformed fulltext search index \"" + filePath.str() + "\"");
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_filesMutex);
+	m_addedFiles.clear();
+	m_shards = shards;
+	return true;
+}
+
+bool FullTextSearchIndex::save(
+	const FilePath& filePath, const std::string& timestamp, const std::string& codecName) const
+{
+	TRACE();
+
+	if (timestamp.empty() || timestamp.size() >= sizeof(Header::timestamp) ||
+		codecName.size() >= sizeof(Header::codecName))
+	{
+		return false;
+	}
+
+	// the shards are never modified, only replaced, so the ones to write stay valid without lock
+	std::vector<std::shared_ptr<Shard>> shards;
+	{
+		std::lock_guard<std::mutex> lock(m_filesMutex);
+		if (!m_addedFiles.empty())
+		{
+			buildShards();
+		}
+		shards = m_shards;
+	}
+
+	Header header;
+	std::memset(&header, 0, sizeof(Header));
+	std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+	header.indexVersion = s_indexVersion;
+	header.wideCharSize = sizeof(wchar_t);
+	std::strncpy(header.timestamp, timestamp.c_str(), sizeof(header.timestamp) - 1);
+	std::strncpy(header.codecName, codecName.c_str(), sizeof(header.codecName) - 1);
+	header.shardCount = shards.size();
+
+	// write to a temporary file first, so a crash never leaves a partially written index
+	const FilePath tempFilePath(filePath.wstr() + L"_tmp");
+	{
+		std::ofstream fileStream;
+		fileStream.open(tempFilePath.str(), std::ios::binary | std::ios::trunc);
+		fileStream.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		writePadding(fileStream, sizeof(Header));
+
+		for (const std::shared_ptr<Shard>& shard: shards)
+		{
+			ShardHeader shardHeader;
+			shardHeader.fileCount = shard->fileIds.size();
+			shardHeader.textSize = static_cast<uint64_t>(shard->array.getSize());
+			fileStream.write(reinterpret_cast<const char*>(&shardHeader), sizeof(ShardHeader));
+
+			const std::vector<uint64_t> fileIds(shard->fileIds.begin(), shard->fileIds.end());
+			fileStream.write(
+				reinterpret_cast<const char*>(fileIds.data()), fileIds.size() * sizeof(uint64_t));
+			fileStream.write(
+				reinterpret_cast<const char*>(shard->fileOffsets.data()),
+				shard->fileOffsets.size() * sizeof(int32_t));
+			writePadding(fileStream, shard->fileOffsets.size() * sizeof(int32_t));
+
+			const size_t textSize = static_cast<size_t>(shard->array.getSize());
+			fileStream.write(shard->array.getText(), textSize);
+			writePadding(fileStream, textSize);
+			fileStream.write(
+				reinterpret_cast<const char*>(shard->array.getArray()), textSize * sizeof(int32_t));
+			writePadding(fileStream, textSize * sizeof(int32_t));
+		}
+		fileStream.close();
+
+		if (fileStream.fail())
+		{
+			LOG_WARNING("Unable to write fulltext search index \"" + tempFilePath.str() + "\"");
+			FileSystem::remove(tempFilePath);
+			return false;
+		}
+	}
+
+	FileSystem::remove(filePath);
+	try
+	{
+		if (FileSystem::rename(tempFilePath, filePath))
+		{
+			return true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		LOG_WARNING("Unable to replace fulltext search index: " + std::string(e.what()));
+	}
+
+	FileSystem::remove(tempFilePath);
+	return false;
+}
+
+size_t FullTextSearchIndex::getFileByteSize() const
+{
+	std::lock_guard<std::mutex> lock(m_filesMutex);
+	if (!m_addedFiles.empty())
+	{
+		buildShards();
+	}
+
+	size_t byteSize = alignOffset(sizeof(Header));
+	for (const std::shared_ptr<Shard>& shard: m_shards)
+	{
+		const size_t textSize = static_cast<size_t>(shard->array.getSize());
+		byteSize += sizeof(ShardHeader) + shard->fileIds.size() * sizeof(uint64_t) +
+			alignOffset(shard->fileOffsets.size() * sizeof(int32_t)) + alignOffset(textSize) +
+			alignOffset(textSize * sizeof(int32_t));
+	}
+	return byteSize;
+}
+
+std::string FullTextSearchIndex::encodeLowercase(const std::wstring& text)
+{
+	// every character is encoded, so character positions can be counted back from byte offsets
+	std::string utf8;
+	utf8.reserve(text.size());
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		unsigned long c = static_cast<unsigned long>(std::towlower(text[i]));
+		if (sizeof(wchar_t) == 2 && c >= 0xD800 && c < 0xDC00 && i + 1 < text.size() &&
+			text[i + 1] >= 0xDC00 && text[i + 1] < 0xE000)
+		{
+			c = 0x10000 + ((c - 0xD800) << 10) + (text[i + 1] - 0xDC00);
+			i++;
+		}
+		else if ((c >= 0xD800 && c < 0xE000) || c > 0x10FFFF)
+		{
+			c = 0xFFFD;
+		}
+
+		if (c < 0x80)
+		{
+			utf8.push_back(static_cast<char>(c));
+		}
+		else if (c < 0x800)
+		{
+			utf8.push_back(static_cast<char>(0xC0 | (c >> 6)));
+			utf8.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		}
+		else if (c < 0x10000)
+		{
+			utf8.push_back(static_cast<char>(0xE0 | (c >> 12)));
+			utf8.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+			utf8.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		}
+		else
+		{
+			utf8.push_back(static_cast<char>(0xF0 | (c >> 18)));
+			utf8.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+			utf8.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+			utf8.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+		}
+	}
+	return utf8;
+}
+
+int FullTextSearchIndex::getCharacterCount(const char* begin, const char* end)
+{
+	int count = 0;
+	for (const char* it = begin; it != end; it++)
+	{
+		const unsigned char byte = static_cast<unsigned char>(*it);
+		if ((byte & 0xC0) != 0x80)
+		{
+			count++;
+		}
+		// characters outside the BMP take a surrogate pair in 16 bit wide strings
+		if (sizeof(wchar_t) == 2 && byte >= 0xF0)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+void FullTextSearchIndex::addShardFiles(
+	const Shard& shard, const std::set<Id>& skippedFileIds) const
+{
+	const char* text = shard.array.getText();
+	for (size_t i = 0; i < shard.fileIds.size(); i++)
+	{
+		if (skippedFileIds.find(shard.fileIds[i]) == skippedFileIds.end())
+		{
+			m_addedFiles.push_back(
+				{shard.fileIds[i],
+				 std::string(text + shard.fileOffsets[i], text + shard.fileOffsets[i + 1])});
+		}
+	}
+}
+
+void FullTextSearchIndex::buildShards() const
+{
+	TRACE();
+
+	std::vector<std::shared_ptr<Shard>> keptShards;
+	for (const std::shared_ptr<Shard>& shard: m_shards)
+	{
+		if (static_cast<size_t>(shard->array.getSize()) >= m_minimumShardByteSize)
+		{
+			keptShards.push_back(shard);
+			continue;
+		}
+
+		addShardFiles(*shard, {});
+	}
+	m_shards = keptShards;
+
+	size_t totalByteSize = 0;
+	for (const File& file: m_addedFiles)
+	{
+		totalByteSize += file.text.size();
+	}
+
+	// one shard per thread, unless the shards would become too small or too big
+	const size_t threadCount = std::max(1, utility::getIdealThreadCount());
+	size_t shardCount = std::max(threadCount, totalByteSize / m_maximumShardByteSize + 1);
+	shardCount = std::min(shardCount, std::max<size_t>(1, totalByteSize / m_minimumShardByteSize));
+	const size_t targetShardByteSize = totalByteSize / shardCount + 1;
+
+	std::vector<std::vector<File>> shardFiles(1);
+	size_t shardByteSize = 0;
+	for (File& file: m_addedFiles)
+	{
+		if (shardByteSize > 0 &&
+			(shardByteSize >= targetShardByteSize ||
+			 shardByteSize + file.text.size() > m_maximumShardByteSize))
+		{
+			shardFiles.emplace_back();
+			shardByteSize = 0;
+		}
+		shardByteSize += file.text.size();
+		shardFiles.back().push_back(std::move(file));
+	}
+	m_addedFiles.clear();
+
+	std::vector<std::shared_ptr<Shard>> builtShards(shardFiles.size());
+	std::atomic<size_t> nextShardIndex(0);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < std::min(threadCount, shardFiles.size()); i++)
+	{
+		threads.emplace_back([&]() {
+			for (size_t shardIndex = nextShardIndex++; shardIndex < shardFiles.size();
+				 shardIndex = nextShardIndex++)
+			{
+				std::string text;
+				std::vector<Id> fileIds;
+				std::vector<int> fileOffsets;
+				for (File& file: shardFiles[shardIndex])
+				{
+					fileIds.push_back(file.fileId);
+					fileOffsets.push_back(static_cast<int>(text.size()));
+					text += file.text;
+					std::string().swap(file.text);
+				}
+				fileOffsets.push_back(static_cast<int>(text.size()));
+
+				builtShards[shardIndex] = std::make_shared<Shard>(
+					std::move(text), std::move(fileIds), std::move(fileOffsets));
+			}
+		});
+	}
+	for (std::thread& thread: threads)
+	{
+		thread.join();
+	}
+
+	m_shards.insert(m_shards.end(), builtShards.begin(), builtShards.end());
+}
+
+void FullTextSearchIndex::searchShard(
+	const Shard& shard,
+	const std::string& term,
+	std::vector<FullTextSearchResult>& results) const
+{
+	std::vector<int> positions = shard.array.searchForTerm(term);
+	std::sort(positions.begin(), positions.end());
+
+	// map the byte offsets to character offsets within their files in a single pass
+	const char* text = shard.array.getText();
+	size_t fileIndex = 0;
+	int countedOffset = 0;
+	int characterCount = 0;
+	bool fileAdded = false;
+	for (int position: positions)
+	{
+		while (shard.fileOffsets[fileIndex + 1] <= position)
+		{
+			fileIndex++;
+			countedOffset = shard.fileOffsets[fileIndex];
+			characterCount = 0;
+			fileAdded = false;
+		}
+
+		// matches must not continue into the next file
+		if (position + static_cast<int>(term.size()) > shard.fileOffsets[fileIndex + 1])
+		{
+			continue;
+		}
+
+		if (!fileAdded)
+		{
+			results.push_back({shard.fileIds[fileIndex], {}});
+			fileAdded = true;
+		}
+
+		characterCount += getCharacterCount(text + countedOffset, text + position);
+		countedOffset = position;
+		results.back().positions.push_back(characterCount);
+	}
 }
@@ -1,15 +1,18 @@
 #ifndef FULLTEXTSEARCH_INDEX_H
 #define FULLTEXTSEARCH_INDEX_H
 
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <set>
+#include <string>
 #include <vector>
 
+#include "FilePath.h"
 #include "SuffixArray.h"
 #include "types.h"
 
-class StorageAccess;
-
 // contains all fulltextsearch results of one file
 struct FullTextSearchResult
 {
@@ -17,26 +20,111 @@ struct FullTextSearchResult
 	std::vector<int> positions;
 };
 
-struct FullTextSearchFile
-{
-	FullTextSearchFile(Id fileId, SuffixArray array): fileId(fileId), array(array) {};
-	Id fileId;
-	SuffixArray array;
-};
-
+// Searches the lowercased contents of all files through suffix arrays over their concatenated UTF-8
+// text. Files are grouped into shards that are built in parallel, so a search takes a binary search
+// per shard instead of one per file. Added files are indexed on the next search.
 class FullTextSearchIndex
 {
 public:
+	static FilePath getIndexFilePath(const FilePath& indexDbFilePath);
+
+	// Lowercases the text and encodes it as UTF-8, like the texts within the index.
+	static std::string encodeLowercase(const std::wstring& text);
+
+	FullTextSearchIndex(
+		size_t minimumShardByteSize = 16 * 1024 * 1024,
+		size_t maximumShardByteSize = 256 * 1024 * 1024);
+
 	void addFile(Id fileId, const std::wstring& file);
+	void removeFiles(const std::set<Id>& fileIds);
+
+	// Positions are the character offsets of case-insensitive occurrences within each file.
 	std::vector<FullTextSearchResult> searchForTerm(const std::wstring& term) const;
 
+	// Calls the function with the indexed text of every file, for different shards in parallel. The
+	// index is locked meanwhile, so the function must not call back into it.
+	void forEachFileText(
+		std::function<void(Id fileId, const char* begin, const char* end)> func) const;
+
 	size_t fileCount() const;
+	size_t shardCount() const;
 
 	void clear();
 
+	// The index file gets memory mapped on load. It is only accepted if it was saved for the same
+	// database timestamp and text codec, because the lowercased texts depend on both.
+	bool load(const FilePath& filePath, const std::string& timestamp, const std::string& codecName);
+
+	// The index is only locked while the added files are built into shards, writing the shards does
+	// not block searches on other threads.
+	bool save(
+		const FilePath& filePath, const std::string& timestamp, const std::string& codecName) const;
+
+	// Size of the file written by save. Each byte of text takes 5 bytes, 1 for the text and 4 for
+	// its suffix array, so the file is about 5 times the size of the indexed sources.
+	size_t getFileByteSize() const;
+
 private:
+	struct File
+	{
+		Id fileId;
+		std::string text;
+	};
+
+	struct Shard
+	{
+		Shard(std::string text, std::vector<Id> fileIds, std::vector<int> fileOffsets);
+		Shard(
+			const char* text,
+			const int* array,
+			int size,
+			std::vector<Id> fileIds,
+			std::vector<int> fileOffsets,
+			std::shared_ptr<const void> mapping);
+
+		SuffixArray array;
+		std::vector<Id> fileIds;
+
+		// offsets of the files within the text, followed by the text length
+		std::vector<int> fileOffsets;
+	};
+
+	static const uint32_t s_indexVersion;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t indexVersion;
+		uint32_t wideCharSize;
+		char timestamp[32];
+		char codecName[64];
+		uint64_t shardCount;
+	};
+
+	struct ShardHeader
+	{
+		uint64_t fileCount;
+		uint64_t textSize;
+	};
+
+	static int getCharacterCount(const char* begin, const char* end);
+
+	// Adds the files of the shard, except the skipped ones, back to the files to index.
+	void addShardFiles(const Shard& shard, const std::set<Id>& skippedFileIds) const;
+
+	// Moves the files of shards too small to keep back to the added files and builds new shards.
+	void buildShards() const;
+	void searchShard(
+		const Shard& shard,
+		const std::string& term,
+		std::vector<FullTextSearchResult>& results) const;
+
+	const size_t m_minimumShardByteSize;
+	const size_t m_maximumShardByteSize;
+
 	mutable std::mutex m_filesMutex;
-	std::vector<FullTextSearchFile> m_files;
+	mutable std::vector<File> m_addedFiles;
+	mutable std::vector<std::shared_ptr<Shard>> m_shards;
 };
 
 #endif	  // FULLTEXTSEARCH_INDEX_H
@@ -0,0 +1,297 @@
+#include "FullTextSearchQuery.h"
+
+#include <cwctype>
+
+#include <re2/re2.h>
+
+#include "utilityString.h"
+
+namespace
+{
+// Appends the UTF-8 encoding of the line and the index of the character each byte belongs to.
+void encodeLine(const std::wstring& line, std::string& text, std::vector<int>& characterIndices)
+{
+	for (size_t i = 0; i < line.size(); i++)
+	{
+		const size_t characterIndex = i;
+		unsigned long codePoint = static_cast<unsigned long>(line[i]);
+		if (sizeof(wchar_t) == 2 && codePoint >= 0xD800 && codePoint < 0xDC00 &&
+			i + 1 < line.size())
+		{
+			// surrogate pairs of UTF-16 strings
+			const unsigned long low = static_cast<unsigned long>(line[i + 1]);
+			if (low >= 0xDC00 && low < 0xE000)
+			{
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				i++;
+			}
+		}
+
+		const size_t size = text.size();
+		if (codePoint < 0x80)
+		{
+			text.push_back(static_cast<char>(codePoint));
+		}
+		else if (codePoint < 0x800)
+		{
+			text.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+			text.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000)
+		{
+			text.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+			text.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			text.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		else
+		{
+			text.push_back(static_cast<char>(0xF0 | ((codePoint >> 18) & 0x07)));
+			text.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+			text.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			text.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+		}
+		characterIndices.insert(
+			characterIndices.end(), text.size() - size, static_cast<int>(characterIndex));
+	}
+	characterIndices.push_back(static_cast<int>(line.size()));
+}
+}	 // namespace
+
+FullTextSearchQuery::FullTextSearchQuery(const std::wstring& term, bool caseSensitive)
+	: m_mode(MODE_SUBSTRING), m_text(term), m_caseSensitive(caseSensitive)
+{
+	if (term.size() > 2 && term.front() == L'/' && term.back() == L'/')
+	{
+		m_mode = MODE_REGEX;
+		m_text = term.substr(1, term.size() - 2);
+	}
+	else if (term.size() > 2 && term.front() == L'"' && term.back() == L'"')
+	{
+		m_mode = MODE_WHOLE_WORD;
+		m_text = term.substr(1, term.size() - 2);
+	}
+
+	if (m_mode == MODE_SUBSTRING)
+	{
+		return;
+	}
+
+	std::wstring pattern = m_text;
+	if (m_mode == MODE_WHOLE_WORD)
+	{
+		// boundaries only make sense next to word characters, e.g. for "->member"
+		pattern = (isWordCharacter(m_text.front()) ? L"\\b" : L"") + escapeRegex(m_text) +
+			(isWordCharacter(m_text.back()) ? L"\\b" : L"");
+	}
+
+	re2::RE2::Options options;
+	options.set_case_sensitive(m_caseSensitive);
+	options.set_log_errors(false);
+
+	std::shared_ptr<re2::RE2> regex = std::make_shared<re2::RE2>(
+		utility::encodeToUtf8(pattern), options);
+	if (regex->ok())
+	{
+		m_regex = regex;
+	}
+	else
+	{
+		m_error = regex->error();
+	}
+}
+
+FullTextSearchQuery::Mode FullTextSearchQuery::getMode() const
+{
+	return m_mode;
+}
+
+const std::wstring& FullTextSearchQuery::getText() const
+{
+	return m_text;
+}
+
+bool FullTextSearchQuery::isCaseSensitive() const
+{
+	return m_caseSensitive;
+}
+
+bool FullTextSearchQuery::isValid() const
+{
+	return m_error.empty();
+}
+
+const std::string& FullTextSearchQuery::getError() const
+{
+	return m_error;
+}
+
+std::vector<std::wstring> FullTextSearchQuery::getRequiredLiterals() const
+{
+	if (m_mode != MODE_REGEX)
+	{
+		return {m_text};
+	}
+
+	// only literal runs outside of groups are collected, so alternatives and quantifiers within
+	// groups cannot make them optional
+	std::vector<std::wstring> literals;
+	std::wstring literal;
+	auto finishLiteral = [&literals, &literal]() {
+		if (!literal.empty())
+		{
+			literals.push_back(literal);
+			literal.clear();
+		}
+	};
+
+	const std::wstring& pattern = m_text;
+	int depth = 0;
+	for (size_t i = 0; i < pattern.size(); i++)
+	{
+		wchar_t c = pattern[i];
+		bool isLiteral = false;
+
+		switch (c)
+		{
+		case L'\\':
+			if (i + 1 < pattern.size() && !std::iswalnum(pattern[i + 1]))
+			{
+				c = pattern[++i];
+				isLiteral = true;
+			}
+			else
+			{
+				// character classes, assertions and back references
+				i++;
+				finishLiteral();
+			}
+			break;
+		case L'(':
+			depth++;
+			finishLiteral();
+			break;
+		case L')':
+			depth--;
+			finishLiteral();
+			break;
+		case L'|':
+			if (depth == 0)
+			{
+				return {};
+			}
+			break;
+		case L'[':
+			// skips the bracket expression, a leading ']' is part of it
+			i += (i + 1 < pattern.size() && pattern[i + 1] == L'^') ? 2 : 1;
+			if (i < pattern.size() && pattern[i] == L']')
+			{
+				i++;
+			}
+			while (i < pattern.size() && pattern[i] != L']')
+			{
+				i += pattern[i] == L'\\' ? 2 : 1;
+			}
+			finishLiteral();
+			break;
+		case L'{':
+			while (i < pattern.size() && pattern[i] != L'}')
+			{
+				i++;
+			}
+			finishLiteral();
+			break;
+		case L'.':
+		case L'^':
+		case L'$':
+		case L'*':
+		case L'+':
+		case L'?':
+			finishLiteral();
+			break;
+		default:
+			isLiteral = true;
+		}
+
+		if (!isLiteral || depth > 0)
+		{
+			continue;
+		}
+
+		const wchar_t next = i + 1 < pattern.size() ? pattern[i + 1] : L'\0';
+		if (next == L'*' || next == L'?' || next == L'{')
+		{
+			// the character may be missing
+			finishLiteral();
+		}
+		else
+		{
+			literal.push_back(c);
+			if (next == L'+')
+			{
+				finishLiteral();
+			}
+		}
+	}
+	finishLiteral();
+
+	return literals;
+}
+
+std::vector<std::pair<int, int>> FullTextSearchQuery::findMatches(const std::wstring& line) const
+{
+	std::vector<std::pair<int, int>> matches;
+	if (m_mode == MODE_SUBSTRING || !isValid())
+	{
+		return matches;
+	}
+
+	std::string text;
+	std::vector<int> characterIndices;
+	encodeLine(line, text, characterIndices);
+
+	size_t position = 0;
+	re2::StringPiece match;
+	while (position <= text.size() &&
+		   m_regex->Match(text, position, text.size(), re2::RE2::UNANCHORED, &match, 1))
+	{
+		const size_t begin = match.data() - text.data();
+		const size_t end = begin + match.size();
+		if (end > begin)
+		{
+			matches.emplace_back(
+				characterIndices[begin], characterIndices[end] - characterIndices[begin]);
+			position = end;
+		}
+		else
+		{
+			// continues after the character of the empty match
+			position = begin + 1;
+			while (position < text.size() && (text[position] & 0xC0) == 0x80)
+			{
+				position++;
+			}
+		}
+	}
+	return matches;
+}
+
+bool FullTextSearchQuery::isWordCharacter(wchar_t c)
+{
+	return std::iswalnum(c) || c == L'_';
+}
+
+std::wstring FullTextSearchQuery::escapeRegex(const std::wstring& text)
+{
+	static const std::wstring specialCharacters = L"\\^$.|?*+()[]{}";
+
+	std::wstring escaped;
+	for (wchar_t c: text)
+	{
+		if (specialCharacters.find(c) != std::wstring::npos)
+		{
+			escaped.push_back(L'\\');
+		}
+		escaped.push_back(c);
+	}
+	return escaped;
+}
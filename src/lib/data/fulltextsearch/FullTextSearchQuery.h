@@ -0,0 +1,56 @@
+#ifndef FULLTEXTSEARCH_QUERY_H
+#define FULLTEXTSEARCH_QUERY_H
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace re2
+{
+class RE2;
+}
+
+// Interprets a full text search term. Terms enclosed in slashes are regular expressions and terms
+// enclosed in double quotes are searched as whole words, all other terms are plain substrings.
+// Regular expressions are matched by RE2, which takes linear time and constant stack space for
+// every line, but does not support back references and lookarounds.
+class FullTextSearchQuery
+{
+public:
+	enum Mode
+	{
+		MODE_SUBSTRING,
+		MODE_WHOLE_WORD,
+		MODE_REGEX
+	};
+
+	FullTextSearchQuery(const std::wstring& term, bool caseSensitive);
+
+	Mode getMode() const;
+	const std::wstring& getText() const;
+	bool isCaseSensitive() const;
+
+	bool isValid() const;
+	const std::string& getError() const;
+
+	// Returns literal strings that are part of every match, so files missing one of them can be
+	// skipped. A regular expression with alternatives on its top level has none.
+	std::vector<std::wstring> getRequiredLiterals() const;
+
+	// Returns start and length of all non-empty whole word or regex matches within the line.
+	std::vector<std::pair<int, int>> findMatches(const std::wstring& line) const;
+
+private:
+	static bool isWordCharacter(wchar_t c);
+	static std::wstring escapeRegex(const std::wstring& text);
+
+	Mode m_mode;
+	std::wstring m_text;
+	bool m_caseSensitive;
+
+	std::shared_ptr<const re2::RE2> m_regex;
+	std::string m_error;
+};
+
+#endif	  // FULLTEXTSEARCH_QUERY_H
@@ -1,188 +1,261 @@
 #include "SuffixArray.h"
 
 #include <algorithm>
-#include <iostream>
+#include <cstring>
 
-struct suffix
+namespace
 {
-	int index;
-	int rank[2];
-};
+// SA-IS as described by Nong, Zhang and Chan, "Two Efficient Algorithms for Linear Time Suffix
+// Array Construction". The text is terminated by a virtual sentinel smaller than all characters,
+// which is sorted before all suffixes and therefore not part of the array.
 
-int SuffixArray::cmp(const struct suffix& a, const struct suffix& b)
+template <typename CharType>
+void getBuckets(
+	const CharType* text, int n, int alphabetSize, std::vector<int>& buckets, bool bucketEnds)
 {
-	return (a.rank[0] == b.rank[0]) ? (a.rank[1] < b.rank[1] ? 1 : 0)
-									: (a.rank[0] < b.rank[0] ? 1 : 0);
+	std::fill(buckets.begin(), buckets.end(), 0);
+	for (int i = 0; i < n; i++)
+	{
+		buckets[static_cast<int>(text[i])]++;
+	}
+
+	int sum = 0;
+	for (int i = 0; i < alphabetSize; i++)
+	{
+		sum += buckets[i];
+		buckets[i] = bucketEnds ? sum : sum - buckets[i];
+	}
 }
 
-SuffixArray::SuffixArray(const std::wstring& text): m_text(text)
+// position n is the virtual sentinel, an S-type LMS position
+bool isLms(const std::vector<bool>& isSType, int n, int i)
 {
-	std::transform(m_text.begin(), m_text.end(), m_text.begin(), ::towlower);
-	m_array = buildSuffixArray();
-	m_lcp = buildLCP();
+	return i == n || (i > 0 && isSType[i] && !isSType[i - 1]);
 }
 
-void SuffixArray::printArray() const
+template <typename CharType>
+void induceSuffixArray(
+	const CharType* text,
+	int* array,
+	int n,
+	int alphabetSize,
+	const std::vector<bool>& isSType,
+	std::vector<int>& buckets)
 {
-	std::cout << "Suffix Array : \n";
-	printArr(m_array);
-	for (size_t i = 0; i < m_array.size(); i++)
+	// L-type suffixes in ascending order, starting with the suffix in front of the sentinel
+	getBuckets(text, n, alphabetSize, buckets, false);
+	array[buckets[static_cast<int>(text[n - 1])]++] = n - 1;
+	for (int i = 0; i < n; i++)
 	{
-		std::wstring suffix = m_text.substr(m_array[i]);
-		std::wcout << i << ": \"" << suffix << "\"" << std::endl;
+		const int j = array[i] - 1;
+		if (j >= 0 && !isSType[j])
+		{
+			array[buckets[static_cast<int>(text[j])]++] = j;
+		}
 	}
-}
 
-void SuffixArray::printLCP() const
-{
-	std::cout << "\nLCP Array : \n";
-	printArr(m_lcp);
-	for (size_t i = 0; i < m_array.size(); i++)
+	// S-type suffixes in descending order, replacing the LMS suffixes placed before
+	getBuckets(text, n, alphabetSize, buckets, true);
+	for (int i = n - 1; i >= 0; i--)
 	{
-		std::wstring prefix = m_text.substr(m_array[i], m_lcp[i]);
-		std::wcout << i << ": \"" << prefix << "\"" << std::endl;
+		const int j = array[i] - 1;
+		if (j >= 0 && isSType[j])
+		{
+			array[--buckets[static_cast<int>(text[j])]] = j;
+		}
 	}
 }
 
-std::vector<int> SuffixArray::buildLCP()
+template <typename CharType>
+void buildSuffixArray(const CharType* text, int* array, int n, int alphabetSize)
 {
-	const int n = static_cast<int>(m_array.size());
-
-	std::vector<int> lcp(n, 0);
-	std::vector<int> invSuff(n, 0);
+	if (n == 0)
+	{
+		return;
+	}
+	if (n == 1)
+	{
+		array[0] = 0;
+		return;
+	}
 
-	for (int i = 0; i < n; i++)
+	// the last character is L-type, because the sentinel is smaller
+	std::vector<bool> isSType(n, false);
+	for (int i = n - 2; i >= 0; i--)
 	{
-		invSuff[m_array[i]] = i;
+		isSType[i] = text[i] < text[i + 1] || (text[i] == text[i + 1] && isSType[i + 1]);
 	}
 
-	int k = 0;
+	std::vector<int> buckets(alphabetSize);
 
-	for (int i = 0; i < n; i++)
+	// sort the LMS substrings by inducing from the unsorted LMS positions
+	getBuckets(text, n, alphabetSize, buckets, true);
+	std::fill(array, array + n, -1);
+	for (int i = 1; i < n; i++)
 	{
-		if (invSuff[i] == n - 1)
+		if (isLms(isSType, n, i))
 		{
-			k = 0;
-			continue;
+			array[--buckets[static_cast<int>(text[i])]] = i;
 		}
+	}
+	induceSuffixArray(text, array, n, alphabetSize, isSType, buckets);
 
-		int j = m_array[invSuff[i] + 1];
-
-		while (i + k < n && j + k < n && m_text[i + k] == m_text[j + k])
+	// move the sorted LMS substrings to the front
+	int lmsCount = 0;
+	for (int i = 0; i < n; i++)
+	{
+		if (isLms(isSType, n, array[i]))
 		{
-			k++;
+			array[lmsCount++] = array[i];
 		}
+	}
 
-		lcp[invSuff[i]] = k;
+	// name the LMS substrings, equal substrings get the same name
+	std::fill(array + lmsCount, array + n, -1);
+	int nameCount = 0;
+	int previous = -1;
+	for (int i = 0; i < lmsCount; i++)
+	{
+		const int position = array[i];
+		bool isDifferent = previous < 0;
+		for (int d = 0; !isDifferent; d++)
+		{
+			if (position + d == n || previous + d == n ||
+				text[position + d] != text[previous + d] ||
+				isSType[position + d] != isSType[previous + d])
+			{
+				isDifferent = true;
+			}
+			else if (
+				d > 0 && (isLms(isSType, n, position + d) || isLms(isSType, n, previous + d)))
+			{
+				break;
+			}
+		}
 
-		if (k > 0)
+		if (isDifferent)
 		{
-			k--;
+			nameCount++;
+			previous = position;
 		}
+		// LMS positions are at least two apart
+		array[lmsCount + position / 2] = nameCount - 1;
 	}
 
-	return lcp;
-}
-
-std::vector<int> SuffixArray::searchForTerm(const std::wstring& searchTerm) const
-{
-	std::wstring term = searchTerm;
-	std::transform(term.begin(), term.end(), term.begin(), ::towlower);
-
-	const int termLength = static_cast<int>(term.length());
-	const int textLength = static_cast<int>(m_text.length());
-	int l = -1;
-	int r = textLength;
-	int m;
-
-	std::vector<int> matches;
-	int compareResult;
-	while (l + 1 < r)
+	// the reduced text of LMS names in text order at the end of the array
+	int* reducedText = array + n - lmsCount;
+	for (int i = n - 1, j = n - 1; i >= lmsCount; i--)
 	{
-		m = (l + r + 1) / 2;
-		compareResult = term.compare(m_text.substr(m_array[m], termLength));
-		if (compareResult < 0)
+		if (array[i] >= 0)
 		{
-			r = m;
+			array[j--] = array[i];
 		}
-		else if (compareResult > 0)
+	}
+
+	// sort the LMS suffixes by the reduced text, recursing if names are not unique
+	int* reducedArray = array;
+	if (nameCount < lmsCount)
+	{
+		buildSuffixArray(reducedText, reducedArray, lmsCount, nameCount);
+	}
+	else
+	{
+		for (int i = 0; i < lmsCount; i++)
 		{
-			l = m;
+			reducedArray[reducedText[i]] = i;
 		}
-		else
+	}
+
+	// place the sorted LMS suffixes at their bucket ends and induce all other suffixes
+	for (int i = 1, j = 0; i < n; i++)
+	{
+		if (isLms(isSType, n, i))
 		{
-			matches.push_back(m_array[m]);
-			for (int lower = m - 1; lower >= 0 && m_lcp[lower] >= termLength; lower--)
-			{
-				matches.push_back(m_array[lower]);
-			}
-			for (int higher = m + 1; higher < textLength && m_lcp[higher - 1] >= termLength; higher++)
-			{
-				matches.push_back(m_array[higher]);
-			}
-			break;
+			reducedText[j++] = i;
 		}
 	}
+	for (int i = 0; i < lmsCount; i++)
+	{
+		reducedArray[i] = reducedText[reducedArray[i]];
+	}
+	std::fill(array + lmsCount, array + n, -1);
 
-	std::sort(matches.begin(), matches.end());
+	getBuckets(text, n, alphabetSize, buckets, true);
+	for (int i = lmsCount - 1; i >= 0; i--)
+	{
+		const int position = array[i];
+		array[i] = -1;
+		array[--buckets[static_cast<int>(text[position])]] = position;
+	}
+	induceSuffixArray(text, array, n, alphabetSize, isSType, buckets);
+}
+}	 // namespace
 
-	return matches;
+SuffixArray::SuffixArray(std::string text)
+	: m_ownedText(std::move(text))
+	, m_ownedArray(m_ownedText.size())
+	, m_text(m_ownedText.data())
+	, m_array(m_ownedArray.data())
+	, m_size(static_cast<int>(m_ownedText.size()))
+{
+	buildSuffixArray(
+		reinterpret_cast<const unsigned char*>(m_text), m_ownedArray.data(), m_size, 256);
 }
 
-std::vector<int> SuffixArray::buildSuffixArray()
+SuffixArray::SuffixArray(
+	const char* text, const int* array, int size, std::shared_ptr<const void> mapping)
+	: m_mapping(std::move(mapping)), m_text(text), m_array(array), m_size(size)
 {
-	const int n = static_cast<int>(m_text.length());
-	std::vector<suffix> suffixes;
-	suffixes.reserve(n);
+}
 
-	suffix s;
-	for (int i = 0; i < n; i++)
+std::vector<int> SuffixArray::searchForTerm(const std::string& term) const
+{
+	std::vector<int> matches;
+	if (term.empty())
 	{
-		s.index = i;
-		s.rank[0] = m_text[i];
-		s.rank[1] = ((i + 1) < n) ? (m_text[i + 1]) : -1;
-		suffixes.push_back(s);
+		return matches;
 	}
 
-	std::sort(suffixes.begin(), suffixes.end(), SuffixArray::cmp);
+	// all suffixes starting with the term are adjacent
+	const int* arrayEnd = m_array + m_size;
+	const int* begin = std::lower_bound(
+		m_array, arrayEnd, term, [this](int suffixIndex, const std::string& term) {
+			return compareSuffix(suffixIndex, term) < 0;
+		});
+	const int* end = std::upper_bound(
+		begin, arrayEnd, term, [this](const std::string& term, int suffixIndex) {
+			return compareSuffix(suffixIndex, term) > 0;
+		});
 
-	std::vector<int> ind(n, 0);
-	for (int k = 4; k < 2 * n; k = k * 2)
-	{
-		int rank = 0;
-		int prev_rank = suffixes[0].rank[0];
-		suffixes[0].rank[0] = rank;
-		ind[suffixes[0].index] = 0;
+	matches.assign(begin, end);
+	return matches;
+}
 
-		for (int i = 1; i < n; i++)
-		{
-			if (suffixes[i].rank[0] == prev_rank && suffixes[i].rank[1] == suffixes[i - 1].rank[1])
-			{
-				prev_rank = suffixes[i].rank[0];
-				suffixes[i].rank[0] = rank;
-			}
-			else
-			{
-				prev_rank = suffixes[i].rank[0];
-				suffixes[i].rank[0] = ++rank;
-			}
-			ind[suffixes[i].index] = i;
-		}
+const char* SuffixArray::getText() const
+{
+	return m_text;
+}
 
-		for (int i = 0; i < n; i++)
-		{
-			int nextindex = suffixes[i].index + k / 2;
-			suffixes[i].rank[1] = (nextindex < n) ? suffixes[ind[nextindex]].rank[0] : -1;
-		}
+const int* SuffixArray::getArray() const
+{
+	return m_array;
+}
 
-		std::sort(suffixes.begin(), suffixes.end(), cmp);
-	}
+int SuffixArray::getSize() const
+{
+	return m_size;
+}
 
-	std::vector<int> suffixArr;
-	for (int i = 0; i < n; i++)
+int SuffixArray::compareSuffix(int suffixIndex, const std::string& term) const
+{
+	const size_t suffixLength = static_cast<size_t>(m_size - suffixIndex);
+	const size_t length = std::min(suffixLength, term.size());
+
+	const int result = std::memcmp(m_text + suffixIndex, term.data(), length);
+	if (result != 0 || length == term.size())
 	{
-		suffixArr.push_back(suffixes[i].index);
+		return result;
 	}
-
-	return suffixArr;
+	// the suffix is a proper prefix of the term
+	return -1;
 }
@@ -1,36 +1,40 @@
 #ifndef SUFFIX_ARRAY_H
 #define SUFFIX_ARRAY_H
 
-#include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
+// Suffix array over the bytes of a text, built in linear time with SA-IS. Texts are limited to
+// less than 2^31 bytes, so a suffix array takes 5 bytes per byte of text. Text and array are either
+// owned or point into memory mapped from an index file, which the array keeps alive.
 class SuffixArray
 {
 public:
-	SuffixArray(const std::wstring& text);
-	std::vector<int> searchForTerm(const std::wstring& searchTerm) const;
-	static int cmp(const struct suffix& a, const struct suffix& b);
+	explicit SuffixArray(std::string text);
+	SuffixArray(const char* text, const int* array, int size, std::shared_ptr<const void> mapping);
 
-	void printArray() const;
-	void printLCP() const;
+	SuffixArray(const SuffixArray&) = delete;
+	SuffixArray& operator=(const SuffixArray&) = delete;
+
+	// Returns the unsorted start positions of all occurrences of the term.
+	std::vector<int> searchForTerm(const std::string& term) const;
+
+	const char* getText() const;
+	const int* getArray() const;
+	int getSize() const;
 
 private:
-	template <typename T>
-	void printArr(std::vector<T> arr) const
-	{
-		for (size_t i = 0; i < arr.size(); i++)
-		{
-			std::cout << arr[i] << " ";
-		}
-		std::cout << std::endl;
-	}
-
-	std::vector<int> buildLCP();
-	std::vector<int> buildSuffixArray();
-	std::vector<int> m_array;
-	std::vector<int> m_lcp;
-	std::wstring m_text;
+	// Compares the suffix with the term, only up to the length of the term.
+	int compareSuffix(int suffixIndex, const std::string& term) const;
+
+	std::string m_ownedText;
+	std::vector<int> m_ownedArray;
+	std::shared_ptr<const void> m_mapping;
+
+	const char* m_text;
+	const int* m_array;
+	int m_size;
 };
 
 #endif	  // SUFFIX_ARRAY_H
@@ -0,0 +1,177 @@
+#include "TrigramIndex.h"
+
+#include <algorithm>
+
+#include "tracing.h"
+
+TrigramIndex::TrigramIndex(): m_isSorted(true) {}
+
+void TrigramIndex::addFile(Id fileId, const char* begin, const char* end)
+{
+	std::vector<uint32_t> trigrams;
+	if (end - begin >= 3)
+	{
+		trigrams.reserve(end - begin - 2);
+		for (const char* it = begin; it + 3 <= end; it++)
+		{
+			trigrams.push_back(getTrigram(it));
+		}
+		std::sort(trigrams.begin(), trigrams.end());
+		trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (uint32_t trigram: trigrams)
+	{
+		m_postingLists[trigram].push_back(fileId);
+	}
+	m_fileIds.push_back(fileId);
+	m_isSorted = false;
+}
+
+void TrigramIndex::removeFiles(const std::set<Id>& fileIds)
+{
+	TRACE();
+
+	auto isRemoved = [&fileIds](Id fileId) { return fileIds.find(fileId) != fileIds.end(); };
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto it = m_postingLists.begin(); it != m_postingLists.end();)
+	{
+		std::vector<Id>& postingList = it->second;
+		postingList.erase(
+			std::remove_if(postingList.begin(), postingList.end(), isRemoved), postingList.end());
+
+		if (postingList.empty())
+		{
+			it = m_postingLists.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	m_fileIds.erase(std::remove_if(m_fileIds.begin(), m_fileIds.end(), isRemoved), m_fileIds.end());
+}
+
+std::vector<Id> TrigramIndex::getCandidateFileIds(const std::vector<std::string>& literals) const
+{
+	TRACE();
+
+	std::vector<uint32_t> trigrams;
+	for (const std::string& literal: literals)
+	{
+		for (size_t i = 0; i + 3 <= literal.size(); i++)
+		{
+			trigrams.push_back(getTrigram(literal.data() + i));
+		}
+	}
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	sortPostingLists();
+
+	if (trigrams.empty())
+	{
+		return m_fileIds;
+	}
+
+	std::vector<const std::vector<Id>*> postingLists;
+	for (uint32_t trigram: trigrams)
+	{
+		auto it = m_postingLists.find(trigram);
+		if (it == m_postingLists.end())
+		{
+			return {};
+		}
+		postingLists.push_back(&it->second);
+	}
+
+	// intersecting the shortest lists first keeps the intermediate results small
+	std::sort(
+		postingLists.begin(),
+		postingLists.end(),
+		[](const std::vector<Id>* a, const std::vector<Id>* b) { return a->size() < b->size(); });
+
+	std::vector<Id> candidates = *postingLists.front();
+	for (size_t i = 1; i < postingLists.size() && !candidates.empty(); i++)
+	{
+		std::vector<Id> intersection;
+		std::set_intersection(
+			candidates.begin(),
+			candidates.end(),
+			postingLists[i]->begin(),
+			postingLists[i]->end(),
+			std::back_inserter(intersection));
+		candidates.swap(intersection);
+	}
+	return candidates;
+}
+
+size_t TrigramIndex::fileCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_fileIds.size();
+}
+
+size_t TrigramIndex::trigramCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_postingLists.size();
+}
+
+size_t TrigramIndex::postingCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	size_t count = 0;
+	for (const auto& p: m_postingLists)
+	{
+		count += p.second.size();
+	}
+	return count;
+}
+
+size_t TrigramIndex::getByteSize() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// buckets and nodes of the hash map are estimated, as their layout is up to the implementation
+	size_t byteSize = m_postingLists.bucket_count() * sizeof(void*) +
+		m_fileIds.capacity() * sizeof(Id);
+	for (const auto& p: m_postingLists)
+	{
+		byteSize += sizeof(void*) + sizeof(p) + p.second.capacity() * sizeof(Id);
+	}
+	return byteSize;
+}
+
+void TrigramIndex::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_postingLists.clear();
+	m_fileIds.clear();
+	m_isSorted = true;
+}
+
+uint32_t TrigramIndex::getTrigram(const char* text)
+{
+	return (static_cast<uint32_t>(static_cast<unsigned char>(text[0])) << 16) |
+		(static_cast<uint32_t>(static_cast<unsigned char>(text[1])) << 8) |
+		static_cast<uint32_t>(static_cast<unsigned char>(text[2]));
+}
+
+void TrigramIndex::sortPostingLists() const
+{
+	if (m_isSorted)
+	{
+		return;
+	}
+
+	for (auto& p: m_postingLists)
+	{
+		std::sort(p.second.begin(), p.second.end());
+	}
+	std::sort(m_fileIds.begin(), m_fileIds.end());
+	m_isSorted = true;
+}
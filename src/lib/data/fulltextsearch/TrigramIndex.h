@@ -0,0 +1,47 @@
+#ifndef TRIGRAM_INDEX_H
+#define TRIGRAM_INDEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+// Maps every trigram of the lowercased UTF-8 file texts to the sorted ids of the files containing
+// it. Files containing all trigrams of the literals a query requires are candidates for a match,
+// which still have to be verified on the file content.
+class TrigramIndex
+{
+public:
+	TrigramIndex();
+
+	// Can be called from multiple threads at once.
+	void addFile(Id fileId, const char* begin, const char* end);
+	void removeFiles(const std::set<Id>& fileIds);
+
+	// Literals are expected lowercased and UTF-8 encoded. Returns all files if the literals contain
+	// no trigram at all.
+	std::vector<Id> getCandidateFileIds(const std::vector<std::string>& literals) const;
+
+	size_t fileCount() const;
+	size_t trigramCount() const;
+	size_t postingCount() const;
+	size_t getByteSize() const;
+
+	void clear();
+
+private:
+	static uint32_t getTrigram(const char* text);
+
+	void sortPostingLists() const;
+
+	mutable std::mutex m_mutex;
+	mutable std::unordered_map<uint32_t, std::vector<Id>> m_postingLists;
+	mutable std::vector<Id> m_fileIds;
+	mutable bool m_isSorted;
+};
+
+#endif	  // TRIGRAM_INDEX_H
@@ -1,5 +1,7 @@
 #include "CombinedIndexerCommandProvider.h"
 
+#include <algorithm>
+
 #include "logging.h"
 #include "utility.h"
 
@@ -96,3 +98,13 @@ size_t CombinedIndexerCommandProvider::size() const
 	}
 	return size;
 }
+
+size_t CombinedIndexerCommandProvider::getCompilerFlagCount(const FilePath& filePath) const
+{
+	size_t compilerFlagCount = 0;
+	for (const std::shared_ptr<IndexerCommandProvider>& provider: m_providers)
+	{
+		compilerFlagCount = std::max(compilerFlagCount, provider->getCompilerFlagCount(filePath));
+	}
+	return compilerFlagCount;
+}
@@ -0,0 +1,20 @@
+#ifndef HEADER_CLAIM_REGISTRY_H
+#define HEADER_CLAIM_REGISTRY_H
+
+#include <vector>
+
+#include "FilePath.h"
+
+// Headers that finished translation units recorded completely. A header is claimed together with a
+// hash of the preprocessor context it was parsed in, translation units parsing it in the same
+// context can skip recording it again.
+class HeaderClaimRegistry
+{
+public:
+	virtual ~HeaderClaimRegistry() = default;
+
+	virtual bool isHeaderClaimed(const FilePath& filePath, size_t contextHash) = 0;
+	virtual void claimHeaders(const std::vector<FilePath>& filePaths, size_t contextHash) = 0;
+};
+
+#endif	  // HEADER_CLAIM_REGISTRY_H
@@ -24,6 +24,11 @@ private:
 		std::shared_ptr<ParserClientImpl> parserClient,
 		std::shared_ptr<IndexerStateInfo> m_indexerStateInfo) = 0;
 
+	// Called for storages that were indexed without interruption, after files were marked
+	// incomplete.
+	virtual void doFinishIndex(
+		std::shared_ptr<T> indexerCommand, std::shared_ptr<const IntermediateStorage> storage);
+
 	std::shared_ptr<IndexerStateInfo> m_indexerStateInfo;
 };
 
@@ -46,6 +51,12 @@ void Indexer<T>::interrupt()
 	m_indexerStateInfo->indexingInterrupted = true;
 }
 
+template <typename T>
+void Indexer<T>::doFinishIndex(
+	std::shared_ptr<T> indexerCommand, std::shared_ptr<const IntermediateStorage> storage)
+{
+}
+
 template <typename T>
 std::shared_ptr<IntermediateStorage> Indexer<T>::index(std::shared_ptr<IndexerCommand> indexerCommand)
 {
@@ -80,6 +91,8 @@ std::shared_ptr<IntermediateStorage> Indexer<T>::index(std::shared_ptr<IndexerCo
 		return nullptr;
 	}
 
+	doFinishIndex(castCommand, storage);
+
 	return storage;
 }
 
@@ -1,3 +1,7 @@
 #include "IndexerBase.h"
 
 IndexerBase::IndexerBase() {}
+
+void IndexerBase::setHeaderClaimRegistry(std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry)
+{
+}
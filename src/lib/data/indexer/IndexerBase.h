@@ -7,6 +7,7 @@
 #include "IndexerCommandType.h"
 
 class FileRegister;
+class HeaderClaimRegistry;
 class IndexerCommand;
 class IntermediateStorage;
 
@@ -20,6 +21,9 @@ public:
 	virtual std::shared_ptr<IntermediateStorage> index(
 		std::shared_ptr<IndexerCommand> indexerCommand) = 0;
 	virtual void interrupt() = 0;
+
+	// Lets the indexer skip headers other translation units already recorded, ignored by default.
+	virtual void setHeaderClaimRegistry(std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry);
 };
 
 #endif	  // INDEXER_BASE_H
@@ -4,3 +4,8 @@ bool IndexerCommandProvider::empty() const
 {
 	return size() == 0;
 }
+
+size_t IndexerCommandProvider::getCompilerFlagCount(const FilePath& filePath) const
+{
+	return 0;
+}
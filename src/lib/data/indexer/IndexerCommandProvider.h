@@ -18,6 +18,9 @@ public:
 	virtual void clear() = 0;
 	virtual size_t size() const = 0;
 	bool empty() const;
+
+	// Number of compiler flags of the command for the source file, 0 if the command has no flags.
+	virtual size_t getCompilerFlagCount(const FilePath& filePath) const;
 };
 
 #endif	  // INDEXER_COMMAND_PROVIDER_H
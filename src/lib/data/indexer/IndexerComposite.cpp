@@ -37,3 +37,12 @@ void IndexerComposite::interrupt()
 		it.second->interrupt();
 	}
 }
+
+void IndexerComposite::setHeaderClaimRegistry(
+	std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry)
+{
+	for (auto& it: m_indexers)
+	{
+		it.second->setHeaderClaimRegistry(headerClaimRegistry);
+	}
+}
@@ -19,6 +19,8 @@ public:
 
 	void interrupt() override;
 
+	void setHeaderClaimRegistry(std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry) override;
+
 private:
 	std::map<IndexerCommandType, std::shared_ptr<IndexerBase>> m_indexers;
 };
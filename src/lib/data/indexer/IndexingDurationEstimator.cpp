@@ -0,0 +1,108 @@
+#include "IndexingDurationEstimator.h"
+
+#include <algorithm>
+
+#include "FileSystem.h"
+
+IndexingDurationEstimator::IndexingDurationEstimator(
+	const std::vector<StorageIndexingDuration>& recordedDurations)
+{
+	for (const StorageIndexingDuration& recordedDuration: recordedDurations)
+	{
+		if (recordedDuration.duration > 0.0f)
+		{
+			m_recordedDurations[recordedDuration.filePath] = recordedDuration.duration;
+		}
+	}
+}
+
+std::vector<FilePath> IndexingDurationEstimator::orderByEstimatedDuration(
+	const std::vector<FilePath>& sourceFilePaths,
+	std::function<size_t(const FilePath&)> getCompilerFlagCount) const
+{
+	struct Estimate
+	{
+		FilePath filePath;
+		double cost;
+		double duration;
+		bool recorded;
+	};
+
+	std::vector<Estimate> estimates;
+	estimates.reserve(sourceFilePaths.size());
+
+	std::vector<double> durationsPerCost;
+	for (const FilePath& filePath: sourceFilePaths)
+	{
+		Estimate estimate;
+		estimate.filePath = filePath;
+		estimate.cost = getCost(
+			filePath.exists() ? FileSystem::getFileByteSize(filePath) : 1,
+			getCompilerFlagCount ? getCompilerFlagCount(filePath) : 0);
+		estimate.duration = 0.0;
+		estimate.recorded = false;
+
+		auto it = m_recordedDurations.find(filePath.wstr());
+		if (it != m_recordedDurations.end())
+		{
+			estimate.duration = it->second;
+			estimate.recorded = true;
+			durationsPerCost.push_back(estimate.duration / estimate.cost);
+		}
+
+		estimates.push_back(estimate);
+	}
+
+	// the median is not skewed by the few translation units including huge headers
+	double durationPerCost = 1.0;
+	if (!durationsPerCost.empty())
+	{
+		const size_t medianIndex = (durationsPerCost.size() - 1) / 2;
+		std::nth_element(
+			durationsPerCost.begin(),
+			durationsPerCost.begin() + medianIndex,
+			durationsPerCost.end());
+		durationPerCost = durationsPerCost[medianIndex];
+	}
+
+	for (Estimate& estimate: estimates)
+	{
+		if (!estimate.recorded)
+		{
+			estimate.duration = estimate.cost * durationPerCost;
+		}
+	}
+
+	std::sort(estimates.begin(), estimates.end(), [](const Estimate& a, const Estimate& b) {
+		if (a.duration != b.duration)
+		{
+			return a.duration > b.duration;
+		}
+		return a.filePath.wstr() < b.filePath.wstr();
+	});
+
+	std::vector<FilePath> orderedFilePaths;
+	orderedFilePaths.reserve(estimates.size());
+	for (const Estimate& estimate: estimates)
+	{
+		orderedFilePaths.push_back(estimate.filePath);
+	}
+	return orderedFilePaths;
+}
+
+size_t IndexingDurationEstimator::getRecordedFileCount(
+	const std::vector<FilePath>& sourceFilePaths) const
+{
+	return std::count_if(
+		sourceFilePaths.begin(), sourceFilePaths.end(), [this](const FilePath& filePath) {
+			return m_recordedDurations.find(filePath.wstr()) != m_recordedDurations.end();
+		});
+}
+
+double IndexingDurationEstimator::getCost(unsigned long long fileByteSize, size_t compilerFlagCount)
+{
+	// every flag weighs like a small include, most of them are include paths and defines
+	const double compilerFlagByteSize = 512.0;
+	return static_cast<double>(std::max<unsigned long long>(fileByteSize, 1)) +
+		compilerFlagCount * compilerFlagByteSize;
+}
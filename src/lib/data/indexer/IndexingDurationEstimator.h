@@ -0,0 +1,35 @@
+#ifndef INDEXING_DURATION_ESTIMATOR_H
+#define INDEXING_DURATION_ESTIMATOR_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "FilePath.h"
+#include "StorageIndexingDuration.h"
+
+// Estimates how long indexing a source file takes from the durations recorded by earlier runs.
+// Source files without a recorded duration are estimated from their size and compiler flag count,
+// scaled to the durations of the recorded files.
+class IndexingDurationEstimator
+{
+public:
+	explicit IndexingDurationEstimator(
+		const std::vector<StorageIndexingDuration>& recordedDurations);
+
+	// Orders the source files by their estimated indexing duration, longest first, so long running
+	// translation units do not start at the end of indexing while most indexers are idle.
+	std::vector<FilePath> orderByEstimatedDuration(
+		const std::vector<FilePath>& sourceFilePaths,
+		std::function<size_t(const FilePath&)> getCompilerFlagCount) const;
+
+	size_t getRecordedFileCount(const std::vector<FilePath>& sourceFilePaths) const;
+
+private:
+	static double getCost(unsigned long long fileByteSize, size_t compilerFlagCount);
+
+	std::map<std::wstring, float> m_recordedDurations;
+};
+
+#endif	  // INDEXING_DURATION_ESTIMATOR_H
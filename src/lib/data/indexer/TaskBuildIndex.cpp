@@ -24,6 +24,7 @@ TaskBuildIndex::TaskBuildIndex(
 	, m_appUUID(appUUID)
 	, m_multiProcessIndexing(multiProcessIndexing)
 	, m_interprocessIndexingStatusManager(appUUID, 0, true)
+	, m_interprocessHeaderClaimManager(appUUID, 0, true)
 	, m_indexerCommandQueueStopped(false)
 	, m_processCount(processCount)
 	, m_interrupted(false)
@@ -35,6 +36,7 @@ TaskBuildIndex::TaskBuildIndex(
 void TaskBuildIndex::doEnter(std::shared_ptr<Blackboard> blackboard)
 {
 	m_interprocessIndexingStatusManager.setIndexingInterrupted(false);
+	m_interprocessHeaderClaimManager.clearHeaderClaims();
 
 	m_indexingFileCount = 0;
 	updateIndexingDialog(blackboard, std::vector<FilePath>());
@@ -107,8 +109,11 @@ Task::TaskState TaskBuildIndex::doUpdate(std::shared_ptr<Blackboard> blackboard)
 	{
 		updateIndexingDialog(blackboard, std::vector<FilePath>());
 	}
-
-	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	else
+	{
+		// returns as soon as an indexer finished a source file or indexing got interrupted
+		m_interprocessIndexingStatusManager.waitForFinishedProcessOrInterrupt(50);
+	}
 
 	return STATE_RUNNING;
 }
@@ -154,6 +159,9 @@ void TaskBuildIndex::doExit(std::shared_ptr<Blackboard> blackboard)
 		m_storageProvider->insert(storage);
 	}
 
+	blackboard->set(
+		"indexing_durations", m_interprocessIndexingStatusManager.getIndexingDurations());
+
 	blackboard->set<bool>("indexer_threads_stopped", true);
 }
 
@@ -200,12 +208,20 @@ void TaskBuildIndex::runIndexerProcess(int processId, const std::wstring& logFil
 		commandArguments.push_back(L"\"" + logFilePath + L"\"");
 	}
 
+	InterprocessIndexerCommandManager indexerCommandManager(m_appUUID, processId, false);
+
 	int result = 1;
 	while ((!m_indexerCommandQueueStopped || result != 0) && !m_interrupted)
 	{
 		result = utility::executeProcessAndGetExitCode(commandPath, commandArguments, FilePath(), -1);
 
 		LOG_INFO_STREAM(<< "Indexer process " << processId << " returned with " + std::to_string(result));
+
+		if (result == 0 && !m_indexerCommandQueueStopped && !m_interrupted)
+		{
+			// the process returned because the queue ran empty, restart it once it was refilled
+			indexerCommandManager.waitForIndexerCommands(200);
+		}
 	}
 
 	{
@@ -216,15 +232,17 @@ void TaskBuildIndex::runIndexerProcess(int processId, const std::wstring& logFil
 
 void TaskBuildIndex::runIndexerThread(int processId)
 {
+	InterprocessIndexerCommandManager indexerCommandManager(m_appUUID, processId, false);
+
 	do
 	{
 		InterprocessIndexer indexer(m_appUUID, processId);
 		indexer.work();	   // this will only return if there are no indexer commands left in the queue
 		if (!m_interrupted)
 		{
-			// sleeping if interrupted may result in a crash due to objects that are already
+			// waiting if interrupted may result in a crash due to objects that are already
 			// destroyed after waking up again
-			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			indexerCommandManager.waitForIndexerCommands(200);
 		}
 	} while (!m_indexerCommandQueueStopped && !m_interrupted);
 
@@ -243,7 +261,7 @@ bool TaskBuildIndex::fetchIntermediateStorages(std::shared_ptr<Blackboard> black
 	{
 		LOG_INFO_STREAM(<< "waiting, too many storages queued: " << providerStorageCount);
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		m_storageProvider->waitForStorageCountBelow(11, 100);
 
 		return true;
 	}
@@ -268,7 +286,10 @@ bool TaskBuildIndex::fetchIntermediateStorages(std::shared_ptr<Blackboard> black
 		}
 
 		LOG_INFO_STREAM(<< storageManager->getProcessId() << " - storage count: " << storageCount);
-		m_storageProvider->insert(storageManager->popIntermediateStorage());
+		if (std::shared_ptr<IntermediateStorage> storage = storageManager->popIntermediateStorage())
+		{
+			m_storageProvider->insert(storage);
+		}
 		poppedStorageCount++;
 	} while (TimeStamp::now().deltaMS(t) <
 			 500);	  // don't process all storages at once to allow for status updates in-between
@@ -7,6 +7,7 @@
 #include "MessageListener.h"
 #include "Task.h"
 
+#include "InterprocessHeaderClaimManager.h"
 #include "InterprocessIndexerCommandManager.h"
 #include "InterprocessIndexingStatusManager.h"
 #include "InterprocessIntermediateStorageManager.h"
@@ -51,6 +52,7 @@ protected:
 	bool m_multiProcessIndexing;
 
 	InterprocessIndexingStatusManager m_interprocessIndexingStatusManager;
+	InterprocessHeaderClaimManager m_interprocessHeaderClaimManager;
 	bool m_indexerCommandQueueStopped;
 	size_t m_processCount;
 	bool m_interrupted;
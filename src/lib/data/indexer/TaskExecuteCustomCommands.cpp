@@ -261,6 +261,15 @@ void TaskExecuteCustomCommands::doEnter(std::shared_ptr<Blackboard> blackboard)
 	m_dialogView->hideUnknownProgressDialog();
 	m_start = TimeStamp::now();
 
+	// custom indexers write through connections of their own that expect a finished database
+	if (m_storage->isBulkLoading())
+	{
+		m_storage->finishBulkLoad([=](int progress) {
+			m_dialogView->showProgressDialog(L"Indexing", L"Building database indices", progress);
+		});
+		m_dialogView->hideProgressDialog();
+	}
+
 	if (m_indexerCommandProvider)
 	{
 		for (const FilePath& sourceFilePath:
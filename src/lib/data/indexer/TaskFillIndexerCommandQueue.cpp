@@ -4,15 +4,16 @@
 #include "FileSystem.h"
 #include "IndexerCommandProvider.h"
 #include "logging.h"
-#include "utilityFile.h"
 
 TaskFillIndexerCommandsQueue::TaskFillIndexerCommandsQueue(
 	const std::string& appUUID,
 	std::unique_ptr<IndexerCommandProvider> indexerCommandProvider,
-	size_t maximumQueueSize)
+	size_t maximumQueueSize,
+	const std::vector<StorageIndexingDuration>& recordedDurations)
 	: m_indexerCommandProvider(std::move(indexerCommandProvider))
 	, m_indexerCommandManager(appUUID, 0, true)
 	, m_maximumQueueSize(maximumQueueSize)
+	, m_durationEstimator(recordedDurations)
 {
 }
 
@@ -20,8 +21,23 @@ void TaskFillIndexerCommandsQueue::doEnter(std::shared_ptr<Blackboard> blackboar
 {
 	{
 		std::lock_guard<std::mutex> lock(m_commandsMutex);
-		for (const FilePath& filePath:
-			 utility::partitionFilePathsBySize(m_indexerCommandProvider->getAllSourceFilePaths(), 2))
+
+		const std::vector<FilePath> sourceFilePaths =
+			m_indexerCommandProvider->getAllSourceFilePaths();
+		const size_t recordedFileCount = m_durationEstimator.getRecordedFileCount(sourceFilePaths);
+		LOG_INFO(
+			"Ordering " + std::to_string(sourceFilePaths.size()) + " source files by duration, " +
+			std::to_string(recordedFileCount) + " of them with recorded durations.");
+
+		blackboard->set<int>(
+			"scheduled_source_file_count", static_cast<int>(sourceFilePaths.size()));
+		blackboard->set<int>(
+			"recorded_duration_source_file_count", static_cast<int>(recordedFileCount));
+
+		for (const FilePath& filePath: m_durationEstimator.orderByEstimatedDuration(
+				 sourceFilePaths, [this](const FilePath& filePath) {
+					 return m_indexerCommandProvider->getCompilerFlagCount(filePath);
+				 }))
 		{
 			m_filePathQueue.emplace(filePath);
 		}
@@ -41,15 +57,18 @@ Task::TaskState TaskFillIndexerCommandsQueue::doUpdate(std::shared_ptr<Blackboar
 
 	if (!fillCommandQueue())
 	{
-		std::lock_guard<std::mutex> lock(m_commandsMutex);
-
-		if (m_indexerCommandProvider->empty())
 		{
-			return STATE_SUCCESS;
+			std::lock_guard<std::mutex> lock(m_commandsMutex);
+
+			if (m_indexerCommandProvider->empty())
+			{
+				return STATE_SUCCESS;
+			}
 		}
-	}
 
-	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		// refill as soon as the indexers consumed half of the queue
+		m_indexerCommandManager.waitForIndexerCommandCountBelow(m_maximumQueueSize / 2 + 1, 200);
+	}
 
 	return STATE_RUNNING;
 }
@@ -3,6 +3,7 @@
 
 #include <queue>
 
+#include "IndexingDurationEstimator.h"
 #include "MessageIndexingInterrupted.h"
 #include "MessageListener.h"
 #include "Task.h"
@@ -19,7 +20,8 @@ public:
 	TaskFillIndexerCommandsQueue(
 		const std::string& appUUID,
 		std::unique_ptr<IndexerCommandProvider> indexerCommandProvider,
-		size_t maximumQueueSize);
+		size_t maximumQueueSize,
+		const std::vector<StorageIndexingDuration>& recordedDurations = {});
 
 protected:
 	void doEnter(std::shared_ptr<Blackboard> blackboard) override;
@@ -37,6 +39,7 @@ private:
 	InterprocessIndexerCommandManager m_indexerCommandManager;
 
 	const size_t m_maximumQueueSize;
+	const IndexingDurationEstimator m_durationEstimator;
 
 	std::queue<FilePath> m_filePathQueue;
 	std::mutex m_commandsMutex;
@@ -0,0 +1,102 @@
+#include "InterprocessHeaderClaimManager.h"
+
+#include "logging.h"
+#include "utilityString.h"
+
+const char* InterprocessHeaderClaimManager::s_sharedMemoryNamePrefix = "hclm_";
+
+const char* InterprocessHeaderClaimManager::s_headerClaimsKeyName = "header_claims";
+
+InterprocessHeaderClaimManager::InterprocessHeaderClaimManager(
+	const std::string& instanceUuid, Id processId, bool isOwner)
+	: BaseInterprocessDataManager(
+		  s_sharedMemoryNamePrefix + instanceUuid, 1048576 /* 1 MB */, instanceUuid, processId, isOwner)
+{
+}
+
+InterprocessHeaderClaimManager::~InterprocessHeaderClaimManager() {}
+
+bool InterprocessHeaderClaimManager::isHeaderClaimed(const FilePath& filePath, size_t contextHash)
+{
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	SharedMemory::Set<SharedMemory::String>* claimsPtr =
+		access.accessValueWithAllocator<SharedMemory::Set<SharedMemory::String>>(
+			s_headerClaimsKeyName);
+	if (!claimsPtr)
+	{
+		return false;
+	}
+
+	SharedMemory::String key(access.getAllocator());
+	key = getClaimKey(filePath, contextHash).c_str();
+	return claimsPtr->find(key) != claimsPtr->end();
+}
+
+void InterprocessHeaderClaimManager::claimHeaders(
+	const std::vector<FilePath>& filePaths, size_t contextHash)
+{
+	if (filePaths.empty())
+	{
+		return;
+	}
+
+	std::vector<std::string> keys;
+	size_t estimatedSize = 0;
+	for (const FilePath& filePath: filePaths)
+	{
+		keys.push_back(getClaimKey(filePath, contextHash));
+
+		// set nodes are allocated next to their strings
+		estimatedSize += keys.back().size() + sizeof(SharedMemory::String) + 64;
+	}
+
+	const size_t overestimationMultiplier = 2;
+	estimatedSize *= overestimationMultiplier;
+
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	while (access.getFreeMemorySize() < estimatedSize)
+	{
+		LOG_INFO_STREAM(
+			<< "grow memory - est: " << estimatedSize << " size: " << access.getMemorySize()
+			<< " free: " << access.getFreeMemorySize() << " alloc: " << access.getMemorySize());
+		access.growMemory(access.getMemorySize());
+
+		LOG_INFO("growing memory succeeded");
+	}
+
+	SharedMemory::Set<SharedMemory::String>* claimsPtr =
+		access.accessValueWithAllocator<SharedMemory::Set<SharedMemory::String>>(
+			s_headerClaimsKeyName);
+	if (!claimsPtr)
+	{
+		return;
+	}
+
+	for (const std::string& key: keys)
+	{
+		SharedMemory::String keyStr(access.getAllocator());
+		keyStr = key.c_str();
+		claimsPtr->insert(keyStr);
+	}
+}
+
+void InterprocessHeaderClaimManager::clearHeaderClaims()
+{
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	SharedMemory::Set<SharedMemory::String>* claimsPtr =
+		access.accessValueWithAllocator<SharedMemory::Set<SharedMemory::String>>(
+			s_headerClaimsKeyName);
+	if (claimsPtr)
+	{
+		claimsPtr->clear();
+	}
+}
+
+std::string InterprocessHeaderClaimManager::getClaimKey(
+	const FilePath& filePath, size_t contextHash)
+{
+	return std::to_string(contextHash) + ":" + utility::encodeToUtf8(filePath.wstr());
+}
@@ -0,0 +1,28 @@
+#ifndef INTERPROCESS_HEADER_CLAIM_MANAGER_H
+#define INTERPROCESS_HEADER_CLAIM_MANAGER_H
+
+#include "BaseInterprocessDataManager.h"
+#include "HeaderClaimRegistry.h"
+
+// Header claims shared by all indexer processes of an indexing run.
+class InterprocessHeaderClaimManager
+	: public BaseInterprocessDataManager
+	, public HeaderClaimRegistry
+{
+public:
+	InterprocessHeaderClaimManager(const std::string& instanceUuid, Id processId, bool isOwner);
+	virtual ~InterprocessHeaderClaimManager();
+
+	bool isHeaderClaimed(const FilePath& filePath, size_t contextHash) override;
+	void claimHeaders(const std::vector<FilePath>& filePaths, size_t contextHash) override;
+
+	void clearHeaderClaims();
+
+private:
+	static std::string getClaimKey(const FilePath& filePath, size_t contextHash);
+
+	static const char* s_sharedMemoryNamePrefix;
+	static const char* s_headerClaimsKeyName;
+};
+
+#endif	  // INTERPROCESS_HEADER_CLAIM_MANAGER_H
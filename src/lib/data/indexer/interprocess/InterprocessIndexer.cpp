@@ -1,16 +1,23 @@
 #include "InterprocessIndexer.h"
 
+#include <algorithm>
+
+#include "ApplicationSettings.h"
 #include "FileRegister.h"
 #include "IndexerCommand.h"
 #include "IndexerComposite.h"
+#include "IntermediateStorage.h"
 #include "LanguagePackageManager.h"
 #include "ScopedFunctor.h"
+#include "TimeStamp.h"
 #include "logging.h"
 
 InterprocessIndexer::InterprocessIndexer(const std::string& uuid, Id processId)
 	: m_interprocessIndexerCommandManager(uuid, processId, false)
 	, m_interprocessIndexingStatusManager(uuid, processId, false)
 	, m_interprocessIntermediateStorageManager(uuid, processId, false)
+	, m_interprocessHeaderClaimManager(
+		  std::make_shared<InterprocessHeaderClaimManager>(uuid, processId, false))
 	, m_uuid(uuid)
 	, m_processId(processId)
 {
@@ -26,13 +33,15 @@ void InterprocessIndexer::work()
 	{
 		LOG_INFO_STREAM(<< m_processId << " starting up indexer");
 		indexer = LanguagePackageManager::getInstance()->instantiateSupportedIndexers();
+		if (ApplicationSettings::getInstance()->getCxxHeaderClaimingEnabled())
+		{
+			indexer->setHeaderClaimRegistry(m_interprocessHeaderClaimManager);
+		}
 
 		updaterThread = std::make_shared<std::thread>([&]() {
 			while (updaterThreadRunning)
 			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-
-				if (m_interprocessIndexingStatusManager.getIndexingInterrupted())
+				if (m_interprocessIndexingStatusManager.waitForIndexingInterrupted(1000))
 				{
 					LOG_INFO_STREAM(<< m_processId << " received indexer interrupt command.");
 					if (indexer)
@@ -48,6 +57,7 @@ void InterprocessIndexer::work()
 			updaterThreadRunning = false;
 			if (updaterThread)
 			{
+				m_interprocessIndexingStatusManager.notifyStatusChange();
 				updaterThread->join();
 				updaterThread.reset();
 			}
@@ -63,18 +73,11 @@ void InterprocessIndexer::work()
 				<< m_processId << " indexer commands left: "
 				<< m_interprocessIndexerCommandManager.indexerCommandCount());
 
-			while (updaterThreadRunning)
+			while (updaterThreadRunning &&
+				   !m_interprocessIntermediateStorageManager.waitForIntermediateStorageCountBelow(
+					   2, 200))
 			{
-				const size_t storageCount =
-					m_interprocessIntermediateStorageManager.getIntermediateStorageCount();
-				if (storageCount < 2)
-				{
-					break;
-				}
-
-				LOG_INFO_STREAM(<< m_processId << " waits, too many intermediate storages: " << storageCount);
-
-				std::this_thread::sleep_for(std::chrono::milliseconds(200));
+				LOG_INFO_STREAM(<< m_processId << " waits, too many intermediate storages");
 			}
 
 			if (!updaterThreadRunning)
@@ -87,16 +90,25 @@ void InterprocessIndexer::work()
 				indexerCommand->getSourceFilePath());
 
 			LOG_INFO_STREAM(<< m_processId << " starting to index current file");
+			const TimeStamp indexingStart = TimeStamp::now();
 			std::shared_ptr<IntermediateStorage> result = indexer->index(indexerCommand);
+			const float indexingDuration = static_cast<float>(
+				TimeStamp::durationSeconds(indexingStart));
 
+			int includedFileCount = 0;
 			if (result)
 			{
+				// the source file itself is one of the recorded files
+				includedFileCount = std::max<int>(
+					0, static_cast<int>(result->getStorageFiles().size()) - 1);
+
 				LOG_INFO_STREAM(<< m_processId << " pushing index to shared memory");
 				m_interprocessIntermediateStorageManager.pushIntermediateStorage(result);
 			}
 
 			LOG_INFO_STREAM(<< m_processId << " finalizing indexer status for current file");
-			m_interprocessIndexingStatusManager.finishIndexingSourceFile();
+			m_interprocessIndexingStatusManager.finishIndexingSourceFile(
+				indexingDuration, includedFileCount);
 
 			LOG_INFO_STREAM(<< m_processId << " all done");
 		}
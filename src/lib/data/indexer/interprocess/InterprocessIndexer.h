@@ -1,6 +1,7 @@
 #ifndef INTERPROCESS_INDEXER_H
 #define INTERPROCESS_INDEXER_H
 
+#include "InterprocessHeaderClaimManager.h"
 #include "InterprocessIndexerCommandManager.h"
 #include "InterprocessIndexingStatusManager.h"
 #include "InterprocessIntermediateStorageManager.h"
@@ -16,6 +17,7 @@ private:
 	InterprocessIndexerCommandManager m_interprocessIndexerCommandManager;
 	InterprocessIndexingStatusManager m_interprocessIndexingStatusManager;
 	InterprocessIntermediateStorageManager m_interprocessIntermediateStorageManager;
+	std::shared_ptr<InterprocessHeaderClaimManager> m_interprocessHeaderClaimManager;
 
 	const std::string m_uuid;
 	const Id m_processId;
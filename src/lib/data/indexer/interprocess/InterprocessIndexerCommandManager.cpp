@@ -7,6 +7,8 @@ const char* InterprocessIndexerCommandManager::s_sharedMemoryNamePrefix = "icmd_
 
 const char* InterprocessIndexerCommandManager::s_indexerCommandsKeyName = "indexer_commands";
 
+const char* InterprocessIndexerCommandManager::s_indexingContextKeyName = "indexing_context";
+
 InterprocessIndexerCommandManager::InterprocessIndexerCommandManager(
 	const std::string& instanceUuid, Id processId, bool isOwner)
 	: BaseInterprocessDataManager(
@@ -19,44 +21,47 @@ InterprocessIndexerCommandManager::~InterprocessIndexerCommandManager() {}
 void InterprocessIndexerCommandManager::pushIndexerCommands(
 	const std::vector<std::shared_ptr<IndexerCommand>>& indexerCommands)
 {
-	size_t size = 0;
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	for (auto& command: indexerCommands)
 	{
+		// overestimates commands that share lists of the indexing context with previous ones
 		const size_t overestimationMultiplier = 2;
-		for (auto& command: indexerCommands)
+		const size_t size = overestimationMultiplier *
+			(command->getByteSize(sizeof(SharedMemory::String)) + sizeof(SharedIndexerCommand) +
+			 4 * sizeof(SharedIndexingContext::StringList));
+
+		while (access.getFreeMemorySize() < size)
 		{
-			size += command->getByteSize(sizeof(SharedMemory::String)) + sizeof(SharedIndexerCommand);
-		}
-		size *= overestimationMultiplier;
-	}
+			size_t currentSize = access.getMemorySize();
+			LOG_INFO_STREAM(
+				<< "grow memory - est: " << size << " size: " << currentSize
+				<< " free: " << access.getFreeMemorySize() << " alloc: " << (currentSize));
 
-	SharedMemory::ScopedAccess access(&m_sharedMemory);
-	while (access.getFreeMemorySize() < size)
-	{
-		size_t currentSize = access.getMemorySize();
-		LOG_INFO_STREAM(
-			<< "grow memory - est: " << size << " size: " << currentSize
-			<< " free: " << access.getFreeMemorySize() << " alloc: " << (currentSize));
+			access.growMemory(currentSize);
 
-		access.growMemory(currentSize);
+			LOG_INFO("growing memory succeeded");
+		}
 
-		LOG_INFO("growing memory succeeded");
-	}
+		SharedMemory::Queue<SharedIndexerCommand>* queue =
+			access.accessValueWithAllocator<SharedMemory::Queue<SharedIndexerCommand>>(
+				s_indexerCommandsKeyName);
+		SharedIndexingContext::StringLists* stringLists =
+			access.accessValueWithAllocator<SharedIndexingContext::StringLists>(
+				s_indexingContextKeyName);
+		if (!queue || !stringLists)
+		{
+			return;
+		}
 
-	SharedMemory::Queue<SharedIndexerCommand>* queue =
-		access.accessValueWithAllocator<SharedMemory::Queue<SharedIndexerCommand>>(
-			s_indexerCommandsKeyName);
-	if (!queue)
-	{
-		return;
-	}
+		m_indexingContext.setStringLists(stringLists);
 
-	for (auto& command: indexerCommands)
-	{
 		queue->push_back(SharedIndexerCommand(access.getAllocator()));
 		SharedIndexerCommand& sharedCommand = queue->back();
-		sharedCommand.fromLocal(command.get());
+		sharedCommand.fromLocal(command.get(), &m_indexingContext);
 	}
 
+	access.notifyAll();
 	LOG_INFO(access.logString());
 }
 
@@ -67,14 +72,22 @@ std::shared_ptr<IndexerCommand> InterprocessIndexerCommandManager::popIndexerCom
 	SharedMemory::Queue<SharedIndexerCommand>* queue =
 		access.accessValueWithAllocator<SharedMemory::Queue<SharedIndexerCommand>>(
 			s_indexerCommandsKeyName);
-	if (!queue || !queue->size())
+	SharedIndexingContext::StringLists* stringLists =
+		access.accessValueWithAllocator<SharedIndexingContext::StringLists>(
+			s_indexingContextKeyName);
+	if (!queue || !queue->size() || !stringLists)
 	{
 		return nullptr;
 	}
 
-	std::shared_ptr<IndexerCommand> command = SharedIndexerCommand::fromShared(queue->front());
+	m_indexingContext.setStringLists(stringLists);
 
+	std::shared_ptr<IndexerCommand> command =
+		SharedIndexerCommand::fromShared(queue->front(), &m_indexingContext);
+
+	queue->front().releaseContext(&m_indexingContext);
 	queue->pop_front();
+	access.notifyAll();
 
 	return command;
 }
@@ -86,12 +99,20 @@ void InterprocessIndexerCommandManager::clearIndexerCommands()
 	SharedMemory::Queue<SharedIndexerCommand>* queue =
 		access.accessValueWithAllocator<SharedMemory::Queue<SharedIndexerCommand>>(
 			s_indexerCommandsKeyName);
-	if (!queue)
+	SharedIndexingContext::StringLists* stringLists =
+		access.accessValueWithAllocator<SharedIndexingContext::StringLists>(
+			s_indexingContextKeyName);
+	if (!queue || !stringLists)
 	{
 		return;
 	}
 
 	queue->clear();
+
+	m_indexingContext.setStringLists(stringLists);
+	m_indexingContext.clear();
+
+	access.notifyAll();
 }
 
 size_t InterprocessIndexerCommandManager::indexerCommandCount()
@@ -108,3 +129,42 @@ size_t InterprocessIndexerCommandManager::indexerCommandCount()
 
 	return queue->size();
 }
+
+bool InterprocessIndexerCommandManager::waitForIndexerCommands(size_t timeoutMs)
+{
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	SharedMemory::Queue<SharedIndexerCommand>* queue =
+		access.accessValueWithAllocator<SharedMemory::Queue<SharedIndexerCommand>>(
+			s_indexerCommandsKeyName);
+	if (queue && queue->size())
+	{
+		return true;
+	}
+
+	access.waitForNotification(timeoutMs);
+
+	queue = access.accessValueWithAllocator<SharedMemory::Queue<SharedIndexerCommand>>(
+		s_indexerCommandsKeyName);
+	return queue && queue->size();
+}
+
+bool InterprocessIndexerCommandManager::waitForIndexerCommandCountBelow(
+	size_t count, size_t timeoutMs)
+{
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	SharedMemory::Queue<SharedIndexerCommand>* queue =
+		access.accessValueWithAllocator<SharedMemory::Queue<SharedIndexerCommand>>(
+			s_indexerCommandsKeyName);
+	if (!queue || queue->size() < count)
+	{
+		return true;
+	}
+
+	access.waitForNotification(timeoutMs);
+
+	queue = access.accessValueWithAllocator<SharedMemory::Queue<SharedIndexerCommand>>(
+		s_indexerCommandsKeyName);
+	return !queue || queue->size() < count;
+}
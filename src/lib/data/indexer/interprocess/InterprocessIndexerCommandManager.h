@@ -3,6 +3,7 @@
 
 #include "BaseInterprocessDataManager.h"
 #include "SharedIndexerCommand.h"
+#include "SharedIndexingContext.h"
 
 class IndexerCommand;
 
@@ -18,9 +19,17 @@ public:
 	void clearIndexerCommands();
 	size_t indexerCommandCount();
 
+	// Wait at most timeoutMs for commands to be pushed or popped, return whether the queue holds
+	// commands or fewer than count commands respectively.
+	bool waitForIndexerCommands(size_t timeoutMs);
+	bool waitForIndexerCommandCountBelow(size_t count, size_t timeoutMs);
+
 private:
 	static const char* s_sharedMemoryNamePrefix;
 	static const char* s_indexerCommandsKeyName;
+	static const char* s_indexingContextKeyName;
+
+	SharedIndexingContext m_indexingContext;
 };
 
 #endif	  // INTERPROCESS_INDEXER_COMMAND_MANAGER_H
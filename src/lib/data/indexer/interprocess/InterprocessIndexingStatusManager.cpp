@@ -11,6 +11,7 @@ const char* InterprocessIndexingStatusManager::s_crashedFilesKeyName = "crashed_
 const char* InterprocessIndexingStatusManager::s_finishedProcessIdsKeyName = "finished_process_ids";
 const char* InterprocessIndexingStatusManager::s_indexingInterruptedKeyName =
 	"indexing_interrupted_flag";
+const char* InterprocessIndexingStatusManager::s_indexingDurationsKeyName = "indexing_durations";
 
 InterprocessIndexingStatusManager::InterprocessIndexingStatusManager(
 	const std::string& instanceUuid, Id processId, bool isOwner)
@@ -87,7 +88,8 @@ void InterprocessIndexingStatusManager::startIndexingSourceFile(const FilePath&
 	}
 }
 
-void InterprocessIndexingStatusManager::finishIndexingSourceFile()
+void InterprocessIndexingStatusManager::finishIndexingSourceFile(
+	float duration, int includedFileCount)
 {
 	SharedMemory::ScopedAccess access(&m_sharedMemory);
 
@@ -95,6 +97,45 @@ void InterprocessIndexingStatusManager::finishIndexingSourceFile()
 		access.accessValueWithAllocator<SharedMemory::Map<Id, SharedMemory::String>>(
 			s_currentFilesKeyName);
 	if (currentFilesPtr)
+	{
+		SharedMemory::Map<Id, SharedMemory::String>::iterator it = currentFilesPtr->find(
+			getProcessId());
+		if (it != currentFilesPtr->end())
+		{
+			const std::string filePath = it->second.c_str();
+
+			const size_t overestimationMultiplier = 3;
+			size_t estimatedSize = 256 + sizeof(SharedMemory::String) + filePath.size();
+			estimatedSize *= overestimationMultiplier;
+
+			while (access.getFreeMemorySize() < estimatedSize)
+			{
+				LOG_INFO_STREAM(
+					<< "grow memory - est: " << estimatedSize << " size: " << access.getMemorySize()
+					<< " free: " << access.getFreeMemorySize()
+					<< " alloc: " << (access.getMemorySize()));
+				access.growMemory(access.getMemorySize());
+
+				LOG_INFO("growing memory succeeded");
+			}
+
+			using DurationMap = SharedMemory::Map<SharedMemory::String, std::pair<float, int>>;
+			DurationMap* indexingDurationsPtr = access.accessValueWithAllocator<DurationMap>(
+				s_indexingDurationsKeyName);
+			if (indexingDurationsPtr)
+			{
+				SharedMemory::String str(access.getAllocator());
+				str = filePath.c_str();
+
+				(*indexingDurationsPtr)[str] = std::make_pair(duration, includedFileCount);
+			}
+
+			currentFilesPtr =
+				access.accessValueWithAllocator<SharedMemory::Map<Id, SharedMemory::String>>(
+					s_currentFilesKeyName);
+		}
+	}
+	if (currentFilesPtr)
 	{
 		currentFilesPtr->erase(currentFilesPtr->find(getProcessId()), currentFilesPtr->end());
 	}
@@ -105,6 +146,8 @@ void InterprocessIndexingStatusManager::finishIndexingSourceFile()
 	{
 		finishedProcessIdsPtr->push_back(m_processId);
 	}
+
+	access.notifyAll();
 }
 
 void InterprocessIndexingStatusManager::setIndexingInterrupted(bool interrupted)
@@ -116,6 +159,8 @@ void InterprocessIndexingStatusManager::setIndexingInterrupted(bool interrupted)
 	{
 		*indexingInterruptedPtr = interrupted;
 	}
+
+	access.notifyAll();
 }
 
 bool InterprocessIndexingStatusManager::getIndexingInterrupted()
@@ -131,6 +176,22 @@ bool InterprocessIndexingStatusManager::getIndexingInterrupted()
 	return false;
 }
 
+bool InterprocessIndexingStatusManager::waitForIndexingInterrupted(size_t timeoutMs)
+{
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	bool* indexingInterruptedPtr = access.accessValue<bool>(s_indexingInterruptedKeyName);
+	if (!indexingInterruptedPtr || *indexingInterruptedPtr)
+	{
+		return indexingInterruptedPtr != nullptr;
+	}
+
+	access.waitForNotification(timeoutMs);
+
+	indexingInterruptedPtr = access.accessValue<bool>(s_indexingInterruptedKeyName);
+	return indexingInterruptedPtr && *indexingInterruptedPtr;
+}
+
 Id InterprocessIndexingStatusManager::getNextFinishedProcessId()
 {
 	SharedMemory::ScopedAccess access(&m_sharedMemory);
@@ -147,6 +208,34 @@ Id InterprocessIndexingStatusManager::getNextFinishedProcessId()
 	return 0;
 }
 
+bool InterprocessIndexingStatusManager::waitForFinishedProcessOrInterrupt(size_t timeoutMs)
+{
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	auto isPending = [&]() {
+		SharedMemory::Queue<Id>* finishedProcessIdsPtr =
+			access.accessValueWithAllocator<SharedMemory::Queue<Id>>(s_finishedProcessIdsKeyName);
+		bool* indexingInterruptedPtr = access.accessValue<bool>(s_indexingInterruptedKeyName);
+		return (finishedProcessIdsPtr && finishedProcessIdsPtr->size()) ||
+			(indexingInterruptedPtr && *indexingInterruptedPtr);
+	};
+
+	if (isPending())
+	{
+		return true;
+	}
+
+	access.waitForNotification(timeoutMs);
+
+	return isPending();
+}
+
+void InterprocessIndexingStatusManager::notifyStatusChange()
+{
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+	access.notifyAll();
+}
+
 std::vector<FilePath> InterprocessIndexingStatusManager::getCurrentlyIndexedSourceFilePaths()
 {
 	SharedMemory::ScopedAccess access(&m_sharedMemory);
@@ -202,3 +291,25 @@ std::vector<FilePath> InterprocessIndexingStatusManager::getCrashedSourceFilePat
 
 	return crashedFiles;
 }
+
+std::vector<StorageIndexingDuration> InterprocessIndexingStatusManager::getIndexingDurations()
+{
+	std::vector<StorageIndexingDuration> indexingDurations;
+
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	using DurationMap = SharedMemory::Map<SharedMemory::String, std::pair<float, int>>;
+	DurationMap* indexingDurationsPtr = access.accessValueWithAllocator<DurationMap>(
+		s_indexingDurationsKeyName);
+	if (indexingDurationsPtr)
+	{
+		for (const auto& p: *indexingDurationsPtr)
+		{
+			indexingDurations.emplace_back(
+				utility::decodeFromUtf8(p.first.c_str()), p.second.first, p.second.second);
+		}
+		indexingDurationsPtr->clear();
+	}
+
+	return indexingDurations;
+}
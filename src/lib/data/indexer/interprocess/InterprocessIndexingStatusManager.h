@@ -5,6 +5,7 @@
 
 #include "BaseInterprocessDataManager.h"
 #include "FilePath.h"
+#include "StorageIndexingDuration.h"
 
 class InterprocessIndexingStatusManager: public BaseInterprocessDataManager
 {
@@ -13,16 +14,31 @@ public:
 	virtual ~InterprocessIndexingStatusManager();
 
 	void startIndexingSourceFile(const FilePath& filePath);
-	void finishIndexingSourceFile();
+	// Records the wall time spent on the currently indexed source file and the number of files it
+	// included.
+	void finishIndexingSourceFile(float duration, int includedFileCount);
 
 	void setIndexingInterrupted(bool interrupted);
 	bool getIndexingInterrupted();
 
+	// Waits at most timeoutMs for the interrupt, returns whether indexing was interrupted.
+	bool waitForIndexingInterrupted(size_t timeoutMs);
+
 	Id getNextFinishedProcessId();
 
+	// Waits at most timeoutMs for a finished source file or the interrupt, returns whether one of
+	// them is pending.
+	bool waitForFinishedProcessOrInterrupt(size_t timeoutMs);
+
+	// Wakes up all threads of all processes currently waiting for a status change.
+	void notifyStatusChange();
+
 	std::vector<FilePath> getCurrentlyIndexedSourceFilePaths();
 	std::vector<FilePath> getCrashedSourceFilePaths();
 
+	// Returns and removes the indexing durations recorded since the last call.
+	std::vector<StorageIndexingDuration> getIndexingDurations();
+
 private:
 	static const char* s_sharedMemoryNamePrefix;
 
@@ -31,6 +47,7 @@ private:
 	static const char* s_crashedFilesKeyName;
 	static const char* s_finishedProcessIdsKeyName;
 	static const char* s_indexingInterruptedKeyName;
+	static const char* s_indexingDurationsKeyName;
 };
 
 #endif	  // INTERPROCESS_INDEXING_STATUS_MANAGER_H
@@ -1,7 +1,7 @@
 #include "InterprocessIntermediateStorageManager.h"
 
+#include "FlatIntermediateStorage.h"
 #include "IntermediateStorage.h"
-#include "SharedIntermediateStorage.h"
 #include "logging.h"
 
 const char* InterprocessIntermediateStorageManager::s_sharedMemoryNamePrefix = "iist_";
@@ -26,56 +26,52 @@ void InterprocessIntermediateStorageManager::pushIntermediateStorage(
 {
 	const size_t requiredInsertsToShrink = 10;
 
-	const size_t overestimationMultiplier = 2;
-	const size_t requiredSize = (intermediateStorage->getByteSize(sizeof(SharedMemory::String)) +
-								 sizeof(SharedIntermediateStorage)) *
-			overestimationMultiplier +
-		1048576 /* 1 MB */;
+	// the size of the encoding is exact, only the bookkeeping of the allocator and the queue needs
+	// some extra memory
+	const size_t allocationOverhead = 65536 /* 64 kB */;
+
+	const FlatIntermediateStorage flatStorage(*intermediateStorage);
+	const size_t requiredSize = flatStorage.getSize() + allocationOverhead;
 
 	SharedMemory::ScopedAccess access(&m_sharedMemory);
 
 	const size_t freeMemory = access.getFreeMemorySize();
 	if (freeMemory < requiredSize)
 	{
-		const size_t requiredGrowth = requiredSize - freeMemory;
-
-		LOG_INFO_STREAM(
-			<< "grow memory - est: " << requiredSize << " size: " << access.getMemorySize()
-			<< " free: " << access.getFreeMemorySize() << " alloc: " << requiredGrowth);
-
-		access.growMemory(requiredGrowth);
-
-		LOG_INFO("growing memory succeeded");
-
-		m_insertsWithoutGrowth = 0;
+		growMemory(&access, requiredSize - freeMemory);
 	}
 	else
 	{
 		m_insertsWithoutGrowth++;
 	}
 
-	SharedMemory::Queue<SharedIntermediateStorage>* queue =
-		access.accessValueWithAllocator<SharedMemory::Queue<SharedIntermediateStorage>>(
+	SharedMemory::Queue<SharedMemory::String>* queue =
+		access.accessValueWithAllocator<SharedMemory::Queue<SharedMemory::String>>(
 			s_intermediatStoragesKeyName);
 	if (!queue)
 	{
 		return;
 	}
 
-	queue->push_back(SharedIntermediateStorage(access.getAllocator()));
-	SharedIntermediateStorage& storage = queue->back();
-
-	storage.setStorageNodes(intermediateStorage->getStorageNodes());
-	storage.setStorageFiles(intermediateStorage->getStorageFiles());
-	storage.setStorageSymbols(intermediateStorage->getStorageSymbols());
-	storage.setStorageEdges(intermediateStorage->getStorageEdges());
-	storage.setStorageLocalSymbols(intermediateStorage->getStorageLocalSymbols());
-	storage.setStorageSourceLocations(intermediateStorage->getStorageSourceLocations());
-	storage.setStorageOccurrences(intermediateStorage->getStorageOccurrences());
-	storage.setStorageComponentAccesses(intermediateStorage->getComponentAccesses());
-	storage.setStorageErrors(intermediateStorage->getErrors());
+	// the storage is encoded once, directly into the shared memory, filling the string first would
+	// take longer than encoding
+	queue->push_back(SharedMemory::String(access.getAllocator()));
+	try
+	{
+		queue->back().resize(flatStorage.getSize(), boost::container::default_init);
+	}
+	catch (boost::interprocess::bad_alloc&)
+	{
+		// the free memory is fragmented, growing by the whole size leaves a large enough block
+		queue->pop_back();
+		growMemory(&access, requiredSize);
 
-	storage.setNextId(intermediateStorage->getNextId());
+		queue = access.accessValueWithAllocator<SharedMemory::Queue<SharedMemory::String>>(
+			s_intermediatStoragesKeyName);
+		queue->push_back(SharedMemory::String(access.getAllocator()));
+		queue->back().resize(flatStorage.getSize(), boost::container::default_init);
+	}
+	flatStorage.encode(&queue->back()[0]);
 
 	if (m_insertsWithoutGrowth >= requiredInsertsToShrink)
 	{
@@ -95,31 +91,23 @@ std::shared_ptr<IntermediateStorage> InterprocessIntermediateStorageManager::pop
 {
 	SharedMemory::ScopedAccess access(&m_sharedMemory);
 
-	SharedMemory::Queue<SharedIntermediateStorage>* queue =
-		access.accessValueWithAllocator<SharedMemory::Queue<SharedIntermediateStorage>>(
+	SharedMemory::Queue<SharedMemory::String>* queue =
+		access.accessValueWithAllocator<SharedMemory::Queue<SharedMemory::String>>(
 			s_intermediatStoragesKeyName);
 	if (!queue || !queue->size())
 	{
 		return nullptr;
 	}
 
-	SharedIntermediateStorage& sharedIntermediateStorage = queue->front();
-
-	std::shared_ptr<IntermediateStorage> storage = std::make_shared<IntermediateStorage>();
-
-	storage->setStorageNodes(sharedIntermediateStorage.getStorageNodes());
-	storage->setStorageFiles(sharedIntermediateStorage.getStorageFiles());
-	storage->setStorageSymbols(sharedIntermediateStorage.getStorageSymbols());
-	storage->setStorageEdges(sharedIntermediateStorage.getStorageEdges());
-	storage->setStorageLocalSymbols(sharedIntermediateStorage.getStorageLocalSymbols());
-	storage->setStorageSourceLocations(sharedIntermediateStorage.getStorageSourceLocations());
-	storage->setStorageOccurrences(sharedIntermediateStorage.getStorageOccurrences());
-	storage->setComponentAccesses(sharedIntermediateStorage.getStorageComponentAccesses());
-	storage->setErrors(sharedIntermediateStorage.getStorageErrors());
-
-	storage->setNextId(sharedIntermediateStorage.getNextId());
+	std::shared_ptr<IntermediateStorage> storage = FlatIntermediateStorage::decode(
+		queue->front().data(), queue->front().size());
+	if (!storage)
+	{
+		LOG_ERROR("Intermediate storage in shared memory could not be decoded.");
+	}
 
 	queue->pop_front();
+	access.notifyAll();
 	LOG_INFO(access.logString());
 
 	return storage;
@@ -129,8 +117,8 @@ size_t InterprocessIntermediateStorageManager::getIntermediateStorageCount()
 {
 	SharedMemory::ScopedAccess access(&m_sharedMemory);
 
-	SharedMemory::Queue<SharedIntermediateStorage>* queue =
-		access.accessValueWithAllocator<SharedMemory::Queue<SharedIntermediateStorage>>(
+	SharedMemory::Queue<SharedMemory::String>* queue =
+		access.accessValueWithAllocator<SharedMemory::Queue<SharedMemory::String>>(
 			s_intermediatStoragesKeyName);
 	if (!queue)
 	{
@@ -139,3 +127,37 @@ size_t InterprocessIntermediateStorageManager::getIntermediateStorageCount()
 
 	return queue->size();
 }
+
+bool InterprocessIntermediateStorageManager::waitForIntermediateStorageCountBelow(
+	size_t count, size_t timeoutMs)
+{
+	SharedMemory::ScopedAccess access(&m_sharedMemory);
+
+	SharedMemory::Queue<SharedMemory::String>* queue =
+		access.accessValueWithAllocator<SharedMemory::Queue<SharedMemory::String>>(
+			s_intermediatStoragesKeyName);
+	if (!queue || queue->size() < count)
+	{
+		return true;
+	}
+
+	access.waitForNotification(timeoutMs);
+
+	queue = access.accessValueWithAllocator<SharedMemory::Queue<SharedMemory::String>>(
+		s_intermediatStoragesKeyName);
+	return !queue || queue->size() < count;
+}
+
+void InterprocessIntermediateStorageManager::growMemory(
+	SharedMemory::ScopedAccess* access, size_t size)
+{
+	LOG_INFO_STREAM(
+		<< "grow memory - size: " << access->getMemorySize()
+		<< " free: " << access->getFreeMemorySize() << " alloc: " << size);
+
+	access->growMemory(size);
+
+	LOG_INFO("growing memory succeeded");
+
+	m_insertsWithoutGrowth = 0;
+}
@@ -16,7 +16,12 @@ public:
 
 	size_t getIntermediateStorageCount();
 
+	// Waits at most timeoutMs for a storage to be popped, returns whether fewer than count are left.
+	bool waitForIntermediateStorageCountBelow(size_t count, size_t timeoutMs);
+
 private:
+	void growMemory(SharedMemory::ScopedAccess* access, size_t size);
+
 	static const char* s_sharedMemoryNamePrefix;
 	static const char* s_intermediatStoragesKeyName;
 
@@ -0,0 +1,426 @@
+#include "FlatIntermediateStorage.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "IntermediateStorage.h"
+
+namespace
+{
+const uint32_t s_magic = 0x53495346;	// "FSIS"
+const uint32_t s_version = 1;
+
+// magic, version, next id and size of the elements
+const size_t s_headerSize = 24;
+
+// writes the elements followed by the string table, without data it only measures their size
+class Writer
+{
+public:
+	Writer(char* data, size_t recordsSize)
+		: m_data(data)
+		, m_pos(s_headerSize)
+		, m_stringsBegin(s_headerSize + recordsSize)
+		, m_stringsPos(0)
+	{
+	}
+
+	template <typename T>
+	void write(T value)
+	{
+		if (m_data)
+		{
+			std::memcpy(m_data + m_pos, &value, sizeof(value));
+		}
+		m_pos += sizeof(value);
+	}
+
+	template <typename CharT>
+	void writeString(const std::basic_string<CharT>& str)
+	{
+		write<uint64_t>(m_stringsPos);
+		write<uint64_t>(str.size());
+
+		const size_t size = str.size() * sizeof(CharT);
+		if (m_data && size)
+		{
+			std::memcpy(m_data + m_stringsBegin + m_stringsPos, str.data(), size);
+		}
+		m_stringsPos += size;
+	}
+
+	size_t getRecordsSize() const
+	{
+		return m_pos - s_headerSize;
+	}
+
+	size_t getSize() const
+	{
+		return m_pos + m_stringsPos;
+	}
+
+private:
+	char* m_data;
+	size_t m_pos;
+	const size_t m_stringsBegin;
+	size_t m_stringsPos;
+};
+
+class Reader
+{
+public:
+	Reader(const char* data, size_t size): m_data(data), m_size(size), m_pos(0) {}
+
+	size_t getRemainingSize() const
+	{
+		return m_size - m_pos;
+	}
+
+	template <typename T>
+	bool read(T* value)
+	{
+		if (sizeof(T) > getRemainingSize())
+		{
+			return false;
+		}
+		std::memcpy(value, m_data + m_pos, sizeof(T));
+		m_pos += sizeof(T);
+		return true;
+	}
+
+	// reads a value that was written as StoredT
+	template <typename StoredT, typename T>
+	bool readAs(T* value)
+	{
+		StoredT result;
+		if (!read(&result))
+		{
+			return false;
+		}
+		*value = static_cast<T>(result);
+		return true;
+	}
+
+	// the string table follows the elements, their strings are read from it by offset
+	bool splitStringTable(size_t recordsSize)
+	{
+		if (recordsSize > getRemainingSize())
+		{
+			return false;
+		}
+		m_strings = m_data + m_pos + recordsSize;
+		m_stringsSize = getRemainingSize() - recordsSize;
+		m_size = m_pos + recordsSize;
+		return true;
+	}
+
+	template <typename CharT>
+	bool readString(std::basic_string<CharT>* str)
+	{
+		uint64_t offset = 0;
+		uint64_t length = 0;
+		if (!read(&offset) || !read(&length) || offset > m_stringsSize ||
+			length > (m_stringsSize - offset) / sizeof(CharT))
+		{
+			return false;
+		}
+
+		str->resize(length);
+		if (length)
+		{
+			std::memcpy(&(*str)[0], m_strings + offset, length * sizeof(CharT));
+		}
+		return true;
+	}
+
+private:
+	const char* m_data;
+	size_t m_size;
+	size_t m_pos;
+
+	const char* m_strings = nullptr;
+	size_t m_stringsSize = 0;
+};
+
+void writeElement(const StorageNode& node, Writer* writer)
+{
+	writer->write<uint64_t>(node.id);
+	writer->write<int32_t>(node.type);
+	writer->writeString(node.serializedName);
+}
+
+bool readElement(Reader* reader, StorageNode* node)
+{
+	return reader->readAs<uint64_t>(&node->id) && reader->readAs<int32_t>(&node->type) &&
+		reader->readString(&node->serializedName);
+}
+
+void writeElement(const StorageFile& file, Writer* writer)
+{
+	writer->write<uint64_t>(file.id);
+	writer->writeString(file.filePath);
+	writer->writeString(file.languageIdentifier);
+	writer->writeString(file.modificationTime);
+	writer->write<uint8_t>(file.indexed);
+	writer->write<uint8_t>(file.complete);
+}
+
+bool readElement(Reader* reader, StorageFile* file)
+{
+	uint8_t indexed = 0;
+	uint8_t complete = 0;
+	if (!reader->readAs<uint64_t>(&file->id) || !reader->readString(&file->filePath) ||
+		!reader->readString(&file->languageIdentifier) ||
+		!reader->readString(&file->modificationTime) || !reader->read(&indexed) ||
+		!reader->read(&complete))
+	{
+		return false;
+	}
+	file->indexed = indexed;
+	file->complete = complete;
+	return true;
+}
+
+void writeElement(const StorageSymbol& symbol, Writer* writer)
+{
+	writer->write<uint64_t>(symbol.id);
+	writer->write<int32_t>(symbol.definitionKind);
+}
+
+bool readElement(Reader* reader, StorageSymbol* symbol)
+{
+	return reader->readAs<uint64_t>(&symbol->id) &&
+		reader->readAs<int32_t>(&symbol->definitionKind);
+}
+
+void writeElement(const StorageEdge& edge, Writer* writer)
+{
+	writer->write<uint64_t>(edge.id);
+	writer->write<int32_t>(edge.type);
+	writer->write<uint64_t>(edge.sourceNodeId);
+	writer->write<uint64_t>(edge.targetNodeId);
+}
+
+bool readElement(Reader* reader, StorageEdge* edge)
+{
+	return reader->readAs<uint64_t>(&edge->id) && reader->readAs<int32_t>(&edge->type) &&
+		reader->readAs<uint64_t>(&edge->sourceNodeId) &&
+		reader->readAs<uint64_t>(&edge->targetNodeId);
+}
+
+void writeElement(const StorageLocalSymbol& localSymbol, Writer* writer)
+{
+	writer->write<uint64_t>(localSymbol.id);
+	writer->writeString(localSymbol.name);
+}
+
+bool readElement(Reader* reader, StorageLocalSymbol* localSymbol)
+{
+	return reader->readAs<uint64_t>(&localSymbol->id) && reader->readString(&localSymbol->name);
+}
+
+void writeElement(const StorageSourceLocation& location, Writer* writer)
+{
+	writer->write<uint64_t>(location.id);
+	writer->write<uint64_t>(location.fileNodeId);
+	writer->write<uint64_t>(location.startLine);
+	writer->write<uint64_t>(location.startCol);
+	writer->write<uint64_t>(location.endLine);
+	writer->write<uint64_t>(location.endCol);
+	writer->write<int32_t>(location.type);
+}
+
+bool readElement(Reader* reader, StorageSourceLocation* location)
+{
+	return reader->readAs<uint64_t>(&location->id) &&
+		reader->readAs<uint64_t>(&location->fileNodeId) &&
+		reader->readAs<uint64_t>(&location->startLine) &&
+		reader->readAs<uint64_t>(&location->startCol) &&
+		reader->readAs<uint64_t>(&location->endLine) &&
+		reader->readAs<uint64_t>(&location->endCol) && reader->readAs<int32_t>(&location->type);
+}
+
+void writeElement(const StorageOccurrence& occurrence, Writer* writer)
+{
+	writer->write<uint64_t>(occurrence.elementId);
+	writer->write<uint64_t>(occurrence.sourceLocationId);
+}
+
+bool readElement(Reader* reader, StorageOccurrence* occurrence)
+{
+	return reader->readAs<uint64_t>(&occurrence->elementId) &&
+		reader->readAs<uint64_t>(&occurrence->sourceLocationId);
+}
+
+void writeElement(const StorageComponentAccess& access, Writer* writer)
+{
+	writer->write<uint64_t>(access.nodeId);
+	writer->write<int32_t>(access.type);
+}
+
+bool readElement(Reader* reader, StorageComponentAccess* access)
+{
+	return reader->readAs<uint64_t>(&access->nodeId) && reader->readAs<int32_t>(&access->type);
+}
+
+void writeElement(const StorageElementComponent& component, Writer* writer)
+{
+	writer->write<uint64_t>(component.elementId);
+	writer->write<int32_t>(component.type);
+	writer->writeString(component.data);
+}
+
+bool readElement(Reader* reader, StorageElementComponent* component)
+{
+	return reader->readAs<uint64_t>(&component->elementId) &&
+		reader->readAs<int32_t>(&component->type) && reader->readString(&component->data);
+}
+
+void writeElement(const StorageError& error, Writer* writer)
+{
+	writer->write<uint64_t>(error.id);
+	writer->writeString(error.message);
+	writer->writeString(error.translationUnit);
+	writer->write<uint8_t>(error.fatal);
+	writer->write<uint8_t>(error.indexed);
+}
+
+bool readElement(Reader* reader, StorageError* error)
+{
+	uint8_t fatal = 0;
+	uint8_t indexed = 0;
+	if (!reader->readAs<uint64_t>(&error->id) || !reader->readString(&error->message) ||
+		!reader->readString(&error->translationUnit) || !reader->read(&fatal) ||
+		!reader->read(&indexed))
+	{
+		return false;
+	}
+	error->fatal = fatal;
+	error->indexed = indexed;
+	return true;
+}
+
+template <typename T>
+void writeElements(const std::vector<T>& elements, Writer* writer)
+{
+	writer->write<uint64_t>(elements.size());
+	for (const T& element: elements)
+	{
+		writeElement(element, writer);
+	}
+}
+
+template <typename T>
+bool readElements(Reader* reader, std::vector<T>* elements)
+{
+	uint64_t count = 0;
+	// every element takes at least 8 bytes, which bounds the count of malformed data
+	if (!reader->read(&count) || count > reader->getRemainingSize() / 8)
+	{
+		return false;
+	}
+
+	elements->resize(count);
+	for (T& element: *elements)
+	{
+		if (!readElement(reader, &element))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void writeElements(const IntermediateStorage& storage, Writer* writer)
+{
+	writeElements(storage.getStorageNodes(), writer);
+	writeElements(storage.getStorageFiles(), writer);
+	writeElements(storage.getStorageSymbols(), writer);
+	writeElements(storage.getStorageEdges(), writer);
+	writeElements(storage.getStorageLocalSymbols(), writer);
+	writeElements(storage.getStorageSourceLocations(), writer);
+	writeElements(storage.getStorageOccurrences(), writer);
+	writeElements(storage.getComponentAccesses(), writer);
+	writeElements(storage.getElementComponents(), writer);
+	writeElements(storage.getErrors(), writer);
+}
+}	 // namespace
+
+std::shared_ptr<IntermediateStorage> FlatIntermediateStorage::decode(const char* data, size_t size)
+{
+	Reader reader(data, size);
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint64_t nextId = 0;
+	uint64_t recordsSize = 0;
+	if (!reader.read(&magic) || magic != s_magic || !reader.read(&version) ||
+		version != s_version || !reader.read(&nextId) || !reader.read(&recordsSize) ||
+		!reader.splitStringTable(recordsSize))
+	{
+		return nullptr;
+	}
+
+	std::vector<StorageNode> nodes;
+	std::vector<StorageFile> files;
+	std::vector<StorageSymbol> symbols;
+	std::vector<StorageEdge> edges;
+	std::vector<StorageLocalSymbol> localSymbols;
+	std::vector<StorageSourceLocation> sourceLocations;
+	std::vector<StorageOccurrence> occurrences;
+	std::vector<StorageComponentAccess> componentAccesses;
+	std::vector<StorageElementComponent> elementComponents;
+	std::vector<StorageError> errors;
+	if (!readElements(&reader, &nodes) || !readElements(&reader, &files) ||
+		!readElements(&reader, &symbols) || !readElements(&reader, &edges) ||
+		!readElements(&reader, &localSymbols) || !readElements(&reader, &sourceLocations) ||
+		!readElements(&reader, &occurrences) || !readElements(&reader, &componentAccesses) ||
+		!readElements(&reader, &elementComponents) || !readElements(&reader, &errors) ||
+		reader.getRemainingSize())
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<IntermediateStorage> storage = std::make_shared<IntermediateStorage>();
+	storage->setStorageNodes(std::move(nodes));
+	storage->setStorageFiles(std::move(files));
+	storage->setStorageSymbols(std::move(symbols));
+	storage->setStorageEdges(std::move(edges));
+	storage->setStorageLocalSymbols(std::move(localSymbols));
+	storage->setStorageSourceLocations(std::move(sourceLocations));
+	storage->setStorageOccurrences(std::move(occurrences));
+	storage->setComponentAccesses(std::move(componentAccesses));
+	storage->setElementComponents(std::move(elementComponents));
+	storage->setErrors(std::move(errors));
+	storage->setNextId(nextId);
+	return storage;
+}
+
+FlatIntermediateStorage::FlatIntermediateStorage(const IntermediateStorage& storage)
+	: m_storage(storage)
+{
+	Writer writer(nullptr, 0);
+	writeElements(storage, &writer);
+	m_recordsSize = writer.getRecordsSize();
+	m_size = writer.getSize();
+}
+
+size_t FlatIntermediateStorage::getSize() const
+{
+	return m_size;
+}
+
+void FlatIntermediateStorage::encode(char* data) const
+{
+	const uint32_t magic = s_magic;
+	const uint32_t version = s_version;
+	const uint64_t nextId = m_storage.getNextId();
+	const uint64_t recordsSize = m_recordsSize;
+	std::memcpy(data, &magic, sizeof(magic));
+	std::memcpy(data + 4, &version, sizeof(version));
+	std::memcpy(data + 8, &nextId, sizeof(nextId));
+	std::memcpy(data + 16, &recordsSize, sizeof(recordsSize));
+
+	Writer writer(data, m_recordsSize);
+	writeElements(m_storage, &writer);
+}
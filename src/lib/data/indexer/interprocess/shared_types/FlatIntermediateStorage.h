@@ -0,0 +1,32 @@
+#ifndef FLAT_INTERMEDIATE_STORAGE_H
+#define FLAT_INTERMEDIATE_STORAGE_H
+
+#include <memory>
+
+class IntermediateStorage;
+
+// Contiguous binary encoding of an IntermediateStorage that is passed between processes through
+// shared memory. A short header is followed by the elements, each kind preceded by its count, and a
+// table holding the characters of all strings. Elements refer to their strings by offset into that
+// table, so the encoding contains no pointers and can be read at any address.
+class FlatIntermediateStorage
+{
+public:
+	// Returns nullptr if the data was not produced by encode().
+	static std::shared_ptr<IntermediateStorage> decode(const char* data, size_t size);
+
+	// Measures the encoding of storage, which has to stay unchanged until it is encoded.
+	FlatIntermediateStorage(const IntermediateStorage& storage);
+
+	size_t getSize() const;
+
+	// Writes the encoding to the getSize() bytes at data.
+	void encode(char* data) const;
+
+private:
+	const IntermediateStorage& m_storage;
+	size_t m_recordsSize;
+	size_t m_size;
+};
+
+#endif	  // FLAT_INTERMEDIATE_STORAGE_H
@@ -2,11 +2,28 @@
 
 #include "IndexerCommandCxx.h"
 #include "IndexerCommandJava.h"
+#include "SharedIndexingContext.h"
 
 #include "logging.h"
 #include "utilityString.h"
 
-void SharedIndexerCommand::fromLocal(IndexerCommand* indexerCommand)
+#if BUILD_CXX_LANGUAGE_PACKAGE
+namespace
+{
+std::vector<std::wstring> toStrings(const std::set<FilePathFilter>& filters)
+{
+	std::vector<std::wstring> strings;
+	strings.reserve(filters.size());
+	for (const FilePathFilter& filter: filters)
+	{
+		strings.push_back(filter.wstr());
+	}
+	return strings;
+}
+}	 // namespace
+#endif	  // BUILD_CXX_LANGUAGE_PACKAGE
+
+void SharedIndexerCommand::fromLocal(IndexerCommand* indexerCommand, SharedIndexingContext* context)
 {
 	setSourceFilePath(indexerCommand->getSourceFilePath());
 
@@ -16,11 +33,11 @@ void SharedIndexerCommand::fromLocal(IndexerCommand* indexerCommand)
 		IndexerCommandCxx* cmd = dynamic_cast<IndexerCommandCxx*>(indexerCommand);
 
 		setType(CXX);
-		setIndexedPaths(cmd->getIndexedPaths());
-		setExcludeFilters(cmd->getExcludeFilters());
-		setIncludeFilters(cmd->getIncludeFilters());
+		setIndexedPaths(cmd->getIndexedPaths(), context);
+		setExcludeFilters(cmd->getExcludeFilters(), context);
+		setIncludeFilters(cmd->getIncludeFilters(), context);
 		setWorkingDirectory(cmd->getWorkingDirectory());
-		setCompilerFlags(cmd->getCompilerFlags());
+		setCompilerFlags(cmd->getCompilerFlags(), context);
 		return;
 	}
 #endif	  // BUILD_CXX_LANGUAGE_PACKAGE
@@ -43,7 +60,8 @@ void SharedIndexerCommand::fromLocal(IndexerCommand* indexerCommand)
 		L". It will be ignored.");
 }
 
-std::shared_ptr<IndexerCommand> SharedIndexerCommand::fromShared(const SharedIndexerCommand& indexerCommand)
+std::shared_ptr<IndexerCommand> SharedIndexerCommand::fromShared(
+	const SharedIndexerCommand& indexerCommand, SharedIndexingContext* context)
 {
 	switch (indexerCommand.getType())
 	{
@@ -51,11 +69,11 @@ std::shared_ptr<IndexerCommand> SharedIndexerCommand::fromShared(const SharedInd
 	case CXX:
 		return std::make_shared<IndexerCommandCxx>(
 			indexerCommand.getSourceFilePath(),
-			indexerCommand.getIndexedPaths(),
-			indexerCommand.getExcludeFilters(),
-			indexerCommand.getIncludeFilters(),
+			indexerCommand.getIndexedPaths(context),
+			indexerCommand.getExcludeFilters(context),
+			indexerCommand.getIncludeFilters(context),
 			indexerCommand.getWorkingDirectory(),
-			indexerCommand.getCompilerFlags());
+			indexerCommand.getCompilerFlags(context));
 #endif	  // BUILD_CXX_LANGUAGE_PACKAGE
 #if BUILD_JAVA_LANGUAGE_PACKAGE
 	case JAVA:
@@ -81,16 +99,29 @@ std::shared_ptr<IndexerCommand> SharedIndexerCommand::fromShared(const SharedInd
 	return nullptr;
 }
 
+void SharedIndexerCommand::releaseContext(SharedIndexingContext* context) const
+{
+#if BUILD_CXX_LANGUAGE_PACKAGE
+	if (getType() == CXX)
+	{
+		context->releaseStringList(m_indexedPathsId);
+		context->releaseStringList(m_excludeFiltersId);
+		context->releaseStringList(m_includeFiltersId);
+		context->releaseStringList(m_compilerFlagsId);
+	}
+#endif	  // BUILD_CXX_LANGUAGE_PACKAGE
+}
 
 SharedIndexerCommand::SharedIndexerCommand(SharedMemory::Allocator* allocator)
 	: m_type(Type::UNKNOWN)
 	, m_sourceFilePath("", allocator)
 #if BUILD_CXX_LANGUAGE_PACKAGE
-	, m_indexedPaths(allocator)
-	, m_excludeFilters(allocator)
-	, m_includeFilters(allocator)
+	, m_indexedPathsId(0)
+	, m_indexesSourceFilePath(false)
+	, m_excludeFiltersId(0)
+	, m_includeFiltersId(0)
 	, m_workingDirectory("", allocator)
-	, m_compilerFlags(allocator)
+	, m_compilerFlagsId(0)
 #endif	  // BUILD_CXX_LANGUAGE_PACKAGE
 #if BUILD_JAVA_LANGUAGE_PACKAGE
 	, m_languageStandard("", allocator)
@@ -113,76 +144,60 @@ void SharedIndexerCommand::setSourceFilePath(const FilePath& filePath)
 
 #if BUILD_CXX_LANGUAGE_PACKAGE
 
-std::set<FilePath> SharedIndexerCommand::getIndexedPaths() const
+std::set<FilePath> SharedIndexerCommand::getIndexedPaths(SharedIndexingContext* context) const
 {
-	std::set<FilePath> result;
-
-	for (unsigned int i = 0; i < m_indexedPaths.size(); i++)
+	std::set<FilePath> result = context->getFilePaths(m_indexedPathsId);
+	if (m_indexesSourceFilePath)
 	{
-		result.insert(FilePath(utility::decodeFromUtf8(m_indexedPaths[i].c_str())));
+		result.insert(getSourceFilePath());
 	}
-
 	return result;
 }
 
-void SharedIndexerCommand::setIndexedPaths(const std::set<FilePath>& indexedPaths)
+void SharedIndexerCommand::setIndexedPaths(
+	const std::set<FilePath>& indexedPaths, SharedIndexingContext* context)
 {
-	m_indexedPaths.clear();
+	const std::wstring sourceFilePath = getSourceFilePath().wstr();
 
+	std::vector<std::wstring> paths;
+	m_indexesSourceFilePath = false;
 	for (const FilePath& indexedPath: indexedPaths)
 	{
-		SharedMemory::String path(m_indexedPaths.get_allocator());
-		path = utility::encodeToUtf8(indexedPath.wstr()).c_str();
-		m_indexedPaths.push_back(path);
+		if (indexedPath.wstr() == sourceFilePath)
+		{
+			m_indexesSourceFilePath = true;
+		}
+		else
+		{
+			paths.push_back(indexedPath.wstr());
+		}
 	}
+
+	m_indexedPathsId = context->addStringList(paths);
 }
 
-std::set<FilePathFilter> SharedIndexerCommand::getExcludeFilters() const
+std::set<FilePathFilter> SharedIndexerCommand::getExcludeFilters(
+	SharedIndexingContext* context) const
 {
-	std::set<FilePathFilter> result;
-
-	for (unsigned int i = 0; i < m_excludeFilters.size(); i++)
-	{
-		result.insert(FilePathFilter(utility::decodeFromUtf8(m_excludeFilters[i].c_str())));
-	}
-
-	return result;
+	return context->getFilePathFilters(m_excludeFiltersId);
 }
 
-void SharedIndexerCommand::setExcludeFilters(const std::set<FilePathFilter>& excludeFilters)
+void SharedIndexerCommand::setExcludeFilters(
+	const std::set<FilePathFilter>& excludeFilters, SharedIndexingContext* context)
 {
-	m_excludeFilters.clear();
-
-	for (const FilePathFilter& excludeFilter: excludeFilters)
-	{
-		SharedMemory::String path(m_excludeFilters.get_allocator());
-		path = utility::encodeToUtf8(excludeFilter.wstr()).c_str();
-		m_excludeFilters.push_back(path);
-	}
+	m_excludeFiltersId = context->addStringList(toStrings(excludeFilters));
 }
 
-std::set<FilePathFilter> SharedIndexerCommand::getIncludeFilters() const
+std::set<FilePathFilter> SharedIndexerCommand::getIncludeFilters(
+	SharedIndexingContext* context) const
 {
-	std::set<FilePathFilter> result;
-
-	for (unsigned int i = 0; i < m_includeFilters.size(); i++)
-	{
-		result.insert(FilePathFilter(utility::decodeFromUtf8(m_includeFilters[i].c_str())));
-	}
-
-	return result;
+	return context->getFilePathFilters(m_includeFiltersId);
 }
 
-void SharedIndexerCommand::setIncludeFilters(const std::set<FilePathFilter>& includeFilters)
+void SharedIndexerCommand::setIncludeFilters(
+	const std::set<FilePathFilter>& includeFilters, SharedIndexingContext* context)
 {
-	m_includeFilters.clear();
-
-	for (const FilePathFilter& includeFilter: includeFilters)
-	{
-		SharedMemory::String path(m_includeFilters.get_allocator());
-		path = utility::encodeToUtf8(includeFilter.wstr()).c_str();
-		m_includeFilters.push_back(path);
-	}
+	m_includeFiltersId = context->addStringList(toStrings(includeFilters));
 }
 
 FilePath SharedIndexerCommand::getWorkingDirectory() const
@@ -195,30 +210,16 @@ void SharedIndexerCommand::setWorkingDirectory(const FilePath& workingDirectory)
 	m_workingDirectory = utility::encodeToUtf8(workingDirectory.wstr()).c_str();
 }
 
-std::vector<std::wstring> SharedIndexerCommand::getCompilerFlags() const
+std::vector<std::wstring> SharedIndexerCommand::getCompilerFlags(
+	SharedIndexingContext* context) const
 {
-	std::vector<std::wstring> result;
-	result.reserve(m_compilerFlags.size());
-
-	for (unsigned int i = 0; i < m_compilerFlags.size(); i++)
-	{
-		result.push_back(utility::decodeFromUtf8(m_compilerFlags[i].c_str()));
-	}
-
-	return result;
+	return context->getStrings(m_compilerFlagsId);
 }
 
-void SharedIndexerCommand::setCompilerFlags(const std::vector<std::wstring>& compilerFlags)
+void SharedIndexerCommand::setCompilerFlags(
+	const std::vector<std::wstring>& compilerFlags, SharedIndexingContext* context)
 {
-	m_compilerFlags.clear();
-	m_compilerFlags.reserve(compilerFlags.size());
-
-	for (const std::wstring& compilerFlag: compilerFlags)
-	{
-		SharedMemory::String path(m_compilerFlags.get_allocator());
-		path = utility::encodeToUtf8(compilerFlag).c_str();
-		m_compilerFlags.push_back(path);
-	}
+	m_compilerFlagsId = context->addStringList(compilerFlags);
 }
 
 #endif	  // BUILD_CXX_LANGUAGE_PACKAGE
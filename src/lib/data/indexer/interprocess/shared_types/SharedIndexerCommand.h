@@ -10,12 +10,17 @@
 #include "SharedMemory.h"
 
 class IndexerCommand;
+class SharedIndexingContext;
 
 class SharedIndexerCommand
 {
 public:
-	void fromLocal(IndexerCommand* indexerCommand);
-	static std::shared_ptr<IndexerCommand> fromShared(const SharedIndexerCommand& indexerCommand);
+	void fromLocal(IndexerCommand* indexerCommand, SharedIndexingContext* context);
+	static std::shared_ptr<IndexerCommand> fromShared(
+		const SharedIndexerCommand& indexerCommand, SharedIndexingContext* context);
+
+	// Releases the lists of the context used by this command.
+	void releaseContext(SharedIndexingContext* context) const;
 
 	SharedIndexerCommand(SharedMemory::Allocator* allocator);
 	~SharedIndexerCommand();
@@ -25,20 +30,23 @@ public:
 
 #if BUILD_CXX_LANGUAGE_PACKAGE
 
-	std::set<FilePath> getIndexedPaths() const;
-	void setIndexedPaths(const std::set<FilePath>& indexedPaths);
+	std::set<FilePath> getIndexedPaths(SharedIndexingContext* context) const;
+	void setIndexedPaths(const std::set<FilePath>& indexedPaths, SharedIndexingContext* context);
 
-	std::set<FilePathFilter> getExcludeFilters() const;
-	void setExcludeFilters(const std::set<FilePathFilter>& excludeFilters);
+	std::set<FilePathFilter> getExcludeFilters(SharedIndexingContext* context) const;
+	void setExcludeFilters(
+		const std::set<FilePathFilter>& excludeFilters, SharedIndexingContext* context);
 
-	std::set<FilePathFilter> getIncludeFilters() const;
-	void setIncludeFilters(const std::set<FilePathFilter>& includeFilters);
+	std::set<FilePathFilter> getIncludeFilters(SharedIndexingContext* context) const;
+	void setIncludeFilters(
+		const std::set<FilePathFilter>& includeFilters, SharedIndexingContext* context);
 
 	FilePath getWorkingDirectory() const;
 	void setWorkingDirectory(const FilePath& workingDirectory);
 
-	std::vector<std::wstring> getCompilerFlags() const;
-	void setCompilerFlags(const std::vector<std::wstring>& compilerFlags);
+	std::vector<std::wstring> getCompilerFlags(SharedIndexingContext* context) const;
+	void setCompilerFlags(
+		const std::vector<std::wstring>& compilerFlags, SharedIndexingContext* context);
 
 #endif	  // BUILD_CXX_LANGUAGE_PACKAGE
 #if BUILD_JAVA_LANGUAGE_PACKAGE
@@ -75,11 +83,14 @@ private:
 	SharedMemory::String m_sourceFilePath;
 
 #if BUILD_CXX_LANGUAGE_PACKAGE
-	SharedMemory::Vector<SharedMemory::String> m_indexedPaths;
-	SharedMemory::Vector<SharedMemory::String> m_excludeFilters;
-	SharedMemory::Vector<SharedMemory::String> m_includeFilters;
+	// ids of lists in the SharedIndexingContext, the indexed paths are stored without the source
+	// file path so they are the same for all commands of a source group
+	size_t m_indexedPathsId;
+	bool m_indexesSourceFilePath;
+	size_t m_excludeFiltersId;
+	size_t m_includeFiltersId;
 	SharedMemory::String m_workingDirectory;
-	SharedMemory::Vector<SharedMemory::String> m_compilerFlags;
+	size_t m_compilerFlagsId;
 #endif	  // BUILD_CXX_LANGUAGE_PACKAGE
 
 #if BUILD_JAVA_LANGUAGE_PACKAGE
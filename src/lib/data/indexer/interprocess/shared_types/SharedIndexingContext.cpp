@@ -0,0 +1,169 @@
+#include "SharedIndexingContext.h"
+
+#include <functional>
+
+#include "logging.h"
+#include "utilityString.h"
+
+namespace
+{
+size_t getHash(const std::vector<std::string>& strings)
+{
+	size_t hash = strings.size();
+	for (const std::string& s: strings)
+	{
+		hash ^= std::hash<std::string>()(s) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
+bool isEqual(
+	const SharedMemory::Vector<SharedMemory::String>& sharedStrings,
+	const std::vector<std::string>& strings)
+{
+	if (sharedStrings.size() != strings.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < strings.size(); i++)
+	{
+		const SharedMemory::String& sharedString = sharedStrings[i];
+		if (strings[i].compare(0, strings[i].size(), sharedString.data(), sharedString.size()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+}	 // namespace
+
+SharedIndexingContext::StringList::StringList(SharedMemory::Allocator* allocator)
+	: strings(allocator), commandCount(0)
+{
+}
+
+void SharedIndexingContext::setStringLists(StringLists* stringLists)
+{
+	m_stringLists = stringLists;
+}
+
+size_t SharedIndexingContext::addStringList(const std::vector<std::wstring>& strings)
+{
+	std::vector<std::string> utf8Strings;
+	utf8Strings.reserve(strings.size());
+	for (const std::wstring& s: strings)
+	{
+		utf8Strings.push_back(utility::encodeToUtf8(s));
+	}
+
+	const size_t hash = getHash(utf8Strings);
+
+	auto range = m_idsByHash.equal_range(hash);
+	for (auto it = range.first; it != range.second;)
+	{
+		StringList& list = (*m_stringLists)[it->second];
+		if (!list.commandCount)
+		{
+			// released since it was added
+			it = m_idsByHash.erase(it);
+		}
+		else if (isEqual(list.strings, utf8Strings))
+		{
+			list.commandCount++;
+			return it->second;
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	m_stringLists->emplace_back(m_stringLists->get_allocator().get_segment_manager());
+	StringList& list = m_stringLists->back();
+	list.strings.reserve(utf8Strings.size());
+	for (const std::string& s: utf8Strings)
+	{
+		list.strings.emplace_back(s.data(), s.size(), list.strings.get_allocator());
+	}
+	list.commandCount = 1;
+
+	const size_t id = m_stringLists->size() - 1;
+	m_idsByHash.emplace(hash, id);
+	return id;
+}
+
+void SharedIndexingContext::releaseStringList(size_t id)
+{
+	if (id >= m_stringLists->size())
+	{
+		LOG_ERROR("Cannot release unknown list of indexer command strings: " + std::to_string(id));
+		return;
+	}
+
+	StringList& list = (*m_stringLists)[id];
+	if (list.commandCount && !--list.commandCount)
+	{
+		list.strings.clear();
+		list.strings.shrink_to_fit();
+	}
+}
+
+void SharedIndexingContext::clear()
+{
+	for (StringList& list: *m_stringLists)
+	{
+		list.strings.clear();
+		list.strings.shrink_to_fit();
+		list.commandCount = 0;
+	}
+	m_idsByHash.clear();
+}
+
+std::vector<std::wstring> SharedIndexingContext::getStrings(size_t id) const
+{
+	std::vector<std::wstring> result;
+	if (id >= m_stringLists->size())
+	{
+		LOG_ERROR("Cannot find list of indexer command strings: " + std::to_string(id));
+		return result;
+	}
+
+	const StringList& list = (*m_stringLists)[id];
+	result.reserve(list.strings.size());
+	for (const SharedMemory::String& s: list.strings)
+	{
+		result.push_back(utility::decodeFromUtf8(std::string(s.data(), s.size())));
+	}
+	return result;
+}
+
+const std::set<FilePath>& SharedIndexingContext::getFilePaths(size_t id)
+{
+	auto it = m_filePaths.find(id);
+	if (it == m_filePaths.end())
+	{
+		std::set<FilePath> filePaths;
+		for (const std::wstring& s: getStrings(id))
+		{
+			filePaths.insert(FilePath(s));
+		}
+		it = m_filePaths.emplace(id, std::move(filePaths)).first;
+	}
+	return it->second;
+}
+
+const std::set<FilePathFilter>& SharedIndexingContext::getFilePathFilters(size_t id)
+{
+	auto it = m_filePathFilters.find(id);
+	if (it == m_filePathFilters.end())
+	{
+		std::set<FilePathFilter> filters;
+		for (const std::wstring& s: getStrings(id))
+		{
+			filters.insert(FilePathFilter(s));
+		}
+		it = m_filePathFilters.emplace(id, std::move(filters)).first;
+	}
+	return it->second;
+}
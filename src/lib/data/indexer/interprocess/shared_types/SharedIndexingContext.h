@@ -0,0 +1,56 @@
+#ifndef SHARED_INDEXING_CONTEXT_H
+#define SHARED_INDEXING_CONTEXT_H
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "FilePath.h"
+#include "FilePathFilter.h"
+#include "SharedMemory.h"
+
+// Indexed paths, filters and compiler flags of the indexer commands in shared memory. All commands
+// of a source group use the same paths and filters and many use the same flags, so every distinct
+// list is stored once and referred to by id. A list is released when the last command using it is
+// popped. Ids are not reused, which allows each process to cache what it decoded from a list.
+class SharedIndexingContext
+{
+public:
+	class StringList
+	{
+	public:
+		StringList(SharedMemory::Allocator* allocator);
+
+		SharedMemory::Vector<SharedMemory::String> strings;
+		size_t commandCount;
+	};
+
+	// a deque, so adding lists never needs one large block of shared memory
+	using StringLists = SharedMemory::Queue<StringList>;
+
+	// Needs to be called on every access, the shared memory may be mapped at a different address.
+	void setStringLists(StringLists* stringLists);
+
+	// Returns the id of an equal list or adds a new one, counts one more command using it.
+	size_t addStringList(const std::vector<std::wstring>& strings);
+	void releaseStringList(size_t id);
+
+	// Releases all lists, e.g. when the queued commands get discarded.
+	void clear();
+
+	std::vector<std::wstring> getStrings(size_t id) const;
+	const std::set<FilePath>& getFilePaths(size_t id);
+	const std::set<FilePathFilter>& getFilePathFilters(size_t id);
+
+private:
+	StringLists* m_stringLists = nullptr;
+
+	// ids of the lists added by this process
+	std::unordered_multimap<size_t, size_t> m_idsByHash;
+
+	std::map<size_t, std::set<FilePath>> m_filePaths;
+	std::map<size_t, std::set<FilePathFilter>> m_filePathFilters;
+};
+
+#endif	  // SHARED_INDEXING_CONTEXT_H
@@ -7,6 +7,58 @@
 #include "utility.h"
 #include "utilityString.h"
 
+namespace
+{
+// Inserts the value at the position of the range. A full range is moved to the end of the arena
+// with twice the capacity, the slots it leaves behind are only reclaimed by finishSetup().
+template <typename RangeType, typename T>
+void insertIntoRange(RangeType* range, size_t position, T value, std::vector<T>* arena)
+{
+	if (range->size == range->capacity)
+	{
+		const uint32_t capacity = std::max<uint32_t>(1, range->capacity * 2);
+		const uint32_t offset = static_cast<uint32_t>(arena->size());
+		arena->resize(arena->size() + capacity);
+		std::move(
+			arena->begin() + range->offset,
+			arena->begin() + range->offset + range->size,
+			arena->begin() + offset);
+		range->offset = offset;
+		range->capacity = capacity;
+	}
+
+	auto begin = arena->begin() + range->offset;
+	std::move_backward(begin + position, begin + range->size, begin + range->size + 1);
+	*(begin + position) = std::move(value);
+	range->size++;
+}
+}	 // namespace
+
+void SearchIndex::SearchGate::add(wchar_t c)
+{
+	const size_t bit = (c >= 32 && c < 127) ? size_t(c - 32) : 95 + size_t(c) % 33;
+	bits[bit / 64] |= uint64_t(1) << (bit % 64);
+}
+
+void SearchIndex::SearchGate::addLowerCase(const wchar_t* text, size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		add(towlower(text[i]));
+	}
+}
+
+void SearchIndex::SearchGate::add(const SearchGate& other)
+{
+	bits[0] |= other.bits[0];
+	bits[1] |= other.bits[1];
+}
+
+bool SearchIndex::SearchGate::contains(const SearchGate& other) const
+{
+	return (bits[0] & other.bits[0]) == other.bits[0] && (bits[1] & other.bits[1]) == other.bits[1];
+}
+
 SearchIndex::SearchIndex()
 {
 	clear();
@@ -16,81 +68,175 @@ SearchIndex::~SearchIndex() {}
 
 void SearchIndex::addNode(Id id, std::wstring name, NodeType type)
 {
-	SearchNode* currentNode = m_root;
+	uint32_t currentNode = 0;
 
-	while (name.size() > 0)
+	size_t pos = 0;
+	while (pos < name.size())
 	{
-		currentNode->containedTypes.add(type);
+		m_nodes[currentNode].containedTypes.add(type);
+
+		const SearchNode& node = m_nodes[currentNode];
+		const size_t edgePosition = findEdgePosition(node, name[pos]);
+		const uint32_t edgeIndex = node.edges.offset + static_cast<uint32_t>(edgePosition);
 
-		auto it = currentNode->edges.find(name[0]);
-		if (it != currentNode->edges.end())
+		if (edgePosition < node.edges.size && m_labels[m_edges[edgeIndex].labelOffset] == name[pos])
 		{
-			SearchEdge* currentEdge = it->second;
-			const std::wstring& edgeString = currentEdge->s;
+			const SearchEdge currentEdge = m_edges[edgeIndex];
 
 			size_t matchCount = 1;
-			for (size_t j = 1; j < edgeString.size() && j < name.size(); j++)
+			for (size_t j = 1; j < currentEdge.labelSize && pos + j < name.size(); j++)
 			{
-				if (edgeString[j] != name[j])
+				if (m_labels[currentEdge.labelOffset + j] != name[pos + j])
 				{
 					break;
 				}
 				matchCount++;
 			}
 
-			if (matchCount < edgeString.size())
+			if (matchCount < currentEdge.labelSize)
 			{
-				// split current edge
-				m_nodes.push_back(std::make_unique<SearchNode>(currentNode->containedTypes));
-				SearchNode* n = m_nodes.back().get();
+				// split current edge, both parts keep their label in the pool
+				const uint32_t n = addSearchNode(node.containedTypes);
 
-				m_edges.push_back(std::make_unique<SearchEdge>(
-					currentEdge->target, edgeString.substr(matchCount)));
-				SearchEdge* e = m_edges.back().get();
+				SearchEdge e = currentEdge;
+				e.labelOffset += static_cast<uint32_t>(matchCount);
+				e.labelSize -= static_cast<uint32_t>(matchCount);
+				insertIntoRange(&m_nodes[n].edges, 0, e, &m_edges);
 
-				n->edges.emplace(e->s[0], e);
+				m_edges[edgeIndex].labelSize = static_cast<uint32_t>(matchCount);
+				m_edges[edgeIndex].target = n;
+			}
 
-				currentEdge->s = edgeString.substr(0, matchCount);
-				currentEdge->target = n;
+			if (m_gatesPopulated)
+			{
+				m_edges[edgeIndex].gate.addLowerCase(name.data() + pos, name.size() - pos);
 			}
 
-			name = name.substr(matchCount);
-			currentNode = currentEdge->target;
+			pos += matchCount;
+			currentNode = m_edges[edgeIndex].target;
 		}
 		else
 		{
-			m_nodes.push_back(std::make_unique<SearchNode>(currentNode->containedTypes));
-			SearchNode* n = m_nodes.back().get();
+			const uint32_t n = addSearchNode(node.containedTypes);
+
+			SearchEdge e;
+			e.target = n;
+			e.labelOffset = static_cast<uint32_t>(m_labels.size());
+			e.labelSize = static_cast<uint32_t>(name.size() - pos);
+			m_labels.append(name, pos, std::wstring::npos);
 
-			m_edges.push_back(std::make_unique<SearchEdge>(n, std::move(name)));
-			SearchEdge* e = m_edges.back().get();
+			if (m_gatesPopulated)
+			{
+				e.gate.addLowerCase(name.data() + pos, name.size() - pos);
+			}
 
-			currentNode->edges.emplace(e->s[0], e);
+			insertIntoRange(&m_nodes[currentNode].edges, edgePosition, e, &m_edges);
 			currentNode = n;
 
-			name.clear();
+			pos = name.size();
+		}
+	}
+
+	SearchRange& elements = m_nodes[currentNode].elements;
+	auto begin = m_elements.begin() + elements.offset;
+	auto it = std::lower_bound(
+		begin, begin + elements.size, id, [](const SearchElement& element, Id id) {
+			return element.id < id;
+		});
+
+	if (it != begin + elements.size && it->id == id)
+	{
+		it->type = type;
+	}
+	else
+	{
+		insertIntoRange(&elements, it - begin, SearchElement {id, type}, &m_elements);
+	}
+}
+
+void SearchIndex::removeNode(Id id, const std::wstring& name)
+{
+	uint32_t currentNode = 0;
+
+	size_t pos = 0;
+	while (pos < name.size())
+	{
+		const SearchNode& node = m_nodes[currentNode];
+		const size_t edgePosition = findEdgePosition(node, name[pos]);
+		if (edgePosition == node.edges.size)
+		{
+			return;
+		}
+
+		const SearchEdge& edge = m_edges[node.edges.offset + edgePosition];
+		if (name.compare(pos, edge.labelSize, m_labels, edge.labelOffset, edge.labelSize))
+		{
+			return;
 		}
+
+		pos += edge.labelSize;
+		currentNode = edge.target;
 	}
 
-	currentNode->elementIds.emplace(id, type);
+	// the trie itself is kept, nodes without elements don't show up in results and contained types
+	// and gates only need to cover the remaining names
+	SearchRange& elements = m_nodes[currentNode].elements;
+	auto begin = m_elements.begin() + elements.offset;
+	auto end = begin + elements.size;
+	auto it = std::find_if(
+		begin, end, [id](const SearchElement& element) { return element.id == id; });
+
+	if (it != end)
+	{
+		std::move(it + 1, end, it);
+		elements.size--;
+	}
 }
 
 void SearchIndex::finishSetup()
 {
-	for (auto& p: m_root->edges)
+	size_t elementCount = 0;
+	for (const SearchNode& node: m_nodes)
+	{
+		elementCount += node.elements.size;
+	}
+
+	// every node but the root has exactly one incoming edge and the labels never overlap
+	std::vector<SearchNode> nodes;
+	std::vector<SearchEdge> edges;
+	std::vector<SearchElement> elements;
+	std::wstring labels;
+	nodes.reserve(m_nodes.size());
+	edges.reserve(m_nodes.size() - 1);
+	elements.reserve(elementCount);
+	labels.reserve(m_labels.size());
+
+	packNode(0, &nodes, &edges, &elements, &labels);
+
+	m_nodes = std::move(nodes);
+	m_edges = std::move(edges);
+	m_elements = std::move(elements);
+	m_labels = std::move(labels);
+
+	const SearchRange& rootEdges = m_nodes[0].edges;
+	for (uint32_t i = rootEdges.offset; i < rootEdges.offset + rootEdges.size; i++)
 	{
-		populateEdgeGate(p.second);
+		populateEdgeGate(i);
 	}
+
+	m_gatesPopulated = true;
 }
 
 void SearchIndex::clear()
 {
-	m_nodes.clear();
-	m_edges.clear();
+	m_nodes = std::vector<SearchNode>();
+	m_edges = std::vector<SearchEdge>();
+	m_elements = std::vector<SearchElement>();
+	m_labels = std::wstring();
 
-	m_nodes.push_back(std::make_unique<SearchNode>(NodeTypeSet()));
+	m_nodes.emplace_back(NodeTypeSet());
 
-	m_root = m_nodes.back().get();
+	m_gatesPopulated = false;
 }
 
 std::vector<SearchResult> SearchIndex::search(
@@ -102,7 +248,7 @@ std::vector<SearchResult> SearchIndex::search(
 	// find paths containing query
 	std::vector<SearchPath> paths;
 	searchRecursive(
-		SearchPath(L"", {}, m_root), utility::toLowerCase(query), acceptedNodeTypes, &paths);
+		SearchPath(L"", {}, 0), utility::toLowerCase(query), acceptedNodeTypes, &paths);
 
 	// create scored search results
 	std::multiset<SearchResult> searchResults = createScoredResults(
@@ -144,19 +290,74 @@ std::vector<SearchResult> SearchIndex::search(
 	return std::vector<SearchResult>(bestResults.begin(), it);
 }
 
-void SearchIndex::populateEdgeGate(SearchEdge* e)
+uint32_t SearchIndex::addSearchNode(NodeTypeSet containedTypes)
+{
+	m_nodes.emplace_back(containedTypes);
+	return static_cast<uint32_t>(m_nodes.size() - 1);
+}
+
+size_t SearchIndex::findEdgePosition(const SearchNode& node, wchar_t c) const
 {
-	for (auto& p: e->target->edges)
+	auto begin = m_edges.begin() + node.edges.offset;
+	auto it = std::lower_bound(
+		begin, begin + node.edges.size, c, [this](const SearchEdge& edge, wchar_t c) {
+			return m_labels[edge.labelOffset] < c;
+		});
+	return it - begin;
+}
+
+uint32_t SearchIndex::packNode(
+	uint32_t nodeIndex,
+	std::vector<SearchNode>* nodes,
+	std::vector<SearchEdge>* edges,
+	std::vector<SearchElement>* elements,
+	std::wstring* labels) const
+{
+	const SearchNode& node = m_nodes[nodeIndex];
+
+	const uint32_t packedIndex = static_cast<uint32_t>(nodes->size());
+	nodes->push_back(node);
+
+	SearchNode& packedNode = nodes->back();
+	packedNode.elements.offset = static_cast<uint32_t>(elements->size());
+	packedNode.elements.capacity = node.elements.size;
+	packedNode.edges.offset = static_cast<uint32_t>(edges->size());
+	packedNode.edges.capacity = node.edges.size;
+
+	auto elementsBegin = m_elements.begin() + node.elements.offset;
+	elements->insert(elements->end(), elementsBegin, elementsBegin + node.elements.size);
+
+	// keep the labels of sibling edges next to each other
+	const uint32_t edgeOffset = static_cast<uint32_t>(edges->size());
+	for (uint32_t i = 0; i < node.edges.size; i++)
+	{
+		SearchEdge edge = m_edges[node.edges.offset + i];
+		edge.labelOffset = static_cast<uint32_t>(labels->size());
+		labels->append(m_labels, m_edges[node.edges.offset + i].labelOffset, edge.labelSize);
+		edges->push_back(edge);
+	}
+
+	for (uint32_t i = 0; i < node.edges.size; i++)
 	{
-		SearchEdge* targetEdge = p.second;
-		populateEdgeGate(targetEdge);
-		utility::append(e->gate, targetEdge->gate);
+		const uint32_t target = packNode(
+			(*edges)[edgeOffset + i].target, nodes, edges, elements, labels);
+		(*edges)[edgeOffset + i].target = target;
 	}
 
-	for (const wchar_t& c: e->s)
+	return packedIndex;
+}
+
+void SearchIndex::populateEdgeGate(uint32_t edgeIndex)
+{
+	const SearchRange& targetEdges = m_nodes[m_edges[edgeIndex].target].edges;
+	for (uint32_t i = targetEdges.offset; i < targetEdges.offset + targetEdges.size; i++)
 	{
-		e->gate.insert(towlower(c));
+		populateEdgeGate(i);
+		m_edges[edgeIndex].gate.add(m_edges[i].gate);
 	}
+
+	SearchEdge& edge = m_edges[edgeIndex];
+	edge.gate.addLowerCase(m_labels.data() + edge.labelOffset, edge.labelSize);
 }
 
 void SearchIndex::searchRecursive(
@@ -165,37 +366,35 @@ void SearchIndex::searchRecursive(
 	NodeTypeSet acceptedNodeTypes,
 	std::vector<SearchIndex::SearchPath>* results) const
 {
-	for (const auto& p: path.node->edges)
+	SearchGate queryGate;
+	for (const wchar_t& c: remainingQuery)
 	{
-		const SearchEdge* currentEdge = p.second;
+		queryGate.add(c);
+	}
+
+	const SearchRange& edges = m_nodes[path.node].edges;
+	for (uint32_t edgeIndex = edges.offset; edgeIndex < edges.offset + edges.size; edgeIndex++)
+	{
+		const SearchEdge& currentEdge = m_edges[edgeIndex];
 
-		if (!acceptedNodeTypes.intersectsWith(currentEdge->target->containedTypes))
+		if (!acceptedNodeTypes.intersectsWith(m_nodes[currentEdge.target].containedTypes))
 		{
 			continue;
 		}
 
 		// test if s passes the edge's gate.
-		bool passesGate = true;
-		for (const wchar_t& c: remainingQuery)
-		{
-			if (currentEdge->gate.find(c) == currentEdge->gate.end())
-			{
-				passesGate = false;
-				break;
-			}
-		}
-
-		if (!passesGate)
+		if (!currentEdge.gate.contains(queryGate))
 		{
 			continue;
 		}
 
 		// consume characters for edge
-		const std::wstring& edgeString = currentEdge->s;
-		SearchPath currentPath {path.text + edgeString, path.indices, currentEdge->target};
+		const wchar_t* edgeString = m_labels.data() + currentEdge.labelOffset;
+		SearchPath currentPath {path.text, path.indices, currentEdge.target};
+		currentPath.text.append(edgeString, currentEdge.labelSize);
 
 		size_t j = 0;
-		for (size_t i = 0; i < edgeString.size() && j < remainingQuery.size(); i++)
+		for (size_t i = 0; i < currentEdge.labelSize && j < remainingQuery.size(); i++)
 		{
 			if (towlower(edgeString[i]) == remainingQuery[j])
 			{
@@ -238,15 +437,17 @@ std::multiset<SearchResult> SearchIndex::createScoredResults(
 
 			for (const SearchPath& path: currentPaths)
 			{
-				if (!path.node->elementIds.empty() &&
-					(acceptedNodeTypes.intersectsWith(path.node->containedTypes)))
+				const SearchNode& node = m_nodes[path.node];
+
+				if (node.elements.size && (acceptedNodeTypes.intersectsWith(node.containedTypes)))
 				{
 					std::vector<Id> elementIds;
-					for (const auto& p: path.node->elementIds)
+					for (uint32_t i = 0; i < node.elements.size; i++)
 					{
-						if (acceptedNodeTypes.contains(p.second))
+						const SearchElement& element = m_elements[node.elements.offset + i];
+						if (acceptedNodeTypes.contains(element.type))
 						{
-							elementIds.push_back(p.first);
+							elementIds.push_back(element.id);
 						}
 					}
 
@@ -265,10 +466,13 @@ std::multiset<SearchResult> SearchIndex::createScoredResults(
 					}
 				}
 
-				for (auto p: path.node->edges)
+				for (uint32_t i = node.edges.offset; i < node.edges.offset + node.edges.size; i++)
 				{
-					const SearchEdge* edge = p.second;
-					nextPaths.emplace_back(path.text + edge->s, path.indices, edge->target);
+					const SearchEdge& edge = m_edges[i];
+					nextPaths.emplace_back(
+						path.text + m_labels.substr(edge.labelOffset, edge.labelSize),
+						path.indices,
+						edge.target);
 				}
 			}
 
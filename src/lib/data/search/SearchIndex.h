@@ -1,8 +1,8 @@
 #ifndef SEARCH_INDEX_H
 #define SEARCH_INDEX_H
 
+#include <cstdint>
 #include <map>
-#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -39,7 +39,9 @@ public:
 	SearchIndex();
 	virtual ~SearchIndex();
 
+	// Nodes can still be added and removed after finishing the setup.
 	void addNode(Id id, std::wstring name, NodeType type = NodeType(NODE_SYMBOL));
+	void removeNode(Id id, const std::wstring& name);
 	void finishSetup();
 	void clear();
 
@@ -51,39 +53,75 @@ public:
 		size_t maxBestScoredResultsLength = 0) const;
 
 private:
-	struct SearchEdge;
+	// The trie is stored in flat arrays that refer to each other by index. Every node owns a range
+	// of the edge array holding its outgoing edges sorted by their first character and a range of
+	// the element array sorted by id. A range that has to grow is moved to the end of its array,
+	// finishSetup() packs all arrays again in depth first order.
+	struct SearchRange
+	{
+		uint32_t offset = 0;
+		uint32_t size = 0;
+		uint32_t capacity = 0;
+	};
 
 	struct SearchNode
 	{
 		SearchNode(NodeTypeSet containedTypes): containedTypes(containedTypes) {}
 
-		std::map<Id, NodeType> elementIds;
 		NodeTypeSet containedTypes;
-		std::map<wchar_t, SearchEdge*> edges;
+		SearchRange edges;
+		SearchRange elements;
+	};
+
+	// Lowercase characters of an edge and all edges below it. Printable ASCII characters have a bit
+	// each, all other characters share the remaining bits. A shared bit can only let an edge pass
+	// that yields no match further down, so results are the same as for an exact set.
+	struct SearchGate
+	{
+		void add(wchar_t c);
+		void addLowerCase(const wchar_t* text, size_t size);
+		void add(const SearchGate& other);
+		bool contains(const SearchGate& other) const;
+
+		uint64_t bits[2] = {0, 0};
 	};
 
 	struct SearchEdge
 	{
-		SearchEdge(SearchNode* target, std::wstring s): target(target), s(std::move(s)) {}
+		uint32_t target = 0;
+		uint32_t labelOffset = 0;
+		uint32_t labelSize = 0;
+		SearchGate gate;
+	};
 
-		SearchNode* target;
-		std::wstring s;
-		std::set<wchar_t> gate;
+	struct SearchElement
+	{
+		Id id = 0;
+		NodeType type = NodeType(NODE_SYMBOL);
 	};
 
 	struct SearchPath
 	{
-		SearchPath(std::wstring text, std::vector<size_t> indices, SearchNode* node)
+		SearchPath(std::wstring text, std::vector<size_t> indices, uint32_t node)
 			: text(std::move(text)), indices(std::move(indices)), node(node)
 		{
 		}
 
 		std::wstring text;
 		std::vector<size_t> indices;
-		SearchNode* node;
+		uint32_t node;
 	};
 
-	void populateEdgeGate(SearchEdge* e);
+	uint32_t addSearchNode(NodeTypeSet containedTypes);
+	size_t findEdgePosition(const SearchNode& node, wchar_t c) const;
+
+	uint32_t packNode(
+		uint32_t nodeIndex,
+		std::vector<SearchNode>* nodes,
+		std::vector<SearchEdge>* edges,
+		std::vector<SearchElement>* elements,
+		std::wstring* labels) const;
+	void populateEdgeGate(uint32_t edgeIndex);
 	void searchRecursive(
 		const SearchPath& path,
 		const std::wstring& remainingQuery,
@@ -119,9 +157,11 @@ public:
 	static bool isNoLetter(const wchar_t c);
 
 private:
-	std::vector<std::unique_ptr<SearchNode>> m_nodes;
-	std::vector<std::unique_ptr<SearchEdge>> m_edges;
-	SearchNode* m_root;
+	std::vector<SearchNode> m_nodes;	   // the root is the first node
+	std::vector<SearchEdge> m_edges;
+	std::vector<SearchElement> m_elements;
+	std::wstring m_labels;
+	bool m_gatesPopulated = false;
 };
 
 #endif	  // SEARCH_INDEX_H
@@ -0,0 +1,491 @@
+#include "IndexSnapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "FileSystem.h"
+#include "SqliteIndexStorage.h"
+#include "logging.h"
+#include "tracing.h"
+
+namespace
+{
+const char SNAPSHOT_MAGIC[8] = {'S', 'R', 'C', 'T', 'S', 'N', 'A', 'P'};
+
+template <typename T>
+void appendColumn(std::vector<char>* buffer, size_t offset, const std::vector<T>& column)
+{
+	if (!column.empty())
+	{
+		std::memcpy(buffer->data() + offset, column.data(), column.size() * sizeof(T));
+	}
+}
+
+template <typename T>
+void reorderColumn(std::vector<T>* column, const std::vector<size_t>& order)
+{
+	std::vector<T> reordered;
+	reordered.reserve(column->size());
+	for (size_t index: order)
+	{
+		reordered.push_back((*column)[index]);
+	}
+	column->swap(reordered);
+}
+}	 // namespace
+
+const uint32_t IndexSnapshot::s_snapshotVersion = 1;
+
+FilePath IndexSnapshot::getSnapshotFilePath(const FilePath& indexDbFilePath)
+{
+	return FilePath(indexDbFilePath.wstr() + L"_snapshot");
+}
+
+IndexSnapshot::IndexSnapshot(): m_data(nullptr)
+{
+	clear();
+}
+
+bool IndexSnapshot::load(
+	const FilePath& filePath, size_t storageVersion, const std::string& timestamp)
+{
+	TRACE();
+
+	clear();
+
+	if (timestamp.empty() || timestamp.size() >= sizeof(Header::timestamp) || !filePath.exists())
+	{
+		return false;
+	}
+
+	std::shared_ptr<boost::interprocess::mapped_region> region;
+	try
+	{
+		boost::interprocess::file_mapping file(
+			filePath.str().c_str(), boost::interprocess::read_only);
+		region = std::make_shared<boost::interprocess::mapped_region>(
+			file, boost::interprocess::read_only);
+	}
+	catch (boost::interprocess::interprocess_exception& e)
+	{
+		LOG_WARNING(
+			"Unable to map index snapshot \"" + filePath.str() + "\": " + std::string(e.what()));
+		return false;
+	}
+
+	if (!setData(static_cast<const char*>(region->get_address()), region->get_size()))
+	{
+		LOG_WARNING("Discarding malformed index snapshot \"" + filePath.str() + "\"");
+		clear();
+		return false;
+	}
+
+	if (m_header.storageVersion != storageVersion ||
+		std::string(m_header.timestamp) != timestamp)
+	{
+		LOG_INFO("Discarding outdated index snapshot \"" + filePath.str() + "\"");
+		clear();
+		return false;
+	}
+
+	m_mapping = region;
+	return true;
+}
+
+void IndexSnapshot::build(
+	const SqliteIndexStorage& storage, size_t storageVersion, const std::string& timestamp)
+{
+	TRACE();
+
+	clear();
+
+	std::vector<wchar_t> strings;
+	auto addString = [&strings](const std::wstring& str, std::vector<uint64_t>* offsets,
+								std::vector<uint32_t>* lengths) {
+		offsets->push_back(strings.size());
+		lengths->push_back(static_cast<uint32_t>(str.size()));
+		strings.insert(strings.end(), str.begin(), str.end());
+	};
+
+	std::vector<uint64_t> nodeIds;
+	std::vector<int32_t> nodeTypes;
+	std::vector<uint64_t> nodeNameOffsets;
+	std::vector<uint32_t> nodeNameLengths;
+	storage.forEach<StorageNode>([&](StorageNode&& node) {
+		nodeIds.push_back(node.id);
+		nodeTypes.push_back(node.type);
+		addString(node.serializedName, &nodeNameOffsets, &nodeNameLengths);
+	});
+
+	// nodes are looked up by id, so they have to be ordered
+	if (!std::is_sorted(nodeIds.begin(), nodeIds.end()))
+	{
+		std::vector<size_t> order(nodeIds.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&nodeIds](size_t a, size_t b) {
+			return nodeIds[a] < nodeIds[b];
+		});
+
+		reorderColumn(&nodeIds, order);
+		reorderColumn(&nodeTypes, order);
+		reorderColumn(&nodeNameOffsets, order);
+		reorderColumn(&nodeNameLengths, order);
+	}
+
+	std::vector<uint64_t> fileIds;
+	std::vector<uint64_t> filePathOffsets;
+	std::vector<uint32_t> filePathLengths;
+	std::vector<uint64_t> fileLanguageOffsets;
+	std::vector<uint32_t> fileLanguageLengths;
+	std::vector<uint8_t> fileFlags;
+	storage.forEach<StorageFile>([&](StorageFile&& file) {
+		fileIds.push_back(file.id);
+		addString(file.filePath, &filePathOffsets, &filePathLengths);
+		addString(file.languageIdentifier, &fileLanguageOffsets, &fileLanguageLengths);
+		fileFlags.push_back(
+			(file.indexed ? FILE_FLAG_INDEXED : 0) | (file.complete ? FILE_FLAG_COMPLETE : 0));
+	});
+
+	std::vector<uint64_t> symbolIds;
+	std::vector<int32_t> symbolDefinitionKinds;
+	storage.forEach<StorageSymbol>([&](StorageSymbol&& symbol) {
+		symbolIds.push_back(symbol.id);
+		symbolDefinitionKinds.push_back(symbol.definitionKind);
+	});
+
+	std::vector<uint64_t> edgeIds;
+	std::vector<int32_t> edgeTypes;
+	std::vector<uint64_t> edgeSourceIds;
+	std::vector<uint64_t> edgeTargetIds;
+	storage.forEach<StorageEdge>([&](StorageEdge&& edge) {
+		edgeIds.push_back(edge.id);
+		edgeTypes.push_back(edge.type);
+		edgeSourceIds.push_back(edge.sourceNodeId);
+		edgeTargetIds.push_back(edge.targetNodeId);
+	});
+
+	Header header;
+	std::memset(&header, 0, sizeof(Header));
+	std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.snapshotVersion = s_snapshotVersion;
+	header.storageVersion = static_cast<uint32_t>(storageVersion);
+	header.wideCharSize = sizeof(wchar_t);
+	std::strncpy(header.timestamp, timestamp.c_str(), sizeof(header.timestamp) - 1);
+	header.nodeCount = nodeIds.size();
+	header.fileCount = fileIds.size();
+	header.symbolCount = symbolIds.size();
+	header.edgeCount = edgeIds.size();
+	header.stringCount = strings.size();
+
+	const Layout layout = getLayout(header);
+
+	m_buffer.assign(layout.totalSize, 0);
+	std::memcpy(m_buffer.data(), &header, sizeof(Header));
+
+	appendColumn(&m_buffer, layout.nodeIds, nodeIds);
+	appendColumn(&m_buffer, layout.nodeTypes, nodeTypes);
+	appendColumn(&m_buffer, layout.nodeNameOffsets, nodeNameOffsets);
+	appendColumn(&m_buffer, layout.nodeNameLengths, nodeNameLengths);
+	appendColumn(&m_buffer, layout.fileIds, fileIds);
+	appendColumn(&m_buffer, layout.filePathOffsets, filePathOffsets);
+	appendColumn(&m_buffer, layout.filePathLengths, filePathLengths);
+	appendColumn(&m_buffer, layout.fileLanguageOffsets, fileLanguageOffsets);
+	appendColumn(&m_buffer, layout.fileLanguageLengths, fileLanguageLengths);
+	appendColumn(&m_buffer, layout.fileFlags, fileFlags);
+	appendColumn(&m_buffer, layout.symbolIds, symbolIds);
+	appendColumn(&m_buffer, layout.symbolDefinitionKinds, symbolDefinitionKinds);
+	appendColumn(&m_buffer, layout.edgeIds, edgeIds);
+	appendColumn(&m_buffer, layout.edgeTypes, edgeTypes);
+	appendColumn(&m_buffer, layout.edgeSourceIds, edgeSourceIds);
+	appendColumn(&m_buffer, layout.edgeTargetIds, edgeTargetIds);
+	appendColumn(&m_buffer, layout.strings, strings);
+
+	setData(m_buffer.data(), m_buffer.size());
+}
+
+bool IndexSnapshot::save(const FilePath& filePath) const
+{
+	TRACE();
+
+	if (isEmpty())
+	{
+		return false;
+	}
+
+	// write to a temporary file first, so a crash never leaves a partially written snapshot
+	const FilePath tempFilePath(filePath.wstr() + L"_tmp");
+	{
+		std::ofstream fileStream;
+		fileStream.open(tempFilePath.str(), std::ios::binary | std::ios::trunc);
+		fileStream.write(m_data, m_layout.totalSize);
+		fileStream.close();
+
+		if (fileStream.fail())
+		{
+			LOG_WARNING("Unable to write index snapshot \"" + tempFilePath.str() + "\"");
+			FileSystem::remove(tempFilePath);
+			return false;
+		}
+	}
+
+	FileSystem::remove(filePath);
+	try
+	{
+		if (FileSystem::rename(tempFilePath, filePath))
+		{
+			return true;
+		}
+	}
+	catch (std::exception& e)
+	{
+		LOG_WARNING("Unable to replace index snapshot: " + std::string(e.what()));
+	}
+
+	FileSystem::remove(tempFilePath);
+	return false;
+}
+
+void IndexSnapshot::clear()
+{
+	m_mapping.reset();
+	m_buffer.clear();
+	m_buffer.shrink_to_fit();
+
+	m_data = nullptr;
+	std::memset(&m_header, 0, sizeof(Header));
+	m_layout = getLayout(m_header);
+}
+
+bool IndexSnapshot::isEmpty() const
+{
+	return m_data == nullptr;
+}
+
+bool IndexSnapshot::isMapped() const
+{
+	return m_mapping != nullptr;
+}
+
+size_t IndexSnapshot::getNodeCount() const
+{
+	return static_cast<size_t>(m_header.nodeCount);
+}
+
+size_t IndexSnapshot::getFileCount() const
+{
+	return static_cast<size_t>(m_header.fileCount);
+}
+
+size_t IndexSnapshot::getSymbolCount() const
+{
+	return static_cast<size_t>(m_header.symbolCount);
+}
+
+size_t IndexSnapshot::getEdgeCount() const
+{
+	return static_cast<size_t>(m_header.edgeCount);
+}
+
+template <>
+void IndexSnapshot::forEach<StorageNode>(std::function<void(StorageNode&&)> func) const
+{
+	for (size_t i = 0; i < getNodeCount(); i++)
+	{
+		func(getNodeAt(i));
+	}
+}
+
+template <>
+void IndexSnapshot::forEach<StorageFile>(std::function<void(StorageFile&&)> func) const
+{
+	const uint64_t* ids = getColumn<uint64_t>(m_layout.fileIds);
+	const uint64_t* pathOffsets = getColumn<uint64_t>(m_layout.filePathOffsets);
+	const uint32_t* pathLengths = getColumn<uint32_t>(m_layout.filePathLengths);
+	const uint64_t* languageOffsets = getColumn<uint64_t>(m_layout.fileLanguageOffsets);
+	const uint32_t* languageLengths = getColumn<uint32_t>(m_layout.fileLanguageLengths);
+	const uint8_t* flags = getColumn<uint8_t>(m_layout.fileFlags);
+
+	for (size_t i = 0; i < getFileCount(); i++)
+	{
+		// the modification time is not part of the snapshot
+		func(StorageFile(
+			static_cast<Id>(ids[i]),
+			getString(pathOffsets[i], pathLengths[i]),
+			getString(languageOffsets[i], languageLengths[i]),
+			"",
+			(flags[i] & FILE_FLAG_INDEXED) != 0,
+			(flags[i] & FILE_FLAG_COMPLETE) != 0));
+	}
+}
+
+template <>
+void IndexSnapshot::forEach<StorageSymbol>(std::function<void(StorageSymbol&&)> func) const
+{
+	const uint64_t* ids = getColumn<uint64_t>(m_layout.symbolIds);
+	const int32_t* definitionKinds = getColumn<int32_t>(m_layout.symbolDefinitionKinds);
+
+	for (size_t i = 0; i < getSymbolCount(); i++)
+	{
+		func(StorageSymbol(static_cast<Id>(ids[i]), definitionKinds[i]));
+	}
+}
+
+template <>
+void IndexSnapshot::forEach<StorageEdge>(std::function<void(StorageEdge&&)> func) const
+{
+	for (size_t i = 0; i < getEdgeCount(); i++)
+	{
+		func(getEdgeAt(i));
+	}
+}
+
+template <>
+void IndexSnapshot::forEachOfType<StorageEdge>(
+	int type, std::function<void(StorageEdge&&)> func) const
+{
+	const int32_t* types = getColumn<int32_t>(m_layout.edgeTypes);
+
+	for (size_t i = 0; i < getEdgeCount(); i++)
+	{
+		if (types[i] == type)
+		{
+			func(getEdgeAt(i));
+		}
+	}
+}
+
+template <>
+void IndexSnapshot::forEachByIds<StorageNode>(
+	const std::vector<Id>& ids, std::function<void(StorageNode&&)> func) const
+{
+	const uint64_t* nodeIds = getColumn<uint64_t>(m_layout.nodeIds);
+	const uint64_t* nodeIdsEnd = nodeIds + getNodeCount();
+
+	std::vector<Id> sortedIds = ids;
+	std::sort(sortedIds.begin(), sortedIds.end());
+	sortedIds.erase(std::unique(sortedIds.begin(), sortedIds.end()), sortedIds.end());
+
+	const uint64_t* it = nodeIds;
+	for (Id id: sortedIds)
+	{
+		it = std::lower_bound(it, nodeIdsEnd, static_cast<uint64_t>(id));
+		if (it == nodeIdsEnd)
+		{
+			break;
+		}
+
+		if (*it == id)
+		{
+			func(getNodeAt(it - nodeIds));
+		}
+	}
+}
+
+IndexSnapshot::Layout IndexSnapshot::getLayout(const Header& header)
+{
+	size_t offset = sizeof(Header);
+	auto reserve = [&offset](uint64_t count, size_t elementSize) {
+		const size_t start = offset;
+		offset += static_cast<size_t>(count) * elementSize;
+		offset = (offset + 7) & ~size_t(7);
+		return start;
+	};
+
+	Layout layout;
+	layout.nodeIds = reserve(header.nodeCount, sizeof(uint64_t));
+	layout.nodeTypes = reserve(header.nodeCount, sizeof(int32_t));
+	layout.nodeNameOffsets = reserve(header.nodeCount, sizeof(uint64_t));
+	layout.nodeNameLengths = reserve(header.nodeCount, sizeof(uint32_t));
+	layout.fileIds = reserve(header.fileCount, sizeof(uint64_t));
+	layout.filePathOffsets = reserve(header.fileCount, sizeof(uint64_t));
+	layout.filePathLengths = reserve(header.fileCount, sizeof(uint32_t));
+	layout.fileLanguageOffsets = reserve(header.fileCount, sizeof(uint64_t));
+	layout.fileLanguageLengths = reserve(header.fileCount, sizeof(uint32_t));
+	layout.fileFlags = reserve(header.fileCount, sizeof(uint8_t));
+	layout.symbolIds = reserve(header.symbolCount, sizeof(uint64_t));
+	layout.symbolDefinitionKinds = reserve(header.symbolCount, sizeof(int32_t));
+	layout.edgeIds = reserve(header.edgeCount, sizeof(uint64_t));
+	layout.edgeTypes = reserve(header.edgeCount, sizeof(int32_t));
+	layout.edgeSourceIds = reserve(header.edgeCount, sizeof(uint64_t));
+	layout.edgeTargetIds = reserve(header.edgeCount, sizeof(uint64_t));
+	layout.strings = reserve(header.stringCount, sizeof(wchar_t));
+	layout.totalSize = offset;
+	return layout;
+}
+
+std::wstring IndexSnapshot::getString(uint64_t offset, uint32_t length) const
+{
+	if (offset + length > m_header.stringCount)
+	{
+		return L"";
+	}
+
+	const wchar_t* strings = getColumn<wchar_t>(m_layout.strings);
+	return std::wstring(strings + offset, length);
+}
+
+StorageNode IndexSnapshot::getNodeAt(size_t index) const
+{
+	return StorageNode(
+		static_cast<Id>(getColumn<uint64_t>(m_layout.nodeIds)[index]),
+		getColumn<int32_t>(m_layout.nodeTypes)[index],
+		getString(
+			getColumn<uint64_t>(m_layout.nodeNameOffsets)[index],
+			getColumn<uint32_t>(m_layout.nodeNameLengths)[index]));
+}
+
+StorageEdge IndexSnapshot::getEdgeAt(size_t index) const
+{
+	return StorageEdge(
+		static_cast<Id>(getColumn<uint64_t>(m_layout.edgeIds)[index]),
+		getColumn<int32_t>(m_layout.edgeTypes)[index],
+		static_cast<Id>(getColumn<uint64_t>(m_layout.edgeSourceIds)[index]),
+		static_cast<Id>(getColumn<uint64_t>(m_layout.edgeTargetIds)[index]));
+}
+
+bool IndexSnapshot::setData(const char* data, size_t size)
+{
+	if (data == nullptr || size < sizeof(Header))
+	{
+		return false;
+	}
+
+	Header header;
+	std::memcpy(&header, data, sizeof(Header));
+
+	if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+		header.snapshotVersion != s_snapshotVersion || header.wideCharSize != sizeof(wchar_t) ||
+		header.timestamp[sizeof(header.timestamp) - 1] != '\0')
+	{
+		return false;
+	}
+
+	// reject counts that cannot fit into the data before computing any offsets
+	for (uint64_t count: {header.nodeCount,
+						  header.fileCount,
+						  header.symbolCount,
+						  header.edgeCount,
+						  header.stringCount})
+	{
+		if (count > size)
+		{
+			return false;
+		}
+	}
+
+	const Layout layout = getLayout(header);
+	if (layout.totalSize != size)
+	{
+		return false;
+	}
+
+	m_data = data;
+	m_header = header;
+	m_layout = layout;
+	return true;
+}
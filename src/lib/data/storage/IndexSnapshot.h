@@ -0,0 +1,135 @@
+#ifndef INDEX_SNAPSHOT_H
+#define INDEX_SNAPSHOT_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FilePath.h"
+#include "StorageEdge.h"
+#include "StorageFile.h"
+#include "StorageNode.h"
+#include "StorageSymbol.h"
+#include "types.h"
+
+class SqliteIndexStorage;
+
+// Read-only columnar copy of the node, file, symbol and edge tables of an index database. The
+// snapshot is stored next to the database file and gets memory mapped on load, so the caches of
+// PersistentStorage can be built without decoding every row through SQLite. The database stays the
+// source of truth: a snapshot is only accepted if its storage version and timestamp match.
+class IndexSnapshot
+{
+public:
+	static FilePath getSnapshotFilePath(const FilePath& indexDbFilePath);
+
+	IndexSnapshot();
+
+	bool load(const FilePath& filePath, size_t storageVersion, const std::string& timestamp);
+	void build(
+		const SqliteIndexStorage& storage, size_t storageVersion, const std::string& timestamp);
+	bool save(const FilePath& filePath) const;
+	void clear();
+
+	bool isEmpty() const;
+	bool isMapped() const;
+
+	size_t getNodeCount() const;
+	size_t getFileCount() const;
+	size_t getSymbolCount() const;
+	size_t getEdgeCount() const;
+
+	template <typename StorageType>
+	void forEach(std::function<void(StorageType&&)> func) const;
+
+	template <typename StorageType>
+	void forEachOfType(int type, std::function<void(StorageType&&)> func) const;
+
+	template <typename StorageType>
+	void forEachByIds(const std::vector<Id>& ids, std::function<void(StorageType&&)> func) const;
+
+private:
+	static const uint32_t s_snapshotVersion;
+
+	struct Header
+	{
+		char magic[8];
+		uint32_t snapshotVersion;
+		uint32_t storageVersion;
+		uint32_t wideCharSize;
+		uint32_t reserved;
+		char timestamp[32];
+		uint64_t nodeCount;
+		uint64_t fileCount;
+		uint64_t symbolCount;
+		uint64_t edgeCount;
+		uint64_t stringCount;
+	};
+
+	struct Layout
+	{
+		size_t nodeIds;
+		size_t nodeTypes;
+		size_t nodeNameOffsets;
+		size_t nodeNameLengths;
+		size_t fileIds;
+		size_t filePathOffsets;
+		size_t filePathLengths;
+		size_t fileLanguageOffsets;
+		size_t fileLanguageLengths;
+		size_t fileFlags;
+		size_t symbolIds;
+		size_t symbolDefinitionKinds;
+		size_t edgeIds;
+		size_t edgeTypes;
+		size_t edgeSourceIds;
+		size_t edgeTargetIds;
+		size_t strings;
+		size_t totalSize;
+	};
+
+	enum FileFlag : uint8_t
+	{
+		FILE_FLAG_INDEXED = 1,
+		FILE_FLAG_COMPLETE = 2
+	};
+
+	static Layout getLayout(const Header& header);
+
+	template <typename T>
+	const T* getColumn(size_t offset) const
+	{
+		return reinterpret_cast<const T*>(m_data + offset);
+	}
+
+	std::wstring getString(uint64_t offset, uint32_t length) const;
+	StorageNode getNodeAt(size_t index) const;
+	StorageEdge getEdgeAt(size_t index) const;
+
+	bool setData(const char* data, size_t size);
+
+	std::shared_ptr<void> m_mapping;
+	std::vector<char> m_buffer;
+
+	const char* m_data;
+	Header m_header;
+	Layout m_layout;
+};
+
+template <>
+void IndexSnapshot::forEach<StorageNode>(std::function<void(StorageNode&&)> func) const;
+template <>
+void IndexSnapshot::forEach<StorageFile>(std::function<void(StorageFile&&)> func) const;
+template <>
+void IndexSnapshot::forEach<StorageSymbol>(std::function<void(StorageSymbol&&)> func) const;
+template <>
+void IndexSnapshot::forEach<StorageEdge>(std::function<void(StorageEdge&&)> func) const;
+template <>
+void IndexSnapshot::forEachOfType<StorageEdge>(
+	int type, std::function<void(StorageEdge&&)> func) const;
+template <>
+void IndexSnapshot::forEachByIds<StorageNode>(
+	const std::vector<Id>& ids, std::function<void(StorageNode&&)> func) const;
+
+#endif	  // INDEX_SNAPSHOT_H
@@ -1,9 +1,134 @@
 #include "IntermediateStorage.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <set>
+
 #include "LocationType.h"
 #include "utility.h"
 
-IntermediateStorage::IntermediateStorage(): m_nextId(1) {}
+namespace
+{
+// number of unsorted elements that may pile up before duplicates are removed
+const size_t s_minUnsortedCount = 1024;
+
+size_t mixHash(uint64_t value)
+{
+	value ^= value >> 31;
+	value *= 0x7fb5d329728ea185ULL;
+	value ^= value >> 27;
+	return static_cast<size_t>(value);
+}
+
+size_t combineHash(size_t seed, uint64_t value)
+{
+	return mixHash(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+// the hashes only cover the members compared by operator< of the respective type
+size_t getHash(const StorageNodeData& node)
+{
+	return std::hash<std::wstring>()(node.serializedName);
+}
+
+size_t getHash(const StorageFile& file)
+{
+	return std::hash<std::wstring>()(file.filePath);
+}
+
+size_t getHash(const StorageEdgeData& edge)
+{
+	return combineHash(combineHash(mixHash(edge.type), edge.sourceNodeId), edge.targetNodeId);
+}
+
+size_t getHash(const StorageLocalSymbolData& localSymbol)
+{
+	return std::hash<std::wstring>()(localSymbol.name);
+}
+
+size_t getHash(const StorageSourceLocationData& location)
+{
+	size_t hash = mixHash(location.fileNodeId);
+	hash = combineHash(hash, location.startLine);
+	hash = combineHash(hash, location.startCol);
+	hash = combineHash(hash, location.endLine);
+	hash = combineHash(hash, location.endCol);
+	return combineHash(hash, location.type);
+}
+
+size_t getHash(const StorageErrorData& error)
+{
+	size_t hash = std::hash<std::wstring>()(error.message);
+	hash = combineHash(hash, std::hash<std::wstring>()(error.translationUnit));
+	return combineHash(hash, (error.fatal ? 2 : 0) + (error.indexed ? 1 : 0));
+}
+
+template <typename T>
+bool isEquivalent(const T& a, const T& b)
+{
+	return !(a < b) && !(b < a);
+}
+
+// Sorts the unsorted tail, merges it into the sorted part and keeps the first inserted element of
+// every group of equivalent elements, like inserting into a std::set would.
+template <typename T>
+void sortUnique(std::vector<T>* elements, size_t* sortedCount)
+{
+	if (*sortedCount == elements->size())
+	{
+		return;
+	}
+
+	const auto middle = elements->begin() + *sortedCount;
+	std::stable_sort(middle, elements->end());
+	std::inplace_merge(elements->begin(), middle, elements->end());
+	elements->erase(
+		std::unique(elements->begin(), elements->end(), isEquivalent<T>), elements->end());
+	*sortedCount = elements->size();
+}
+
+template <typename T>
+void sortUnique(std::vector<T>* elements, size_t* sortedCount, FlatHashIndex* index)
+{
+	if (*sortedCount != elements->size())
+	{
+		sortUnique(elements, sortedCount);
+		index->rebuild(elements->size(), [elements](size_t i) { return getHash((*elements)[i]); });
+	}
+}
+
+template <typename T>
+void addUnsorted(const T& element, std::vector<T>* elements, size_t* sortedCount)
+{
+	elements->push_back(element);
+	if (elements->size() >= *sortedCount * 2 + s_minUnsortedCount)
+	{
+		sortUnique(elements, sortedCount);
+	}
+}
+
+template <typename T>
+void addUnsorted(const std::vector<T>& newElements, std::vector<T>* elements, size_t* sortedCount)
+{
+	elements->insert(elements->end(), newElements.begin(), newElements.end());
+	if (elements->size() >= *sortedCount * 2 + s_minUnsortedCount)
+	{
+		sortUnique(elements, sortedCount);
+	}
+}
+}	 // namespace
+
+IntermediateStorage::IntermediateStorage()
+	: m_sortedLocalSymbolCount(0)
+	, m_sortedSourceLocationCount(0)
+	, m_sortedOccurrenceCount(0)
+	, m_sortedComponentAccessCount(0)
+	, m_sortedElementComponentCount(0)
+	, m_indicesOutdated(false)
+	, m_nextId(1)
+{
+}
 
 void IntermediateStorage::clear()
 {
@@ -20,14 +145,27 @@ void IntermediateStorage::clear()
 	m_edgesIndex.clear();
 	m_edges.clear();
 
+	m_localSymbolsIndex.clear();
 	m_localSymbols.clear();
+	m_sortedLocalSymbolCount = 0;
+
+	m_sourceLocationsIndex.clear();
 	m_sourceLocations.clear();
+	m_sortedSourceLocationCount = 0;
+
 	m_occurrences.clear();
+	m_sortedOccurrenceCount = 0;
+
 	m_componentAccesses.clear();
+	m_sortedComponentAccessCount = 0;
+
+	m_elementComponents.clear();
+	m_sortedElementComponentCount = 0;
 
 	m_errorsIndex.clear();
 	m_errors.clear();
 
+	m_indicesOutdated = false;
 	m_nextId = 1;
 }
 
@@ -118,10 +256,15 @@ void IntermediateStorage::setFilesWithErrorsIncomplete()
 
 std::pair<Id, bool> IntermediateStorage::addNode(const StorageNodeData& nodeData)
 {
-	auto it = m_nodesIndex.find(nodeData);
-	if (it != m_nodesIndex.end())
+	updateIndices();
+
+	const size_t hash = getHash(nodeData);
+	const size_t index = m_nodesIndex.find(hash, [&](size_t i) {
+		return isEquivalent<StorageNodeData>(m_nodes[i], nodeData);
+	});
+	if (index != FlatHashIndex::s_notFound)
 	{
-		StorageNode& storedNode = m_nodes[it->second];
+		StorageNode& storedNode = m_nodes[index];
 		if (storedNode.type < nodeData.type)
 		{
 			storedNode.type = nodeData.type;
@@ -131,8 +274,8 @@ std::pair<Id, bool> IntermediateStorage::addNode(const StorageNodeData& nodeData
 
 	Id nodeId = m_nextId++;
 	m_nodes.emplace_back(nodeId, nodeData);
-	m_nodesIndex.emplace(nodeData, m_nodes.size() - 1);
-	m_nodeIdIndex.emplace(nodeId, m_nodes.size() - 1);
+	m_nodesIndex.insert(hash, m_nodes.size() - 1);
+	m_nodeIdIndex.insert(mixHash(nodeId), m_nodes.size() - 1);
 	return std::make_pair(nodeId, true);
 }
 
@@ -149,10 +292,13 @@ std::vector<Id> IntermediateStorage::addNodes(const std::vector<StorageNode>& no
 
 void IntermediateStorage::setNodeType(Id nodeId, int nodeType)
 {
-	auto it = m_nodeIdIndex.find(nodeId);
-	if (it != m_nodeIdIndex.end() && m_nodes[it->second].type < nodeType)
+	updateIndices();
+
+	const size_t index = m_nodeIdIndex.find(
+		mixHash(nodeId), [&](size_t i) { return m_nodes[i].id == nodeId; });
+	if (index != FlatHashIndex::s_notFound && m_nodes[index].type < nodeType)
 	{
-		m_nodes[it->second].type = nodeType;
+		m_nodes[index].type = nodeType;
 	}
 }
 
@@ -168,10 +314,14 @@ void IntermediateStorage::addSymbols(const std::vector<StorageSymbol>& symbols)
 
 void IntermediateStorage::addFile(const StorageFile& file)
 {
-	auto it = m_filesIndex.find(file);
-	if (it != m_filesIndex.end())
+	updateIndices();
+
+	const size_t hash = getHash(file);
+	const size_t index = m_filesIndex.find(
+		hash, [&](size_t i) { return isEquivalent(m_files[i], file); });
+	if (index != FlatHashIndex::s_notFound)
 	{
-		StorageFile& storedFile = m_files[it->second];
+		StorageFile& storedFile = m_files[index];
 
 		if (file.indexed)
 		{
@@ -190,32 +340,40 @@ void IntermediateStorage::addFile(const StorageFile& file)
 	}
 	else
 	{
-		m_filesIndex.emplace(file, m_files.size());
-		m_filesIdIndex.emplace(file.id, m_files.size());
+		m_filesIndex.insert(hash, m_files.size());
+		m_filesIdIndex.insert(mixHash(file.id), m_files.size());
 		m_files.emplace_back(file);
 	}
 }
 
 void IntermediateStorage::setFileLanguage(Id fileId, const std::wstring& languageIdentifier)
 {
-	auto it = m_filesIdIndex.find(fileId);
-	if (it != m_filesIdIndex.end())
+	updateIndices();
+
+	const size_t index = m_filesIdIndex.find(
+		mixHash(fileId), [&](size_t i) { return m_files[i].id == fileId; });
+	if (index != FlatHashIndex::s_notFound)
 	{
-		m_files[it->second].languageIdentifier = languageIdentifier;
+		m_files[index].languageIdentifier = languageIdentifier;
 	}
 }
 
 Id IntermediateStorage::addEdge(const StorageEdgeData& edgeData)
 {
-	auto it = m_edgesIndex.find(edgeData);
-	if (it != m_edgesIndex.end())
+	updateIndices();
+
+	const size_t hash = getHash(edgeData);
+	const size_t index = m_edgesIndex.find(hash, [&](size_t i) {
+		return isEquivalent<StorageEdgeData>(m_edges[i], edgeData);
+	});
+	if (index != FlatHashIndex::s_notFound)
 	{
-		return m_edges[it->second].id;
+		return m_edges[index].id;
 	}
 
 	Id edgeId = m_nextId++;
 	m_edges.emplace_back(edgeId, edgeData);
-	m_edgesIndex.emplace(edgeData, m_edges.size() - 1);
+	m_edgesIndex.insert(hash, m_edges.size() - 1);
 	return edgeId;
 }
 
@@ -232,18 +390,24 @@ std::vector<Id> IntermediateStorage::addEdges(const std::vector<StorageEdge>& ed
 
 Id IntermediateStorage::addLocalSymbol(const StorageLocalSymbolData& localSymbolData)
 {
-	auto it = m_localSymbols.find(StorageLocalSymbol(0, localSymbolData));
-	if (it != m_localSymbols.end())
+	updateIndices();
+
+	const size_t hash = getHash(localSymbolData);
+	const size_t index = m_localSymbolsIndex.find(hash, [&](size_t i) {
+		return isEquivalent<StorageLocalSymbolData>(m_localSymbols[i], localSymbolData);
+	});
+	if (index != FlatHashIndex::s_notFound)
 	{
-		return it->id;
+		return m_localSymbols[index].id;
 	}
 
 	Id localSymbolId = m_nextId++;
-	m_localSymbols.emplace(localSymbolId, localSymbolData);
+	m_localSymbols.emplace_back(localSymbolId, localSymbolData);
+	m_localSymbolsIndex.insert(hash, m_localSymbols.size() - 1);
 	return localSymbolId;
 }
 
-std::vector<Id> IntermediateStorage::addLocalSymbols(const std::set<StorageLocalSymbol>& symbols)
+std::vector<Id> IntermediateStorage::addLocalSymbols(const std::vector<StorageLocalSymbol>& symbols)
 {
 	std::vector<Id> symbolIds;
 	symbolIds.reserve(symbols.size());
@@ -256,14 +420,20 @@ std::vector<Id> IntermediateStorage::addLocalSymbols(const std::set<StorageLocal
 
 Id IntermediateStorage::addSourceLocation(const StorageSourceLocationData& sourceLocationData)
 {
-	auto it = m_sourceLocations.find(StorageSourceLocation(0, sourceLocationData));
-	if (it != m_sourceLocations.end())
+	updateIndices();
+
+	const size_t hash = getHash(sourceLocationData);
+	const size_t index = m_sourceLocationsIndex.find(hash, [&](size_t i) {
+		return isEquivalent<StorageSourceLocationData>(m_sourceLocations[i], sourceLocationData);
+	});
+	if (index != FlatHashIndex::s_notFound)
 	{
-		return it->id;
+		return m_sourceLocations[index].id;
 	}
 
 	Id sourceLocationId = m_nextId++;
-	m_sourceLocations.emplace(sourceLocationId, sourceLocationData);
+	m_sourceLocations.emplace_back(sourceLocationId, sourceLocationData);
+	m_sourceLocationsIndex.insert(hash, m_sourceLocations.size() - 1);
 	return sourceLocationId;
 }
 
@@ -280,45 +450,50 @@ std::vector<Id> IntermediateStorage::addSourceLocations(const std::vector<Storag
 
 void IntermediateStorage::addOccurrence(const StorageOccurrence& occurrence)
 {
-	m_occurrences.emplace(occurrence);
+	addUnsorted(occurrence, &m_occurrences, &m_sortedOccurrenceCount);
 }
 
 void IntermediateStorage::addOccurrences(const std::vector<StorageOccurrence>& occurrences)
 {
-	m_occurrences.insert(occurrences.begin(), occurrences.end());
+	addUnsorted(occurrences, &m_occurrences, &m_sortedOccurrenceCount);
 }
 
 void IntermediateStorage::addComponentAccess(const StorageComponentAccess& componentAccess)
 {
-	m_componentAccesses.emplace(componentAccess);
+	addUnsorted(componentAccess, &m_componentAccesses, &m_sortedComponentAccessCount);
 }
 
 void IntermediateStorage::addComponentAccesses(const std::vector<StorageComponentAccess>& componentAccesses)
 {
-	m_componentAccesses.insert(componentAccesses.begin(), componentAccesses.end());
+	addUnsorted(componentAccesses, &m_componentAccesses, &m_sortedComponentAccessCount);
 }
 
 void IntermediateStorage::addElementComponent(const StorageElementComponent& component)
 {
-	m_elementComponents.emplace(component);
+	addUnsorted(component, &m_elementComponents, &m_sortedElementComponentCount);
 }
 
 void IntermediateStorage::addElementComponents(const std::vector<StorageElementComponent>& components)
 {
-	m_elementComponents.insert(components.begin(), components.end());
+	addUnsorted(components, &m_elementComponents, &m_sortedElementComponentCount);
 }
 
 Id IntermediateStorage::addError(const StorageErrorData& errorData)
 {
-	auto it = m_errorsIndex.find(errorData);
-	if (it != m_errorsIndex.end())
+	updateIndices();
+
+	const size_t hash = getHash(errorData);
+	const size_t index = m_errorsIndex.find(hash, [&](size_t i) {
+		return isEquivalent<StorageErrorData>(m_errors[i], errorData);
+	});
+	if (index != FlatHashIndex::s_notFound)
 	{
-		return m_errors[it->second].id;
+		return m_errors[index].id;
 	}
 
 	Id errorId = m_nextId++;
 	m_errors.emplace_back(errorId, errorData);
-	m_errorsIndex.emplace(errorData, m_errors.size() - 1);
+	m_errorsIndex.insert(hash, m_errors.size() - 1);
 	return errorId;
 }
 
@@ -342,28 +517,33 @@ const std::vector<StorageEdge>& IntermediateStorage::getStorageEdges() const
 	return m_edges;
 }
 
-const std::set<StorageLocalSymbol>& IntermediateStorage::getStorageLocalSymbols() const
+const std::vector<StorageLocalSymbol>& IntermediateStorage::getStorageLocalSymbols() const
 {
+	sortUnique(&m_localSymbols, &m_sortedLocalSymbolCount, &m_localSymbolsIndex);
 	return m_localSymbols;
 }
 
-const std::set<StorageSourceLocation>& IntermediateStorage::getStorageSourceLocations() const
+const std::vector<StorageSourceLocation>& IntermediateStorage::getStorageSourceLocations() const
 {
+	sortUnique(&m_sourceLocations, &m_sortedSourceLocationCount, &m_sourceLocationsIndex);
 	return m_sourceLocations;
 }
 
-const std::set<StorageOccurrence>& IntermediateStorage::getStorageOccurrences() const
+const std::vector<StorageOccurrence>& IntermediateStorage::getStorageOccurrences() const
 {
+	sortUnique(&m_occurrences, &m_sortedOccurrenceCount);
 	return m_occurrences;
 }
 
-const std::set<StorageComponentAccess>& IntermediateStorage::getComponentAccesses() const
+const std::vector<StorageComponentAccess>& IntermediateStorage::getComponentAccesses() const
 {
+	sortUnique(&m_componentAccesses, &m_sortedComponentAccessCount);
 	return m_componentAccesses;
 }
 
-const std::set<StorageElementComponent>& IntermediateStorage::getElementComponents() const
+const std::vector<StorageElementComponent>& IntermediateStorage::getElementComponents() const
 {
+	sortUnique(&m_elementComponents, &m_sortedElementComponentCount);
 	return m_elementComponents;
 }
 
@@ -375,27 +555,13 @@ const std::vector<StorageError>& IntermediateStorage::getErrors() const
 void IntermediateStorage::setStorageNodes(std::vector<StorageNode> storageNodes)
 {
 	m_nodes = std::move(storageNodes);
-
-	m_nodesIndex.clear();
-	m_nodeIdIndex.clear();
-	for (size_t i = 0; i < m_nodes.size(); i++)
-	{
-		m_nodesIndex.emplace(m_nodes[i], i);
-		m_nodeIdIndex.emplace(m_nodes[i].id, i);
-	}
+	m_indicesOutdated = true;
 }
 
 void IntermediateStorage::setStorageFiles(std::vector<StorageFile> storageFiles)
 {
 	m_files = std::move(storageFiles);
-
-	m_filesIndex.clear();
-	m_filesIdIndex.clear();
-	for (size_t i = 0; i < m_files.size(); i++)
-	{
-		m_filesIndex.emplace(m_files[i], i);
-		m_filesIdIndex.emplace(m_files[i].id, i);
-	}
+	m_indicesOutdated = true;
 }
 
 void IntermediateStorage::setStorageSymbols(std::vector<StorageSymbol> storageSymbols)
@@ -406,48 +572,48 @@ void IntermediateStorage::setStorageSymbols(std::vector<StorageSymbol> storageSy
 void IntermediateStorage::setStorageEdges(std::vector<StorageEdge> storageEdges)
 {
 	m_edges = std::move(storageEdges);
-
-	m_edgesIndex.clear();
-	for (size_t i = 0; i < m_edges.size(); i++)
-	{
-		m_edgesIndex.emplace(m_edges[i], i);
-	}
+	m_indicesOutdated = true;
 }
 
-void IntermediateStorage::setStorageLocalSymbols(std::set<StorageLocalSymbol> storageLocalSymbols)
+void IntermediateStorage::setStorageLocalSymbols(
+	std::vector<StorageLocalSymbol> storageLocalSymbols)
 {
 	m_localSymbols = std::move(storageLocalSymbols);
+	m_sortedLocalSymbolCount = m_localSymbols.size();
+	m_indicesOutdated = true;
 }
 
-void IntermediateStorage::setStorageSourceLocations(std::set<StorageSourceLocation> storageSourceLocations)
+void IntermediateStorage::setStorageSourceLocations(
+	std::vector<StorageSourceLocation> storageSourceLocations)
 {
 	m_sourceLocations = std::move(storageSourceLocations);
+	m_sortedSourceLocationCount = m_sourceLocations.size();
+	m_indicesOutdated = true;
 }
 
-void IntermediateStorage::setStorageOccurrences(std::set<StorageOccurrence> storageOccurrences)
+void IntermediateStorage::setStorageOccurrences(std::vector<StorageOccurrence> storageOccurrences)
 {
 	m_occurrences = std::move(storageOccurrences);
+	m_sortedOccurrenceCount = m_occurrences.size();
 }
 
-void IntermediateStorage::setComponentAccesses(std::set<StorageComponentAccess> componentAccesses)
+void IntermediateStorage::setComponentAccesses(
+	std::vector<StorageComponentAccess> componentAccesses)
 {
 	m_componentAccesses = std::move(componentAccesses);
+	m_sortedComponentAccessCount = m_componentAccesses.size();
 }
 
-void IntermediateStorage::setElementComponents(std::set<StorageElementComponent> components)
+void IntermediateStorage::setElementComponents(std::vector<StorageElementComponent> components)
 {
 	m_elementComponents = std::move(components);
+	m_sortedElementComponentCount = m_elementComponents.size();
 }
 
 void IntermediateStorage::setErrors(std::vector<StorageError> errors)
 {
 	m_errors = std::move(errors);
-
-	m_errorsIndex.clear();
-	for (size_t i = 0; i < m_errors.size(); i++)
-	{
-		m_errorsIndex.emplace(m_errors[i], i);
-	}
+	m_indicesOutdated = true;
 }
 
 Id IntermediateStorage::getNextId() const
@@ -459,3 +625,24 @@ void IntermediateStorage::setNextId(const Id nextId)
 {
 	m_nextId = nextId;
 }
+
+void IntermediateStorage::updateIndices()
+{
+	if (!m_indicesOutdated)
+	{
+		return;
+	}
+
+	m_nodesIndex.rebuild(m_nodes.size(), [this](size_t i) { return getHash(m_nodes[i]); });
+	m_nodeIdIndex.rebuild(m_nodes.size(), [this](size_t i) { return mixHash(m_nodes[i].id); });
+	m_filesIndex.rebuild(m_files.size(), [this](size_t i) { return getHash(m_files[i]); });
+	m_filesIdIndex.rebuild(m_files.size(), [this](size_t i) { return mixHash(m_files[i].id); });
+	m_edgesIndex.rebuild(m_edges.size(), [this](size_t i) { return getHash(m_edges[i]); });
+	m_localSymbolsIndex.rebuild(
+		m_localSymbols.size(), [this](size_t i) { return getHash(m_localSymbols[i]); });
+	m_sourceLocationsIndex.rebuild(
+		m_sourceLocations.size(), [this](size_t i) { return getHash(m_sourceLocations[i]); });
+	m_errorsIndex.rebuild(m_errors.size(), [this](size_t i) { return getHash(m_errors[i]); });
+
+	m_indicesOutdated = false;
+}
@@ -1,12 +1,14 @@
 #ifndef INTERMEDIATE_STORAGE_H
 #define INTERMEDIATE_STORAGE_H
 
-#include <map>
 #include <memory>
-#include <set>
 
+#include "FlatHashIndex.h"
 #include "Storage.h"
 
+// Collects the data of indexed files before it is injected into the persistent storage. Elements
+// are appended to vectors and looked up through flat hash indices. Occurrences, component accesses
+// and element components are deduplicated by sorting them once they are read or grow too large.
 class IntermediateStorage: public Storage
 {
 public:
@@ -31,7 +33,7 @@ public:
 	Id addEdge(const StorageEdgeData& edgeData) override;
 	std::vector<Id> addEdges(const std::vector<StorageEdge>& edges) override;
 	Id addLocalSymbol(const StorageLocalSymbolData& localSymbolData) override;
-	std::vector<Id> addLocalSymbols(const std::set<StorageLocalSymbol>& symbols) override;
+	std::vector<Id> addLocalSymbols(const std::vector<StorageLocalSymbol>& symbols) override;
 	Id addSourceLocation(const StorageSourceLocationData& sourceLocationData) override;
 	std::vector<Id> addSourceLocations(const std::vector<StorageSourceLocation>& locations) override;
 	void addOccurrence(const StorageOccurrence& occurrence) override;
@@ -46,53 +48,69 @@ public:
 	const std::vector<StorageFile>& getStorageFiles() const override;
 	const std::vector<StorageSymbol>& getStorageSymbols() const override;
 	const std::vector<StorageEdge>& getStorageEdges() const override;
-	const std::set<StorageLocalSymbol>& getStorageLocalSymbols() const override;
-	const std::set<StorageSourceLocation>& getStorageSourceLocations() const override;
-	const std::set<StorageOccurrence>& getStorageOccurrences() const override;
-	const std::set<StorageComponentAccess>& getComponentAccesses() const override;
-	const std::set<StorageElementComponent>& getElementComponents() const override;
+	const std::vector<StorageLocalSymbol>& getStorageLocalSymbols() const override;
+	const std::vector<StorageSourceLocation>& getStorageSourceLocations() const override;
+	const std::vector<StorageOccurrence>& getStorageOccurrences() const override;
+	const std::vector<StorageComponentAccess>& getComponentAccesses() const override;
+	const std::vector<StorageElementComponent>& getElementComponents() const override;
 	const std::vector<StorageError>& getErrors() const override;
 
+	// The setters take elements as the getters of another storage returned them, so they have to be
+	// unique and sorted. The hash indices are only rebuilt once elements are added, storages that
+	// are just read never build them.
 	void setStorageNodes(std::vector<StorageNode> storageNodes);
 	void setStorageFiles(std::vector<StorageFile> storageFiles);
 	void setStorageSymbols(std::vector<StorageSymbol> storageSymbols);
 	void setStorageEdges(std::vector<StorageEdge> storageEdges);
-	void setStorageLocalSymbols(std::set<StorageLocalSymbol> storageLocalSymbols);
-	void setStorageSourceLocations(std::set<StorageSourceLocation> storageSourceLocations);
-	void setStorageOccurrences(std::set<StorageOccurrence> storageOccurrences);
-	void setComponentAccesses(std::set<StorageComponentAccess> componentAccesses);
-	void setElementComponents(std::set<StorageElementComponent> components);
+	void setStorageLocalSymbols(std::vector<StorageLocalSymbol> storageLocalSymbols);
+	void setStorageSourceLocations(std::vector<StorageSourceLocation> storageSourceLocations);
+	void setStorageOccurrences(std::vector<StorageOccurrence> storageOccurrences);
+	void setComponentAccesses(std::vector<StorageComponentAccess> componentAccesses);
+	void setElementComponents(std::vector<StorageElementComponent> components);
 	void setErrors(std::vector<StorageError> errors);
 
 	Id getNextId() const;
 	void setNextId(const Id nextId);
 
 private:
-	std::map<StorageNodeData, size_t> m_nodesIndex;
-	std::map<Id, size_t> m_nodeIdIndex;
+	void updateIndices();
+
+	FlatHashIndex m_nodesIndex;
+	FlatHashIndex m_nodeIdIndex;
 	std::vector<StorageNode> m_nodes;
 
-	std::map<StorageFile, size_t> m_filesIndex;	   // this is used to prevent duplicates (unique)
-	std::map<Id, size_t> m_filesIdIndex;
+	FlatHashIndex m_filesIndex;	   // this is used to prevent duplicates (unique)
+	FlatHashIndex m_filesIdIndex;
 	std::vector<StorageFile> m_files;
 
 	std::vector<StorageSymbol> m_symbols;
 
-	std::map<StorageEdgeData, size_t> m_edgesIndex;
+	FlatHashIndex m_edgesIndex;
 	std::vector<StorageEdge> m_edges;
 
-	std::set<StorageLocalSymbol> m_localSymbols;
+	// the following vectors are sorted lazily by the const getters, the counts tell how many of the
+	// leading elements are already sorted and unique
+	mutable FlatHashIndex m_localSymbolsIndex;
+	mutable std::vector<StorageLocalSymbol> m_localSymbols;
+	mutable size_t m_sortedLocalSymbolCount;
+
+	mutable FlatHashIndex m_sourceLocationsIndex;
+	mutable std::vector<StorageSourceLocation> m_sourceLocations;
+	mutable size_t m_sortedSourceLocationCount;
 
-	std::set<StorageSourceLocation> m_sourceLocations;
+	mutable std::vector<StorageOccurrence> m_occurrences;
+	mutable size_t m_sortedOccurrenceCount;
 
-	std::set<StorageOccurrence> m_occurrences;
+	mutable std::vector<StorageComponentAccess> m_componentAccesses;
+	mutable size_t m_sortedComponentAccessCount;
 
-	std::set<StorageComponentAccess> m_componentAccesses;
-	std::set<StorageElementComponent> m_elementComponents;
+	mutable std::vector<StorageElementComponent> m_elementComponents;
+	mutable size_t m_sortedElementComponentCount;
 
-	std::map<StorageErrorData, size_t> m_errorsIndex;	 // this is used to prevent duplicates (unique)
+	FlatHashIndex m_errorsIndex;	// this is used to prevent duplicates (unique)
 	std::vector<StorageError> m_errors;
 
+	bool m_indicesOutdated;
 	Id m_nextId;
 };
 
@@ -1,14 +1,20 @@
 #include "PersistentStorage.h"
 
+#include <algorithm>
+#include <atomic>
 #include <queue>
 #include <sstream>
+#include <thread>
 
 #include "AccessKind.h"
 #include "ApplicationSettings.h"
 #include "ElementComponentKind.h"
 #include "FileInfo.h"
 #include "FilePath.h"
+#include "FileSystem.h"
+#include "FullTextSearchQuery.h"
 #include "Graph.h"
+#include "IndexSnapshot.h"
 #include "MessageErrorCountUpdate.h"
 #include "MessageStatus.h"
 #include "NodeTypeSet.h"
@@ -29,6 +35,12 @@
 #include "utility.h"
 #include "utilityApp.h"
 
+namespace
+{
+// cache locks held by the current thread, nested getters do not lock them again
+thread_local std::vector<const std::shared_mutex*> s_lockedCacheMutexes;
+}
+
 PersistentStorage::PersistentStorage(const FilePath& dbPath, const FilePath& bookmarkPath)
 	: m_sqliteIndexStorage(dbPath), m_sqliteBookmarkStorage(bookmarkPath)
 {
@@ -47,28 +59,48 @@ PersistentStorage::PersistentStorage(const FilePath& dbPath, const FilePath& boo
 	m_commandIndex.finishSetup();
 }
 
+PersistentStorage::~PersistentStorage()
+{
+	std::lock_guard<std::mutex> lock(m_fullTextSearchMutex);
+	waitForFullTextSearchIndexSave();
+}
+
 std::pair<Id, bool> PersistentStorage::addNode(const StorageNodeData& data)
 {
-	return std::make_pair(m_sqliteIndexStorage.addNode(data), true);
+	const Id nodeId = m_sqliteIndexStorage.addNode(data);
+	addWrittenNodeIds({nodeId});
+	return std::make_pair(nodeId, true);
 }
 
 std::vector<Id> PersistentStorage::addNodes(const std::vector<StorageNode>& nodes)
 {
-	return m_sqliteIndexStorage.addNodes(nodes);
+	const std::vector<Id> nodeIds = m_sqliteIndexStorage.addNodes(nodes);
+	addWrittenNodeIds(nodeIds);
+	return nodeIds;
 }
 
 void PersistentStorage::addSymbol(const StorageSymbol& data)
 {
 	m_sqliteIndexStorage.addSymbol(data);
+	addWrittenNodeIds({data.id});
 }
 
 void PersistentStorage::addSymbols(const std::vector<StorageSymbol>& symbols)
 {
 	m_sqliteIndexStorage.addSymbols(symbols);
+
+	std::vector<Id> symbolIds;
+	for (const StorageSymbol& symbol: symbols)
+	{
+		symbolIds.push_back(symbol.id);
+	}
+	addWrittenNodeIds(symbolIds);
 }
 
 void PersistentStorage::addFile(const StorageFile& data)
 {
+	addWrittenNodeIds({data.id});
+
 	const StorageFile storedFile = m_sqliteIndexStorage.getFirstById<StorageFile>(data.id);
 
 	if (storedFile.id == 0)
@@ -92,12 +124,19 @@ void PersistentStorage::addFile(const StorageFile& data)
 
 Id PersistentStorage::addEdge(const StorageEdgeData& data)
 {
-	return m_sqliteIndexStorage.addEdge(data);
+	const Id edgeId = m_sqliteIndexStorage.addEdge(data);
+	addEdgeToAdjacencyIndex(StorageEdge(edgeId, data));
+	return edgeId;
 }
 
 std::vector<Id> PersistentStorage::addEdges(const std::vector<StorageEdge>& edges)
 {
-	return m_sqliteIndexStorage.addEdges(edges);
+	const std::vector<Id> edgeIds = m_sqliteIndexStorage.addEdges(edges);
+	for (size_t i = 0; i < edges.size() && i < edgeIds.size(); i++)
+	{
+		addEdgeToAdjacencyIndex(StorageEdge(edgeIds[i], edges[i]));
+	}
+	return edgeIds;
 }
 
 Id PersistentStorage::addLocalSymbol(const StorageLocalSymbolData& data)
@@ -105,7 +144,7 @@ Id PersistentStorage::addLocalSymbol(const StorageLocalSymbolData& data)
 	return m_sqliteIndexStorage.addLocalSymbol(data);
 }
 
-std::vector<Id> PersistentStorage::addLocalSymbols(const std::set<StorageLocalSymbol>& symbols)
+std::vector<Id> PersistentStorage::addLocalSymbols(const std::vector<StorageLocalSymbol>& symbols)
 {
 	return m_sqliteIndexStorage.addLocalSymbols(symbols);
 }
@@ -152,17 +191,34 @@ void PersistentStorage::addElementComponents(const std::vector<StorageElementCom
 
 Id PersistentStorage::addError(const StorageErrorData& data)
 {
+	// counting the errors is skipped by injections without errors
+	if (m_isInjecting && !m_isRecordingInjectedErrors)
+	{
+		beforeErrorRecording();
+		m_isRecordingInjectedErrors = true;
+	}
+
 	return m_sqliteIndexStorage.addError(data).id;
 }
 
 void PersistentStorage::removeElement(const Id id)
 {
-	m_sqliteIndexStorage.removeElement(id);
+	removeElements({id});
 }
 
 void PersistentStorage::removeElements(const std::vector<Id>& ids)
 {
+	if (m_isRefreshing)
+	{
+		addRemovalCandidates(ids);
+		m_sqliteIndexStorage.removeElements(ids);
+		return;
+	}
+
 	m_sqliteIndexStorage.removeElements(ids);
+
+	std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+	m_adjacencyIndex.removeElements(ids);
 }
 
 void PersistentStorage::removeOccurrence(const StorageOccurrence& occurrence)
@@ -177,7 +233,18 @@ void PersistentStorage::removeOccurrences(const std::vector<StorageOccurrence>&
 
 void PersistentStorage::removeElementsWithoutOccurrences(const std::vector<Id>& elementIds)
 {
+	if (m_isRefreshing)
+	{
+		addRemovalCandidates(elementIds);
+		m_sqliteIndexStorage.removeElementsWithoutOccurrences(elementIds);
+		return;
+	}
+
 	m_sqliteIndexStorage.removeElementsWithoutOccurrences(elementIds);
+
+	// it is unknown which of the elements got removed, so edges are looked up in the database again
+	std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+	m_adjacencyIndex.clear();
 }
 
 const std::vector<StorageNode>& PersistentStorage::getStorageNodes() const
@@ -200,33 +267,29 @@ const std::vector<StorageEdge>& PersistentStorage::getStorageEdges() const
 	return m_storageData.edges = m_sqliteIndexStorage.getAll<StorageEdge>();
 }
 
-const std::set<StorageLocalSymbol>& PersistentStorage::getStorageLocalSymbols() const
+const std::vector<StorageLocalSymbol>& PersistentStorage::getStorageLocalSymbols() const
 {
-	return m_storageData.locals = utility::toSet(m_sqliteIndexStorage.getAll<StorageLocalSymbol>());
+	return m_storageData.locals = m_sqliteIndexStorage.getAll<StorageLocalSymbol>();
 }
 
-const std::set<StorageSourceLocation>& PersistentStorage::getStorageSourceLocations() const
+const std::vector<StorageSourceLocation>& PersistentStorage::getStorageSourceLocations() const
 {
-	return m_storageData.locations = utility::toSet(
-			   m_sqliteIndexStorage.getAll<StorageSourceLocation>());
+	return m_storageData.locations = m_sqliteIndexStorage.getAll<StorageSourceLocation>();
 }
 
-const std::set<StorageOccurrence>& PersistentStorage::getStorageOccurrences() const
+const std::vector<StorageOccurrence>& PersistentStorage::getStorageOccurrences() const
 {
-	return m_storageData.occurrences = utility::toSet(
-			   m_sqliteIndexStorage.getAll<StorageOccurrence>());
+	return m_storageData.occurrences = m_sqliteIndexStorage.getAll<StorageOccurrence>();
 }
 
-const std::set<StorageComponentAccess>& PersistentStorage::getComponentAccesses() const
+const std::vector<StorageComponentAccess>& PersistentStorage::getComponentAccesses() const
 {
-	return m_storageData.accesses = utility::toSet(
-			   m_sqliteIndexStorage.getAll<StorageComponentAccess>());
+	return m_storageData.accesses = m_sqliteIndexStorage.getAll<StorageComponentAccess>();
 }
 
-const std::set<StorageElementComponent>& PersistentStorage::getElementComponents() const
+const std::vector<StorageElementComponent>& PersistentStorage::getElementComponents() const
 {
-	return m_storageData.components = utility::toSet(
-			   m_sqliteIndexStorage.getAll<StorageElementComponent>());
+	return m_storageData.components = m_sqliteIndexStorage.getAll<StorageElementComponent>();
 }
 
 const std::vector<StorageError>& PersistentStorage::getErrors() const
@@ -241,23 +304,48 @@ const std::vector<StorageError>& PersistentStorage::getErrors() const
 
 void PersistentStorage::startInjection()
 {
-	beforeErrorRecording();
-
 	m_sqliteIndexStorage.beginTransaction();
+	m_isInjecting = true;
+	m_injectionAdjacencyEdgeOffset = m_pendingAdjacencyEdges.size();
 }
 
 void PersistentStorage::finishInjection()
 {
 	m_sqliteIndexStorage.commitTransaction();
+	m_isInjecting = false;
+
+	// caches are only updated with committed data, so readers never see parts of an injection. a
+	// refresh keeps the edges pending until it gets committed as a whole.
+	if (!m_isRefreshing)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+			for (const StorageEdge& edge: m_pendingAdjacencyEdges)
+			{
+				m_adjacencyIndex.addEdge(edge);
+			}
+		}
+		m_pendingAdjacencyEdges.clear();
+	}
 
-	afterErrorRecording();
+	if (m_isRecordingInjectedErrors)
+	{
+		afterErrorRecording();
+		m_isRecordingInjectedErrors = false;
+	}
 }
 
 void PersistentStorage::rollbackInjection()
 {
 	m_sqliteIndexStorage.rollbackTransaction();
+	m_isInjecting = false;
+	m_pendingAdjacencyEdges.resize(m_injectionAdjacencyEdgeOffset);
 
-	afterErrorRecording();
+	if (m_isRecordingInjectedErrors)
+	{
+		afterErrorRecording();
+		m_isRecordingInjectedErrors = false;
+	}
 }
 
 void PersistentStorage::beforeErrorRecording()
@@ -286,7 +374,25 @@ void PersistentStorage::afterErrorRecording()
 
 void PersistentStorage::setMode(const SqliteIndexStorage::StorageModeType mode)
 {
-	m_sqliteIndexStorage.setMode(mode);
+	// the live database keeps the indices of all modes while it gets refreshed in place
+	m_sqliteIndexStorage.setMode(m_isRefreshing ? SqliteIndexStorage::STORAGE_MODE_REFRESH : mode);
+}
+
+void PersistentStorage::beginBulkLoad()
+{
+	m_sqliteIndexStorage.beginBulkLoad();
+}
+
+void PersistentStorage::finishBulkLoad(std::function<void(int)> updateStatusCallback)
+{
+	TRACE();
+
+	m_sqliteIndexStorage.finishBulkLoad(updateStatusCallback);
+}
+
+bool PersistentStorage::isBulkLoading() const
+{
+	return m_sqliteIndexStorage.isBulkLoading();
 }
 
 FilePath PersistentStorage::getIndexDbFilePath() const
@@ -319,6 +425,21 @@ void PersistentStorage::setProjectSettingsText(std::string text)
 	m_sqliteIndexStorage.setProjectSettingsText(text);
 }
 
+std::vector<StorageIndexingDuration> PersistentStorage::getIndexingDurations() const
+{
+	return m_sqliteIndexStorage.getIndexingDurations();
+}
+
+void PersistentStorage::addIndexingDurations(const std::vector<StorageIndexingDuration>& durations)
+{
+	m_sqliteIndexStorage.addIndexingDurations(durations);
+}
+
+void PersistentStorage::removeIndexingDurationsOfRemovedFiles()
+{
+	m_sqliteIndexStorage.removeIndexingDurationsOfRemovedFiles();
+}
+
 void PersistentStorage::setup()
 {
 	m_sqliteIndexStorage.setup();
@@ -340,25 +461,47 @@ void PersistentStorage::clear()
 {
 	m_sqliteIndexStorage.clear();
 
+	FileSystem::remove(IndexSnapshot::getSnapshotFilePath(getIndexDbFilePath()));
+	{
+		std::lock_guard<std::mutex> lock(m_fullTextSearchMutex);
+		waitForFullTextSearchIndexSave();
+		FileSystem::remove(FullTextSearchIndex::getIndexFilePath(getIndexDbFilePath()));
+	}
+
 	clearCaches();
 }
 
 void PersistentStorage::clearCaches()
 {
-	m_symbolIndex.clear();
-	m_fileIndex.clear();
+	{
+		const ScopedFunctor cacheLock = lockCaches(true);
 
-	m_fileNodeIds.clear();
-	m_lowerCasefileNodeIds.clear();
-	m_fileNodePaths.clear();
-	m_fileNodeComplete.clear();
-	m_fileNodeIndexed.clear();
-	m_fileNodeLanguage.clear();
-	m_symbolDefinitionKinds.clear();
+		m_symbolIndex.clear();
+		m_fileIndex.clear();
 
-	m_hierarchyCache.clear();
-	m_fullTextSearchIndex.clear();
-	m_fullTextSearchCodec = "";
+		m_fileNodeIds.clear();
+		m_lowerCasefileNodeIds.clear();
+		m_fileNodePaths.clear();
+		m_fileNodeComplete.clear();
+		m_fileNodeIndexed.clear();
+		m_fileNodeLanguage.clear();
+		m_symbolDefinitionKinds.clear();
+		m_memberEdgeIdOrderMap.clear();
+		m_nextMemberEdgeOrderId = s_firstMemberEdgeOrderId;
+
+		m_hierarchyCache.clear();
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+		m_adjacencyIndex.clear();
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_fullTextSearchMutex);
+		m_fullTextSearchIndex.clear();
+		m_fullTextSearchCodec = "";
+		m_trigramIndex.clear();
+		m_hasTrigramIndex = false;
+	}
 }
 
 std::set<FilePath> PersistentStorage::getReferenced(const std::set<FilePath>& filePaths) const
@@ -404,9 +547,19 @@ void PersistentStorage::clearFileElements(
 	if (!fileNodeIds.empty())
 	{
 		m_sqliteIndexStorage.beginTransaction();
+		if (m_isRefreshing)
+		{
+			addRemovalCandidates(utility::concat(
+				fileNodeIds, m_sqliteIndexStorage.getElementIdsWithLocationInFiles(fileNodeIds)));
+		}
 		m_sqliteIndexStorage.removeElementsWithLocationInFiles(fileNodeIds, updateStatusCallback);
 		m_sqliteIndexStorage.removeElements(fileNodeIds);
 		m_sqliteIndexStorage.commitTransaction();
+		if (!m_isRefreshing)
+		{
+			std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+			m_adjacencyIndex.clear();
+		}
 		updateStatusCallback(100);
 	}
 }
@@ -434,6 +587,8 @@ std::set<FilePath> PersistentStorage::getIncompleteFiles() const
 {
 	TRACE();
 
+	const ScopedFunctor cacheLock = lockCaches(false);
+
 	std::set<FilePath> incompleteFiles;
 	for (auto p: m_fileNodeComplete)
 	{
@@ -463,22 +618,118 @@ void PersistentStorage::buildCaches()
 
 	clearCaches();
 
-	buildFilePathMaps();
-	buildSearchIndex();
-	buildMemberEdgeIdOrderMap();
-	buildHierarchyCache();
+	IndexSnapshot snapshot;
+	loadIndexSnapshot(&snapshot);
+
+	const ScopedFunctor cacheLock = lockCaches(true);
+
+	buildFilePathMaps(snapshot);
+	buildSearchIndex(snapshot);
+	buildMemberEdgeIdOrderMap(snapshot);
+	buildHierarchyCache(snapshot);
+	buildAdjacencyIndex(snapshot);
+}
+
+void PersistentStorage::packSourceLocations()
+{
+	TRACE();
+
+	m_sqliteIndexStorage.packSourceLocations();
+}
+
+void PersistentStorage::writeIndexSnapshot() const
+{
+	TRACE();
+
+	// the snapshot of a database refreshed in place gets rebuilt on the next load
+	if (m_isRefreshing)
+	{
+		return;
+	}
+
+	const std::string timestamp = getIndexTimestamp();
+	if (timestamp.empty())
+	{
+		return;
+	}
+
+	IndexSnapshot snapshot;
+	snapshot.build(m_sqliteIndexStorage, SqliteIndexStorage::getStorageVersion(), timestamp);
+	snapshot.save(IndexSnapshot::getSnapshotFilePath(getIndexDbFilePath()));
 }
 
 void PersistentStorage::optimizeMemory()
 {
 	TRACE();
 
+	// VACUUM cannot run inside the refresh transaction and would rewrite the whole database
+	if (m_isRefreshing)
+	{
+		m_sqliteIndexStorage.beginTransaction();
+		m_sqliteIndexStorage.setTime();
+		m_sqliteIndexStorage.commitTransaction();
+		return;
+	}
+
 	m_sqliteIndexStorage.setTime();
 	m_sqliteIndexStorage.optimizeMemory();
 
 	m_sqliteBookmarkStorage.optimizeMemory();
 }
 
+void PersistentStorage::enableConcurrentReads()
+{
+	m_sqliteIndexStorage.enableConcurrentReads();
+}
+
+void PersistentStorage::checkpoint() const
+{
+	m_sqliteIndexStorage.checkpoint();
+}
+
+void PersistentStorage::startIncrementalRefresh()
+{
+	TRACE();
+
+	// the full text search index file was saved for the timestamp before the refresh
+	m_refreshStartTimestamp = getIndexTimestamp();
+
+	m_isRefreshing = true;
+	m_sqliteIndexStorage.setMode(SqliteIndexStorage::STORAGE_MODE_REFRESH);
+	m_sqliteIndexStorage.beginTransaction();
+}
+
+void PersistentStorage::finishIncrementalRefresh()
+{
+	TRACE();
+
+	m_sqliteIndexStorage.commitTransaction();
+	m_isRefreshing = false;
+	m_sqliteIndexStorage.setMode(SqliteIndexStorage::STORAGE_MODE_READ);
+
+	updateCachesForRefresh();
+
+	m_refreshChanges = RefreshChanges();
+	m_pendingAdjacencyEdges.clear();
+
+	// the snapshot does not match the new timestamp anymore and gets rebuilt on the next load
+	FileSystem::remove(IndexSnapshot::getSnapshotFilePath(getIndexDbFilePath()));
+}
+
+void PersistentStorage::rollbackIncrementalRefresh()
+{
+	TRACE();
+
+	m_sqliteIndexStorage.rollbackTransaction();
+	m_isRefreshing = false;
+
+	// drops the ids of rolled back nodes that were cached for writing
+	m_sqliteIndexStorage.setMode(SqliteIndexStorage::STORAGE_MODE_READ);
+
+	m_refreshChanges = RefreshChanges();
+	m_pendingAdjacencyEdges.clear();
+}
+
 Id PersistentStorage::getNodeIdForFileNode(const FilePath& filePath) const
 {
 	return getFileNodeId(filePath);
@@ -581,16 +832,40 @@ StorageEdge PersistentStorage::getEdgeById(Id edgeId) const
 	return m_sqliteIndexStorage.getEdgeById(edgeId);
 }
 
-std::shared_ptr<SourceLocationCollection> PersistentStorage::getFullTextSearchLocations(
-	const std::wstring& searchTerm, bool caseSensitive) const
+bool PersistentStorage::searchFullTextLocations(
+	const std::wstring& searchTerm,
+	bool caseSensitive,
+	size_t maxResultCount,
+	const std::function<bool(std::shared_ptr<SourceLocationCollection>)>& handleBatch) const
 {
 	TRACE();
 
-	std::shared_ptr<SourceLocationCollection> collection =
-		std::make_shared<SourceLocationCollection>();
 	if (searchTerm.empty())
 	{
-		return collection;
+		return true;
+	}
+
+	const FullTextSearchQuery query(searchTerm, caseSensitive);
+	if (!query.isValid())
+	{
+		MessageStatus(
+			L"Invalid regular expression for fulltext search: " +
+				utility::decodeFromUtf8(query.getError()),
+			true,
+			false)
+			.dispatch();
+		return true;
+	}
+
+	std::wstring searchDescription = std::wstring(L"case-") +
+		(caseSensitive ? L"sensitive" : L"insensitive");
+	if (query.getMode() == FullTextSearchQuery::MODE_REGEX)
+	{
+		searchDescription += L", regex";
+	}
+	else if (query.getMode() == FullTextSearchQuery::MODE_WHOLE_WORD)
+	{
+		searchDescription += L", whole word";
 	}
 
 	const TextCodec codec(ApplicationSettings::getInstance()->getTextEncoding());
@@ -599,108 +874,129 @@ std::shared_ptr<SourceLocationCollection> PersistentStorage::getFullTextSearchLo
 
 		if (m_fullTextSearchCodec != codec.getName())
 		{
-			MessageStatus(L"Building fulltext search index", false, true).dispatch();
-			buildFullTextSearchIndex();
+			// a database refreshed in place has no committed timestamp to check the index file with
+			if (m_isRefreshing || !loadFullTextSearchIndex(getIndexTimestamp()))
+			{
+				MessageStatus(L"Building fulltext search index", false, true).dispatch();
+				buildFullTextSearchIndex();
+				if (!m_isRefreshing)
+				{
+					saveFullTextSearchIndex();
+				}
+			}
+		}
+
+		if (query.getMode() != FullTextSearchQuery::MODE_SUBSTRING && !m_hasTrigramIndex)
+		{
+			MessageStatus(L"Building fulltext search trigram index", false, true).dispatch();
+			buildTrigramIndex();
 		}
 	}
 
 	MessageStatus(
-		std::wstring(L"Searching fulltext (case-") +
-			(caseSensitive ? L"sensitive" : L"insensitive") + L"): " + searchTerm,
-		false,
-		true)
+		L"Searching fulltext (" + searchDescription + L"): " + searchTerm, false, true)
 		.dispatch();
 
+	std::vector<Id> fileIds;
+	std::function<std::vector<ParseLocation>(size_t, const TextAccess*)> findLocations;
+
+	std::vector<FullTextSearchResult> fileResults;
+	if (query.getMode() == FullTextSearchQuery::MODE_SUBSTRING)
 	{
-		std::vector<std::shared_ptr<std::thread>> threads;
-		std::mutex collectionMutex;
-		for (std::vector<FullTextSearchResult> fileResults: utility::splitToEqualySizedParts(
-				 m_fullTextSearchIndex.searchForTerm(searchTerm), utility::getIdealThreadCount()))
+		// results are passed on in the order of the file paths, like the code view lists them
 		{
-			std::shared_ptr<std::thread> thread = std::make_shared<std::thread>(
-				[this,
-				 &searchTerm,
-				 &caseSensitive,
-				 &codec,
-				 /*no ref here!*/ fileResults,
-				 &collection,
-				 &collectionMutex]() {
-					const int termLength = static_cast<int>(searchTerm.length());
-					for (const FullTextSearchResult& fileResult: fileResults)
-					{
-						const FilePath filePath = getFileNodePath(fileResult.fileId);
-						std::shared_ptr<TextAccess> fileContent = getFileContent(filePath, false);
+			std::lock_guard<std::mutex> lock(m_fullTextSearchMutex);
+			fileResults = m_fullTextSearchIndex.searchForTerm(searchTerm);
+		}
 
-						int charsTotal = 0;
-						int lineNumber = 1;
-						std::wstring line = codec.decode(fileContent->getLine(lineNumber));
+		std::vector<std::pair<FilePath, FullTextSearchResult>> sortedFileResults;
+		for (FullTextSearchResult& fileResult: fileResults)
+		{
+			sortedFileResults.emplace_back(
+				getFileNodePath(fileResult.fileId), std::move(fileResult));
+		}
+		std::sort(
+			sortedFileResults.begin(),
+			sortedFileResults.end(),
+			[](const std::pair<FilePath, FullTextSearchResult>& a,
+			   const std::pair<FilePath, FullTextSearchResult>& b) { return a.first < b.first; });
+
+		fileResults.clear();
+		for (std::pair<FilePath, FullTextSearchResult>& fileResult: sortedFileResults)
+		{
+			fileResults.push_back(std::move(fileResult.second));
+		}
 
-						for (int pos: fileResult.positions)
-						{
-							while (charsTotal + (int)line.length() <= pos)
-							{
-								charsTotal += static_cast<int>(line.length());
-								lineNumber++;
-								line = codec.decode(fileContent->getLine(lineNumber));
-							}
+		for (const FullTextSearchResult& fileResult: fileResults)
+		{
+			fileIds.push_back(fileResult.fileId);
+		}
 
-							ParseLocation location;
-							location.startLineNumber = lineNumber;
-							location.startColumnNumber = pos - charsTotal + 1;
+		findLocations = [&](size_t fileIndex, const TextAccess* fileContent) {
+			return getFullTextSearchTermLocations(
+				fileResults[fileIndex], searchTerm, caseSensitive, codec, fileContent);
+		};
+	}
+	else
+	{
+		std::vector<std::string> literals;
+		for (const std::wstring& literal: query.getRequiredLiterals())
+		{
+			literals.push_back(FullTextSearchIndex::encodeLowercase(literal));
+		}
 
-							if (caseSensitive &&
-								line.substr(location.startColumnNumber - 1, termLength) != searchTerm)
-							{
-								continue;
-							}
-							while ((charsTotal + (int)line.length()) < pos + termLength)
-							{
-								charsTotal += static_cast<int>(line.length());
-								lineNumber++;
-								line = codec.decode(fileContent->getLine(lineNumber));
-							}
-							location.endLineNumber = lineNumber;
-							location.endColumnNumber = pos + termLength - charsTotal;
+		{
+			std::lock_guard<std::mutex> lock(m_fullTextSearchMutex);
+			fileIds = m_trigramIndex.getCandidateFileIds(literals);
+		}
 
-							{
-								std::lock_guard<std::mutex> lock(collectionMutex);
-								// Set first bit to 1 to avoid collisions
-								const Id locationId = ~(~Id(0) >> 1) +
-									collection->getSourceLocationCount() + 1;
-								collection->addSourceLocation(
-									LOCATION_FULLTEXT_SEARCH,
-									locationId,
-									std::vector<Id>(),
-									filePath,
-									location.startLineNumber,
-									location.startColumnNumber,
-									location.endLineNumber,
-									location.endColumnNumber);
-							}
-						}
-					}
-				});
-			threads.push_back(thread);
+		std::vector<std::pair<FilePath, Id>> sortedFileIds;
+		for (Id fileId: fileIds)
+		{
+			sortedFileIds.emplace_back(getFileNodePath(fileId), fileId);
 		}
+		std::sort(sortedFileIds.begin(), sortedFileIds.end());
 
-		for (std::shared_ptr<std::thread> thread: threads)
+		for (size_t i = 0; i < sortedFileIds.size(); i++)
 		{
-			thread->join();
+			fileIds[i] = sortedFileIds[i].second;
 		}
-	}
 
-	addCompleteFlagsToSourceLocationCollection(collection.get());
+		findLocations = [&](size_t fileIndex, const TextAccess* fileContent) {
+			return getFullTextSearchQueryLocations(query, codec, fileContent);
+		};
+	}
+
+	size_t resultCount = 0;
+	size_t resultFileCount = 0;
+	const bool completed = searchFullTextLocationsInBatches(
+		fileIds,
+		findLocations,
+		maxResultCount,
+		[&](std::shared_ptr<SourceLocationCollection> batch) {
+			resultCount += batch->getSourceLocationCount();
+			resultFileCount += batch->getSourceLocationFileCount();
+			return handleBatch(batch);
+		});
 
-	MessageStatus(
-		std::to_wstring(collection->getSourceLocationCount()) + L" results in " +
-			std::to_wstring(collection->getSourceLocationFileCount()) +
-			L" files for fulltext search (case-" + (caseSensitive ? L"sensitive" : L"insensitive") +
-			L"): " + searchTerm,
-		false,
-		false)
-		.dispatch();
+	if (!completed)
+	{
+		MessageStatus(
+			L"Cancelled fulltext search (" + searchDescription + L"): " + searchTerm, false, false)
+			.dispatch();
+		return false;
+	}
 
-	return collection;
+	std::wstring status = std::to_wstring(resultCount) + L" results in " +
+		std::to_wstring(resultFileCount) + L" files for fulltext search (" + searchDescription +
+		L"): " + searchTerm;
+	if (maxResultCount && resultCount >= maxResultCount)
+	{
+		status += L" (stopped at the limit of " + std::to_wstring(maxResultCount) + L" results)";
+	}
+	MessageStatus(status, false, false).dispatch();
+
+	return true;
 }
 
 std::vector<SearchMatch> PersistentStorage::getAutocompletionMatches(
@@ -804,6 +1100,8 @@ std::vector<SearchMatch> PersistentStorage::getAutocompletionSymbolMatches(
 	size_t maxResultsCount,
 	size_t maxBestScoredResultsLength) const
 {
+	const ScopedFunctor cacheLock = lockCaches(false);
+
 	// search in indices
 	const std::vector<SearchResult> results = m_symbolIndex.search(
 		query, acceptedNodeTypes, maxResultsCount, maxBestScoredResultsLength);
@@ -893,6 +1191,8 @@ std::vector<SearchMatch> PersistentStorage::getAutocompletionSymbolMatches(
 std::vector<SearchMatch> PersistentStorage::getAutocompletionFileMatches(
 	const std::wstring& query, size_t maxResultsCount) const
 {
+	const ScopedFunctor cacheLock = lockCaches(false);
+
 	const std::vector<SearchResult> results = m_fileIndex.search(
 		query,
 		NodeTypeSet::all().getWithMatchingKept([](const NodeType& type) { return type.isFile(); }),
@@ -978,6 +1278,7 @@ std::vector<SearchMatch> PersistentStorage::getSearchMatchesForTokenIds(
 	const std::vector<Id>& elementIds) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	// todo: what if all these elements share the same node in the searchindex?
 	// In that case there should be only one search match.
@@ -1023,6 +1324,7 @@ std::vector<SearchMatch> PersistentStorage::getSearchMatchesForTokenIds(
 std::shared_ptr<Graph> PersistentStorage::getGraphForAll() const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::shared_ptr<Graph> graph = std::make_shared<Graph>();
 	const size_t sdk_size = m_symbolDefinitionKinds.size();
@@ -1058,6 +1360,7 @@ std::shared_ptr<Graph> PersistentStorage::getGraphForAll() const
 std::shared_ptr<Graph> PersistentStorage::getGraphForNodeTypes(NodeTypeSet nodeTypes) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::vector<Id> tokenIds;
 
@@ -1090,6 +1393,7 @@ std::shared_ptr<Graph> PersistentStorage::getGraphForActiveTokenIds(
 	const std::vector<Id>& tokenIds, const std::vector<Id>& expandedNodeIds, bool* isActiveNamespace) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::vector<Id> ids(tokenIds);
 	bool isPackage = false;
@@ -1131,8 +1435,7 @@ std::shared_ptr<Graph> PersistentStorage::getGraphForActiveTokenIds(
 				nodeIds.push_back(elementId);
 				edgeIds.clear();
 
-				for (const StorageEdge& edge:
-					 m_sqliteIndexStorage.getEdgesBySourceOrTargetId(elementId))
+				for (const StorageEdge& edge: getEdgesBySourceOrTargetId(elementId))
 				{
 					Edge::EdgeType edgeType = Edge::intToType(edge.type);
 					if (edgeType == Edge::EDGE_MEMBER)
@@ -1262,6 +1565,7 @@ std::shared_ptr<Graph> PersistentStorage::getGraphForActiveTokenIds(
 std::shared_ptr<Graph> PersistentStorage::getGraphForChildrenOfNodeId(Id nodeId) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::vector<Id> nodeIds;
 	std::vector<Id> edgeIds;
@@ -1287,6 +1591,7 @@ std::shared_ptr<Graph> PersistentStorage::getGraphForTrail(
 	bool directed) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::set<Id> nodeIds;
 	std::set<Id> edgeIds;
@@ -1316,16 +1621,15 @@ std::shared_ptr<Graph> PersistentStorage::getGraphForTrail(
 
 	while (nodeIdsToProcess.size() && (!depth || currentDepth < depth))
 	{
-		std::vector<StorageEdge> edges = forward
-			? m_sqliteIndexStorage.getEdgesBySourceIds(nodeIdsToProcess)
-			: m_sqliteIndexStorage.getEdgesByTargetIds(nodeIdsToProcess);
+		std::vector<StorageEdge> edges = forward ? getEdgesBySourceIds(nodeIdsToProcess, edgeTypes)
+												 : getEdgesByTargetIds(nodeIdsToProcess, edgeTypes);
 
 		if (!directed || edgeTypes & Edge::LAYOUT_VERTICAL)
 		{
 			utility::append(
 				edges,
-				forward ? m_sqliteIndexStorage.getEdgesByTargetIds(nodeIdsToProcess)
-						: m_sqliteIndexStorage.getEdgesBySourceIds(nodeIdsToProcess));
+				forward ? getEdgesByTargetIds(nodeIdsToProcess, edgeTypes)
+						: getEdgesBySourceIds(nodeIdsToProcess, edgeTypes));
 		}
 
 		std::vector<Id> nodeIdsToCheck;
@@ -1526,6 +1830,7 @@ Edge::TypeMask PersistentStorage::getAvailableEdgeTypes() const
 std::vector<Id> PersistentStorage::getActiveTokenIdsForId(Id tokenId, Id* declarationId) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::vector<Id> activeTokenIds;
 
@@ -1555,6 +1860,7 @@ std::vector<Id> PersistentStorage::getActiveTokenIdsForId(Id tokenId, Id* declar
 std::vector<Id> PersistentStorage::getNodeIdsForLocationIds(const std::vector<Id>& locationIds) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::set<Id> nodeIds;
 	std::set<Id> implicitNodeIds;
@@ -1594,6 +1900,7 @@ std::shared_ptr<SourceLocationCollection> PersistentStorage::getSourceLocationsF
 	const std::vector<Id>& tokenIds) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::map<Id, FilePath> filePaths;
 	std::vector<Id> nonFileIds;
@@ -1700,6 +2007,7 @@ std::shared_ptr<SourceLocationCollection> PersistentStorage::getSourceLocationsF
 	const std::vector<Id>& locationIds) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::shared_ptr<SourceLocationCollection> collection =
 		std::make_shared<SourceLocationCollection>();
@@ -1741,6 +2049,7 @@ std::shared_ptr<SourceLocationFile> PersistentStorage::getSourceLocationsForFile
 	const FilePath& filePath) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	return m_sqliteIndexStorage.getSourceLocationsForFile(filePath)->getFilteredByTypes(
 		{LOCATION_TOKEN, LOCATION_SCOPE, LOCATION_QUALIFIER, LOCATION_LOCAL_SYMBOL, LOCATION_UNSOLVED});
@@ -1750,6 +2059,7 @@ std::shared_ptr<SourceLocationFile> PersistentStorage::getSourceLocationsForLine
 	const FilePath& filePath, size_t startLine, size_t endLine) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	return m_sqliteIndexStorage.getSourceLocationsForLinesInFile(filePath, startLine, endLine)
 		->getFilteredByLines(startLine, endLine)
@@ -1765,6 +2075,7 @@ std::shared_ptr<SourceLocationFile> PersistentStorage::getSourceLocationsOfTypeI
 	const FilePath& filePath, LocationType type) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	return m_sqliteIndexStorage.getSourceLocationsOfTypeInFile(filePath, type);
 }
@@ -1773,6 +2084,7 @@ std::shared_ptr<TextAccess> PersistentStorage::getFileContent(
 	const FilePath& filePath, bool showsErrors) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::shared_ptr<TextAccess> fileContent = m_sqliteIndexStorage.getFileContentByPath(
 		filePath.wstr());
@@ -1783,15 +2095,38 @@ std::shared_ptr<TextAccess> PersistentStorage::getFileContent(
 	return TextAccess::createFromFile(FilePath(filePath));
 }
 
-bool PersistentStorage::hasContentForFile(const FilePath& filePath) const
+std::vector<std::string> PersistentStorage::getFileContentLines(
+	const FilePath& filePath, size_t firstLineNumber, size_t lastLineNumber, bool showsErrors) const
 {
-	std::shared_ptr<TextAccess> fileContent = m_sqliteIndexStorage.getFileContentByPath(
-		filePath.wstr());
-	if (fileContent->getLineCount() > 0)
+	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
+
+	const Id fileId = m_sqliteIndexStorage.getFileByPath(filePath.wstr()).id;
+	if (m_sqliteIndexStorage.hasFileContentById(fileId))
 	{
-		return true;
+		return m_sqliteIndexStorage.getFileContentLinesById(fileId, firstLineNumber, lastLineNumber);
 	}
-	return false;
+	return TextAccess::createFromFile(filePath)->getLines(
+		static_cast<unsigned int>(firstLineNumber), static_cast<unsigned int>(lastLineNumber));
+}
+
+size_t PersistentStorage::getFileContentLineCount(const FilePath& filePath, bool showsErrors) const
+{
+	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
+
+	const Id fileId = m_sqliteIndexStorage.getFileByPath(filePath.wstr()).id;
+	if (m_sqliteIndexStorage.hasFileContentById(fileId))
+	{
+		return m_sqliteIndexStorage.getFileContentLineCountById(fileId);
+	}
+	return TextAccess::createFromFile(filePath)->getLineCount();
+}
+
+bool PersistentStorage::hasContentForFile(const FilePath& filePath) const
+{
+	return m_sqliteIndexStorage.hasFileContentById(
+		m_sqliteIndexStorage.getFileByPath(filePath.wstr()).id);
 }
 
 FileInfo PersistentStorage::getFileInfoForFileId(Id id) const
@@ -1821,6 +2156,7 @@ std::vector<FileInfo> PersistentStorage::getFileInfosForFilePaths(
 StorageStats PersistentStorage::getStorageStats() const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	StorageStats stats;
 
@@ -1917,6 +2253,7 @@ std::shared_ptr<SourceLocationCollection> PersistentStorage::getErrorSourceLocat
 	const std::vector<ErrorInfo>& errors) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	std::shared_ptr<SourceLocationCollection> collection =
 		std::make_shared<SourceLocationCollection>();
@@ -2140,6 +2477,7 @@ TooltipInfo PersistentStorage::getTooltipInfoForTokenIds(
 	const std::vector<Id>& tokenIds, TooltipOrigin origin) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	TooltipInfo info;
 
@@ -2274,11 +2612,11 @@ TooltipSnippet PersistentStorage::getTooltipSnippetForNode(const StorageNode& no
 			};
 
 			std::vector<Annotation> annotations;
-			std::vector<std::string> lines =
-				getFileContent(sigLoc->getFilePath(), false)
-					->getLines(
-						static_cast<unsigned int>(sigLoc->getLineNumber()),
-						static_cast<unsigned int>(sigLoc->getEndLocation()->getLineNumber()));
+			std::vector<std::string> lines = getFileContentLines(
+				sigLoc->getFilePath(),
+				sigLoc->getLineNumber(),
+				sigLoc->getEndLocation()->getLineNumber(),
+				false);
 
 			// check if signature location refers to correct locations in the code
 			// wrongly recorded signature locations of implicit template methods in C++ caused crashes
@@ -2486,6 +2824,7 @@ TooltipInfo PersistentStorage::getTooltipInfoForSourceLocationIdsAndLocalSymbolI
 	const std::vector<Id>& locationIds, const std::vector<Id>& localSymbolIds) const
 {
 	TRACE();
+	const ScopedFunctor readTransaction = startReadTransaction();
 
 	const TextCodec codec(ApplicationSettings::getInstance()->getTextEncoding());
 
@@ -2544,6 +2883,8 @@ TooltipInfo PersistentStorage::getTooltipInfoForSourceLocationIdsAndLocalSymbolI
 
 Id PersistentStorage::getFileNodeId(const FilePath& filePath) const
 {
+	const ScopedFunctor cacheLock = lockCaches(false);
+
 	if (filePath.empty())
 	{
 		LOG_ERROR("No file path set");
@@ -2591,6 +2932,8 @@ std::set<Id> PersistentStorage::getFileNodeIds(const std::set<FilePath>& filePat
 
 FilePath PersistentStorage::getFileNodePath(Id fileId) const
 {
+	const ScopedFunctor cacheLock = lockCaches(false);
+
 	if (fileId == 0)
 	{
 		LOG_ERROR("No file id set");
@@ -2609,6 +2952,8 @@ FilePath PersistentStorage::getFileNodePath(Id fileId) const
 
 bool PersistentStorage::getFileNodeComplete(Id fileId) const
 {
+	const ScopedFunctor cacheLock = lockCaches(false);
+
 	auto it = m_fileNodeComplete.find(fileId);
 	if (it != m_fileNodeComplete.end())
 	{
@@ -2620,6 +2965,8 @@ bool PersistentStorage::getFileNodeComplete(Id fileId) const
 
 bool PersistentStorage::getFileNodeIndexed(Id fileId) const
 {
+	const ScopedFunctor cacheLock = lockCaches(false);
+
 	auto it = m_fileNodeIndexed.find(fileId);
 	if (it != m_fileNodeIndexed.end())
 	{
@@ -2631,6 +2978,8 @@ bool PersistentStorage::getFileNodeIndexed(Id fileId) const
 
 std::wstring PersistentStorage::getFileNodeLanguage(Id fileId) const
 {
+	const ScopedFunctor cacheLock = lockCaches(false);
+
 	auto it = m_fileNodeLanguage.find(fileId);
 	if (it != m_fileNodeLanguage.end())
 	{
@@ -2814,49 +3163,409 @@ std::set<FilePath> PersistentStorage::getReferencingByImports(const std::set<Fil
 	return paths;
 }
 
-void PersistentStorage::addNodesToGraph(
-	const std::vector<Id>& newNodeIds, Graph* graph, bool addChildCount) const
+std::vector<StorageEdge> PersistentStorage::getEdgesBySourceIds(
+	const std::vector<Id>& sourceIds, Edge::TypeMask edgeTypes) const
 {
-	TRACE();
-
-	std::vector<Id> nodeIds;
-	if (graph->getNodeCount())
 	{
-		for (Id id: newNodeIds)
+		std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+		if (m_adjacencyIndex.isBuilt())
 		{
-			if (!graph->getNodeById(id))
-			{
-				nodeIds.push_back(id);
-			}
+			return m_adjacencyIndex.getEdgesBySourceIds(sourceIds, edgeTypes);
 		}
 	}
-	else
-	{
-		nodeIds = newNodeIds;
-	}
+	return m_sqliteIndexStorage.getEdgesBySourceIds(sourceIds);
+}
 
-	if (nodeIds.size() == 0)
+std::vector<StorageEdge> PersistentStorage::getEdgesByTargetIds(
+	const std::vector<Id>& targetIds, Edge::TypeMask edgeTypes) const
+{
 	{
-		return;
+		std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+		if (m_adjacencyIndex.isBuilt())
+		{
+			return m_adjacencyIndex.getEdgesByTargetIds(targetIds, edgeTypes);
+		}
 	}
+	return m_sqliteIndexStorage.getEdgesByTargetIds(targetIds);
+}
 
-	for (const StorageNode& storageNode: m_sqliteIndexStorage.getAllByIds<StorageNode>(nodeIds))
+std::vector<StorageEdge> PersistentStorage::getEdgesBySourceOrTargetId(Id nodeId) const
+{
 	{
-		const NodeType type(intToNodeKind(storageNode.type));
-		if (type.isFile())
-		{
-			addFileNodeToGraph(storageNode, graph);
-		}
-		else
+		std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+		if (m_adjacencyIndex.isBuilt())
 		{
-			addNodeToGraph(storageNode, type, graph, addChildCount);
+			return m_adjacencyIndex.getEdgesBySourceOrTargetId(nodeId);
 		}
 	}
+	return m_sqliteIndexStorage.getEdgesBySourceOrTargetId(nodeId);
 }
 
-void PersistentStorage::addFileNodeToGraph(const StorageNode& storageNode, Graph* const graph) const
+void PersistentStorage::addEdgeToAdjacencyIndex(const StorageEdge& edge)
 {
-	NameHierarchy nameHierarchy = NameHierarchy::deserialize(storageNode.serializedName);
+	if (m_isInjecting || m_isRefreshing)
+	{
+		m_pendingAdjacencyEdges.push_back(edge);
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+		m_adjacencyIndex.addEdge(edge);
+	}
+}
+
+ScopedFunctor PersistentStorage::startReadTransaction() const
+{
+	// the caches match the committed state as long as no refresh can update them in between
+	std::shared_ptr<ScopedFunctor> cacheLock(new ScopedFunctor(lockCaches(false)));
+	m_sqliteIndexStorage.beginReadTransaction();
+	return ScopedFunctor([this, cacheLock]() { m_sqliteIndexStorage.endReadTransaction(); });
+}
+
+ScopedFunctor PersistentStorage::lockCaches(bool exclusive) const
+{
+	if (std::find(s_lockedCacheMutexes.begin(), s_lockedCacheMutexes.end(), &m_cacheMutex) !=
+		s_lockedCacheMutexes.end())
+	{
+		return ScopedFunctor();
+	}
+
+	if (exclusive)
+	{
+		m_cacheMutex.lock();
+	}
+	else
+	{
+		m_cacheMutex.lock_shared();
+	}
+	s_lockedCacheMutexes.push_back(&m_cacheMutex);
+
+	return ScopedFunctor([this, exclusive]() {
+		s_lockedCacheMutexes.erase(
+			std::find(s_lockedCacheMutexes.begin(), s_lockedCacheMutexes.end(), &m_cacheMutex));
+		if (exclusive)
+		{
+			m_cacheMutex.unlock();
+		}
+		else
+		{
+			m_cacheMutex.unlock_shared();
+		}
+	});
+}
+
+void PersistentStorage::addWrittenNodeIds(const std::vector<Id>& nodeIds)
+{
+	if (m_isRefreshing)
+	{
+		m_refreshChanges.writtenNodeIds.insert(nodeIds.begin(), nodeIds.end());
+	}
+}
+
+void PersistentStorage::addRemovalCandidates(const std::vector<Id>& elementIds)
+{
+	// the elements are stored before removing them, their caches are cleaned up with this data once
+	// the refresh is committed. edges of removed nodes get removed along with them.
+	std::vector<Id> nodeIds;
+	for (const StorageNode& node: m_sqliteIndexStorage.getAllByIds<StorageNode>(elementIds))
+	{
+		m_refreshChanges.removalCandidateNodes.emplace(node.id, node);
+		nodeIds.push_back(node.id);
+	}
+
+	std::vector<StorageEdge> edges = m_sqliteIndexStorage.getAllByIds<StorageEdge>(elementIds);
+	utility::append(edges, m_sqliteIndexStorage.getEdgesBySourceIds(nodeIds));
+	utility::append(edges, m_sqliteIndexStorage.getEdgesByTargetIds(nodeIds));
+	for (const StorageEdge& edge: edges)
+	{
+		m_refreshChanges.removalCandidateEdges.emplace(edge.id, edge);
+	}
+}
+
+void PersistentStorage::updateCachesForRefresh()
+{
+	TRACE();
+
+	// everything is read from the database first, so the caches are locked for readers on other
+	// threads only while they are updated in memory
+
+	// nodes
+	std::vector<Id> nodeIds = utility::toVector(m_refreshChanges.writtenNodeIds);
+	for (const auto& p: m_refreshChanges.removalCandidateNodes)
+	{
+		nodeIds.push_back(p.first);
+	}
+
+	std::map<Id, StorageNode> nodes;
+	m_sqliteIndexStorage.forEachByIds<StorageNode>(
+		nodeIds, [&nodes](StorageNode&& node) { nodes.emplace(node.id, std::move(node)); });
+
+	std::vector<Id> removedElementIds;
+	std::vector<StorageNode> oldNodes;
+	for (const auto& p: m_refreshChanges.removalCandidateNodes)
+	{
+		auto it = nodes.find(p.first);
+		if (it == nodes.end() || it->second.serializedName != p.second.serializedName)
+		{
+			removedElementIds.push_back(p.first);
+		}
+		oldNodes.push_back(p.second);
+	}
+	for (const auto& p: nodes)
+	{
+		if (m_refreshChanges.removalCandidateNodes.find(p.first) ==
+			m_refreshChanges.removalCandidateNodes.end())
+		{
+			oldNodes.push_back(p.second);
+		}
+	}
+
+	std::vector<Id> currentNodeIds;
+	for (const auto& p: nodes)
+	{
+		currentNodeIds.push_back(p.first);
+	}
+
+	std::vector<StorageFile> files;
+	m_sqliteIndexStorage.forEachByIds<StorageFile>(
+		currentNodeIds, [&files](StorageFile&& file) { files.push_back(std::move(file)); });
+
+	std::vector<StorageSymbol> symbols;
+	m_sqliteIndexStorage.forEachByIds<StorageSymbol>(
+		currentNodeIds,
+		[&symbols](StorageSymbol&& symbol) { symbols.push_back(std::move(symbol)); });
+
+	// edges
+	std::vector<Id> edgeIds;
+	for (const StorageEdge& edge: m_pendingAdjacencyEdges)
+	{
+		edgeIds.push_back(edge.id);
+	}
+	for (const auto& p: m_refreshChanges.removalCandidateEdges)
+	{
+		edgeIds.push_back(p.first);
+	}
+
+	std::map<Id, StorageEdge> edges;
+	m_sqliteIndexStorage.forEachByIds<StorageEdge>(
+		edgeIds, [&edges](StorageEdge&& edge) { edges.emplace(edge.id, std::move(edge)); });
+
+	std::vector<StorageEdge> removedEdges;
+	for (const auto& p: m_refreshChanges.removalCandidateEdges)
+	{
+		const StorageEdge& edge = p.second;
+
+		auto it = edges.find(edge.id);
+		if (it != edges.end() && it->second.type == edge.type &&
+			it->second.sourceNodeId == edge.sourceNodeId &&
+			it->second.targetNodeId == edge.targetNodeId)
+		{
+			continue;
+		}
+
+		removedElementIds.push_back(edge.id);
+		removedEdges.push_back(edge);
+	}
+
+	std::vector<StorageEdge> addedEdges;
+	std::vector<StorageEdge> addedMemberEdges;
+	std::vector<StorageEdge> addedInheritanceEdges;
+	std::vector<Id> memberSourceNodeIds;
+	for (const StorageEdge& edge: m_pendingAdjacencyEdges)
+	{
+		auto it = edges.find(edge.id);
+		if (it != edges.end())
+		{
+			addedEdges.push_back(it->second);
+			if (Edge::intToType(edge.type) == Edge::EDGE_MEMBER)
+			{
+				addedMemberEdges.push_back(it->second);
+				memberSourceNodeIds.push_back(edge.sourceNodeId);
+			}
+			else if (Edge::intToType(edge.type) == Edge::EDGE_INHERITANCE)
+			{
+				addedInheritanceEdges.push_back(it->second);
+			}
+		}
+	}
+
+	std::set<Id> invisibleParentSourceNodeIds;
+	m_sqliteIndexStorage.forEachByIds<StorageNode>(
+		memberSourceNodeIds, [&invisibleParentSourceNodeIds](StorageNode&& node) {
+			if (!NodeType(intToNodeKind(node.type)).isVisibleAsParentInGraph())
+			{
+				invisibleParentSourceNodeIds.insert(node.id);
+			}
+		});
+
+	std::set<Id> fileIds;
+	{
+		const ScopedFunctor cacheLock = lockCaches(true);
+
+		for (const StorageNode& node: oldNodes)
+		{
+			removeNodeFromSearchIndex(node);
+
+			auto it = m_fileNodePaths.find(node.id);
+			if (it != m_fileNodePaths.end())
+			{
+				m_fileNodeIds.erase(it->second);
+				m_lowerCasefileNodeIds.erase(it->second.getLowerCase());
+				m_fileNodePaths.erase(it);
+				m_fileNodeComplete.erase(node.id);
+				m_fileNodeIndexed.erase(node.id);
+				m_fileNodeLanguage.erase(node.id);
+				fileIds.insert(node.id);
+			}
+			m_symbolDefinitionKinds.erase(node.id);
+		}
+
+		for (const StorageFile& file: files)
+		{
+			addFileToFilePathMaps(file);
+			fileIds.insert(file.id);
+		}
+
+		for (const StorageSymbol& symbol: symbols)
+		{
+			m_symbolDefinitionKinds.emplace(symbol.id, intToDefinitionKind(symbol.definitionKind));
+		}
+
+		for (const auto& p: nodes)
+		{
+			addNodeToSearchIndex(p.second);
+		}
+
+		for (const StorageEdge& edge: removedEdges)
+		{
+			m_memberEdgeIdOrderMap.erase(edge.id);
+
+			if (Edge::intToType(edge.type) == Edge::EDGE_MEMBER)
+			{
+				m_hierarchyCache.removeConnection(edge.id, edge.sourceNodeId, edge.targetNodeId);
+			}
+			else if (Edge::intToType(edge.type) == Edge::EDGE_INHERITANCE)
+			{
+				m_hierarchyCache.removeInheritance(edge.id, edge.sourceNodeId);
+			}
+		}
+
+		for (const StorageEdge& edge: addedInheritanceEdges)
+		{
+			m_hierarchyCache.createInheritance(edge.id, edge.sourceNodeId, edge.targetNodeId);
+		}
+
+		for (const StorageEdge& edge: addedMemberEdges)
+		{
+			createHierarchyConnection(
+				edge,
+				invisibleParentSourceNodeIds.find(edge.sourceNodeId) ==
+					invisibleParentSourceNodeIds.end());
+		}
+
+		for (const auto& p: nodes)
+		{
+			auto it = m_symbolDefinitionKinds.find(p.first);
+			m_hierarchyCache.updateNode(
+				p.first,
+				NodeType(intToNodeKind(p.second.type)).isVisibleAsParentInGraph(),
+				it != m_symbolDefinitionKinds.end() && it->second == DEFINITION_IMPLICIT);
+		}
+
+		if (m_hasJavaFiles)
+		{
+			addMemberEdgesToOrderMap(addedMemberEdges);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+		m_adjacencyIndex.removeElements(removedElementIds);
+		for (const StorageEdge& edge: addedEdges)
+		{
+			m_adjacencyIndex.addEdge(edge);
+		}
+	}
+
+	// full text search index, only if it was built already or was saved before the refresh
+	std::lock_guard<std::mutex> lock(m_fullTextSearchMutex);
+	if (m_fullTextSearchCodec.empty())
+	{
+		loadFullTextSearchIndex(m_refreshStartTimestamp);
+	}
+	if (!m_fullTextSearchCodec.empty())
+	{
+		m_fullTextSearchIndex.removeFiles(fileIds);
+		if (m_hasTrigramIndex)
+		{
+			m_trigramIndex.removeFiles(fileIds);
+		}
+
+		TextCodec codec(m_fullTextSearchCodec);
+		for (const StorageFile& file: files)
+		{
+			if (file.indexed)
+			{
+				const std::wstring content = codec.decode(
+					m_sqliteIndexStorage.getFileContentTextById(file.id));
+				m_fullTextSearchIndex.addFile(file.id, content);
+
+				if (m_hasTrigramIndex)
+				{
+					const std::string text = FullTextSearchIndex::encodeLowercase(content);
+					m_trigramIndex.addFile(file.id, text.data(), text.data() + text.size());
+				}
+			}
+		}
+
+		// only the shards of changed files get rebuilt before the index is saved again
+		saveFullTextSearchIndex();
+	}
+}
+
+void PersistentStorage::addNodesToGraph(
+	const std::vector<Id>& newNodeIds, Graph* graph, bool addChildCount) const
+{
+	TRACE();
+
+	std::vector<Id> nodeIds;
+	if (graph->getNodeCount())
+	{
+		for (Id id: newNodeIds)
+		{
+			if (!graph->getNodeById(id))
+			{
+				nodeIds.push_back(id);
+			}
+		}
+	}
+	else
+	{
+		nodeIds = newNodeIds;
+	}
+
+	if (nodeIds.size() == 0)
+	{
+		return;
+	}
+
+	for (const StorageNode& storageNode: m_sqliteIndexStorage.getAllByIds<StorageNode>(nodeIds))
+	{
+		const NodeType type(intToNodeKind(storageNode.type));
+		if (type.isFile())
+		{
+			addFileNodeToGraph(storageNode, graph);
+		}
+		else
+		{
+			addNodeToGraph(storageNode, type, graph, addChildCount);
+		}
+	}
+}
+
+void PersistentStorage::addFileNodeToGraph(const StorageNode& storageNode, Graph* const graph) const
+{
+	NameHierarchy nameHierarchy = NameHierarchy::deserialize(storageNode.serializedName);
 	const FilePath filePath(nameHierarchy.getRawName());
 
 	bool complete = getFileNodeComplete(storageNode.id);
@@ -2995,8 +3704,7 @@ void PersistentStorage::addAggregationEdgesToGraph(
 		connectedNodeIds[isSource ? edge.targetNodeId : edge.sourceNodeId].push_back(edgeInfo);
 	}
 
-	const std::vector<StorageEdge> outgoingEdges = m_sqliteIndexStorage.getEdgesBySourceIds(
-		childNodeIds);
+	const std::vector<StorageEdge> outgoingEdges = getEdgesBySourceIds(childNodeIds);
 	for (const StorageEdge& outEdge: outgoingEdges)
 	{
 		EdgeInfo edgeInfo;
@@ -3005,8 +3713,7 @@ void PersistentStorage::addAggregationEdgesToGraph(
 		connectedNodeIds[outEdge.targetNodeId].push_back(edgeInfo);
 	}
 
-	const std::vector<StorageEdge> incomingEdges = m_sqliteIndexStorage.getEdgesByTargetIds(
-		childNodeIds);
+	const std::vector<StorageEdge> incomingEdges = getEdgesByTargetIds(childNodeIds);
 	for (const StorageEdge& inEdge: incomingEdges)
 	{
 		EdgeInfo edgeInfo;
@@ -3237,88 +3944,151 @@ void PersistentStorage::addInheritanceChainsToGraph(const std::vector<Id>& activ
 	}
 }
 
-void PersistentStorage::buildFilePathMaps()
+void PersistentStorage::loadIndexSnapshot(IndexSnapshot* snapshot) const
 {
 	TRACE();
 
-	m_sqliteIndexStorage.forEach<StorageFile>([&](StorageFile&& file) {
-		const FilePath path(file.filePath);
+	const std::string timestamp = getIndexTimestamp();
+	const FilePath snapshotFilePath = IndexSnapshot::getSnapshotFilePath(getIndexDbFilePath());
 
-		m_fileNodeIds.emplace(path, file.id);
-		m_lowerCasefileNodeIds.emplace(path.getLowerCase(), file.id);
-		m_fileNodePaths.emplace(file.id, path);
-		m_fileNodeComplete.emplace(file.id, file.complete);
-		m_fileNodeIndexed.emplace(file.id, file.indexed);
-		m_fileNodeLanguage.emplace(file.id, file.languageIdentifier);
+	if (snapshot->load(snapshotFilePath, SqliteIndexStorage::getStorageVersion(), timestamp))
+	{
+		return;
+	}
 
-		if (!m_hasJavaFiles && path.extension() == L".java")
-		{
-			m_hasJavaFiles = true;
-		}
-	});
+	snapshot->build(m_sqliteIndexStorage, SqliteIndexStorage::getStorageVersion(), timestamp);
+
+	// storages without timestamp are still being written, so there is nothing worth persisting
+	if (!timestamp.empty())
+	{
+		snapshot->save(snapshotFilePath);
+	}
+}
 
-	m_sqliteIndexStorage.forEach<StorageSymbol>([&](StorageSymbol&& symbol) {
+std::string PersistentStorage::getIndexTimestamp() const
+{
+	const TimeStamp time = m_sqliteIndexStorage.getTime();
+	if (time.isValid())
+	{
+		return time.toString();
+	}
+	return "";
+}
+
+void PersistentStorage::buildFilePathMaps(const IndexSnapshot& snapshot)
+{
+	TRACE();
+
+	snapshot.forEach<StorageFile>([this](StorageFile&& file) { addFileToFilePathMaps(file); });
+
+	snapshot.forEach<StorageSymbol>([&](StorageSymbol&& symbol) {
 		m_symbolDefinitionKinds.emplace(symbol.id, intToDefinitionKind(symbol.definitionKind));
 	});
 }
 
-void PersistentStorage::buildSearchIndex()
+void PersistentStorage::buildSearchIndex(const IndexSnapshot& snapshot)
 {
 	TRACE();
 
-	const FilePath dbPath = getIndexDbFilePath();
+	snapshot.forEach<StorageNode>([this](StorageNode&& node) { addNodeToSearchIndex(node); });
 
-	m_sqliteIndexStorage.forEach<StorageNode>([&](StorageNode&& node) {
-		const NodeType type(intToNodeKind(node.type));
-		if (type.isFile())
-		{
-			bool indexed = getFileNodeIndexed(node.id);
-			if (!indexed)
-			{
-				return;
-			}
+	m_symbolIndex.finishSetup();
+	m_fileIndex.finishSetup();
+}
 
-			auto it = m_fileNodePaths.find(node.id);
-			if (it != m_fileNodePaths.end())
-			{
-				FilePath filePath(it->second);
+void PersistentStorage::addFileToFilePathMaps(const StorageFile& file)
+{
+	const FilePath path(file.filePath);
 
-				if (filePath.exists())
-				{
-					filePath.makeRelativeTo(dbPath);
-				}
+	m_fileNodeIds.emplace(path, file.id);
+	m_lowerCasefileNodeIds.emplace(path.getLowerCase(), file.id);
+	m_fileNodePaths.emplace(file.id, path);
+	m_fileNodeComplete.emplace(file.id, file.complete);
+	m_fileNodeIndexed.emplace(file.id, file.indexed);
+	m_fileNodeLanguage.emplace(file.id, file.languageIdentifier);
 
-				m_fileIndex.addNode(node.id, filePath.wstr(), type);
-			}
+	if (!m_hasJavaFiles && path.extension() == L".java")
+	{
+		m_hasJavaFiles = true;
+	}
+}
+
+void PersistentStorage::addNodeToSearchIndex(const StorageNode& node)
+{
+	const NodeType type(intToNodeKind(node.type));
+	if (type.isFile())
+	{
+		bool indexed = getFileNodeIndexed(node.id);
+		if (!indexed)
+		{
+			return;
 		}
-		else
+
+		auto it = m_fileNodePaths.find(node.id);
+		if (it != m_fileNodePaths.end())
 		{
-			auto it = m_symbolDefinitionKinds.find(node.id);
-			const DefinitionKind defKind =
-				(it != m_symbolDefinitionKinds.end() ? it->second : DEFINITION_NONE);
-			if (defKind != DEFINITION_IMPLICIT)
-			{
-				const NameHierarchy nameHierarchy = NameHierarchy::deserialize(node.serializedName);
+			FilePath filePath(it->second);
 
-				// we don't use the signature here, so elements with the same signature share the
-				// same node.
-				std::wstring name = nameHierarchy.getQualifiedName();
+			if (filePath.exists())
+			{
+				filePath.makeRelativeTo(getIndexDbFilePath());
+			}
 
-				// replace template arguments with .. to avoid clutter in search results and have
-				// different template specializations share the same node.
-				if (defKind == DEFINITION_NONE &&
-					nameHierarchy.getDelimiter() == nameDelimiterTypeToString(NAME_DELIMITER_CXX))
-				{
-					name = utility::replaceBetween(name, L'<', L'>', L"..");
-				}
+			m_fileIndex.addNode(node.id, filePath.wstr(), type);
+		}
+	}
+	else
+	{
+		std::wstring name = getSearchIndexSymbolName(node);
+		if (!name.empty())
+		{
+			m_symbolIndex.addNode(node.id, std::move(name), type);
+		}
+	}
+}
 
-				m_symbolIndex.addNode(node.id, std::move(name), type);
-			}
+void PersistentStorage::removeNodeFromSearchIndex(const StorageNode& node)
+{
+	if (NodeType(intToNodeKind(node.type)).isFile())
+	{
+		auto it = m_fileNodePaths.find(node.id);
+		if (it != m_fileNodePaths.end())
+		{
+			// the file may have been deleted since it was added with its relative path
+			m_fileIndex.removeNode(node.id, it->second.wstr());
+			m_fileIndex.removeNode(node.id, it->second.getRelativeTo(getIndexDbFilePath()).wstr());
 		}
-	});
+	}
+	else
+	{
+		m_symbolIndex.removeNode(node.id, getSearchIndexSymbolName(node));
+	}
+}
 
-	m_symbolIndex.finishSetup();
-	m_fileIndex.finishSetup();
+std::wstring PersistentStorage::getSearchIndexSymbolName(const StorageNode& node) const
+{
+	auto it = m_symbolDefinitionKinds.find(node.id);
+	const DefinitionKind defKind =
+		(it != m_symbolDefinitionKinds.end() ? it->second : DEFINITION_NONE);
+	if (defKind == DEFINITION_IMPLICIT)
+	{
+		return L"";
+	}
+
+	const NameHierarchy nameHierarchy = NameHierarchy::deserialize(node.serializedName);
+
+	// we don't use the signature here, so elements with the same signature share the same node.
+	std::wstring name = nameHierarchy.getQualifiedName();
+
+	// replace template arguments with .. to avoid clutter in search results and have different
+	// template specializations share the same node.
+	if (defKind == DEFINITION_NONE &&
+		nameHierarchy.getDelimiter() == nameDelimiterTypeToString(NAME_DELIMITER_CXX))
+	{
+		name = utility::replaceBetween(name, L'<', L'>', L"..");
+	}
+
+	return name;
 }
 
 void PersistentStorage::buildFullTextSearchIndex() const
@@ -3330,6 +4100,8 @@ void PersistentStorage::buildFullTextSearchIndex() const
 	m_fullTextSearchCodec = codec.getName();
 
 	m_fullTextSearchIndex.clear();
+	m_trigramIndex.clear();
+	m_hasTrigramIndex = false;
 
 	std::vector<std::shared_ptr<std::thread>> threads;
 	{
@@ -3350,7 +4122,7 @@ void PersistentStorage::buildFullTextSearchIndex() const
 					{
 						m_fullTextSearchIndex.addFile(
 							file.id,
-							codec.decode(m_sqliteIndexStorage.getFileContentById(file.id)->getText()));
+							codec.decode(m_sqliteIndexStorage.getFileContentTextById(file.id)));
 					}
 				},
 				part);
@@ -3363,7 +4135,251 @@ void PersistentStorage::buildFullTextSearchIndex() const
 	}
 }
 
-void PersistentStorage::buildMemberEdgeIdOrderMap()
+bool PersistentStorage::loadFullTextSearchIndex(const std::string& timestamp) const
+{
+	TRACE();
+
+	const TextCodec codec(ApplicationSettings::getInstance()->getTextEncoding());
+	if (!m_fullTextSearchIndex.load(
+			FullTextSearchIndex::getIndexFilePath(getIndexDbFilePath()), timestamp, codec.getName()))
+	{
+		return false;
+	}
+
+	m_fullTextSearchCodec = codec.getName();
+	m_trigramIndex.clear();
+	m_hasTrigramIndex = false;
+	return true;
+}
+
+void PersistentStorage::saveFullTextSearchIndex() const
+{
+	TRACE();
+
+	// storages without timestamp are still being written, so there is nothing worth persisting
+	const std::string timestamp = getIndexTimestamp();
+	if (timestamp.empty())
+	{
+		return;
+	}
+
+	const int maximumMegabytes =
+		ApplicationSettings::getInstance()->getCodeFullTextSearchMaxIndexFileSize();
+	const size_t maximumByteSize = static_cast<size_t>(std::max(maximumMegabytes, 0)) * 1024 * 1024;
+	const size_t byteSize = m_fullTextSearchIndex.getFileByteSize();
+	if (byteSize > maximumByteSize)
+	{
+		LOG_INFO(
+			"Not saving fulltext search index of " + std::to_string(byteSize / 1024 / 1024) +
+			" MB, the limit is " + std::to_string(maximumByteSize / 1024 / 1024) + " MB");
+		return;
+	}
+
+	waitForFullTextSearchIndexSave();
+
+	const FilePath filePath = FullTextSearchIndex::getIndexFilePath(getIndexDbFilePath());
+	const std::string codecName = m_fullTextSearchCodec;
+	m_fullTextSearchSaveThread = std::make_shared<std::thread>(
+		[this, filePath, timestamp, codecName]() {
+			m_fullTextSearchIndex.save(filePath, timestamp, codecName);
+		});
+}
+
+void PersistentStorage::waitForFullTextSearchIndexSave() const
+{
+	if (m_fullTextSearchSaveThread)
+	{
+		m_fullTextSearchSaveThread->join();
+		m_fullTextSearchSaveThread.reset();
+	}
+}
+
+void PersistentStorage::buildTrigramIndex() const
+{
+	TRACE();
+
+	const TimeStamp start = TimeStamp::now();
+
+	m_trigramIndex.clear();
+	m_fullTextSearchIndex.forEachFileText([this](Id fileId, const char* begin, const char* end) {
+		m_trigramIndex.addFile(fileId, begin, end);
+	});
+	m_hasTrigramIndex = true;
+
+	LOG_INFO(
+		"Built fulltext search trigram index for " + std::to_string(m_trigramIndex.fileCount()) +
+		" files in " + std::to_string(TimeStamp::durationSeconds(start)) + " s: " +
+		std::to_string(m_trigramIndex.trigramCount()) + " trigrams, " +
+		std::to_string(m_trigramIndex.postingCount()) + " postings, " +
+		std::to_string(m_trigramIndex.getByteSize() / 1024) + " kB");
+}
+
+bool PersistentStorage::searchFullTextLocationsInBatches(
+	const std::vector<Id>& fileIds,
+	const std::function<std::vector<ParseLocation>(size_t, const TextAccess*)>& findLocations,
+	size_t maxResultCount,
+	const std::function<bool(std::shared_ptr<SourceLocationCollection>)>& handleBatch) const
+{
+	TRACE();
+
+	const size_t threadCount = static_cast<size_t>(utility::getIdealThreadCount());
+	const size_t maximumBatchFileCount = 64 * threadCount;
+
+	size_t batchFileCount = threadCount;
+	size_t batchStart = 0;
+	size_t resultCount = 0;
+
+	while (batchStart < fileIds.size())
+	{
+		const size_t batchEnd = std::min(fileIds.size(), batchStart + batchFileCount);
+
+		std::vector<FilePath> filePaths(batchEnd - batchStart);
+		std::vector<std::vector<ParseLocation>> fileLocations(batchEnd - batchStart);
+		std::atomic<size_t> nextFileIndex(batchStart);
+
+		std::vector<std::shared_ptr<std::thread>> threads;
+		for (size_t i = 0; i < std::min(threadCount, batchEnd - batchStart); i++)
+		{
+			std::shared_ptr<std::thread> thread = std::make_shared<std::thread>([&]() {
+				for (size_t fileIndex = nextFileIndex++; fileIndex < batchEnd;
+					 fileIndex = nextFileIndex++)
+				{
+					const FilePath filePath = getFileNodePath(fileIds[fileIndex]);
+					std::shared_ptr<TextAccess> fileContent = getFileContent(filePath, false);
+
+					filePaths[fileIndex - batchStart] = filePath;
+					fileLocations[fileIndex - batchStart] = findLocations(
+						fileIndex, fileContent.get());
+				}
+			});
+			threads.push_back(thread);
+		}
+
+		for (std::shared_ptr<std::thread> thread: threads)
+		{
+			thread->join();
+		}
+
+		std::shared_ptr<SourceLocationCollection> batch =
+			std::make_shared<SourceLocationCollection>();
+		for (size_t i = 0; i < fileLocations.size(); i++)
+		{
+			for (const ParseLocation& location: fileLocations[i])
+			{
+				if (maxResultCount && resultCount >= maxResultCount)
+				{
+					break;
+				}
+
+				resultCount++;
+
+				// Set first bit to 1 to avoid collisions
+				const Id locationId = ~(~Id(0) >> 1) + resultCount;
+				batch->addSourceLocation(
+					LOCATION_FULLTEXT_SEARCH,
+					locationId,
+					std::vector<Id>(),
+					filePaths[i],
+					location.startLineNumber,
+					location.startColumnNumber,
+					location.endLineNumber,
+					location.endColumnNumber);
+			}
+		}
+
+		if (batch->getSourceLocationFileCount())
+		{
+			addCompleteFlagsToSourceLocationCollection(batch.get());
+			if (!handleBatch(batch))
+			{
+				return false;
+			}
+		}
+
+		if (maxResultCount && resultCount >= maxResultCount)
+		{
+			break;
+		}
+
+		batchStart = batchEnd;
+		batchFileCount = std::min(2 * batchFileCount, maximumBatchFileCount);
+	}
+
+	return true;
+}
+
+std::vector<ParseLocation> PersistentStorage::getFullTextSearchTermLocations(
+	const FullTextSearchResult& fileResult,
+	const std::wstring& searchTerm,
+	bool caseSensitive,
+	const TextCodec& codec,
+	const TextAccess* fileContent) const
+{
+	std::vector<ParseLocation> locations;
+
+	const int termLength = static_cast<int>(searchTerm.length());
+
+	int charsTotal = 0;
+	int lineNumber = 1;
+	std::wstring line = codec.decode(fileContent->getLine(lineNumber));
+
+	for (int pos: fileResult.positions)
+	{
+		while (charsTotal + (int)line.length() <= pos)
+		{
+			charsTotal += static_cast<int>(line.length());
+			lineNumber++;
+			line = codec.decode(fileContent->getLine(lineNumber));
+		}
+
+		ParseLocation location;
+		location.startLineNumber = lineNumber;
+		location.startColumnNumber = pos - charsTotal + 1;
+
+		if (caseSensitive && line.substr(location.startColumnNumber - 1, termLength) != searchTerm)
+		{
+			continue;
+		}
+		while ((charsTotal + (int)line.length()) < pos + termLength)
+		{
+			charsTotal += static_cast<int>(line.length());
+			lineNumber++;
+			line = codec.decode(fileContent->getLine(lineNumber));
+		}
+		location.endLineNumber = lineNumber;
+		location.endColumnNumber = pos + termLength - charsTotal;
+
+		locations.push_back(location);
+	}
+
+	return locations;
+}
+
+std::vector<ParseLocation> PersistentStorage::getFullTextSearchQueryLocations(
+	const FullTextSearchQuery& query, const TextCodec& codec, const TextAccess* fileContent) const
+{
+	std::vector<ParseLocation> locations;
+
+	for (unsigned int lineNumber = 1; lineNumber <= fileContent->getLineCount(); lineNumber++)
+	{
+		// line breaks are left out, so '$' matches at the end of each line
+		std::wstring line = codec.decode(fileContent->getLine(lineNumber));
+		while (!line.empty() && (line.back() == L'\n' || line.back() == L'\r'))
+		{
+			line.pop_back();
+		}
+
+		for (const std::pair<int, int>& match: query.findMatches(line))
+		{
+			locations.push_back(ParseLocation(
+				0, lineNumber, match.first + 1, lineNumber, match.first + match.second));
+		}
+	}
+
+	return locations;
+}
+
+void PersistentStorage::buildMemberEdgeIdOrderMap(const IndexSnapshot& snapshot)
 {
 	TRACE();
 
@@ -3372,15 +4388,23 @@ void PersistentStorage::buildMemberEdgeIdOrderMap()
 		return;
 	}
 
+	std::vector<StorageEdge> memberEdges;
+	snapshot.forEachOfType<StorageEdge>(
+		Edge::typeToInt(Edge::EDGE_MEMBER),
+		[&memberEdges](StorageEdge&& edge) { memberEdges.push_back(edge); });
+
+	addMemberEdgesToOrderMap(memberEdges);
+}
+
+void PersistentStorage::addMemberEdgesToOrderMap(const std::vector<StorageEdge>& memberEdges)
+{
 	std::vector<Id> childNodeIds;
 	std::unordered_map<Id, Id> childIdToMemberEdgeIdMap;
-
-	m_sqliteIndexStorage.forEachOfType<StorageEdge>(
-		Edge::typeToInt(Edge::EDGE_MEMBER),
-		[&childNodeIds, &childIdToMemberEdgeIdMap](StorageEdge&& edge) {
-			childNodeIds.push_back(edge.targetNodeId);
-			childIdToMemberEdgeIdMap.emplace(edge.targetNodeId, edge.id);
-		});
+	for (const StorageEdge& edge: memberEdges)
+	{
+		childNodeIds.push_back(edge.targetNodeId);
+		childIdToMemberEdgeIdMap.emplace(edge.targetNodeId, edge.id);
+	}
 
 	std::vector<Id> locationIds;
 	std::unordered_map<Id, Id> locationIdToElementIdMap;
@@ -3416,9 +4440,6 @@ void PersistentStorage::buildMemberEdgeIdOrderMap()
 		}
 	}
 
-	// Set first 3 bits to 1 to avoid collisions
-	Id baseId = ~(~Id(0) >> 3) + 1;
-
 	collection.forEachSourceLocation([&](SourceLocation* location) {
 		auto it = locationIdToElementIdMap.find(location->getLocationId());
 		if (it != locationIdToElementIdMap.end())
@@ -3426,23 +4447,35 @@ void PersistentStorage::buildMemberEdgeIdOrderMap()
 			auto it2 = childIdToMemberEdgeIdMap.find(it->second);
 			if (it2 != childIdToMemberEdgeIdMap.end())
 			{
-				if (m_memberEdgeIdOrderMap.emplace(it2->second, baseId).second)
+				if (m_memberEdgeIdOrderMap.emplace(it2->second, m_nextMemberEdgeOrderId).second)
 				{
-					baseId++;
+					m_nextMemberEdgeOrderId++;
 				}
 			}
 		}
 	});
 }
 
-void PersistentStorage::buildHierarchyCache()
+void PersistentStorage::buildAdjacencyIndex(const IndexSnapshot& snapshot)
+{
+	TRACE();
+
+	std::vector<StorageEdge> edges;
+	edges.reserve(snapshot.getEdgeCount());
+	snapshot.forEach<StorageEdge>([&edges](StorageEdge&& edge) { edges.push_back(edge); });
+
+	std::lock_guard<std::mutex> lock(m_adjacencyIndexMutex);
+	m_adjacencyIndex.build(edges);
+}
+
+void PersistentStorage::buildHierarchyCache(const IndexSnapshot& snapshot)
 {
 	TRACE();
 
 	std::vector<Id> sourceNodeIds;
 	std::vector<StorageEdge> memberEdges;
 
-	m_sqliteIndexStorage.forEachOfType<StorageEdge>(
+	snapshot.forEachOfType<StorageEdge>(
 		Edge::typeToInt(Edge::EDGE_MEMBER), [&sourceNodeIds, &memberEdges](StorageEdge&& edge) {
 			sourceNodeIds.push_back(edge.sourceNodeId);
 			memberEdges.emplace_back(edge);
@@ -3450,7 +4483,7 @@ void PersistentStorage::buildHierarchyCache()
 
 	std::set<Id> invisibleParentSourceNodeIds;
 
-	m_sqliteIndexStorage.forEachByIds<StorageNode>(
+	snapshot.forEachByIds<StorageNode>(
 		sourceNodeIds, [&invisibleParentSourceNodeIds](StorageNode&& node) {
 			if (!NodeType(intToNodeKind(node.type)).isVisibleAsParentInGraph())
 			{
@@ -3460,37 +4493,40 @@ void PersistentStorage::buildHierarchyCache()
 
 	for (const StorageEdge& edge: memberEdges)
 	{
-		bool sourceIsVisible = true;
-		if (invisibleParentSourceNodeIds.find(edge.sourceNodeId) != invisibleParentSourceNodeIds.end())
-		{
-			sourceIsVisible = false;
-		}
-
-		bool sourceIsImplicit = false;
-		auto it = m_symbolDefinitionKinds.find(edge.sourceNodeId);
-		if (it != m_symbolDefinitionKinds.end())
-		{
-			sourceIsImplicit = (it->second == DEFINITION_IMPLICIT);
-		}
-
-		bool targetIsImplicit = false;
-		it = m_symbolDefinitionKinds.find(edge.targetNodeId);
-		if (it != m_symbolDefinitionKinds.end())
-		{
-			targetIsImplicit = (it->second == DEFINITION_IMPLICIT);
-		}
-
-		m_hierarchyCache.createConnection(
-			edge.id,
-			edge.sourceNodeId,
-			edge.targetNodeId,
-			sourceIsVisible,
-			sourceIsImplicit,
-			targetIsImplicit);
+		createHierarchyConnection(
+			edge,
+			invisibleParentSourceNodeIds.find(edge.sourceNodeId) ==
+				invisibleParentSourceNodeIds.end());
 	}
 
-	m_sqliteIndexStorage.forEachOfType<StorageEdge>(
+	snapshot.forEachOfType<StorageEdge>(
 		Edge::typeToInt(Edge::EDGE_INHERITANCE), [this](StorageEdge&& edge) {
 			m_hierarchyCache.createInheritance(edge.id, edge.sourceNodeId, edge.targetNodeId);
 		});
 }
+
+void PersistentStorage::createHierarchyConnection(
+	const StorageEdge& memberEdge, bool sourceIsVisible)
+{
+	bool sourceIsImplicit = false;
+	auto it = m_symbolDefinitionKinds.find(memberEdge.sourceNodeId);
+	if (it != m_symbolDefinitionKinds.end())
+	{
+		sourceIsImplicit = (it->second == DEFINITION_IMPLICIT);
+	}
+
+	bool targetIsImplicit = false;
+	it = m_symbolDefinitionKinds.find(memberEdge.targetNodeId);
+	if (it != m_symbolDefinitionKinds.end())
+	{
+		targetIsImplicit = (it->second == DEFINITION_IMPLICIT);
+	}
+
+	m_hierarchyCache.createConnection(
+		memberEdge.id,
+		memberEdge.sourceNodeId,
+		memberEdge.targetNodeId,
+		sourceIsVisible,
+		sourceIsImplicit,
+		targetIsImplicit);
+}
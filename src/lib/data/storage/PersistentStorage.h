@@ -1,16 +1,28 @@
 #ifndef PERSISTENT_STORAGE_H
 #define PERSISTENT_STORAGE_H
 
+#include <map>
 #include <memory>
+#include <set>
+#include <shared_mutex>
+#include <thread>
 #include <vector>
 
+#include "AdjacencyIndex.h"
 #include "FullTextSearchIndex.h"
 #include "HierarchyCache.h"
+#include "ScopedFunctor.h"
 #include "SearchIndex.h"
 #include "SqliteBookmarkStorage.h"
 #include "SqliteIndexStorage.h"
 #include "Storage.h"
 #include "StorageAccess.h"
+#include "TrigramIndex.h"
+
+class FullTextSearchQuery;
+class IndexSnapshot;
+class TextCodec;
+struct ParseLocation;
 
 class PersistentStorage
 	: public Storage
@@ -18,6 +30,7 @@ class PersistentStorage
 {
 public:
 	PersistentStorage(const FilePath& dbPath, const FilePath& bookmarkPath);
+	~PersistentStorage() override;
 
 	std::pair<Id, bool> addNode(const StorageNodeData& data) override;
 	std::vector<Id> addNodes(const std::vector<StorageNode>& nodes) override;
@@ -27,7 +40,7 @@ public:
 	Id addEdge(const StorageEdgeData& data) override;
 	std::vector<Id> addEdges(const std::vector<StorageEdge>& edges) override;
 	Id addLocalSymbol(const StorageLocalSymbolData& data) override;
-	std::vector<Id> addLocalSymbols(const std::set<StorageLocalSymbol>& symbols) override;
+	std::vector<Id> addLocalSymbols(const std::vector<StorageLocalSymbol>& symbols) override;
 	Id addSourceLocation(const StorageSourceLocationData& data) override;
 	std::vector<Id> addSourceLocations(const std::vector<StorageSourceLocation>& locations) override;
 	void addOccurrence(const StorageOccurrence& data) override;
@@ -48,11 +61,11 @@ public:
 	const std::vector<StorageFile>& getStorageFiles() const override;
 	const std::vector<StorageSymbol>& getStorageSymbols() const override;
 	const std::vector<StorageEdge>& getStorageEdges() const override;
-	const std::set<StorageLocalSymbol>& getStorageLocalSymbols() const override;
-	const std::set<StorageSourceLocation>& getStorageSourceLocations() const override;
-	const std::set<StorageOccurrence>& getStorageOccurrences() const override;
-	const std::set<StorageComponentAccess>& getComponentAccesses() const override;
-	const std::set<StorageElementComponent>& getElementComponents() const override;
+	const std::vector<StorageLocalSymbol>& getStorageLocalSymbols() const override;
+	const std::vector<StorageSourceLocation>& getStorageSourceLocations() const override;
+	const std::vector<StorageOccurrence>& getStorageOccurrences() const override;
+	const std::vector<StorageComponentAccess>& getComponentAccesses() const override;
+	const std::vector<StorageElementComponent>& getElementComponents() const override;
 	const std::vector<StorageError>& getErrors() const override;
 
 	void startInjection() override;
@@ -64,6 +77,10 @@ public:
 
 	void setMode(const SqliteIndexStorage::StorageModeType mode);
 
+	void beginBulkLoad();
+	void finishBulkLoad(std::function<void(int)> updateStatusCallback);
+	bool isBulkLoading() const;
+
 	FilePath getIndexDbFilePath() const;
 	FilePath getBookmarkDbFilePath() const;
 
@@ -72,6 +89,10 @@ public:
 	std::string getProjectSettingsText() const;
 	void setProjectSettingsText(std::string text);
 
+	std::vector<StorageIndexingDuration> getIndexingDurations() const;
+	void addIndexingDurations(const std::vector<StorageIndexingDuration>& durations);
+	void removeIndexingDurationsOfRemovedFiles();
+
 	void setup();
 	void updateVersion();
 	void clear();
@@ -89,9 +110,23 @@ public:
 	bool getFilePathIndexed(const FilePath& path) const;
 
 	void buildCaches();
+	void packSourceLocations();
+	void writeIndexSnapshot() const;
 
 	void optimizeMemory();
 
+	void enableConcurrentReads();
+	void checkpoint() const;
+
+	// Refreshes this storage in place: clearing files and injecting their new data happens inside
+	// one transaction, so readers keep seeing the last committed state. Once it is committed, the
+	// caches only get updated for the elements that were removed or written in the meantime.
+	// The indices needed for writing and clearing only exist during the refresh. All three have to
+	// be called on the same thread; other threads write through nested transactions meanwhile.
+	void startIncrementalRefresh();
+	void finishIncrementalRefresh();
+	void rollbackIncrementalRefresh();
+
 	// StorageAccess implementation
 	Id getNodeIdForFileNode(const FilePath& filePath) const override;
 	Id getNodeIdForNameHierarchy(const NameHierarchy& nameHierarchy) const override;
@@ -107,8 +142,12 @@ public:
 
 	StorageEdge getEdgeById(Id edgeId) const override;
 
-	std::shared_ptr<SourceLocationCollection> getFullTextSearchLocations(
-		const std::wstring& searchTerm, bool caseSensitive) const override;
+	bool searchFullTextLocations(
+		const std::wstring& searchTerm,
+		bool caseSensitive,
+		size_t maxResultCount,
+		const std::function<bool(std::shared_ptr<SourceLocationCollection>)>& handleBatch)
+		const override;
 
 	std::vector<SearchMatch> getAutocompletionMatches(
 		const std::wstring& query, NodeTypeSet acceptedNodeTypes, bool acceptCommands) const override;
@@ -157,6 +196,12 @@ public:
 		const FilePath& filePath, LocationType type) const override;
 
 	std::shared_ptr<TextAccess> getFileContent(const FilePath& filePath, bool showsErrors) const override;
+	std::vector<std::string> getFileContentLines(
+		const FilePath& filePath,
+		size_t firstLineNumber,
+		size_t lastLineNumber,
+		bool showsErrors) const override;
+	size_t getFileContentLineCount(const FilePath& filePath, bool showsErrors) const override;
 	bool hasContentForFile(const FilePath& filePath) const;
 
 	FileInfo getFileInfoForFileId(Id id) const override;
@@ -202,11 +247,11 @@ private:
 		std::vector<StorageFile> files;
 		std::vector<StorageSymbol> symbols;
 		std::vector<StorageEdge> edges;
-		std::set<StorageLocalSymbol> locals;
-		std::set<StorageSourceLocation> locations;
-		std::set<StorageOccurrence> occurrences;
-		std::set<StorageComponentAccess> accesses;
-		std::set<StorageElementComponent> components;
+		std::vector<StorageLocalSymbol> locals;
+		std::vector<StorageSourceLocation> locations;
+		std::vector<StorageOccurrence> occurrences;
+		std::vector<StorageComponentAccess> accesses;
+		std::vector<StorageElementComponent> components;
 		std::vector<StorageError> errors;
 	} m_storageData;
 
@@ -234,6 +279,22 @@ private:
 	std::set<FilePath> getReferencingByIncludes(const std::set<FilePath>& filePaths) const;
 	std::set<FilePath> getReferencingByImports(const std::set<FilePath>& filePaths) const;
 
+	std::vector<StorageEdge> getEdgesBySourceIds(
+		const std::vector<Id>& sourceIds, Edge::TypeMask edgeTypes = ~Edge::TypeMask(0)) const;
+	std::vector<StorageEdge> getEdgesByTargetIds(
+		const std::vector<Id>& targetIds, Edge::TypeMask edgeTypes = ~Edge::TypeMask(0)) const;
+	std::vector<StorageEdge> getEdgesBySourceOrTargetId(Id nodeId) const;
+	void addEdgeToAdjacencyIndex(const StorageEdge& edge);
+
+	ScopedFunctor startReadTransaction() const;
+	// Readers share the lock while an incremental refresh updates the caches exclusively. A thread
+	// that holds the lock already does not lock it again, so locked getters can call each other.
+	ScopedFunctor lockCaches(bool exclusive) const;
+
+	void addWrittenNodeIds(const std::vector<Id>& nodeIds);
+	void addRemovalCandidates(const std::vector<Id>& elementIds);
+	void updateCachesForRefresh();
+
 	void addNodesToGraph(const std::vector<Id>& nodeIds, Graph* graph, bool addChildCount) const;
 	void addEdgesToGraph(const std::vector<Id>& edgeIds, Graph* graph) const;
 	void addNodesWithParentsAndEdgesToGraph(
@@ -253,16 +314,52 @@ private:
 	void addCompleteFlagsToSourceLocationCollection(SourceLocationCollection* collection) const;
 	void addInheritanceChainsToGraph(const std::vector<Id>& nodeIds, Graph* graph) const;
 
-	void buildFilePathMaps();
-	void buildSearchIndex();
+	void loadIndexSnapshot(IndexSnapshot* snapshot) const;
+	std::string getIndexTimestamp() const;
+
+	void buildFilePathMaps(const IndexSnapshot& snapshot);
+	void buildSearchIndex(const IndexSnapshot& snapshot);
 	void buildFullTextSearchIndex() const;
-	void buildMemberEdgeIdOrderMap();
-	void buildHierarchyCache();
+	bool loadFullTextSearchIndex(const std::string& timestamp) const;
+	// Writes the index file on a thread of its own, so the search does not wait for it. Both need
+	// the fulltext search mutex to be locked.
+	void saveFullTextSearchIndex() const;
+	void waitForFullTextSearchIndexSave() const;
+	void buildTrigramIndex() const;
+	// Searches the files in parallel, in batches that start at one file per thread and grow, so the
+	// first results get passed on without waiting for the search to finish.
+	bool searchFullTextLocationsInBatches(
+		const std::vector<Id>& fileIds,
+		const std::function<std::vector<ParseLocation>(size_t, const TextAccess*)>& findLocations,
+		size_t maxResultCount,
+		const std::function<bool(std::shared_ptr<SourceLocationCollection>)>& handleBatch) const;
+	std::vector<ParseLocation> getFullTextSearchTermLocations(
+		const FullTextSearchResult& fileResult,
+		const std::wstring& searchTerm,
+		bool caseSensitive,
+		const TextCodec& codec,
+		const TextAccess* fileContent) const;
+	std::vector<ParseLocation> getFullTextSearchQueryLocations(
+		const FullTextSearchQuery& query,
+		const TextCodec& codec,
+		const TextAccess* fileContent) const;
+	void buildMemberEdgeIdOrderMap(const IndexSnapshot& snapshot);
+	void buildHierarchyCache(const IndexSnapshot& snapshot);
+	void buildAdjacencyIndex(const IndexSnapshot& snapshot);
+
+	void addFileToFilePathMaps(const StorageFile& file);
+	void addNodeToSearchIndex(const StorageNode& node);
+	void removeNodeFromSearchIndex(const StorageNode& node);
+	std::wstring getSearchIndexSymbolName(const StorageNode& node) const;
+	void addMemberEdgesToOrderMap(const std::vector<StorageEdge>& memberEdges);
+	void createHierarchyConnection(const StorageEdge& memberEdge, bool sourceIsVisible);
 
 	bool m_preIndexingErrorCountSet = false;
 	size_t m_preIndexingErrorCount = 0;
 	size_t m_preInjectionErrorCount = 0;
 
+	mutable std::shared_mutex m_cacheMutex;
+
 	SearchIndex m_commandIndex;
 	SearchIndex m_symbolIndex;
 	SearchIndex m_fileIndex;
@@ -270,6 +367,9 @@ private:
 	mutable FullTextSearchIndex m_fullTextSearchIndex;
 	mutable std::string m_fullTextSearchCodec;
 	mutable std::mutex m_fullTextSearchMutex;
+	mutable TrigramIndex m_trigramIndex;
+	mutable bool m_hasTrigramIndex = false;
+	mutable std::shared_ptr<std::thread> m_fullTextSearchSaveThread;
 
 	SqliteIndexStorage m_sqliteIndexStorage;
 	SqliteBookmarkStorage m_sqliteBookmarkStorage;
@@ -284,7 +384,26 @@ private:
 	std::unordered_map<Id, DefinitionKind> m_symbolDefinitionKinds;
 	std::map<Id, Id> m_memberEdgeIdOrderMap;
 
+	// Set first 3 bits to 1 to avoid collisions
+	static constexpr Id s_firstMemberEdgeOrderId = ~(~Id(0) >> 3) + 1;
+	Id m_nextMemberEdgeOrderId = s_firstMemberEdgeOrderId;
+
 	HierarchyCache m_hierarchyCache;
+	AdjacencyIndex m_adjacencyIndex;
+	mutable std::mutex m_adjacencyIndexMutex;
+	std::vector<StorageEdge> m_pendingAdjacencyEdges;
+	size_t m_injectionAdjacencyEdgeOffset = 0;
+	bool m_isInjecting = false;
+	bool m_isRecordingInjectedErrors = false;
+
+	struct RefreshChanges
+	{
+		std::map<Id, StorageNode> removalCandidateNodes;
+		std::map<Id, StorageEdge> removalCandidateEdges;
+		std::set<Id> writtenNodeIds;
+	} m_refreshChanges;
+	bool m_isRefreshing = false;
+	std::string m_refreshStartTimestamp;
 
 	bool m_hasJavaFiles = false;
 };
@@ -1,6 +1,7 @@
 #ifndef STORAGE_ACCESS_H
 #define STORAGE_ACCESS_H
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -50,8 +51,14 @@ public:
 
 	virtual StorageEdge getEdgeById(Id edgeId) const = 0;
 
-	virtual std::shared_ptr<SourceLocationCollection> getFullTextSearchLocations(
-		const std::wstring& searchTerm, bool caseSensitive) const = 0;
+	// Passes the results to the callback in batches of whole files ordered by path, until the
+	// callback returns false or maxResultCount results were passed. Returns false if cancelled.
+	virtual bool searchFullTextLocations(
+		const std::wstring& searchTerm,
+		bool caseSensitive,
+		size_t maxResultCount,
+		const std::function<bool(std::shared_ptr<SourceLocationCollection>)>& handleBatch)
+		const = 0;
 	virtual std::vector<SearchMatch> getAutocompletionMatches(
 		const std::wstring& query, NodeTypeSet acceptedNodeTypes, bool acceptCommands) const = 0;
 	virtual std::vector<SearchMatch> getSearchMatchesForTokenIds(
@@ -93,6 +100,12 @@ public:
 
 	virtual std::shared_ptr<TextAccess> getFileContent(
 		const FilePath& filePath, bool showsErrors) const = 0;
+	virtual std::vector<std::string> getFileContentLines(
+		const FilePath& filePath,
+		size_t firstLineNumber,
+		size_t lastLineNumber,
+		bool showsErrors) const = 0;
+	virtual size_t getFileContentLineCount(const FilePath& filePath, bool showsErrors) const = 0;
 
 	virtual FileInfo getFileInfoForFileId(Id id) const = 0;
 
@@ -164,12 +164,14 @@ DEF_GETTER_1(getNodeIdToParentFileMap, const std::vector<Id>&, NodeIdToParentFil
 
 DEF_GETTER_1(getNodeTypeForNodeWithId, Id, NodeType, NodeType(NODE_SYMBOL))
 DEF_GETTER_1(getEdgeById, Id, StorageEdge, StorageEdge())
-DEF_GETTER_2(
-	getFullTextSearchLocations,
+DEF_GETTER_4(
+	searchFullTextLocations,
 	const std::wstring&,
 	bool,
-	std::shared_ptr<SourceLocationCollection>,
-	std::make_shared<SourceLocationCollection>())
+	size_t,
+	const std::function<bool(std::shared_ptr<SourceLocationCollection>)>&,
+	bool,
+	true)
 DEF_GETTER_3(
 	getAutocompletionMatches,
 	const std::wstring&,
@@ -236,6 +238,9 @@ DEF_GETTER_2(
 	std::shared_ptr<SourceLocationFile>,
 	std::make_shared<SourceLocationFile>(FilePath(), L"", false, false, false))
 DEF_GETTER_2(getFileContent, const FilePath&, bool, std::shared_ptr<TextAccess>, nullptr)
+DEF_GETTER_4(
+	getFileContentLines, const FilePath&, size_t, size_t, bool, std::vector<std::string>, {})
+DEF_GETTER_2(getFileContentLineCount, const FilePath&, bool, size_t, 0)
 DEF_GETTER_1(getFileInfoForFileId, Id, FileInfo, FileInfo())
 DEF_GETTER_1(getFileInfoForFilePath, const FilePath&, FileInfo, FileInfo())
 DEF_GETTER_1(getFileInfosForFilePaths, const std::vector<FilePath>&, std::vector<FileInfo>, {})
@@ -27,8 +27,12 @@ public:
 
 	StorageEdge getEdgeById(Id edgeId) const override;
 
-	std::shared_ptr<SourceLocationCollection> getFullTextSearchLocations(
-		const std::wstring& searchTerm, bool caseSensitive) const override;
+	bool searchFullTextLocations(
+		const std::wstring& searchTerm,
+		bool caseSensitive,
+		size_t maxResultCount,
+		const std::function<bool(std::shared_ptr<SourceLocationCollection>)>& handleBatch)
+		const override;
 	std::vector<SearchMatch> getAutocompletionMatches(
 		const std::wstring& query, NodeTypeSet acceptedNodeTypes, bool acceptCommands) const override;
 	std::vector<SearchMatch> getSearchMatchesForTokenIds(const std::vector<Id>& tokenIds) const override;
@@ -67,6 +71,12 @@ public:
 		const FilePath& filePath, LocationType type) const override;
 
 	std::shared_ptr<TextAccess> getFileContent(const FilePath& filePath, bool showsErrors) const override;
+	std::vector<std::string> getFileContentLines(
+		const FilePath& filePath,
+		size_t firstLineNumber,
+		size_t lastLineNumber,
+		bool showsErrors) const override;
+	size_t getFileContentLineCount(const FilePath& filePath, bool showsErrors) const override;
 
 	FileInfo getFileInfoForFileId(Id id) const override;
 
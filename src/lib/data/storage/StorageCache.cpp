@@ -44,6 +44,29 @@ std::shared_ptr<TextAccess> StorageCache::getFileContent(const FilePath& filePat
 	return StorageAccessProxy::getFileContent(filePath, showsErrors);
 }
 
+std::vector<std::string> StorageCache::getFileContentLines(
+	const FilePath& filePath, size_t firstLineNumber, size_t lastLineNumber, bool showsErrors) const
+{
+	if (m_useErrorCache && showsErrors)
+	{
+		return TextAccess::createFromFile(filePath)->getLines(
+			static_cast<unsigned int>(firstLineNumber), static_cast<unsigned int>(lastLineNumber));
+	}
+
+	return StorageAccessProxy::getFileContentLines(
+		filePath, firstLineNumber, lastLineNumber, showsErrors);
+}
+
+size_t StorageCache::getFileContentLineCount(const FilePath& filePath, bool showsErrors) const
+{
+	if (m_useErrorCache && showsErrors)
+	{
+		return TextAccess::createFromFile(filePath)->getLineCount();
+	}
+
+	return StorageAccessProxy::getFileContentLineCount(filePath, showsErrors);
+}
+
 ErrorCountInfo StorageCache::getErrorCount() const
 {
 	if (!m_useErrorCache)
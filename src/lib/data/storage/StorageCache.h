@@ -15,6 +15,12 @@ public:
 	StorageStats getStorageStats() const override;
 
 	std::shared_ptr<TextAccess> getFileContent(const FilePath& filePath, bool showsErrors) const override;
+	std::vector<std::string> getFileContentLines(
+		const FilePath& filePath,
+		size_t firstLineNumber,
+		size_t lastLineNumber,
+		bool showsErrors) const override;
+	size_t getFileContentLineCount(const FilePath& filePath, bool showsErrors) const override;
 
 	ErrorCountInfo getErrorCount() const override;
 	std::vector<ErrorInfo> getErrorsLimited(const ErrorFilter& filter) const override;
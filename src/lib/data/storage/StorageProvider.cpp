@@ -43,6 +43,22 @@ std::shared_ptr<IntermediateStorage> StorageProvider::consumeSecondLargestStorag
 			m_storages.erase(it);
 		}
 	}
+	m_storagesConsumedCondition.notify_all();
+	return ret;
+}
+
+std::shared_ptr<IntermediateStorage> StorageProvider::consumeSmallestStorage()
+{
+	std::shared_ptr<IntermediateStorage> ret;
+	{
+		std::lock_guard<std::mutex> lock(m_storagesMutex);
+		if (m_storages.size() > 1)
+		{
+			ret = m_storages.back();
+			m_storages.pop_back();
+		}
+	}
+	m_storagesConsumedCondition.notify_all();
 	return ret;
 }
 
@@ -57,10 +73,20 @@ std::shared_ptr<IntermediateStorage> StorageProvider::consumeLargestStorage()
 			m_storages.pop_front();
 		}
 	}
+	m_storagesConsumedCondition.notify_all();
 
 	return ret;
 }
 
+bool StorageProvider::waitForStorageCountBelow(int count, size_t timeoutMs)
+{
+	std::unique_lock<std::mutex> lock(m_storagesMutex);
+	return m_storagesConsumedCondition.wait_for(
+		lock, std::chrono::milliseconds(timeoutMs), [&]() {
+			return static_cast<int>(m_storages.size()) < count;
+		});
+}
+
 void StorageProvider::logCurrentState() const
 {
 	std::string logString = "Storages waiting for injection:";
@@ -2,6 +2,7 @@
 #define STORAGE_PROVIDER_H
 
 #include "IntermediateStorage.h"
+#include <condition_variable>
 #include <list>
 #include <memory>
 #include <mutex>
@@ -18,14 +19,22 @@ public:
 	// returns empty shared_ptr if no storages available
 	std::shared_ptr<IntermediateStorage> consumeSecondLargestStorage();
 
+	// returns empty shared_ptr if less than two storages available, the largest one is left for
+	// injection
+	std::shared_ptr<IntermediateStorage> consumeSmallestStorage();
+
 	// returns empty shared_ptr if no storages available
 	std::shared_ptr<IntermediateStorage> consumeLargestStorage();
 
+	// waits at most timeoutMs for storages to be consumed, returns whether fewer than count are left
+	bool waitForStorageCountBelow(int count, size_t timeoutMs);
+
 	void logCurrentState() const;
 
 private:
 	std::list<std::shared_ptr<IntermediateStorage>> m_storages;	   // larger storages are in front
 	mutable std::mutex m_storagesMutex;
+	std::condition_variable m_storagesConsumedCondition;
 };
 
 #endif	  // STORAGE_PROVIDER_H
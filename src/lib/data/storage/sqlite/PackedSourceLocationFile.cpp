@@ -0,0 +1,204 @@
+#include "PackedSourceLocationFile.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+
+const size_t PackedSourceLocationFile::s_blockSize = 32;
+
+namespace
+{
+void writeVarint(uint64_t value, std::string* out)
+{
+	while (value >= 0x80)
+	{
+		out->push_back(char((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out->push_back(char(value));
+}
+
+bool readVarint(const std::string& data, size_t* pos, uint64_t* value)
+{
+	*value = 0;
+	for (size_t shift = 0; shift < 64 && *pos < data.size(); shift += 7)
+	{
+		const unsigned char byte = data[(*pos)++];
+		*value |= uint64_t(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// signed differences are stored with the sign in the lowest bit, so small values stay short
+uint64_t toZigZag(int64_t value)
+{
+	return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+}
+
+int64_t fromZigZag(uint64_t value)
+{
+	return int64_t(value >> 1) ^ -int64_t(value & 1);
+}
+
+struct Block
+{
+	uint64_t firstStartLine = 0;
+	uint64_t maxEndLine = 0;
+	uint64_t size = 0;
+};
+}	 // namespace
+
+std::string PackedSourceLocationFile::pack(std::vector<Location> locations)
+{
+	std::sort(locations.begin(), locations.end(), [](const Location& a, const Location& b) {
+		return std::tie(a.startLine, a.startCol, a.endLine, a.endCol, a.type, a.id) <
+			std::tie(b.startLine, b.startCol, b.endLine, b.endCol, b.type, b.id);
+	});
+
+	std::string index;
+	std::string blocks;
+	writeVarint(locations.size(), &index);
+	writeVarint((locations.size() + s_blockSize - 1) / s_blockSize, &index);
+
+	for (size_t i = 0; i < locations.size(); i += s_blockSize)
+	{
+		std::string block;
+		size_t maxEndLine = 0;
+		size_t previousStartLine = locations[i].startLine;
+		Id previousId = 0;
+
+		for (size_t j = i; j < std::min(i + s_blockSize, locations.size()); j++)
+		{
+			const Location& location = locations[j];
+			writeVarint(location.startLine - previousStartLine, &block);
+			writeVarint(location.startCol, &block);
+			writeVarint(toZigZag(int64_t(location.endLine) - int64_t(location.startLine)), &block);
+			writeVarint(location.endCol, &block);
+			writeVarint(toZigZag(location.type), &block);
+			writeVarint(toZigZag(int64_t(location.id - previousId)), &block);
+
+			writeVarint(location.elementIds.size(), &block);
+			for (const Id elementId: location.elementIds)
+			{
+				writeVarint(elementId, &block);
+			}
+
+			previousStartLine = location.startLine;
+			previousId = location.id;
+			maxEndLine = std::max(maxEndLine, location.endLine);
+		}
+
+		writeVarint(locations[i].startLine, &index);
+		writeVarint(maxEndLine, &index);
+		writeVarint(block.size(), &index);
+		blocks += block;
+	}
+
+	return index + blocks;
+}
+
+bool PackedSourceLocationFile::unpack(
+	const std::string& data,
+	size_t startLine,
+	size_t endLine,
+	const std::function<void(const Location&)>& func)
+{
+	size_t pos = 0;
+	uint64_t locationCount = 0;
+	uint64_t blockCount = 0;
+	if (!readVarint(data, &pos, &locationCount) || !readVarint(data, &pos, &blockCount) ||
+		blockCount != (locationCount + s_blockSize - 1) / s_blockSize)
+	{
+		return false;
+	}
+
+	std::vector<Block> blocks;
+	for (uint64_t i = 0; i < blockCount; i++)
+	{
+		Block block;
+		if (!readVarint(data, &pos, &block.firstStartLine) ||
+			!readVarint(data, &pos, &block.maxEndLine) || !readVarint(data, &pos, &block.size))
+		{
+			return false;
+		}
+		blocks.push_back(block);
+	}
+
+	size_t remainingCount = locationCount;
+	for (const Block& block: blocks)
+	{
+		const size_t count = std::min(s_blockSize, remainingCount);
+		remainingCount -= count;
+
+		if (block.firstStartLine > endLine)
+		{
+			break;
+		}
+
+		if (block.size > data.size() - pos)
+		{
+			return false;
+		}
+
+		const size_t blockEnd = pos + block.size;
+		if (block.maxEndLine < startLine)
+		{
+			pos = blockEnd;
+			continue;
+		}
+
+		Location location;
+		location.startLine = block.firstStartLine;
+		for (size_t i = 0; i < count; i++)
+		{
+			uint64_t startLineDiff = 0;
+			uint64_t startCol = 0;
+			uint64_t lineDiff = 0;
+			uint64_t endCol = 0;
+			uint64_t type = 0;
+			uint64_t idDiff = 0;
+			uint64_t elementCount = 0;
+			if (!readVarint(data, &pos, &startLineDiff) || !readVarint(data, &pos, &startCol) ||
+				!readVarint(data, &pos, &lineDiff) || !readVarint(data, &pos, &endCol) ||
+				!readVarint(data, &pos, &type) || !readVarint(data, &pos, &idDiff) ||
+				!readVarint(data, &pos, &elementCount) || elementCount > blockEnd - pos)
+			{
+				return false;
+			}
+
+			location.startLine += startLineDiff;
+			location.startCol = startCol;
+			location.endLine = location.startLine + fromZigZag(lineDiff);
+			location.endCol = endCol;
+			location.type = static_cast<int>(fromZigZag(type));
+			location.id += fromZigZag(idDiff);
+
+			location.elementIds.resize(elementCount);
+			for (Id& elementId: location.elementIds)
+			{
+				uint64_t value = 0;
+				if (!readVarint(data, &pos, &value))
+				{
+					return false;
+				}
+				elementId = value;
+			}
+
+			if (location.startLine <= endLine && location.endLine >= startLine)
+			{
+				func(location);
+			}
+		}
+
+		if (pos != blockEnd)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,42 @@
+#ifndef PACKED_SOURCE_LOCATION_FILE_H
+#define PACKED_SOURCE_LOCATION_FILE_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+// Source locations of one file and the elements occurring at them, packed into a single blob. The
+// locations are sorted by start line and stored as varints relative to the previous location. A
+// skip index holding the first start line and the largest end line of every block of locations
+// allows decoding only the blocks that overlap a range of lines.
+class PackedSourceLocationFile
+{
+public:
+	struct Location
+	{
+		Id id = 0;
+		int type = 0;
+		size_t startLine = 0;
+		size_t startCol = 0;
+		size_t endLine = 0;
+		size_t endCol = 0;
+		std::vector<Id> elementIds;
+	};
+
+	static std::string pack(std::vector<Location> locations);
+
+	// Calls func for every location overlapping the lines from startLine to endLine. Returns false
+	// if the data was not produced by pack().
+	static bool unpack(
+		const std::string& data,
+		size_t startLine,
+		size_t endLine,
+		const std::function<void(const Location&)>& func);
+
+private:
+	static const size_t s_blockSize;
+};
+
+#endif	  // PACKED_SOURCE_LOCATION_FILE_H
@@ -277,6 +277,8 @@ void SqliteBookmarkStorage::setupTables()
 
 void SqliteBookmarkStorage::setupPrecompiledStatements() {}
 
+void SqliteBookmarkStorage::prepareWriteTransaction() {}
+
 template <>
 std::vector<StorageBookmarkCategory> SqliteBookmarkStorage::doGetAll<StorageBookmarkCategory>(
 	const std::string& query) const
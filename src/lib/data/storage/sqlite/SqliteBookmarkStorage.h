@@ -42,6 +42,7 @@ private:
 	virtual void clearTables();
 	virtual void setupTables();
 	virtual void setupPrecompiledStatements();
+	virtual void prepareWriteTransaction();
 
 	// void updateBookmarkMetaData(const BookmarkMetaData& metaData);
 
@@ -1,17 +1,23 @@
 #include "SqliteIndexStorage.h"
 
+#include <limits>
+#include <set>
 #include <sstream>
 #include <unordered_map>
 
 #include "FileSystem.h"
 #include "LocationType.h"
+#include "PackedSourceLocationFile.h"
 #include "SourceLocationCollection.h"
 #include "SourceLocationFile.h"
 #include "TextAccess.h"
 #include "logging.h"
+#include "utilityCompression.h"
 #include "utilityString.h"
 
-const size_t SqliteIndexStorage::s_storageVersion = 25;
+const size_t SqliteIndexStorage::s_storageVersion = 28;
+const size_t SqliteIndexStorage::s_fileContentBlockLineCount = 64;
+const size_t SqliteIndexStorage::s_packedSourceLocationMinCount = 100;
 
 namespace
 {
@@ -42,8 +48,19 @@ size_t SqliteIndexStorage::getStaticVersion() const
 	return s_storageVersion;
 }
 
+bool SqliteIndexStorage::isIncompatible() const
+{
+	return SqliteStorage::isIncompatible() || getMetaValue("bulk_load") == "1";
+}
+
 void SqliteIndexStorage::setMode(const StorageModeType mode)
 {
+	if (m_isBulkLoading && mode != STORAGE_MODE_WRITE)
+	{
+		// removing elements relies on the cascades of the foreign keys
+		finishBulkLoad([](int) {});
+	}
+
 	m_tempNodeNameIndex.clear();
 	m_tempWNodeNameIndex.clear();
 	m_tempNodeTypes.clear();
@@ -51,6 +68,9 @@ void SqliteIndexStorage::setMode(const StorageModeType mode)
 	m_tempLocalSymbolIndex.clear();
 	m_tempSourceLocationIndices.clear();
 
+	m_nextElementId = 0;
+	m_nextSourceLocationId = 0;
+
 	std::vector<std::pair<int, SqliteDatabaseIndex>> indices = getIndices();
 	for (size_t i = 0; i < indices.size(); i++)
 	{
@@ -65,6 +85,61 @@ void SqliteIndexStorage::setMode(const StorageModeType mode)
 	}
 }
 
+void SqliteIndexStorage::beginBulkLoad()
+{
+	if (m_isBulkLoading)
+	{
+		return;
+	}
+
+	if (getNodeCount() > 0)
+	{
+		LOG_WARNING("Bulk load is only used to fill an empty database.");
+		return;
+	}
+
+	// the marker has to be written before turning off synchronous writes
+	insertOrUpdateMetaValue("bulk_load", "1");
+
+	executeStatement("PRAGMA foreign_keys=OFF;");
+	executeStatement("PRAGMA synchronous=OFF;");
+
+	m_isBulkLoading = true;
+	setMode(STORAGE_MODE_WRITE);
+}
+
+void SqliteIndexStorage::finishBulkLoad(std::function<void(int)> updateStatusCallback)
+{
+	if (!m_isBulkLoading)
+	{
+		return;
+	}
+
+	m_isBulkLoading = false;
+
+	std::vector<std::pair<int, SqliteDatabaseIndex>> indices = getIndices();
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		updateStatusCallback(static_cast<int>(i * 100 / indices.size()));
+		if (indices[i].first & STORAGE_MODE_REFRESH)
+		{
+			indices[i].second.createOnDatabase(m_database);
+		}
+	}
+
+	executeStatement("PRAGMA synchronous=FULL;");
+	executeStatement("PRAGMA foreign_keys=ON;");
+
+	insertOrUpdateMetaValue("bulk_load", "0");
+
+	updateStatusCallback(100);
+}
+
+bool SqliteIndexStorage::isBulkLoading() const
+{
+	return m_isBulkLoading;
+}
+
 std::string SqliteIndexStorage::getProjectSettingsText() const
 {
 	return getMetaValue("project_settings");
@@ -75,6 +150,63 @@ void SqliteIndexStorage::setProjectSettingsText(std::string text)
 	insertOrUpdateMetaValue("project_settings", text);
 }
 
+std::vector<StorageIndexingDuration> SqliteIndexStorage::getIndexingDurations() const
+{
+	std::vector<StorageIndexingDuration> durations;
+	if (!hasTable("indexing_duration"))
+	{
+		return durations;
+	}
+
+	CppSQLite3Query q = executeQuery(
+		"SELECT file_path, duration, included_file_count FROM indexing_duration;");
+	while (!q.eof())
+	{
+		const std::string filePath = q.getStringField(0, "");
+		const double duration = q.getFloatField(1, 0.0);
+		const int includedFileCount = q.getIntField(2, 0);
+
+		if (!filePath.empty())
+		{
+			durations.emplace_back(
+				utility::decodeFromUtf8(filePath), static_cast<float>(duration), includedFileCount);
+		}
+
+		q.nextRow();
+	}
+
+	return durations;
+}
+
+void SqliteIndexStorage::addIndexingDurations(const std::vector<StorageIndexingDuration>& durations)
+{
+	if (durations.empty())
+	{
+		return;
+	}
+
+	CppSQLite3Statement stmt = m_database.compileStatement(
+		"INSERT OR REPLACE INTO indexing_duration(file_path, duration, included_file_count) "
+		"VALUES(?, ?, ?);");
+
+	beginTransaction();
+	for (const StorageIndexingDuration& duration: durations)
+	{
+		stmt.bind(1, utility::encodeToUtf8(duration.filePath).c_str());
+		stmt.bind(2, static_cast<double>(duration.duration));
+		stmt.bind(3, duration.includedFileCount);
+		executeStatement(stmt);
+		stmt.reset();
+	}
+	commitTransaction();
+}
+
+void SqliteIndexStorage::removeIndexingDurationsOfRemovedFiles()
+{
+	executeStatement(
+		"DELETE FROM indexing_duration WHERE file_path NOT IN (SELECT path FROM file);");
+}
+
 Id SqliteIndexStorage::addNode(const StorageNodeData& data)
 {
 	std::vector<Id> ids = addNodes({StorageNode(0, data)});
@@ -101,7 +233,9 @@ std::vector<Id> SqliteIndexStorage::addNodes(const std::vector<StorageNode>& nod
 	}
 
 	std::vector<Id> nodeIds(nodes.size(), 0);
+	std::vector<Id> elementIds;
 	std::vector<StorageNode> nodesToInsert;
+	std::vector<std::pair<int, Id>> nodeTypeUpdates;
 	for (size_t i = 0; i < nodes.size(); i++)
 	{
 		const StorageNodeData& data = nodes[i];
@@ -122,7 +256,7 @@ std::vector<Id> SqliteIndexStorage::addNodes(const std::vector<StorageNode>& nod
 				auto it = m_tempNodeTypes.find(static_cast<uint32_t>(nodeId));
 				if (it != m_tempNodeTypes.end() && it->second < data.type)
 				{
-					setNodeType(data.type, nodeId);
+					nodeTypeUpdates.emplace_back(data.type, nodeId);
 					m_tempNodeTypes[static_cast<uint32_t>(nodeId)] = data.type;
 				}
 
@@ -130,9 +264,9 @@ std::vector<Id> SqliteIndexStorage::addNodes(const std::vector<StorageNode>& nod
 			}
 			else
 			{
-				executeStatement(m_insertElementStmt);
-				const Id id = static_cast<Id>(m_database.lastRowId());
+				const Id id = generateElementId();
 
+				elementIds.push_back(id);
 				nodesToInsert.emplace_back(id, data);
 				nodeIds[i] = id;
 
@@ -149,11 +283,16 @@ std::vector<Id> SqliteIndexStorage::addNodes(const std::vector<StorageNode>& nod
 		}
 	}
 
-	if (nodesToInsert.size())
+	if (nodesToInsert.size() && m_insertElementBatchStatement.execute(elementIds, this))
 	{
 		m_insertNodeBatchStatement.execute(nodesToInsert, this);
 	}
 
+	for (const std::pair<int, Id>& update: nodeTypeUpdates)
+	{
+		setNodeType(update.first, update.second);
+	}
+
 	return nodeIds;
 }
 
@@ -204,9 +343,26 @@ bool SqliteIndexStorage::addFile(const StorageFile& data)
 
 	if (success && content)
 	{
-		m_insertFileContentStmt.bind(1, int(data.id));
-		m_insertFileContentStmt.bind(2, content->getText().c_str());
-		success = executeStatement(m_insertFileContentStmt);
+		// the content is compressed in blocks of lines, so single lines can be read without
+		// decompressing the whole file
+		const std::vector<std::string>& lines = content->getAllLines();
+		for (size_t i = 0; success && i < lines.size(); i += s_fileContentBlockLineCount)
+		{
+			std::string block;
+			for (size_t j = i; j < std::min(i + s_fileContentBlockLineCount, lines.size()); j++)
+			{
+				block += lines[j];
+			}
+			const std::string compressedBlock = utility::compress(block);
+
+			m_insertFileContentBlockStmt.bind(1, int(data.id));
+			m_insertFileContentBlockStmt.bind(2, int(i / s_fileContentBlockLineCount));
+			m_insertFileContentBlockStmt.bind(
+				3,
+				reinterpret_cast<const unsigned char*>(compressedBlock.data()),
+				int(compressedBlock.size()));
+			success = executeStatement(m_insertFileContentBlockStmt);
+		}
 	}
 
 	return success;
@@ -230,6 +386,7 @@ std::vector<Id> SqliteIndexStorage::addEdges(const std::vector<StorageEdge>& edg
 	}
 
 	std::vector<Id> edgeIds(edges.size(), 0);
+	std::vector<Id> elementIds;
 	std::vector<StorageEdge> edgesToInsert;
 	for (size_t i = 0; i < edges.size(); i++)
 	{
@@ -241,10 +398,10 @@ std::vector<Id> SqliteIndexStorage::addEdges(const std::vector<StorageEdge>& edg
 		}
 		else
 		{
-			executeStatement(m_insertElementStmt);
-			const Id id = static_cast<Id>(m_database.lastRowId());
+			const Id id = generateElementId();
 
 			edgeIds[i] = id;
+			elementIds.push_back(id);
 			edgesToInsert.emplace_back(id, data);
 
 			m_tempEdgeIndex.emplace(data, static_cast<uint32_t>(id));
@@ -253,7 +410,10 @@ std::vector<Id> SqliteIndexStorage::addEdges(const std::vector<StorageEdge>& edg
 
 	if (edgesToInsert.size())
 	{
-		m_insertEdgeBatchStatement.execute(edgesToInsert, this);
+		if (m_insertElementBatchStatement.execute(elementIds, this))
+		{
+			m_insertEdgeBatchStatement.execute(edgesToInsert, this);
+		}
 	}
 
 	return edgeIds;
@@ -265,7 +425,7 @@ Id SqliteIndexStorage::addLocalSymbol(const StorageLocalSymbolData& data)
 	return ids.size() ? ids[0] : 0;
 }
 
-std::vector<Id> SqliteIndexStorage::addLocalSymbols(const std::set<StorageLocalSymbol>& symbols)
+std::vector<Id> SqliteIndexStorage::addLocalSymbols(const std::vector<StorageLocalSymbol>& symbols)
 {
 	if (m_tempLocalSymbolIndex.empty())
 	{
@@ -280,6 +440,7 @@ std::vector<Id> SqliteIndexStorage::addLocalSymbols(const std::set<StorageLocalS
 	}
 
 	std::vector<Id> symbolIds(symbols.size(), 0);
+	std::vector<Id> elementIds;
 	std::vector<StorageLocalSymbol> symbolsToInsert;
 	auto it = symbols.begin();
 	for (size_t i = 0; i < symbols.size(); i++)
@@ -301,10 +462,10 @@ std::vector<Id> SqliteIndexStorage::addLocalSymbols(const std::set<StorageLocalS
 
 		if (!symbolIds[i])
 		{
-			executeStatement(m_insertElementStmt);
-			const Id id = static_cast<Id>(m_database.lastRowId());
+			const Id id = generateElementId();
 
 			symbolIds[i] = id;
+			elementIds.push_back(id);
 			symbolsToInsert.emplace_back(id, data);
 			if (name.second.size())
 			{
@@ -317,7 +478,10 @@ std::vector<Id> SqliteIndexStorage::addLocalSymbols(const std::set<StorageLocalS
 
 	if (symbolsToInsert.size())
 	{
-		m_insertLocalSymbolBatchStatement.execute(symbolsToInsert, this);
+		if (m_insertElementBatchStatement.execute(elementIds, this))
+		{
+			m_insertLocalSymbolBatchStatement.execute(symbolsToInsert, this);
+		}
 	}
 
 	return symbolIds;
@@ -347,9 +511,18 @@ std::vector<Id> SqliteIndexStorage::addSourceLocations(const std::vector<Storage
 		});
 	}
 
+	// occurrences are only added for locations passed here, so dropping the packed locations of
+	// these files covers the occurrences as well
+	std::set<Id> fileIds;
+	for (const StorageSourceLocation& location: locations)
+	{
+		fileIds.insert(location.fileNodeId);
+	}
+	const std::string fileIdQuery = utility::join(
+		utility::toStrings(utility::toVector(fileIds)), ',');
+
 	std::vector<Id> locationIds(locations.size(), 0);
-	std::vector<StorageSourceLocationData> locationsToInsert;
-	size_t lastRowId = executeStatementScalar("SELECT MAX(rowid) from source_location", 0);
+	std::vector<StorageSourceLocation> locationsToInsert;
 
 	for (size_t i = 0; i < locations.size(); i++)
 	{
@@ -370,18 +543,18 @@ std::vector<Id> SqliteIndexStorage::addSourceLocations(const std::vector<Storage
 		}
 		else
 		{
-			executeStatement(m_insertElementStmt);
-			Id id = lastRowId + 1 + locationsToInsert.size();
+			const Id id = generateSourceLocationId();
 
 			locationIds[i] = id;
 			index.emplace(tempLoc, static_cast<uint32_t>(id));
 
-			locationsToInsert.emplace_back(data);
+			locationsToInsert.emplace_back(id, data);
 		}
 	}
 
-	if (locationsToInsert.size())
+	if (fileIds.size())
 	{
+		dropPackedSourceLocations(fileIdQuery);
 		m_insertSourceLocationBatchStatement.execute(locationsToInsert, this);
 	}
 
@@ -410,18 +583,18 @@ bool SqliteIndexStorage::addComponentAccesses(const std::vector<StorageComponent
 
 void SqliteIndexStorage::addElementComponent(const StorageElementComponent& component)
 {
-	m_insertElementComponentStmt.bind(1, int(component.elementId));
-	m_insertElementComponentStmt.bind(2, component.type);
-	m_insertElementComponentStmt.bind(3, utility::encodeToUtf8(component.data).c_str());
-	executeStatement(m_insertElementComponentStmt);
-	m_insertElementComponentStmt.reset();
+	addElementComponents({component});
 }
 
 void SqliteIndexStorage::addElementComponents(const std::vector<StorageElementComponent>& components)
 {
 	for (const StorageElementComponent& component: components)
 	{
-		addElementComponent(component);
+		m_insertElementComponentStmt.bind(1, int(component.elementId));
+		m_insertElementComponentStmt.bind(2, component.type);
+		m_insertElementComponentStmt.bind(3, utility::encodeToUtf8(component.data).c_str());
+		executeStatement(m_insertElementComponentStmt);
+		m_insertElementComponentStmt.reset();
 	}
 }
 
@@ -444,8 +617,8 @@ StorageError SqliteIndexStorage::addError(const StorageErrorData& data)
 
 	if (id == 0)
 	{
-		executeStatement(m_insertElementStmt);
-		id = static_cast<Id>(m_database.lastRowId());
+		id = generateElementId();
+		m_insertElementBatchStatement.execute({id}, this);
 
 		m_insertErrorStmt.bind(1, int(id));
 		m_insertErrorStmt.bind(2, utility::encodeToUtf8(sanitizedMessage).c_str());
@@ -453,10 +626,9 @@ StorageError SqliteIndexStorage::addError(const StorageErrorData& data)
 		m_insertErrorStmt.bind(4, data.indexed);
 		m_insertErrorStmt.bind(5, utility::encodeToUtf8(data.translationUnit).c_str());
 
-		const bool success = executeStatement(m_insertErrorStmt);
-		if (success)
+		if (!executeStatement(m_insertErrorStmt))
 		{
-			id = static_cast<Id>(m_database.lastRowId());
+			id = 0;
 		}
 	}
 
@@ -472,12 +644,21 @@ void SqliteIndexStorage::removeElement(Id id)
 
 void SqliteIndexStorage::removeElements(const std::vector<Id>& ids)
 {
+	dropPackedSourceLocations(
+		"SELECT source_location.file_node_id FROM occurrence INNER JOIN source_location ON "
+		"(occurrence.source_location_id = source_location.id) WHERE occurrence.element_id IN (" +
+		utility::join(utility::toStrings(ids), ',') + ")");
+
 	executeStatement(
 		"DELETE FROM element WHERE id IN (" + utility::join(utility::toStrings(ids), ',') + ");");
 }
 
 void SqliteIndexStorage::removeOccurrence(const StorageOccurrence& occurrence)
 {
+	dropPackedSourceLocations(
+		"SELECT file_node_id FROM source_location WHERE id = " +
+		std::to_string(occurrence.sourceLocationId));
+
 	executeStatement(
 		"DELETE FROM occurrence WHERE element_id = " + std::to_string(occurrence.elementId) +
 		" AND source_location_id = " + std::to_string(occurrence.sourceLocationId) + ";");
@@ -542,6 +723,15 @@ void SqliteIndexStorage::removeElementsWithLocationInFiles(
 		updateStatusCallback(4);
 	}
 
+	// deleting the edges below also deletes their occurrences in other files
+	dropPackedSourceLocations(
+		"SELECT source_location.file_node_id FROM occurrence INNER JOIN source_location ON "
+		"(occurrence.source_location_id = source_location.id) WHERE occurrence.element_id IN ("
+		"	SELECT id FROM edge WHERE id IN (SELECT id FROM element_id_to_clear) "
+		"	UNION SELECT id FROM edge WHERE source_node_id IN (SELECT id FROM element_id_to_clear)"
+		")");
+	dropPackedSourceLocations(utility::join(utility::toStrings(fileIds), ','));
+
 	// delete all edges in element_id_to_clear
 	executeStatement(
 		"DELETE FROM element WHERE element.id IN "
@@ -644,6 +834,29 @@ void SqliteIndexStorage::removeAllErrors()
 	executeStatement("DELETE FROM error;");
 }
 
+std::vector<Id> SqliteIndexStorage::getElementIdsWithLocationInFiles(
+	const std::vector<Id>& fileIds) const
+{
+	std::vector<Id> elementIds;
+
+	CppSQLite3Query q = executeQuery(
+		"SELECT DISTINCT occurrence.element_id "
+		"FROM occurrence "
+		"INNER JOIN source_location ON ("
+		"	occurrence.source_location_id = source_location.id"
+		") "
+		"WHERE source_location.file_node_id IN (" +
+		utility::join(utility::toStrings(fileIds), ',') + ");");
+
+	while (!q.eof())
+	{
+		elementIds.push_back(q.getIntField(0, 0));
+		q.nextRow();
+	}
+
+	return elementIds;
+}
+
 bool SqliteIndexStorage::isEdge(Id elementId) const
 {
 	int count = executeStatementScalar(
@@ -667,15 +880,7 @@ bool SqliteIndexStorage::isFile(Id elementId) const
 
 StorageEdge SqliteIndexStorage::getEdgeById(Id edgeId) const
 {
-	std::vector<StorageEdge> candidates = doGetAll<StorageEdge>(
-		"WHERE id = " + std::to_string(edgeId));
-
-	if (candidates.size() > 0)
-	{
-		return candidates[0];
-	}
-
-	return StorageEdge();
+	return getFirstById<StorageEdge>(edgeId);
 }
 
 StorageEdge SqliteIndexStorage::getEdgeBySourceTargetType(Id sourceId, Id targetId, int type) const
@@ -694,24 +899,22 @@ StorageEdge SqliteIndexStorage::getEdgeBySourceTargetType(Id sourceId, Id target
 
 std::vector<StorageEdge> SqliteIndexStorage::getEdgesBySourceId(Id sourceId) const
 {
-	return doGetAll<StorageEdge>("WHERE source_node_id == " + std::to_string(sourceId));
+	return doGetAllByColumnIds<StorageEdge>("source_node_id", {sourceId});
 }
 
 std::vector<StorageEdge> SqliteIndexStorage::getEdgesBySourceIds(const std::vector<Id>& sourceIds) const
 {
-	return doGetAll<StorageEdge>(
-		"WHERE source_node_id IN (" + utility::join(utility::toStrings(sourceIds), ',') + ")");
+	return doGetAllByColumnIds<StorageEdge>("source_node_id", sourceIds);
 }
 
 std::vector<StorageEdge> SqliteIndexStorage::getEdgesByTargetId(Id targetId) const
 {
-	return doGetAll<StorageEdge>("WHERE target_node_id == " + std::to_string(targetId));
+	return doGetAllByColumnIds<StorageEdge>("target_node_id", {targetId});
 }
 
 std::vector<StorageEdge> SqliteIndexStorage::getEdgesByTargetIds(const std::vector<Id>& targetIds) const
 {
-	return doGetAll<StorageEdge>(
-		"WHERE target_node_id IN (" + utility::join(utility::toStrings(targetIds), ',') + ")");
+	return doGetAllByColumnIds<StorageEdge>("target_node_id", targetIds);
 }
 
 std::vector<StorageEdge> SqliteIndexStorage::getEdgesBySourceOrTargetId(Id id) const
@@ -736,11 +939,8 @@ std::vector<StorageEdge> SqliteIndexStorage::getEdgesBySourceType(Id sourceId, i
 std::vector<StorageEdge> SqliteIndexStorage::getEdgesBySourcesType(
 	const std::vector<Id>& sourceIds, int type) const
 {
-	return doGetAll<StorageEdge>(
-		"WHERE source_node_id IN (" + utility::join(utility::toStrings(sourceIds), ',') +
-		")"
-		" AND type == " +
-		std::to_string(type));
+	return doGetAllByColumnIds<StorageEdge>(
+		"source_node_id", sourceIds, "type == " + std::to_string(type));
 }
 
 std::vector<StorageEdge> SqliteIndexStorage::getEdgesByTargetType(Id targetId, int type) const
@@ -753,28 +953,18 @@ std::vector<StorageEdge> SqliteIndexStorage::getEdgesByTargetType(Id targetId, i
 std::vector<StorageEdge> SqliteIndexStorage::getEdgesByTargetsType(
 	const std::vector<Id>& targetIds, int type) const
 {
-	return doGetAll<StorageEdge>(
-		"WHERE target_node_id IN (" + utility::join(utility::toStrings(targetIds), ',') +
-		")"
-		" AND type == " +
-		std::to_string(type));
+	return doGetAllByColumnIds<StorageEdge>(
+		"target_node_id", targetIds, "type == " + std::to_string(type));
 }
 
 StorageNode SqliteIndexStorage::getNodeById(Id id) const
 {
-	std::vector<StorageNode> candidates = doGetAll<StorageNode>("WHERE id = " + std::to_string(id));
-
-	if (candidates.size() > 0)
-	{
-		return candidates[0];
-	}
-
-	return StorageNode();
+	return getFirstById<StorageNode>(id);
 }
 
 StorageNode SqliteIndexStorage::getNodeBySerializedName(const std::wstring& serializedName) const
 {
-	CppSQLite3Statement stmt = m_database.compileStatement(
+	CppSQLite3Statement stmt = getReadDatabase().compileStatement(
 		"SELECT id, type, serialized_name FROM node WHERE serialized_name == ? LIMIT 1;");
 
 	stmt.bind(1, utility::encodeToUtf8(serializedName).c_str());
@@ -850,38 +1040,69 @@ std::vector<StorageFile> SqliteIndexStorage::getFilesByPaths(const std::vector<F
 
 std::shared_ptr<TextAccess> SqliteIndexStorage::getFileContentById(Id fileId) const
 {
-	CppSQLite3Query q = executeQuery(
-		"SELECT content FROM filecontent WHERE id = '" + std::to_string(fileId) + "';");
-	if (!q.eof())
+	return TextAccess::createFromString(getFileContentTextById(fileId));
+}
+
+std::shared_ptr<TextAccess> SqliteIndexStorage::getFileContentByPath(const std::wstring& filePath) const
+{
+	return getFileContentById(getFileByPath(filePath).id);
+}
+
+std::string SqliteIndexStorage::getFileContentTextById(Id fileId) const
+{
+	std::string text = getFileContentBlocks(fileId, 0, std::numeric_limits<int>::max());
+	if (text.empty())
 	{
-		return TextAccess::createFromString(q.getStringField(0, ""));
+		text = getPlainFileContent(fileId);
 	}
-
-	return TextAccess::createFromString("");
+	return text;
 }
 
-std::shared_ptr<TextAccess> SqliteIndexStorage::getFileContentByPath(const std::wstring& filePath) const
+std::vector<std::string> SqliteIndexStorage::getFileContentLinesById(
+	Id fileId, size_t firstLineNumber, size_t lastLineNumber) const
 {
-	try
+	if (firstLineNumber < 1 || firstLineNumber > lastLineNumber)
 	{
-		CppSQLite3Query q = executeQuery(
-			"SELECT filecontent.content "
-			"FROM filecontent "
-			"INNER JOIN file ON filecontent.id = file.id "
-			"WHERE file.path = '" +
-			utility::encodeToUtf8(filePath) + "';");
+		return {};
+	}
 
-		if (!q.eof())
-		{
-			return TextAccess::createFromString(q.getStringField(0, ""));
-		}
+	const size_t firstBlockIndex = (firstLineNumber - 1) / s_fileContentBlockLineCount;
+	std::string text = getFileContentBlocks(
+		fileId, firstBlockIndex, (lastLineNumber - 1) / s_fileContentBlockLineCount);
+	size_t lineOffset = firstBlockIndex * s_fileContentBlockLineCount;
+
+	if (text.empty() && !hasFileContentById(fileId))
+	{
+		text = getPlainFileContent(fileId);
+		lineOffset = 0;
 	}
-	catch (CppSQLite3Exception& e)
+
+	return TextAccess::createFromString(text)->getLines(
+		static_cast<unsigned int>(firstLineNumber - lineOffset),
+		static_cast<unsigned int>(lastLineNumber - lineOffset));
+}
+
+size_t SqliteIndexStorage::getFileContentLineCountById(Id fileId) const
+{
+	const std::string fileIdString = std::to_string(fileId);
+	if (executeStatementScalar(
+			"SELECT EXISTS(SELECT * FROM filecontent_block WHERE file_id = " + fileIdString + ");",
+			0))
 	{
-		LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+		return executeStatementScalar(
+			"SELECT line_count FROM file WHERE id = " + fileIdString + ";", 0);
 	}
+	return TextAccess::createFromString(getPlainFileContent(fileId))->getLineCount();
+}
 
-	return TextAccess::createFromString("");
+bool SqliteIndexStorage::hasFileContentById(Id fileId) const
+{
+	const std::string fileIdString = std::to_string(fileId);
+	return executeStatementScalar(
+		"SELECT EXISTS(SELECT * FROM filecontent_block WHERE file_id = " + fileIdString +
+			") OR EXISTS(SELECT * FROM filecontent WHERE id = " + fileIdString +
+			" AND content != '');",
+		0);
 }
 
 void SqliteIndexStorage::setFileIndexed(Id fileId, bool indexed)
@@ -912,8 +1133,113 @@ void SqliteIndexStorage::setNodeType(int type, Id nodeId)
 		" WHERE id == " + std::to_string(nodeId) + ";");
 }
 
+void SqliteIndexStorage::packSourceLocations()
+{
+	// reading the rows of files with few source locations is fast enough, so they are not packed
+	// to keep the database small
+	std::vector<std::pair<Id, std::string>> files;
+	{
+		CppSQLite3Query q = executeQuery(
+			"SELECT id, modification_time FROM file WHERE id NOT IN "
+			"(SELECT file_node_id FROM source_location_file) AND "
+			"(SELECT count(*) FROM source_location WHERE file_node_id = file.id) >= " +
+			std::to_string(s_packedSourceLocationMinCount) + ";");
+		while (!q.eof())
+		{
+			files.emplace_back(q.getIntField(0, 0), q.getStringField(1, ""));
+			q.nextRow();
+		}
+	}
+
+	beginTransaction();
+	for (const std::pair<Id, std::string>& file: files)
+	{
+		const Id fileId = file.first;
+		std::vector<PackedSourceLocationFile::Location> locations;
+		try
+		{
+			CppSQLite3Query q = executeQuery(
+				"SELECT source_location.id, source_location.start_line, "
+				"source_location.start_column, source_location.end_line, "
+				"source_location.end_column, source_location.type, occurrence.element_id "
+				"FROM source_location LEFT JOIN occurrence "
+				"ON (occurrence.source_location_id = source_location.id) "
+				"WHERE source_location.file_node_id = " +
+				std::to_string(fileId) + " ORDER BY source_location.id;");
+
+			while (!q.eof())
+			{
+				const Id id = q.getIntField(0, 0);
+				if (locations.empty() || locations.back().id != id)
+				{
+					PackedSourceLocationFile::Location location;
+					location.id = id;
+					location.startLine = q.getIntField(1, -1);
+					location.startCol = q.getIntField(2, -1);
+					location.endLine = q.getIntField(3, -1);
+					location.endCol = q.getIntField(4, -1);
+					location.type = q.getIntField(5, -1);
+					locations.push_back(location);
+				}
+
+				const Id elementId = q.getIntField(6, 0);
+				if (elementId != 0)
+				{
+					locations.back().elementIds.push_back(elementId);
+				}
+
+				q.nextRow();
+			}
+		}
+		catch (CppSQLite3Exception& e)
+		{
+			LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+			continue;
+		}
+
+		PackedSourceLocationStamp stamp;
+		stamp.modificationTime = file.second;
+		stamp.locationCount = locations.size();
+		for (const PackedSourceLocationFile::Location& location: locations)
+		{
+			stamp.occurrenceCount += location.elementIds.size();
+			stamp.maxLocationId = std::max(stamp.maxLocationId, location.id);
+		}
+
+		const std::string data = PackedSourceLocationFile::pack(std::move(locations));
+		m_insertPackedSourceLocationsStmt.bind(1, int(fileId));
+		m_insertPackedSourceLocationsStmt.bind(
+			2, reinterpret_cast<const unsigned char*>(data.data()), int(data.size()));
+		m_insertPackedSourceLocationsStmt.bind(3, stamp.modificationTime.c_str());
+		m_insertPackedSourceLocationsStmt.bind(4, int(stamp.locationCount));
+		m_insertPackedSourceLocationsStmt.bind(5, int(stamp.occurrenceCount));
+		m_insertPackedSourceLocationsStmt.bind(6, int(stamp.maxLocationId));
+		executeStatement(m_insertPackedSourceLocationsStmt);
+	}
+	commitTransaction();
+}
+
 std::shared_ptr<SourceLocationFile> SqliteIndexStorage::getSourceLocationsForFile(
-	const FilePath& filePath, const std::string& query) const
+	const FilePath& filePath) const
+{
+	return doGetSourceLocationsForFile(filePath, 0, std::numeric_limits<size_t>::max(), -1);
+}
+
+std::shared_ptr<SourceLocationFile> SqliteIndexStorage::getSourceLocationsForLinesInFile(
+	const FilePath& filePath, size_t startLine, size_t endLine) const
+{
+	return doGetSourceLocationsForFile(filePath, startLine, endLine, -1);
+}
+
+std::shared_ptr<SourceLocationFile> SqliteIndexStorage::getSourceLocationsOfTypeInFile(
+	const FilePath& filePath, LocationType type) const
+{
+	return doGetSourceLocationsForFile(
+		filePath, 0, std::numeric_limits<size_t>::max(), locationTypeToInt(type));
+}
+
+std::shared_ptr<SourceLocationFile> SqliteIndexStorage::doGetSourceLocationsForFile(
+	const FilePath& filePath, size_t startLine, size_t endLine, int type) const
 {
 	std::shared_ptr<SourceLocationFile> ret = std::make_shared<SourceLocationFile>(
 		filePath, L"", true, false, false);
@@ -928,8 +1254,62 @@ std::shared_ptr<SourceLocationFile> SqliteIndexStorage::getSourceLocationsForFil
 	ret->setIsComplete(file.complete);
 	ret->setIsIndexed(file.indexed);
 
-	std::vector<StorageSourceLocation> sourceLocations = doGetAll<StorageSourceLocation>(
-		"WHERE file_node_id == " + std::to_string(file.id) + " " + query);
+	try
+	{
+		CppSQLite3Query q = executeQuery(
+			"SELECT data, modification_time, location_count, occurrence_count, max_location_id "
+			"FROM source_location_file WHERE file_node_id = " +
+			std::to_string(file.id) + ";");
+		if (!q.eof() && isPackedSourceLocationStampCurrent(q, file))
+		{
+			int length = 0;
+			const char* data = reinterpret_cast<const char*>(q.getBlobField(0, length));
+
+			std::vector<PackedSourceLocationFile::Location> locations;
+			if (PackedSourceLocationFile::unpack(
+					std::string(data, length),
+					startLine,
+					endLine,
+					[&](const PackedSourceLocationFile::Location& location) {
+						if (type < 0 || location.type == type)
+						{
+							locations.push_back(location);
+						}
+					}))
+			{
+				for (const PackedSourceLocationFile::Location& location: locations)
+				{
+					ret->addSourceLocation(
+						intToLocationType(location.type),
+						location.id,
+						location.elementIds,
+						location.startLine,
+						location.startCol,
+						location.endLine,
+						location.endCol);
+				}
+				return ret;
+			}
+			LOG_ERROR(L"Packed source locations of file " + filePath.wstr() + L" are corrupted.");
+		}
+	}
+	catch (CppSQLite3Exception& e)
+	{
+		LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+	}
+
+	std::string query = "WHERE file_node_id == " + std::to_string(file.id);
+	if (startLine > 0 || endLine < std::numeric_limits<size_t>::max())
+	{
+		query += " AND start_line <= " + std::to_string(endLine) +
+			" AND end_line >= " + std::to_string(startLine);
+	}
+	if (type >= 0)
+	{
+		query += " AND type == " + std::to_string(type);
+	}
+
+	std::vector<StorageSourceLocation> sourceLocations = doGetAll<StorageSourceLocation>(query);
 
 	std::vector<Id> sourceLocationIds;
 	sourceLocationIds.reserve(sourceLocations.size());
@@ -961,22 +1341,6 @@ std::shared_ptr<SourceLocationFile> SqliteIndexStorage::getSourceLocationsForFil
 	return ret;
 }
 
-std::shared_ptr<SourceLocationFile> SqliteIndexStorage::getSourceLocationsForLinesInFile(
-	const FilePath& filePath, size_t startLine, size_t endLine) const
-{
-	return getSourceLocationsForFile(
-		filePath,
-		"AND start_line <= " + std::to_string(endLine) +
-			" AND end_line >= " + std::to_string(startLine));
-}
-
-std::shared_ptr<SourceLocationFile> SqliteIndexStorage::getSourceLocationsOfTypeInFile(
-	const FilePath& filePath, LocationType type) const
-{
-	return getSourceLocationsForFile(
-		filePath, "AND type == " + std::to_string(locationTypeToInt(type)));
-}
-
 std::shared_ptr<SourceLocationCollection> SqliteIndexStorage::getSourceLocationsForElementIds(
 	const std::vector<Id>& elementIds) const
 {
@@ -1037,15 +1401,13 @@ std::vector<StorageOccurrence> SqliteIndexStorage::getOccurrencesForLocationId(I
 std::vector<StorageOccurrence> SqliteIndexStorage::getOccurrencesForLocationIds(
 	const std::vector<Id>& locationIds) const
 {
-	return doGetAll<StorageOccurrence>(
-		"WHERE source_location_id IN (" + utility::join(utility::toStrings(locationIds), ',') + ")");
+	return doGetAllByColumnIds<StorageOccurrence>("source_location_id", locationIds);
 }
 
 std::vector<StorageOccurrence> SqliteIndexStorage::getOccurrencesForElementIds(
 	const std::vector<Id>& elementIds) const
 {
-	return doGetAll<StorageOccurrence>(
-		"WHERE element_id IN (" + utility::join(utility::toStrings(elementIds), ',') + ")");
+	return doGetAllByColumnIds<StorageOccurrence>("element_id", elementIds);
 }
 
 StorageComponentAccess SqliteIndexStorage::getComponentAccessByNodeId(Id nodeId) const
@@ -1056,15 +1418,13 @@ StorageComponentAccess SqliteIndexStorage::getComponentAccessByNodeId(Id nodeId)
 std::vector<StorageComponentAccess> SqliteIndexStorage::getComponentAccessesByNodeIds(
 	const std::vector<Id>& nodeIds) const
 {
-	return doGetAll<StorageComponentAccess>(
-		"WHERE node_id IN (" + utility::join(utility::toStrings(nodeIds), ',') + ")");
+	return doGetAllByColumnIds<StorageComponentAccess>("node_id", nodeIds);
 }
 
 std::vector<StorageElementComponent> SqliteIndexStorage::getElementComponentsByElementIds(
 	const std::vector<Id>& elementIds) const
 {
-	return doGetAll<StorageElementComponent>(
-		"WHERE element_id IN (" + utility::join(utility::toStrings(elementIds), ',') + ")");
+	return doGetAllByColumnIds<StorageElementComponent>("element_id", elementIds);
 }
 
 std::vector<ErrorInfo> SqliteIndexStorage::getAllErrorInfos() const
@@ -1190,20 +1550,21 @@ std::vector<std::pair<int, SqliteDatabaseIndex>> SqliteIndexStorage::getIndices(
 		STORAGE_MODE_CLEAR,
 		SqliteDatabaseIndex(
 			"element_component_foreign_key_index", "element_component(element_id)")));
+	// duplicates of indices above that are only listed to remove them from older databases
 	indices.push_back(std::make_pair(
-		STORAGE_MODE_CLEAR,
+		0,
 		SqliteDatabaseIndex("edge_source_foreign_key_index", "edge(source_node_id)")));
 	indices.push_back(std::make_pair(
-		STORAGE_MODE_CLEAR,
+		0,
 		SqliteDatabaseIndex("edge_target_foreign_key_index", "edge(target_node_id)")));
 	indices.push_back(std::make_pair(
-		STORAGE_MODE_CLEAR,
+		0,
 		SqliteDatabaseIndex("source_location_foreign_key_index", "source_location(file_node_id)")));
 	indices.push_back(std::make_pair(
-		STORAGE_MODE_CLEAR,
+		0,
 		SqliteDatabaseIndex("occurrence_element_foreign_key_index", "occurrence(element_id)")));
 	indices.push_back(std::make_pair(
-		STORAGE_MODE_CLEAR,
+		0,
 		SqliteDatabaseIndex(
 			"occurrence_source_location_foreign_key_index", "occurrence(source_location_id)")));
 
@@ -1212,13 +1573,20 @@ std::vector<std::pair<int, SqliteDatabaseIndex>> SqliteIndexStorage::getIndices(
 
 void SqliteIndexStorage::clearTables()
 {
+	m_nextElementId = 0;
+	m_nextSourceLocationId = 0;
+
 	try
 	{
 		m_database.execDML("DROP TABLE IF EXISTS main.error;");
 		m_database.execDML("DROP TABLE IF EXISTS main.component_access;");
+		// left by older versions
+		m_database.execDML("DROP TABLE IF EXISTS main.file_element;");
 		m_database.execDML("DROP TABLE IF EXISTS main.occurrence;");
+		m_database.execDML("DROP TABLE IF EXISTS main.source_location_file;");
 		m_database.execDML("DROP TABLE IF EXISTS main.source_location;");
 		m_database.execDML("DROP TABLE IF EXISTS main.local_symbol;");
+		m_database.execDML("DROP TABLE IF EXISTS main.filecontent_block;");
 		m_database.execDML("DROP TABLE IF EXISTS main.filecontent;");
 		m_database.execDML("DROP TABLE IF EXISTS main.file;");
 		m_database.execDML("DROP TABLE IF EXISTS main.symbol;");
@@ -1227,6 +1595,7 @@ void SqliteIndexStorage::clearTables()
 		m_database.execDML("DROP TABLE IF EXISTS main.element_component;");
 		m_database.execDML("DROP TABLE IF EXISTS main.element;");
 		m_database.execDML("DROP TABLE IF EXISTS main.meta;");
+		m_database.execDML("DROP TABLE IF EXISTS main.indexing_duration;");
 	}
 	catch (CppSQLite3Exception& e)
 	{
@@ -1300,6 +1669,19 @@ void SqliteIndexStorage::setupTables()
 			"ON DELETE CASCADE "
 			"ON UPDATE CASCADE);");
 
+		// file contents are compressed in blocks of a fixed number of lines, so the block holding
+		// a line follows from its line number. the filecontent table above is still read for
+		// contents stored as plain text.
+		m_database.execDML(
+			"CREATE TABLE IF NOT EXISTS filecontent_block("
+			"file_id INTEGER NOT NULL, "
+			"block_index INTEGER NOT NULL, "
+			"content BLOB, "
+			"PRIMARY KEY(file_id, block_index), "
+			"FOREIGN KEY(file_id) REFERENCES file(id) "
+			"ON DELETE CASCADE "
+			"ON UPDATE CASCADE);");
+
 		m_database.execDML(
 			"CREATE TABLE IF NOT EXISTS local_symbol("
 			"id INTEGER NOT NULL, "
@@ -1319,6 +1701,19 @@ void SqliteIndexStorage::setupTables()
 			"PRIMARY KEY(id), "
 			"FOREIGN KEY(file_node_id) REFERENCES node(id) ON DELETE CASCADE);");
 
+		// optional copy of the source locations and occurrences of a file packed into one blob,
+		// the other columns describe the rows it was packed from to detect writes that bypassed it
+		m_database.execDML(
+			"CREATE TABLE IF NOT EXISTS source_location_file("
+			"file_node_id INTEGER NOT NULL, "
+			"data BLOB, "
+			"modification_time TEXT, "
+			"location_count INTEGER, "
+			"occurrence_count INTEGER, "
+			"max_location_id INTEGER, "
+			"PRIMARY KEY(file_node_id), "
+			"FOREIGN KEY(file_node_id) REFERENCES node(id) ON DELETE CASCADE);");
+
 		m_database.execDML(
 			"CREATE TABLE IF NOT EXISTS occurrence("
 			"element_id INTEGER NOT NULL, "
@@ -1343,6 +1738,13 @@ void SqliteIndexStorage::setupTables()
 			"translation_unit TEXT, "
 			"PRIMARY KEY(id), "
 			"FOREIGN KEY(id) REFERENCES element(id) ON DELETE CASCADE);");
+
+		m_database.execDML(
+			"CREATE TABLE IF NOT EXISTS indexing_duration("
+			"file_path TEXT NOT NULL, "
+			"duration REAL NOT NULL, "
+			"included_file_count INTEGER NOT NULL, "
+			"PRIMARY KEY(file_path));");
 	}
 	catch (CppSQLite3Exception& e)
 	{
@@ -1356,6 +1758,13 @@ void SqliteIndexStorage::setupPrecompiledStatements()
 {
 	try
 	{
+		m_insertElementBatchStatement.compile(
+			"INSERT INTO element(id) VALUES",
+			1,
+			[](CppSQLite3Statement& stmt, const Id& id, size_t index) {
+				stmt.bind(int(index) + 1, int(id));
+			},
+			m_database);
 		m_insertNodeBatchStatement.compile(
 			"INSERT INTO node(id, type, serialized_name) VALUES",
 			3,
@@ -1392,16 +1801,17 @@ void SqliteIndexStorage::setupPrecompiledStatements()
 			},
 			m_database);
 		m_insertSourceLocationBatchStatement.compile(
-			"INSERT INTO source_location(file_node_id, start_line, start_column, end_line, "
+			"INSERT INTO source_location(id, file_node_id, start_line, start_column, end_line, "
 			"end_column, type) VALUES",
-			6,
-			[](CppSQLite3Statement& stmt, const StorageSourceLocationData& location, size_t index) {
-				stmt.bind(int(index) * 6 + 1, int(location.fileNodeId));
-				stmt.bind(int(index) * 6 + 2, int(location.startLine));
-				stmt.bind(int(index) * 6 + 3, int(location.startCol));
-				stmt.bind(int(index) * 6 + 4, int(location.endLine));
-				stmt.bind(int(index) * 6 + 5, int(location.endCol));
-				stmt.bind(int(index) * 6 + 6, int(location.type));
+			7,
+			[](CppSQLite3Statement& stmt, const StorageSourceLocation& location, size_t index) {
+				stmt.bind(int(index) * 7 + 1, int(location.id));
+				stmt.bind(int(index) * 7 + 2, int(location.fileNodeId));
+				stmt.bind(int(index) * 7 + 3, int(location.startLine));
+				stmt.bind(int(index) * 7 + 4, int(location.startCol));
+				stmt.bind(int(index) * 7 + 5, int(location.endLine));
+				stmt.bind(int(index) * 7 + 6, int(location.endCol));
+				stmt.bind(int(index) * 7 + 7, int(location.type));
 			},
 			m_database);
 		m_insertOccurenceBatchStatement.compile(
@@ -1421,14 +1831,16 @@ void SqliteIndexStorage::setupPrecompiledStatements()
 			},
 			m_database);
 
-		m_insertElementStmt = m_database.compileStatement("INSERT INTO element(id) VALUES(NULL);");
 		m_insertElementComponentStmt = m_database.compileStatement(
 			"INSERT INTO element_component(id, element_id, type, data) VALUES(NULL, ?, ?, ?);");
 		m_insertFileStmt = m_database.compileStatement(
 			"INSERT INTO file(id, path, language, modification_time, indexed, complete, "
 			"line_count) VALUES(?, ?, ?, ?, ?, ?, ?);");
-		m_insertFileContentStmt = m_database.compileStatement(
-			"INSERT INTO filecontent(id, content) VALUES(?, ?);");
+		m_insertFileContentBlockStmt = m_database.compileStatement(
+			"INSERT INTO filecontent_block(file_id, block_index, content) VALUES(?, ?, ?);");
+		m_insertPackedSourceLocationsStmt = m_database.compileStatement(
+			"INSERT OR REPLACE INTO source_location_file(file_node_id, data, modification_time, "
+			"location_count, occurrence_count, max_location_id) VALUES(?, ?, ?, ?, ?, ?);");
 		m_checkErrorExistsStmt = m_database.compileStatement(
 			"SELECT id FROM error WHERE "
 			"message = ? AND "
@@ -1448,12 +1860,274 @@ void SqliteIndexStorage::setupPrecompiledStatements()
 	}
 }
 
-template <>
-void SqliteIndexStorage::forEach<StorageEdge>(
-	const std::string& query, std::function<void(StorageEdge&&)> func) const
+void SqliteIndexStorage::prepareWriteTransaction()
+{
+	// other connections may have added rows since the maximum ids were read
+	m_nextElementId = 0;
+	m_nextSourceLocationId = 0;
+}
+
+std::string SqliteIndexStorage::getFileContentBlocks(
+	Id fileId, size_t firstBlockIndex, size_t lastBlockIndex) const
+{
+	std::string text;
+	try
+	{
+		CppSQLite3Query q = executeQuery(
+			"SELECT content FROM filecontent_block WHERE file_id = " + std::to_string(fileId) +
+			" AND block_index BETWEEN " + std::to_string(firstBlockIndex) + " AND " +
+			std::to_string(lastBlockIndex) + " ORDER BY block_index;");
+
+		while (!q.eof())
+		{
+			int length = 0;
+			const char* data = reinterpret_cast<const char*>(q.getBlobField(0, length));
+
+			std::string block;
+			if (!utility::decompress(std::string(data, length), &block))
+			{
+				LOG_ERROR("Content of file " + std::to_string(fileId) + " is corrupted.");
+				return "";
+			}
+			text += block;
+
+			q.nextRow();
+		}
+	}
+	catch (CppSQLite3Exception& e)
+	{
+		LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+	}
+	return text;
+}
+
+std::string SqliteIndexStorage::getPlainFileContent(Id fileId) const
 {
+	// content written as text by other tools that use the same database format
+	try
+	{
+		CppSQLite3Query q = executeQuery(
+			"SELECT content FROM filecontent WHERE id = " + std::to_string(fileId) + ";");
+		if (!q.eof())
+		{
+			return q.getStringField(0, "");
+		}
+	}
+	catch (CppSQLite3Exception& e)
+	{
+		LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+	}
+	return "";
+}
+
+bool SqliteIndexStorage::isPackedSourceLocationStampCurrent(
+	CppSQLite3Query& packedQuery, const StorageFile& file) const
+{
+	PackedSourceLocationStamp stamp;
+	stamp.modificationTime = packedQuery.getStringField(1, "");
+	stamp.locationCount = packedQuery.getIntField(2, 0);
+	stamp.occurrenceCount = packedQuery.getIntField(3, 0);
+	stamp.maxLocationId = packedQuery.getIntField(4, 0);
+
+	if (stamp.modificationTime != file.modificationTime)
+	{
+		return false;
+	}
+
+	// only reads the indices on source locations and occurrences, which is cheaper than reading
+	// the rows themselves
 	CppSQLite3Query q = executeQuery(
-		"SELECT id, type, source_node_id, target_node_id FROM edge " + query + ";");
+		"SELECT count(DISTINCT source_location.id), count(occurrence.source_location_id), "
+		"max(source_location.id) FROM source_location LEFT JOIN occurrence "
+		"ON (occurrence.source_location_id = source_location.id) "
+		"WHERE source_location.file_node_id = " +
+		std::to_string(file.id) + ";");
+
+	if (q.eof() || size_t(q.getIntField(0, 0)) != stamp.locationCount ||
+		size_t(q.getIntField(1, 0)) != stamp.occurrenceCount ||
+		Id(q.getIntField(2, 0)) != stamp.maxLocationId)
+	{
+		LOG_INFO(L"Packed source locations of file " + file.filePath + L" are outdated.");
+		return false;
+	}
+	return true;
+}
+
+void SqliteIndexStorage::dropPackedSourceLocations(const std::string& fileIdQuery)
+{
+	// looking up the files can be expensive, so it is skipped while no file is packed
+	if (executeStatementScalar("SELECT EXISTS(SELECT * FROM source_location_file);", 0))
+	{
+		executeStatement(
+			"DELETE FROM source_location_file WHERE file_node_id IN (" + fileIdQuery + ");");
+	}
+}
+
+Id SqliteIndexStorage::generateElementId()
+{
+	if (m_nextElementId == 0)
+	{
+		m_nextElementId = executeStatementScalar("SELECT MAX(id) FROM element;", 0) + 1;
+	}
+	return m_nextElementId++;
+}
+
+Id SqliteIndexStorage::generateSourceLocationId()
+{
+	if (m_nextSourceLocationId == 0)
+	{
+		m_nextSourceLocationId =
+			executeStatementScalar("SELECT MAX(id) FROM source_location;", 0) + 1;
+	}
+	return m_nextSourceLocationId++;
+}
+
+CppSQLite3Query SqliteIndexStorage::executeLookup(
+	const std::string& select,
+	const std::string& column,
+	const std::string& condition,
+	const std::vector<Id>& ids,
+	size_t slot) const
+{
+	// small id lists are bound to "IN (?, ...)" statements of a few fixed sizes, the remaining
+	// parameters are padded with the last id. larger lists are written to a temporary table, so
+	// a lookup on a column without index still scans the table only once.
+	const size_t batchSizes[] = {1, 8, 64, 512};
+
+	size_t batchSize = 0;
+	for (const size_t size: batchSizes)
+	{
+		if (ids.size() <= size)
+		{
+			batchSize = size;
+			break;
+		}
+	}
+
+	std::string statement = select + " WHERE " + column + " IN (";
+	if (batchSize)
+	{
+		statement += utility::join(std::vector<std::string>(batchSize, "?"), ',');
+	}
+	else
+	{
+		const std::string tableName = "lookup_id_" + std::to_string(slot);
+		if (!fillLookupTable(tableName, ids, slot))
+		{
+			return CppSQLite3Query();
+		}
+		statement += "SELECT id FROM temp." + tableName;
+	}
+	statement += ")";
+
+	if (!condition.empty())
+	{
+		statement += " AND " + condition;
+	}
+	statement += ";";
+
+	try
+	{
+		CppSQLite3Statement& stmt = getLookupStatement(statement, slot);
+		for (size_t i = 0; i < batchSize; i++)
+		{
+			stmt.bind(int(i) + 1, int(ids[std::min(i, ids.size() - 1)]));
+		}
+
+		return executeQuery(stmt);
+	}
+	catch (CppSQLite3Exception& e)
+	{
+		LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+	}
+
+	return CppSQLite3Query();
+}
+
+bool SqliteIndexStorage::fillLookupTable(
+	const std::string& tableName, const std::vector<Id>& ids, size_t slot) const
+{
+	const size_t batchSize = 512;
+
+	try
+	{
+		CppSQLite3DB& database = getReadDatabase();
+		database.execDML(
+			("CREATE TEMP TABLE IF NOT EXISTS " + tableName + "(id INTEGER PRIMARY KEY);").c_str());
+		database.execDML(("DELETE FROM temp." + tableName + ";").c_str());
+
+		CppSQLite3Statement& stmt = getLookupStatement(
+			"INSERT OR IGNORE INTO temp." + tableName + "(id) VALUES " +
+				utility::join(std::vector<std::string>(batchSize, "(?)"), ',') + ";",
+			slot);
+
+		for (size_t i = 0; i < ids.size(); i += batchSize)
+		{
+			for (size_t j = 0; j < batchSize; j++)
+			{
+				stmt.bind(int(j) + 1, int(ids[std::min(i + j, ids.size() - 1)]));
+			}
+			stmt.execDML();
+		}
+	}
+	catch (CppSQLite3Exception& e)
+	{
+		LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+		return false;
+	}
+
+	return true;
+}
+
+CppSQLite3Statement& SqliteIndexStorage::getLookupStatement(
+	const std::string& statement, size_t slot) const
+{
+	// statements belong to the connection they were compiled on
+	CppSQLite3DB& database = getReadDatabase();
+	const auto key = std::make_tuple(statement, slot, &database);
+
+	std::lock_guard<std::mutex> lock(m_lookupStmtsMutex);
+	auto it = m_lookupStmts.find(key);
+	if (it == m_lookupStmts.end())
+	{
+		CppSQLite3Statement stmt = database.compileStatement(statement.c_str());
+		it = m_lookupStmts.emplace(key, stmt).first;
+	}
+
+	// a previous lookup may not have been stepped to the end
+	it->second.reset();
+	return it->second;
+}
+
+size_t SqliteIndexStorage::acquireLookupSlot(const CppSQLite3DB& database) const
+{
+	std::lock_guard<std::mutex> lock(m_lookupStmtsMutex);
+
+	std::vector<bool>& usedSlots = m_usedLookupSlots[&database];
+	const size_t slot = std::find(usedSlots.begin(), usedSlots.end(), false) - usedSlots.begin();
+	if (slot == usedSlots.size())
+	{
+		usedSlots.push_back(true);
+	}
+	else
+	{
+		usedSlots[slot] = true;
+	}
+	return slot;
+}
+
+void SqliteIndexStorage::releaseLookupSlot(const CppSQLite3DB& database, size_t slot) const
+{
+	std::lock_guard<std::mutex> lock(m_lookupStmtsMutex);
+	m_usedLookupSlots[&database][slot] = false;
+}
+
+template <>
+void SqliteIndexStorage::doForEach<StorageEdge>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageEdge&&)> func) const
+{
+	CppSQLite3Query q = executeFunc("SELECT id, type, source_node_id, target_node_id FROM edge");
 
 	while (!q.eof())
 	{
@@ -1472,10 +2146,11 @@ void SqliteIndexStorage::forEach<StorageEdge>(
 }
 
 template <>
-void SqliteIndexStorage::forEach<StorageNode>(
-	const std::string& query, std::function<void(StorageNode&&)> func) const
+void SqliteIndexStorage::doForEach<StorageNode>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageNode&&)> func) const
 {
-	CppSQLite3Query q = executeQuery("SELECT id, type, serialized_name FROM node " + query + ";");
+	CppSQLite3Query q = executeFunc("SELECT id, type, serialized_name FROM node");
 
 	while (!q.eof())
 	{
@@ -1493,10 +2168,11 @@ void SqliteIndexStorage::forEach<StorageNode>(
 }
 
 template <>
-void SqliteIndexStorage::forEach<StorageSymbol>(
-	const std::string& query, std::function<void(StorageSymbol&&)> func) const
+void SqliteIndexStorage::doForEach<StorageSymbol>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageSymbol&&)> func) const
 {
-	CppSQLite3Query q = executeQuery("SELECT id, definition_kind FROM symbol " + query + ";");
+	CppSQLite3Query q = executeFunc("SELECT id, definition_kind FROM symbol");
 
 	while (!q.eof())
 	{
@@ -1513,11 +2189,12 @@ void SqliteIndexStorage::forEach<StorageSymbol>(
 }
 
 template <>
-void SqliteIndexStorage::forEach<StorageFile>(
-	const std::string& query, std::function<void(StorageFile&&)> func) const
+void SqliteIndexStorage::doForEach<StorageFile>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageFile&&)> func) const
 {
-	CppSQLite3Query q = executeQuery(
-		"SELECT id, path, language, modification_time, indexed, complete FROM file " + query + ";");
+	CppSQLite3Query q = executeFunc(
+		"SELECT id, path, language, modification_time, indexed, complete FROM file");
 
 	while (!q.eof())
 	{
@@ -1543,10 +2220,11 @@ void SqliteIndexStorage::forEach<StorageFile>(
 }
 
 template <>
-void SqliteIndexStorage::forEach<StorageLocalSymbol>(
-	const std::string& query, std::function<void(StorageLocalSymbol&&)> func) const
+void SqliteIndexStorage::doForEach<StorageLocalSymbol>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageLocalSymbol&&)> func) const
 {
-	CppSQLite3Query q = executeQuery("SELECT id, name FROM local_symbol " + query + ";");
+	CppSQLite3Query q = executeFunc("SELECT id, name FROM local_symbol");
 
 	while (!q.eof())
 	{
@@ -1563,13 +2241,13 @@ void SqliteIndexStorage::forEach<StorageLocalSymbol>(
 }
 
 template <>
-void SqliteIndexStorage::forEach<StorageSourceLocation>(
-	const std::string& query, std::function<void(StorageSourceLocation&&)> func) const
+void SqliteIndexStorage::doForEach<StorageSourceLocation>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageSourceLocation&&)> func) const
 {
-	CppSQLite3Query q = executeQuery(
+	CppSQLite3Query q = executeFunc(
 		"SELECT id, file_node_id, start_line, start_column, end_line, end_column, type FROM "
-		"source_location " +
-		query + ";");
+		"source_location");
 
 	while (!q.eof())
 	{
@@ -1593,11 +2271,11 @@ void SqliteIndexStorage::forEach<StorageSourceLocation>(
 }
 
 template <>
-void SqliteIndexStorage::forEach<StorageOccurrence>(
-	const std::string& query, std::function<void(StorageOccurrence&&)> func) const
+void SqliteIndexStorage::doForEach<StorageOccurrence>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageOccurrence&&)> func) const
 {
-	CppSQLite3Query q = executeQuery(
-		"SELECT element_id, source_location_id FROM occurrence " + query + ";");
+	CppSQLite3Query q = executeFunc("SELECT element_id, source_location_id FROM occurrence");
 
 	while (!q.eof())
 	{
@@ -1614,10 +2292,11 @@ void SqliteIndexStorage::forEach<StorageOccurrence>(
 }
 
 template <>
-void SqliteIndexStorage::forEach<StorageComponentAccess>(
-	const std::string& query, std::function<void(StorageComponentAccess&&)> func) const
+void SqliteIndexStorage::doForEach<StorageComponentAccess>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageComponentAccess&&)> func) const
 {
-	CppSQLite3Query q = executeQuery("SELECT node_id, type FROM component_access " + query + ";");
+	CppSQLite3Query q = executeFunc("SELECT node_id, type FROM component_access");
 
 	while (!q.eof())
 	{
@@ -1634,11 +2313,11 @@ void SqliteIndexStorage::forEach<StorageComponentAccess>(
 }
 
 template <>
-void SqliteIndexStorage::forEach<StorageElementComponent>(
-	const std::string& query, std::function<void(StorageElementComponent&&)> func) const
+void SqliteIndexStorage::doForEach<StorageElementComponent>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageElementComponent&&)> func) const
 {
-	CppSQLite3Query q = executeQuery(
-		"SELECT element_id, type, data FROM element_component " + query + ";");
+	CppSQLite3Query q = executeFunc("SELECT element_id, type, data FROM element_component");
 
 	while (!q.eof())
 	{
@@ -1656,11 +2335,12 @@ void SqliteIndexStorage::forEach<StorageElementComponent>(
 }
 
 template <>
-void SqliteIndexStorage::forEach<StorageError>(
-	const std::string& query, std::function<void(StorageError&&)> func) const
+void SqliteIndexStorage::doForEach<StorageError>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageError&&)> func) const
 {
-	CppSQLite3Query q = executeQuery(
-		"SELECT id, message, fatal, indexed, translation_unit FROM error " + query + ";");
+	CppSQLite3Query q = executeFunc(
+		"SELECT id, message, fatal, indexed, translation_unit FROM error");
 
 	while (!q.eof())
 	{
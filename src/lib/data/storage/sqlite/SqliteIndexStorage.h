@@ -1,13 +1,19 @@
 #ifndef SQLITE_INDEX_STORAGE_H
 #define SQLITE_INDEX_STORAGE_H
 
+#include <algorithm>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "ErrorInfo.h"
 #include "LocationType.h"
 #include "LowMemoryStringMap.h"
+#include "ScopedFunctor.h"
 #include "SqliteDatabaseIndex.h"
 #include "SqliteStorage.h"
 #include "StorageComponentAccess.h"
@@ -15,6 +21,7 @@
 #include "StorageElementComponent.h"
 #include "StorageError.h"
 #include "StorageFile.h"
+#include "StorageIndexingDuration.h"
 #include "StorageLocalSymbol.h"
 #include "StorageNode.h"
 #include "StorageOccurrence.h"
@@ -38,18 +45,35 @@ public:
 	{
 		STORAGE_MODE_READ = 1,
 		STORAGE_MODE_WRITE = 2,
-		STORAGE_MODE_CLEAR = 4
+		STORAGE_MODE_CLEAR = 4,
+		STORAGE_MODE_REFRESH = STORAGE_MODE_READ | STORAGE_MODE_WRITE | STORAGE_MODE_CLEAR
 	};
 
 	SqliteIndexStorage(const FilePath& dbFilePath);
 
 	virtual size_t getStaticVersion() const;
+	bool isIncompatible() const override;
 
+	// Switching to any mode but writing finishes a bulk load first. The ids of new elements and
+	// source locations are looked up again after switching.
 	void setMode(const StorageModeType mode);
 
+	// Fills an empty database without foreign key checks, synchronous writes and the indices not
+	// needed for writing. All indices are built once the bulk load is finished. Until then the
+	// database counts as incompatible, so an interrupted bulk load gets rebuilt.
+	void beginBulkLoad();
+	void finishBulkLoad(std::function<void(int)> updateStatusCallback);
+	bool isBulkLoading() const;
+
 	std::string getProjectSettingsText() const;
 	void setProjectSettingsText(std::string text);
 
+	// Durations of earlier indexing runs per source file, kept when the file gets cleared.
+	std::vector<StorageIndexingDuration> getIndexingDurations() const;
+	void addIndexingDurations(const std::vector<StorageIndexingDuration>& durations);
+	// Removes the durations of source files that are no longer part of the storage.
+	void removeIndexingDurationsOfRemovedFiles();
+
 	Id addNode(const StorageNodeData& data);
 	std::vector<Id> addNodes(const std::vector<StorageNode>& nodes);
 	bool addSymbol(const StorageSymbol& data);
@@ -58,7 +82,7 @@ public:
 	Id addEdge(const StorageEdgeData& data);
 	std::vector<Id> addEdges(const std::vector<StorageEdge>& edges);
 	Id addLocalSymbol(const StorageLocalSymbolData& data);
-	std::vector<Id> addLocalSymbols(const std::set<StorageLocalSymbol>& symbols);
+	std::vector<Id> addLocalSymbols(const std::vector<StorageLocalSymbol>& symbols);
 	Id addSourceLocation(const StorageSourceLocationData& data);
 	std::vector<Id> addSourceLocations(const std::vector<StorageSourceLocation>& locations);
 	bool addOccurrence(const StorageOccurrence& data);
@@ -83,6 +107,8 @@ public:
 	bool isNode(Id elementId) const;
 	bool isFile(Id elementId) const;
 
+	std::vector<Id> getElementIdsWithLocationInFiles(const std::vector<Id>& fileIds) const;
+
 	StorageEdge getEdgeById(Id edgeId) const;
 	StorageEdge getEdgeBySourceTargetType(Id sourceId, Id targetId, int type) const;
 
@@ -109,13 +135,23 @@ public:
 	std::vector<StorageFile> getFilesByPaths(const std::vector<FilePath>& filePaths) const;
 	std::shared_ptr<TextAccess> getFileContentByPath(const std::wstring& filePath) const;
 	std::shared_ptr<TextAccess> getFileContentById(Id fileId) const;
+	std::string getFileContentTextById(Id fileId) const;
+
+	// Only decompresses the content blocks containing the requested lines, which start with 1.
+	std::vector<std::string> getFileContentLinesById(
+		Id fileId, size_t firstLineNumber, size_t lastLineNumber) const;
+	size_t getFileContentLineCountById(Id fileId) const;
+	bool hasFileContentById(Id fileId) const;
 
 	void setFileIndexed(Id fileId, bool indexed);
 	void setFileCompleteIfNoError(Id fileId, const std::wstring& filePath, bool complete);
 	void setNodeType(int type, Id nodeId);
 
-	std::shared_ptr<SourceLocationFile> getSourceLocationsForFile(
-		const FilePath& filePath, const std::string& query = "") const;
+	// Packs the source locations of all files that are not packed yet. Packed files are read with
+	// one row per file, adding or removing their locations drops the packed row again.
+	void packSourceLocations();
+
+	std::shared_ptr<SourceLocationFile> getSourceLocationsForFile(const FilePath& filePath) const;
 	std::shared_ptr<SourceLocationFile> getSourceLocationsForLinesInFile(
 		const FilePath& filePath, size_t startLine, size_t endLine) const;
 	std::shared_ptr<SourceLocationFile> getSourceLocationsOfTypeInFile(
@@ -146,22 +182,19 @@ public:
 	template <typename ResultType>
 	ResultType getFirstById(const Id id) const
 	{
+		ResultType result;
 		if (id != 0)
 		{
-			return doGetFirst<ResultType>("WHERE id == " + std::to_string(id));
+			forEachByColumnIds<ResultType>(
+				"id", {id}, [&result](ResultType&& element) { result = std::move(element); });
 		}
-		return ResultType();
+		return result;
 	}
 
 	template <typename ResultType>
 	std::vector<ResultType> getAllByIds(const std::vector<Id>& ids) const
 	{
-		if (ids.size())
-		{
-			return doGetAll<ResultType>(
-				"WHERE id IN (" + utility::join(utility::toStrings(ids), ',') + ")");
-		}
-		return std::vector<ResultType>();
+		return doGetAllByColumnIds<ResultType>("id", ids);
 	}
 
 	template <typename StorageType>
@@ -177,12 +210,9 @@ public:
 	}
 
 	template <typename StorageType>
-	void forEachByIds(const std::vector<Id> ids, std::function<void(StorageType&&)> func) const
+	void forEachByIds(const std::vector<Id>& ids, std::function<void(StorageType&&)> func) const
 	{
-		if (ids.size())
-		{
-			forEach("WHERE id IN (" + utility::join(utility::toStrings(ids), ',') + ")", func);
-		}
+		forEachByColumnIds("id", ids, func);
 	}
 
 	int getNodeCount() const;
@@ -195,6 +225,17 @@ public:
 
 private:
 	static const size_t s_storageVersion;
+	static const size_t s_fileContentBlockLineCount;
+	static const size_t s_packedSourceLocationMinCount;
+
+	// the rows a packed file was created from, which are compared to the current rows on reading
+	struct PackedSourceLocationStamp
+	{
+		std::string modificationTime;
+		size_t locationCount = 0;
+		size_t occurrenceCount = 0;
+		Id maxLocationId = 0;
+	};
 
 	struct TempSourceLocation
 	{
@@ -240,13 +281,45 @@ private:
 	virtual void clearTables();
 	virtual void setupTables();
 	virtual void setupPrecompiledStatements();
+	virtual void prepareWriteTransaction();
+
+	std::string getFileContentBlocks(Id fileId, size_t firstBlockIndex, size_t lastBlockIndex) const;
+	std::string getPlainFileContent(Id fileId) const;
+
+	// type is ignored if it is negative
+	std::shared_ptr<SourceLocationFile> doGetSourceLocationsForFile(
+		const FilePath& filePath, size_t startLine, size_t endLine, int type) const;
+	bool isPackedSourceLocationStampCurrent(
+		CppSQLite3Query& packedQuery, const StorageFile& file) const;
+	void dropPackedSourceLocations(const std::string& fileIdQuery);
+
+	// New ids are counted up in memory, so inserts do not need to read back the last row id. The
+	// maximum is read again for each write transaction.
+	Id generateElementId();
+	Id generateSourceLocationId();
 
 	template <typename ResultType>
 	std::vector<ResultType> doGetAll(const std::string& query) const
 	{
 		std::vector<ResultType> elements;
-		forEach<ResultType>(
-			query, [&elements](ResultType&& element) { elements.emplace_back(element); });
+		forEach<ResultType>(query, [&elements](ResultType&& element) {
+			elements.emplace_back(std::move(element));
+		});
+		return elements;
+	}
+
+	template <typename ResultType>
+	std::vector<ResultType> doGetAllByColumnIds(
+		const std::string& column,
+		const std::vector<Id>& ids,
+		const std::string& condition = "") const
+	{
+		std::vector<ResultType> elements;
+		forEachByColumnIds<ResultType>(
+			column,
+			ids,
+			[&elements](ResultType&& element) { elements.emplace_back(std::move(element)); },
+			condition);
 		return elements;
 	}
 
@@ -262,7 +335,68 @@ private:
 	}
 
 	template <typename StorageType>
-	void forEach(const std::string& query, std::function<void(StorageType&&)> func) const;
+	void forEach(const std::string& query, std::function<void(StorageType&&)> func) const
+	{
+		doForEach<StorageType>(
+			[&](const std::string& select) { return executeQuery(select + " " + query + ";"); },
+			func);
+	}
+
+	// Streams all rows whose column matches one of the ids. Instead of writing the ids into the
+	// SQL text, they get bound to prepared statements that are cached for the lifetime of the
+	// storage, so SQLite does not need to parse and plan every lookup again.
+	template <typename StorageType>
+	void forEachByColumnIds(
+		const std::string& column,
+		const std::vector<Id>& ids,
+		std::function<void(StorageType&&)> func,
+		const std::string& condition = "") const
+	{
+		if (ids.empty())
+		{
+			return;
+		}
+
+		std::vector<Id> uniqueIds = ids;
+		std::sort(uniqueIds.begin(), uniqueIds.end());
+		uniqueIds.erase(std::unique(uniqueIds.begin(), uniqueIds.end()), uniqueIds.end());
+
+		// other threads run their lookups on separate connections while this one writes
+		beginReadTransaction();
+		ScopedFunctor readTransactionEnder([this]() { endReadTransaction(); });
+
+		// the callback or other threads on the same connection may run lookups of their own, these
+		// must not reset the running statement
+		CppSQLite3DB& database = getReadDatabase();
+		const size_t slot = acquireLookupSlot(database);
+		ScopedFunctor slotReleaser([this, &database, slot]() { releaseLookupSlot(database, slot); });
+
+		doForEach<StorageType>(
+			[&](const std::string& select) {
+				return executeLookup(select, column, condition, uniqueIds, slot);
+			},
+			func);
+	}
+
+	template <typename StorageType>
+	void doForEach(
+		std::function<CppSQLite3Query(const std::string&)> executeFunc,
+		std::function<void(StorageType&&)> func) const;
+
+	CppSQLite3Query executeLookup(
+		const std::string& select,
+		const std::string& column,
+		const std::string& condition,
+		const std::vector<Id>& ids,
+		size_t slot) const;
+	bool fillLookupTable(
+		const std::string& tableName, const std::vector<Id>& ids, size_t slot) const;
+	CppSQLite3Statement& getLookupStatement(const std::string& statement, size_t slot) const;
+
+	// Lookups running at the same time on one connection each use a slot of their own, which
+	// selects their cached statements and temp table.
+	size_t acquireLookupSlot(const CppSQLite3DB& database) const;
+	void releaseLookupSlot(const CppSQLite3DB& database, size_t slot) const;
 
 	LowMemoryStringMap<std::string, uint32_t, 0> m_tempNodeNameIndex;
 	LowMemoryStringMap<std::wstring, uint32_t, 0> m_tempWNodeNameIndex;
@@ -271,6 +405,11 @@ private:
 	std::map<std::wstring, std::map<std::wstring, uint32_t>> m_tempLocalSymbolIndex;
 	std::map<uint32_t, std::map<TempSourceLocation, uint32_t>> m_tempSourceLocationIndices;
 
+	Id m_nextElementId = 0;
+	Id m_nextSourceLocationId = 0;
+
+	bool m_isBulkLoading = false;
+
 	template <typename StorageType>
 	class InsertBatchStatement
 	{
@@ -352,51 +491,67 @@ private:
 		std::function<void(CppSQLite3Statement& stmt, const StorageType&, size_t)> m_bindValuesFunc;
 	};
 
+	InsertBatchStatement<Id> m_insertElementBatchStatement;
 	InsertBatchStatement<StorageNode> m_insertNodeBatchStatement;
 	InsertBatchStatement<StorageEdge> m_insertEdgeBatchStatement;
 	InsertBatchStatement<StorageSymbol> m_insertSymbolBatchStatement;
 	InsertBatchStatement<StorageLocalSymbol> m_insertLocalSymbolBatchStatement;
-	InsertBatchStatement<StorageSourceLocationData> m_insertSourceLocationBatchStatement;
+	InsertBatchStatement<StorageSourceLocation> m_insertSourceLocationBatchStatement;
 	InsertBatchStatement<StorageOccurrence> m_insertOccurenceBatchStatement;
 	InsertBatchStatement<StorageComponentAccess> m_insertComponentAccessBatchStatement;
 
-	CppSQLite3Statement m_insertElementStmt;
 	CppSQLite3Statement m_insertElementComponentStmt;
 	CppSQLite3Statement m_insertFileStmt;
-	CppSQLite3Statement m_insertFileContentStmt;
+	CppSQLite3Statement m_insertFileContentBlockStmt;
+	CppSQLite3Statement m_insertPackedSourceLocationsStmt;
 	CppSQLite3Statement m_checkErrorExistsStmt;
 	CppSQLite3Statement m_insertErrorStmt;
+
+	mutable std::map<std::tuple<std::string, size_t, const CppSQLite3DB*>, CppSQLite3Statement>
+		m_lookupStmts;
+	mutable std::map<const CppSQLite3DB*, std::vector<bool>> m_usedLookupSlots;
+	mutable std::mutex m_lookupStmtsMutex;
 };
 
 template <>
-void SqliteIndexStorage::forEach<StorageEdge>(
-	const std::string& query, std::function<void(StorageEdge&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageEdge>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageEdge&&)> func) const;
 template <>
-void SqliteIndexStorage::forEach<StorageNode>(
-	const std::string& query, std::function<void(StorageNode&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageNode>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageNode&&)> func) const;
 template <>
-void SqliteIndexStorage::forEach<StorageSymbol>(
-	const std::string& query, std::function<void(StorageSymbol&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageSymbol>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageSymbol&&)> func) const;
 template <>
-void SqliteIndexStorage::forEach<StorageFile>(
-	const std::string& query, std::function<void(StorageFile&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageFile>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageFile&&)> func) const;
 template <>
-void SqliteIndexStorage::forEach<StorageLocalSymbol>(
-	const std::string& query, std::function<void(StorageLocalSymbol&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageLocalSymbol>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageLocalSymbol&&)> func) const;
 template <>
-void SqliteIndexStorage::forEach<StorageSourceLocation>(
-	const std::string& query, std::function<void(StorageSourceLocation&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageSourceLocation>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageSourceLocation&&)> func) const;
 template <>
-void SqliteIndexStorage::forEach<StorageOccurrence>(
-	const std::string& query, std::function<void(StorageOccurrence&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageOccurrence>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageOccurrence&&)> func) const;
 template <>
-void SqliteIndexStorage::forEach<StorageComponentAccess>(
-	const std::string& query, std::function<void(StorageComponentAccess&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageComponentAccess>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageComponentAccess&&)> func) const;
 template <>
-void SqliteIndexStorage::forEach<StorageElementComponent>(
-	const std::string& query, std::function<void(StorageElementComponent&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageElementComponent>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageElementComponent&&)> func) const;
 template <>
-void SqliteIndexStorage::forEach<StorageError>(
-	const std::string& query, std::function<void(StorageError&&)> func) const;
+void SqliteIndexStorage::doForEach<StorageError>(
+	std::function<CppSQLite3Query(const std::string&)> executeFunc,
+	std::function<void(StorageError&&)> func) const;
 
 #endif	  // SQLITE_INDEX_STORAGE_H
@@ -1,5 +1,7 @@
 #include "SqliteStorage.h"
 
+#include <algorithm>
+
 #include "FileSystem.h"
 #include "TimeStamp.h"
 #include "logging.h"
@@ -24,11 +26,22 @@ SqliteStorage::SqliteStorage(const FilePath& dbFilePath): m_dbFilePath(dbFilePat
 		throw;
 	}
 
+	// a database that was not closed properly may still be in write-ahead logging mode
+	restoreRollbackJournal();
 	executeStatement("PRAGMA foreign_keys=ON;");
 }
 
 SqliteStorage::~SqliteStorage()
 {
+	m_activeReadConnections.clear();
+	m_autocommitReadConnections.clear();
+	m_idleReadConnections.clear();
+
+	if (m_concurrentReads)
+	{
+		restoreRollbackJournal();
+	}
+
 	try
 	{
 		m_database.close();
@@ -84,17 +97,55 @@ void SqliteStorage::setVersion(size_t version)
 
 void SqliteStorage::beginTransaction()
 {
-	executeStatement("BEGIN TRANSACTION;");
+	if (m_transactionDepth == 0)
+	{
+		prepareWriteTransaction();
+		executeStatement("BEGIN TRANSACTION;");
+	}
+	else
+	{
+		executeStatement("SAVEPOINT " + getSavepointName(m_transactionDepth) + ";");
+	}
+	m_transactionDepth++;
+
+	std::lock_guard<std::mutex> lock(m_readConnectionMutex);
+	if (m_transactionDepth == 1)
+	{
+		m_writeThreadIds.clear();
+	}
+	m_writeThreadIds.push_back(std::this_thread::get_id());
 }
 
 void SqliteStorage::commitTransaction()
 {
+	if (m_transactionDepth > 1)
+	{
+		m_transactionDepth--;
+		executeStatement("RELEASE SAVEPOINT " + getSavepointName(m_transactionDepth) + ";");
+		releaseWriteThread();
+		return;
+	}
+
 	executeStatement("COMMIT TRANSACTION;");
+	m_transactionDepth = 0;
+	resetWriteThread();
 }
 
 void SqliteStorage::rollbackTransaction()
 {
+	if (m_transactionDepth > 1)
+	{
+		m_transactionDepth--;
+		const std::string savepointName = getSavepointName(m_transactionDepth);
+		executeStatement("ROLLBACK TRANSACTION TO SAVEPOINT " + savepointName + ";");
+		executeStatement("RELEASE SAVEPOINT " + savepointName + ";");
+		releaseWriteThread();
+		return;
+	}
+
 	executeStatement("ROLLBACK TRANSACTION;");
+	m_transactionDepth = 0;
+	resetWriteThread();
 }
 
 void SqliteStorage::optimizeMemory() const
@@ -133,6 +184,220 @@ TimeStamp SqliteStorage::getTime() const
 	return TimeStamp(getMetaValue("timestamp"));
 }
 
+void SqliteStorage::enableConcurrentReads()
+{
+	try
+	{
+		CppSQLite3Query q = m_database.execQuery("PRAGMA journal_mode=WAL;");
+		if (q.eof() || std::string(q.getStringField(0, "")) != "wal")
+		{
+			LOG_WARNING(
+				L"Unable to enable write-ahead logging for database \"" + m_dbFilePath.wstr() +
+				L"\"");
+			return;
+		}
+	}
+	catch (CppSQLite3Exception& e)
+	{
+		LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+		return;
+	}
+
+	m_concurrentReads = true;
+}
+
+void SqliteStorage::checkpoint() const
+{
+	if (m_concurrentReads)
+	{
+		executeStatement("PRAGMA wal_checkpoint(TRUNCATE);");
+	}
+}
+
+void SqliteStorage::beginReadTransaction() const
+{
+	std::lock_guard<std::mutex> lock(m_readConnectionMutex);
+
+	const std::thread::id threadId = std::this_thread::get_id();
+	auto it = m_activeReadConnections.find(threadId);
+	if (it != m_activeReadConnections.end())
+	{
+		it->second.depth++;
+		return;
+	}
+
+	ReadConnection connection = {nullptr, 1};
+	if (m_concurrentReads && !isWriteThread(threadId))
+	{
+		if (m_idleReadConnections.size())
+		{
+			connection.database = m_idleReadConnections.back();
+			m_idleReadConnections.pop_back();
+		}
+		else
+		{
+			connection.database = openReadConnection();
+		}
+	}
+
+	if (connection.database)
+	{
+		try
+		{
+			// reading once pins the snapshot to the state at the start of the transaction
+			connection.database->execDML("BEGIN TRANSACTION;");
+			connection.database->execScalar("SELECT count(*) FROM sqlite_master;");
+		}
+		catch (CppSQLite3Exception& e)
+		{
+			LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+			connection.database.reset();
+		}
+	}
+
+	m_activeReadConnections.emplace(threadId, connection);
+}
+
+void SqliteStorage::endReadTransaction() const
+{
+	std::lock_guard<std::mutex> lock(m_readConnectionMutex);
+
+	auto it = m_activeReadConnections.find(std::this_thread::get_id());
+	if (it == m_activeReadConnections.end() || --it->second.depth > 0)
+	{
+		return;
+	}
+
+	if (std::shared_ptr<CppSQLite3DB> database = it->second.database)
+	{
+		try
+		{
+			database->execDML("COMMIT TRANSACTION;");
+			m_idleReadConnections.push_back(database);
+		}
+		catch (CppSQLite3Exception& e)
+		{
+			LOG_ERROR(std::to_string(e.errorCode()) + ": " + e.errorMessage());
+		}
+	}
+
+	m_activeReadConnections.erase(it);
+}
+
+CppSQLite3DB& SqliteStorage::getReadDatabase() const
+{
+	if (m_concurrentReads)
+	{
+		std::lock_guard<std::mutex> lock(m_readConnectionMutex);
+
+		const std::thread::id threadId = std::this_thread::get_id();
+		auto it = m_activeReadConnections.find(threadId);
+		if (it != m_activeReadConnections.end())
+		{
+			if (it->second.database)
+			{
+				return *it->second.database;
+			}
+		}
+		else if (m_writeThreadIds.size() && !isWriteThread(threadId))
+		{
+			// reads outside of read transactions must not see the uncommitted writes either, so
+			// each other thread keeps a connection of the pool for them. The connection stays owned
+			// by that thread, because its statements may still be running after the write ends.
+			std::shared_ptr<CppSQLite3DB>& database = m_autocommitReadConnections[threadId];
+			if (!database && m_idleReadConnections.size())
+			{
+				database = m_idleReadConnections.back();
+				m_idleReadConnections.pop_back();
+			}
+			else if (!database)
+			{
+				database = openReadConnection();
+			}
+
+			if (database)
+			{
+				return *database;
+			}
+		}
+	}
+
+	return m_database;
+}
+
+std::string SqliteStorage::getSavepointName(size_t depth)
+{
+	return "transaction_" + std::to_string(depth);
+}
+
+std::shared_ptr<CppSQLite3DB> SqliteStorage::openReadConnection() const
+{
+	std::shared_ptr<CppSQLite3DB> database = std::make_shared<CppSQLite3DB>();
+	try
+	{
+		database->open(utility::encodeToUtf8(m_dbFilePath.wstr()).c_str());
+		database->setBusyTimeout(1000);
+	}
+	catch (CppSQLite3Exception& e)
+	{
+		LOG_ERROR(
+			L"Failed to open read connection to database file \"" + m_dbFilePath.wstr() +
+			L"\" with message: " + utility::decodeFromUtf8(e.errorMessage()));
+		return nullptr;
+	}
+	return database;
+}
+
+bool SqliteStorage::isWriteThread(std::thread::id threadId) const
+{
+	return std::find(m_writeThreadIds.begin(), m_writeThreadIds.end(), threadId) !=
+		m_writeThreadIds.end();
+}
+
+void SqliteStorage::releaseWriteThread()
+{
+	std::lock_guard<std::mutex> lock(m_readConnectionMutex);
+	if (m_writeThreadIds.size() > 1)
+	{
+		m_writeThreadIds.pop_back();
+	}
+}
+
+void SqliteStorage::resetWriteThread()
+{
+	std::lock_guard<std::mutex> lock(m_readConnectionMutex);
+	m_writeThreadIds.clear();
+}
+
+void SqliteStorage::restoreRollbackJournal()
+{
+	try
+	{
+		{
+			CppSQLite3Query q = m_database.execQuery("PRAGMA journal_mode;");
+			if (q.eof() || std::string(q.getStringField(0, "")) != "wal")
+			{
+				return;
+			}
+		}
+
+		// leaving write-ahead logging fails while other connections still use the database
+		CppSQLite3Query q = m_database.execQuery("PRAGMA journal_mode=DELETE;");
+		if (q.eof() || std::string(q.getStringField(0, "")) != "delete")
+		{
+			LOG_INFO(
+				L"Database \"" + m_dbFilePath.wstr() +
+				L"\" stays in write-ahead logging mode while it is in use");
+		}
+	}
+	catch (CppSQLite3Exception& e)
+	{
+		LOG_INFO(
+			L"Database \"" + m_dbFilePath.wstr() +
+			L"\" stays in write-ahead logging mode: " + utility::decodeFromUtf8(e.errorMessage()));
+	}
+}
+
 void SqliteStorage::setupMetaTable()
 {
 	try
@@ -200,7 +465,7 @@ int SqliteStorage::executeStatementScalar(const std::string& statement, const in
 	int ret = 0;
 	try
 	{
-		ret = m_database.execScalar(statement.c_str(), nullValue);
+		ret = getReadDatabase().execScalar(statement.c_str(), nullValue);
 	}
 	catch (CppSQLite3Exception e)
 	{
@@ -236,7 +501,7 @@ CppSQLite3Query SqliteStorage::executeQuery(const std::string& statement) const
 {
 	try
 	{
-		return m_database.execQuery(statement.c_str());
+		return getReadDatabase().execQuery(statement.c_str());
 	}
 	catch (CppSQLite3Exception e)
 	{
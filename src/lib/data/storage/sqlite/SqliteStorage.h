@@ -1,6 +1,13 @@
 #ifndef SQLITE_STORAGE_H
 #define SQLITE_STORAGE_H
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "CppSQLite3.h"
 
 #include "FilePath.h"
@@ -21,6 +28,11 @@ public:
 	size_t getVersion() const;
 	void setVersion(size_t version);
 
+	// Transactions may be nested, inner transactions become savepoints of the outermost one. Every
+	// thread that began one of the open levels counts as a writer and reads the uncommitted state,
+	// see beginReadTransaction(). This hands the write transaction over to other threads for the
+	// duration of their inner transactions, while the thread that began the outermost level keeps
+	// it until it commits or rolls back.
 	void beginTransaction();
 	void commitTransaction();
 	void rollbackTransaction();
@@ -30,11 +42,23 @@ public:
 	FilePath getDbFilePath() const;
 
 	bool isEmpty() const;
-	bool isIncompatible() const;
+	virtual bool isIncompatible() const;
 
 	void setTime();
 	TimeStamp getTime() const;
 
+	// Switches the database to write-ahead logging, so that read transactions started on other
+	// threads run on a pool of separate connections and keep seeing the last committed state
+	// while this connection writes. Rollback journaling is restored when the storage is closed.
+	void enableConcurrentReads();
+	void checkpoint() const;
+
+	// All queries of the calling thread between these calls see the same state of the database.
+	// Calls may be nested. Without concurrent reads, or on the thread that currently holds a write
+	// transaction, the queries simply run on the main connection.
+	void beginReadTransaction() const;
+	void endReadTransaction() const;
+
 protected:
 	void setupMetaTable();
 	void clearMetaTable();
@@ -46,6 +70,10 @@ protected:
 	CppSQLite3Query executeQuery(const std::string& statement) const;
 	CppSQLite3Query executeQuery(CppSQLite3Statement& statement) const;
 
+	// connection used for queries of the calling thread. While another thread writes, queries
+	// outside of read transactions run on a pooled connection as well.
+	CppSQLite3DB& getReadDatabase() const;
+
 	bool hasTable(const std::string& tableName) const;
 
 	std::string getMetaValue(const std::string& key) const;
@@ -59,9 +87,35 @@ private:
 	virtual void clearTables() = 0;
 	virtual void setupTables() = 0;
 	virtual void setupPrecompiledStatements() = 0;
+	// called before an outermost write transaction begins, other connections may have written since
+	virtual void prepareWriteTransaction() = 0;
+
+	struct ReadConnection
+	{
+		std::shared_ptr<CppSQLite3DB> database;
+		size_t depth;
+	};
+
+	static std::string getSavepointName(size_t depth);
+
+	std::shared_ptr<CppSQLite3DB> openReadConnection() const;
+	bool isWriteThread(std::thread::id threadId) const;
+	void releaseWriteThread();
+	void resetWriteThread();
+	void restoreRollbackJournal();
 
 	std::vector<std::pair<int, SqliteDatabaseIndex>> m_indices;
 
+	size_t m_transactionDepth = 0;
+
+	bool m_concurrentReads = false;
+	// the thread that began each open transaction level, guarded by m_readConnectionMutex
+	std::vector<std::thread::id> m_writeThreadIds;
+	mutable std::vector<std::shared_ptr<CppSQLite3DB>> m_idleReadConnections;
+	mutable std::map<std::thread::id, ReadConnection> m_activeReadConnections;
+	mutable std::map<std::thread::id, std::shared_ptr<CppSQLite3DB>> m_autocommitReadConnections;
+	mutable std::mutex m_readConnectionMutex;
+
 	bool m_precompiledStatementsInitialized = false;
 
 	friend SqliteStorageMigration;
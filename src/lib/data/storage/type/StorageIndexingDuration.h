@@ -0,0 +1,20 @@
+#ifndef STORAGE_INDEXING_DURATION_H
+#define STORAGE_INDEXING_DURATION_H
+
+#include <string>
+
+struct StorageIndexingDuration
+{
+	StorageIndexingDuration(): filePath(L""), duration(0.0f), includedFileCount(0) {}
+
+	StorageIndexingDuration(std::wstring filePath, float duration, int includedFileCount)
+		: filePath(std::move(filePath)), duration(duration), includedFileCount(includedFileCount)
+	{
+	}
+
+	std::wstring filePath;
+	float duration;	   // seconds
+	int includedFileCount;
+};
+
+#endif	  // STORAGE_INDEXING_DURATION_H
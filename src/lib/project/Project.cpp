@@ -3,7 +3,9 @@
 #include "ApplicationSettings.h"
 #include "CombinedIndexerCommandProvider.h"
 #include "DialogView.h"
+#include "FullTextSearchIndex.h"
 #include "IndexerCommand.h"
+#include "IndexSnapshot.h"
 #include "IndexerCommandCustom.h"
 #include "PersistentStorage.h"
 #include "ProjectSettings.h"
@@ -154,6 +156,7 @@ void Project::load(std::shared_ptr<DialogView> dialogView)
 				{
 					LOG_INFO("Discarding temporary indexing data on user's decision");
 					FileSystem::remove(tempDbPath);
+					FileSystem::remove(IndexSnapshot::getSnapshotFilePath(tempDbPath));
 				}
 			}
 			else
@@ -162,6 +165,10 @@ void Project::load(std::shared_ptr<DialogView> dialogView)
 					"Switching to temporary indexing data because no other persistent data was "
 					"found");
 				FileSystem::rename(tempDbPath, dbPath);
+				FileSystem::remove(IndexSnapshot::getSnapshotFilePath(dbPath));
+				FileSystem::rename(
+					IndexSnapshot::getSnapshotFilePath(tempDbPath),
+					IndexSnapshot::getSnapshotFilePath(dbPath));
 			}
 		}
 	}
@@ -221,6 +228,7 @@ void Project::load(std::shared_ptr<DialogView> dialogView)
 	if (canLoad)
 	{
 		m_storage->setMode(SqliteIndexStorage::STORAGE_MODE_READ);
+		m_storage->enableConcurrentReads();
 		m_storage->buildCaches();
 		m_storageCache->setSubject(m_storage);
 
@@ -540,36 +548,6 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 	m_storageCache->clear();
 	m_storageCache->setSubject(m_storage);
 
-	const FilePath indexDbFilePath = m_settings->getDBFilePath();
-	const FilePath tempIndexDbFilePath = m_settings->getTempDBFilePath();
-
-	if (info.mode != REFRESH_ALL_FILES)
-	{
-		// store the indexed data into the temp db but keep the current state to allow browsing
-		// while indexing
-		FileSystem::copyFile(indexDbFilePath, tempIndexDbFilePath);
-	}
-
-	std::shared_ptr<PersistentStorage> tempStorage = std::make_shared<PersistentStorage>(
-		tempIndexDbFilePath, m_storage->getBookmarkDbFilePath());
-	tempStorage->setup();
-
-	std::shared_ptr<TaskGroupSequence> taskSequential = std::make_shared<TaskGroupSequence>();
-
-	if (info.mode != REFRESH_ALL_FILES &&
-		(info.filesToClear.size() || info.nonIndexedFilesToClear.size()))
-	{
-		taskSequential->addTask(std::make_shared<TaskCleanStorage>(
-			tempStorage,
-			dialogView,
-			utility::toVector(utility::concat(info.filesToClear, info.nonIndexedFilesToClear)),
-			info.mode == REFRESH_UPDATED_AND_INCOMPLETE_FILES));
-	}
-
-	tempStorage->setProjectSettingsText(
-		TextAccess::createFromFile(getProjectSettingsFilePath())->getText());
-	tempStorage->updateVersion();
-
 	std::unique_ptr<CombinedIndexerCommandProvider> indexerCommandProvider =
 		std::make_unique<CombinedIndexerCommandProvider>();
 	std::unique_ptr<CombinedIndexerCommandProvider> customIndexerCommandProvider =
@@ -597,6 +575,67 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 		}
 	}
 
+	// custom indexers write into the temp db file from processes of their own
+	const bool refreshInPlace =
+		(info.mode != REFRESH_ALL_FILES && customIndexerCommandProvider->empty());
+	const std::string projectSettingsText =
+		TextAccess::createFromFile(getProjectSettingsFilePath())->getText();
+
+	std::shared_ptr<TaskGroupSequence> taskSequential = std::make_shared<TaskGroupSequence>();
+
+	// durations of the last runs are used to start the longest running source files first
+	const std::vector<StorageIndexingDuration> recordedDurations =
+		m_storage->getIndexingDurations();
+
+	std::shared_ptr<PersistentStorage> storage = m_storage;
+	if (refreshInPlace)
+	{
+		// write the changes directly into the current storage, which stays browsable at its last
+		// committed state until indexing is finished. The transaction of the refresh belongs to the
+		// thread running this sequence, it gets committed or rolled back by the tasks at its end.
+		taskSequential->addTask(std::make_shared<TaskLambda>([storage, projectSettingsText]() {
+			storage->startIncrementalRefresh();
+			storage->setProjectSettingsText(projectSettingsText);
+			storage->updateVersion();
+		}));
+	}
+	else
+	{
+		const FilePath tempIndexDbFilePath = m_settings->getTempDBFilePath();
+
+		if (info.mode != REFRESH_ALL_FILES)
+		{
+			// store the indexed data into the temp db but keep the current state to allow browsing
+			// while indexing
+			m_storage->checkpoint();
+			FileSystem::copyFile(m_settings->getDBFilePath(), tempIndexDbFilePath);
+		}
+
+		// a snapshot left over from an earlier run does not describe the new temp db
+		FileSystem::remove(IndexSnapshot::getSnapshotFilePath(tempIndexDbFilePath));
+
+		storage = std::make_shared<PersistentStorage>(
+			tempIndexDbFilePath, m_storage->getBookmarkDbFilePath());
+		storage->setup();
+		if (info.mode == REFRESH_ALL_FILES)
+		{
+			storage->addIndexingDurations(recordedDurations);
+			storage->beginBulkLoad();
+		}
+		storage->setProjectSettingsText(projectSettingsText);
+		storage->updateVersion();
+	}
+
+	if (info.mode != REFRESH_ALL_FILES &&
+		(info.filesToClear.size() || info.nonIndexedFilesToClear.size()))
+	{
+		taskSequential->addTask(std::make_shared<TaskCleanStorage>(
+			storage,
+			dialogView,
+			utility::toVector(utility::concat(info.filesToClear, info.nonIndexedFilesToClear)),
+			info.mode == REFRESH_UPDATED_AND_INCOMPLETE_FILES));
+	}
+
 	size_t sourceFileCount = indexerCommandProvider->size() + customIndexerCommandProvider->size();
 
 	taskSequential->addTask(std::make_shared<TaskSetValue<bool>>("shallow_indexing", info.shallow));
@@ -605,6 +644,13 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 	taskSequential->addTask(std::make_shared<TaskSetValue<int>>("indexed_source_file_count", 0));
 	taskSequential->addTask(std::make_shared<TaskSetValue<bool>>("interrupted_indexing", false));
 	taskSequential->addTask(std::make_shared<TaskSetValue<float>>("index_time", 0.0f));
+	taskSequential->addTask(
+		std::make_shared<TaskSetValue<int>>("automatic_pch_source_file_count", 0));
+	taskSequential->addTask(
+		std::make_shared<TaskSetValue<float>>("automatic_pch_build_time", 0.0f));
+	taskSequential->addTask(std::make_shared<TaskSetValue<int>>("scheduled_source_file_count", 0));
+	taskSequential->addTask(
+		std::make_shared<TaskSetValue<int>>("recorded_duration_source_file_count", 0));
 
 	int indexerThreadCount = ApplicationSettings::getInstance()->getIndexerThreadCount();
 	if (indexerThreadCount <= 0)
@@ -623,6 +669,8 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 
 		std::shared_ptr<StorageProvider> storageProvider = std::make_shared<StorageProvider>();
 		// add tasks for setting some variables on the blackboard that are used during indexing
+		taskSequential->addTask(std::make_shared<TaskSetValue<int>>(
+			"indexer_thread_count", adjustedIndexerThreadCount));
 		taskSequential->addTask(
 			std::make_shared<TaskSetValue<bool>>("indexer_threads_started", false));
 		taskSequential->addTask(
@@ -643,7 +691,7 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 		}
 
 		std::shared_ptr<TaskParseWrapper> taskParserWrapper = std::make_shared<TaskParseWrapper>(
-			tempStorage, dialogView);
+			storage, dialogView);
 		taskSequential->addTask(taskParserWrapper);
 
 		std::shared_ptr<TaskGroupParallel> taskParallelIndexing =
@@ -652,7 +700,7 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 
 		// add task for refilling the indexer command queue
 		taskParallelIndexing->addTask(std::make_shared<TaskFillIndexerCommandsQueue>(
-			m_appUUID, std::move(indexerCommandProvider), 20));
+			m_appUUID, std::move(indexerCommandProvider), 20, recordedDurations));
 
 		// add task for indexing
 		bool multiProcess = ApplicationSettings::getInstance()->getMultiProcessIndexingEnabled() &&
@@ -666,22 +714,30 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 			std::make_shared<TaskBuildIndex>(
 				adjustedIndexerThreadCount, storageProvider, dialogView, m_appUUID, multiProcess)));
 
-		// add task for merging the intermediate storages
-		taskParallelIndexing->addTask(std::make_shared<TaskGroupSequence>()->addChildTasks(
-			// block until there are indexers running
-			std::make_shared<TaskDecoratorRepeat>(
-				TaskDecoratorRepeat::CONDITION_WHILE_SUCCESS, Task::STATE_SUCCESS, 25)
-				->addChildTask(std::make_shared<TaskReturnSuccessIf<bool>>(
-					"indexer_threads_started", TaskReturnSuccessIf<bool>::CONDITION_EQUALS, false)),
-			// merge until all indexers stopped and nothing left to merge
-			std::make_shared<TaskDecoratorRepeat>(
-				TaskDecoratorRepeat::CONDITION_WHILE_SUCCESS, Task::STATE_SUCCESS, 250)
-				->addChildTask(std::make_shared<TaskGroupSelector>()->addChildTasks(
-					std::make_shared<TaskMergeStorages>(storageProvider),
-					std::make_shared<TaskReturnSuccessIf<bool>>(
-						"indexer_threads_stopped",
+		const int mergeWorkerCount = TaskMergeStorages::getWorkerCount(
+			ApplicationSettings::getInstance()->getMergeWorkerCount(), adjustedIndexerThreadCount);
+
+		// add tasks for merging the intermediate storages
+		for (int i = 0; i < mergeWorkerCount; i++)
+		{
+			taskParallelIndexing->addTask(std::make_shared<TaskGroupSequence>()->addChildTasks(
+				// block until there are indexers running
+				std::make_shared<TaskDecoratorRepeat>(
+					TaskDecoratorRepeat::CONDITION_WHILE_SUCCESS, Task::STATE_SUCCESS, 25)
+					->addChildTask(std::make_shared<TaskReturnSuccessIf<bool>>(
+						"indexer_threads_started",
 						TaskReturnSuccessIf<bool>::CONDITION_EQUALS,
-						false)))));
+						false)),
+				// merge until all indexers stopped and nothing left to merge
+				std::make_shared<TaskDecoratorRepeat>(
+					TaskDecoratorRepeat::CONDITION_WHILE_SUCCESS, Task::STATE_SUCCESS, 25)
+					->addChildTask(std::make_shared<TaskGroupSelector>()->addChildTasks(
+						std::make_shared<TaskMergeStorages>(storageProvider),
+						std::make_shared<TaskReturnSuccessIf<bool>>(
+							"indexer_threads_stopped",
+							TaskReturnSuccessIf<bool>::CONDITION_EQUALS,
+							false)))));
+		}
 
 		// add task for injecting the intermediate storages into the persistent storage
 		taskParallelIndexing->addTask(std::make_shared<TaskGroupSequence>()->addChildTasks(
@@ -693,7 +749,7 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 			std::make_shared<TaskDecoratorRepeat>(
 				TaskDecoratorRepeat::CONDITION_WHILE_SUCCESS, Task::STATE_SUCCESS, 25)
 				->addChildTask(std::make_shared<TaskGroupSelector>()->addChildTasks(
-					std::make_shared<TaskInjectStorage>(storageProvider, tempStorage),
+					std::make_shared<TaskInjectStorage>(storageProvider, storage),
 					// continuing when indexers still running, even if there are no storages right now.
 					std::make_shared<TaskReturnSuccessIf<bool>>(
 						"indexer_threads_stopped",
@@ -711,7 +767,7 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 		taskSequential->addTask(
 			std::make_shared<TaskDecoratorRepeat>(
 				TaskDecoratorRepeat::CONDITION_WHILE_SUCCESS, Task::STATE_SUCCESS, 25)
-				->addChildTask(std::make_shared<TaskInjectStorage>(storageProvider, tempStorage)));
+				->addChildTask(std::make_shared<TaskInjectStorage>(storageProvider, storage)));
 	}
 	else
 	{
@@ -725,27 +781,46 @@ void Project::buildIndex(RefreshInfo info, std::shared_ptr<DialogView> dialogVie
 
 		taskSequential->addTask(std::make_shared<TaskExecuteCustomCommands>(
 			std::move(customIndexerCommandProvider),
-			tempStorage,
+			storage,
 			dialogView,
 			adjustedIndexerThreadCount,
 			getProjectSettingsFilePath().getParentDirectory()));
 	}
 
-	taskSequential->addTask(std::make_shared<TaskFinishParsing>(tempStorage, dialogView));
+	taskSequential->addTask(std::make_shared<TaskFinishParsing>(storage, dialogView));
 
 	taskSequential->addTask(std::make_shared<TaskGroupSelector>()->addChildTasks(
 		std::make_shared<TaskGroupSequence>()->addChildTasks(
 			std::make_shared<TaskFindKeyOnBlackboard>("keep_database"),
-			std::make_shared<TaskLambda>([dialogView, this]() {
-				Task::dispatch(TabId::app(), std::make_shared<TaskLambda>([dialogView, this]() {
-								   swapToTempStorage(dialogView);
-							   }));
+			std::make_shared<TaskLambda>([dialogView, storage, refreshInPlace, this]() {
+				if (refreshInPlace)
+				{
+					storage->finishIncrementalRefresh();
+				}
+				Task::dispatch(
+					TabId::app(),
+					std::make_shared<TaskLambda>([dialogView, refreshInPlace, this]() {
+						if (refreshInPlace)
+						{
+							finishIncrementalRefresh();
+						}
+						else
+						{
+							swapToTempStorage(dialogView);
+						}
+					}));
 			})),
 		std::make_shared<TaskGroupSequence>()->addChildTasks(
 			std::make_shared<TaskFindKeyOnBlackboard>("discard_database"),
-			std::make_shared<TaskLambda>([this]() {
-				Task::dispatch(
-					TabId::app(), std::make_shared<TaskLambda>([this]() { discardTempStorage(); }));
+			std::make_shared<TaskLambda>([storage, refreshInPlace, this]() {
+				if (refreshInPlace)
+				{
+					storage->rollbackIncrementalRefresh();
+					return;
+				}
+				Task::dispatch(TabId::app(), std::make_shared<TaskLambda>([this]() {
+								   discardTempStorage();
+							   }));
 			}))));
 
 	taskSequential->addTask(std::make_shared<TaskLambda>([dialogView, this]() {
@@ -794,6 +869,7 @@ void Project::swapToTempStorage(std::shared_ptr<DialogView> dialogView)
 
 	m_storage = std::make_shared<PersistentStorage>(indexDbFilePath, bookmarkDbFilePath);
 	m_storage->setup();
+	m_storage->enableConcurrentReads();
 
 	// std::shared_ptr<DialogView> dialogView =
 	// Application::getInstance()->getDialogView(DialogView::UseCase::INDEXING);
@@ -805,6 +881,14 @@ void Project::swapToTempStorage(std::shared_ptr<DialogView> dialogView)
 	m_state = PROJECT_STATE_LOADED;
 }
 
+void Project::finishIncrementalRefresh()
+{
+	LOG_INFO("Applying refreshed indexing data");
+
+	// the storage was already committed on the indexing thread
+	m_storageCache->clear();
+}
+
 bool Project::swapToTempStorageFile(
 	const FilePath& indexDbFilePath,
 	const FilePath& tempIndexDbFilePath,
@@ -814,6 +898,15 @@ bool Project::swapToTempStorageFile(
 	{
 		FileSystem::remove(indexDbFilePath);
 		FileSystem::rename(tempIndexDbFilePath, indexDbFilePath);
+
+		// the snapshot belongs to the db file it was written for, so it is swapped along with it
+		FileSystem::remove(IndexSnapshot::getSnapshotFilePath(indexDbFilePath));
+		FileSystem::rename(
+			IndexSnapshot::getSnapshotFilePath(tempIndexDbFilePath),
+			IndexSnapshot::getSnapshotFilePath(indexDbFilePath));
+
+		// the temp db never has a full text search index and the old one does not match anymore
+		FileSystem::remove(FullTextSearchIndex::getIndexFilePath(indexDbFilePath));
 	}
 	catch (std::exception& /*e*/)
 	{
@@ -839,6 +932,7 @@ void Project::discardTempStorage()
 		LOG_INFO("Discarding temporary indexing data");
 		FileSystem::remove(tempIndexDbPath);
 	}
+	FileSystem::remove(IndexSnapshot::getSnapshotFilePath(tempIndexDbPath));
 }
 
 bool Project::hasCxxSourceGroup() const
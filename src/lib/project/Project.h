@@ -65,6 +65,7 @@ private:
 
 	Project(const Project&);
 
+	void finishIncrementalRefresh();
 	void swapToTempStorage(std::shared_ptr<DialogView> dialogView);
 	bool swapToTempStorageFile(
 		const FilePath& indexDbFilePath,
@@ -379,6 +379,46 @@ void ApplicationSettings::setIndexerThreadCount(const int count)
 	setValue<int>("indexing/indexer_thread_count", count);
 }
 
+int ApplicationSettings::getMergeWorkerCount() const
+{
+	return getValue<int>("indexing/merge_worker_count", 0);
+}
+
+void ApplicationSettings::setMergeWorkerCount(const int count)
+{
+	setValue<int>("indexing/merge_worker_count", count);
+}
+
+int ApplicationSettings::getCxxFileCacheSize() const
+{
+	return getValue<int>("indexing/cxx/file_cache_size", 1024);
+}
+
+void ApplicationSettings::setCxxFileCacheSize(const int size)
+{
+	setValue<int>("indexing/cxx/file_cache_size", size);
+}
+
+bool ApplicationSettings::getCxxNameCacheEnabled() const
+{
+	return getValue<bool>("indexing/cxx/name_cache_enabled", false);
+}
+
+void ApplicationSettings::setCxxNameCacheEnabled(bool enabled)
+{
+	setValue<bool>("indexing/cxx/name_cache_enabled", enabled);
+}
+
+bool ApplicationSettings::getCxxHeaderClaimingEnabled() const
+{
+	return getValue<bool>("indexing/cxx/header_claiming_enabled", false);
+}
+
+void ApplicationSettings::setCxxHeaderClaimingEnabled(bool enabled)
+{
+	setValue<bool>("indexing/cxx/header_claiming_enabled", enabled);
+}
+
 bool ApplicationSettings::getMultiProcessIndexingEnabled() const
 {
 	return getValue<bool>("indexing/multi_process_indexing", true);
@@ -546,6 +586,26 @@ void ApplicationSettings::setCodeSnippetExpandRange(int range)
 	setValue<int>("code/snippet/expand_range", range);
 }
 
+int ApplicationSettings::getCodeFullTextSearchMaxResultCount() const
+{
+	return getValue<int>("code/fulltext_search/max_result_count", 1000);
+}
+
+void ApplicationSettings::setCodeFullTextSearchMaxResultCount(int count)
+{
+	setValue<int>("code/fulltext_search/max_result_count", count);
+}
+
+int ApplicationSettings::getCodeFullTextSearchMaxIndexFileSize() const
+{
+	return getValue<int>("code/fulltext_search/max_index_file_size", 1024);
+}
+
+void ApplicationSettings::setCodeFullTextSearchMaxIndexFileSize(int size)
+{
+	setValue<int>("code/fulltext_search/max_index_file_size", size);
+}
+
 bool ApplicationSettings::getCodeViewModeSingle() const
 {
 	return getValue<bool>("code/view_mode_single", false);
@@ -95,6 +95,21 @@ public:
 	int getIndexerThreadCount() const;
 	void setIndexerThreadCount(const int count);
 
+	int getMergeWorkerCount() const;
+	void setMergeWorkerCount(const int count);
+
+	// megabytes of file contents kept by all C/C++ indexers together
+	int getCxxFileCacheSize() const;
+	void setCxxFileCacheSize(const int size);
+
+	// caches the names resolved by the C/C++ indexer within each translation unit
+	bool getCxxNameCacheEnabled() const;
+	void setCxxNameCacheEnabled(bool enabled);
+
+	// skips recording headers that translation units indexed earlier recorded completely
+	bool getCxxHeaderClaimingEnabled() const;
+	void setCxxHeaderClaimingEnabled(bool enabled);
+
 	bool getMultiProcessIndexingEnabled() const;
 	void setMultiProcessIndexingEnabled(bool enabled);
 
@@ -147,6 +162,15 @@ public:
 	int getCodeSnippetExpandRange() const;
 	void setCodeSnippetExpandRange(int range);
 
+	// fulltext search stops after this many results, 0 means no limit
+	int getCodeFullTextSearchMaxResultCount() const;
+	void setCodeFullTextSearchMaxResultCount(int count);
+
+	// megabytes the fulltext search index may take when saved next to the database, it is rebuilt
+	// on the first search of every session if it gets larger, 0 means it is never saved
+	int getCodeFullTextSearchMaxIndexFileSize() const;
+	void setCodeFullTextSearchMaxIndexFileSize(int size);
+
 	bool getCodeViewModeSingle() const;
 	void setCodeViewModeSingle(bool enabled);
 
@@ -0,0 +1,117 @@
+#ifndef FLAT_HASH_INDEX_H
+#define FLAT_HASH_INDEX_H
+
+#include <cstdint>
+#include <vector>
+
+// Open addressing hash table that maps to positions in a vector owned by the caller. Only the
+// hashes and the positions are stored, so the elements are not copied into the index and adding an
+// element does not allocate unless the table has to grow.
+class FlatHashIndex
+{
+public:
+	static const size_t s_notFound = size_t(-1);
+
+	void clear()
+	{
+		m_slots.clear();
+		m_size = 0;
+	}
+
+	// Returns the position of an element with the given hash for which isEqual(position) is true.
+	template <typename EqualFunc>
+	size_t find(size_t hash, EqualFunc isEqual) const
+	{
+		if (m_slots.empty())
+		{
+			return s_notFound;
+		}
+
+		const uint32_t shortHash = static_cast<uint32_t>(hash);
+		const size_t mask = m_slots.size() - 1;
+		for (size_t i = hash & mask; m_slots[i].position != s_emptyPosition; i = (i + 1) & mask)
+		{
+			if (m_slots[i].hash == shortHash && isEqual(m_slots[i].position))
+			{
+				return m_slots[i].position;
+			}
+		}
+		return s_notFound;
+	}
+
+	void insert(size_t hash, size_t position)
+	{
+		if ((m_size + 1) * 4 > m_slots.size() * 3)
+		{
+			grow();
+		}
+
+		insertSlot(static_cast<uint32_t>(hash), static_cast<uint32_t>(position));
+		m_size++;
+	}
+
+	// Replaces the content by the positions 0 to count - 1, getHash(position) returns their hashes.
+	template <typename HashFunc>
+	void rebuild(size_t count, HashFunc getHash)
+	{
+		clear();
+		if (!count)
+		{
+			return;
+		}
+
+		// the table is sized once instead of growing while the positions are inserted
+		size_t slotCount = 16;
+		while (count * 4 > slotCount * 3)
+		{
+			slotCount *= 2;
+		}
+		m_slots.assign(slotCount, Slot {0, s_emptyPosition});
+
+		for (size_t i = 0; i < count; i++)
+		{
+			insertSlot(static_cast<uint32_t>(getHash(i)), static_cast<uint32_t>(i));
+		}
+		m_size = count;
+	}
+
+private:
+	struct Slot
+	{
+		uint32_t hash;
+		uint32_t position;
+	};
+
+	static const uint32_t s_emptyPosition = uint32_t(-1);
+
+	void grow()
+	{
+		std::vector<Slot> slots(
+			m_slots.empty() ? 16 : m_slots.size() * 2, Slot {0, s_emptyPosition});
+		m_slots.swap(slots);
+
+		for (const Slot& slot: slots)
+		{
+			if (slot.position != s_emptyPosition)
+			{
+				insertSlot(slot.hash, slot.position);
+			}
+		}
+	}
+
+	void insertSlot(uint32_t hash, uint32_t position)
+	{
+		const size_t mask = m_slots.size() - 1;
+		size_t i = hash & mask;
+		while (m_slots[i].position != s_emptyPosition)
+		{
+			i = (i + 1) & mask;
+		}
+		m_slots[i] = Slot {hash, position};
+	}
+
+	std::vector<Slot> m_slots;
+	size_t m_size = 0;
+};
+
+#endif	  // FLAT_HASH_INDEX_H
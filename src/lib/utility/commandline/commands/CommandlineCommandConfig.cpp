@@ -84,6 +84,10 @@ void CommandlineCommandConfig::setup()
 		"indexer-threads,t",
 		po::value<int>(),
 		"Set the number of threads used for indexing (0 uses ideal thread count)")(
+		"merge-workers,w",
+		po::value<int>(),
+		"Set the number of threads merging indexed data before it is saved (0 derives it from the "
+		"indexer threads)")(
 		"use-processes,p",
 		po::value<bool>(),
 		"Enable C/C++ Indexer threads to run in different processes. <true/false>")(
@@ -147,6 +151,7 @@ CommandlineCommand::ReturnStatus CommandlineCommandConfig::parse(std::vector<std
 	{
 		std::cout << "Sourcetrail Settings:\n"
 				  << "\n  indexer-threads: " << settings->getIndexerThreadCount()
+				  << "\n  merge-workers: " << settings->getMergeWorkerCount()
 				  << "\n  use-processes: " << settings->getMultiProcessIndexingEnabled()
 				  << "\n  logging-enabled: " << settings->getLoggingEnabled()
 				  << "\n  verbose-indexer-logging-enabled: "
@@ -169,6 +174,7 @@ CommandlineCommand::ReturnStatus CommandlineCommandConfig::parse(std::vector<std
 		vm);
 
 	parseAndSetValue(&ApplicationSettings::setIndexerThreadCount, "indexer-threads", settings, vm);
+	parseAndSetValue(&ApplicationSettings::setMergeWorkerCount, "merge-workers", settings, vm);
 
 	parseAndSetValue(&ApplicationSettings::setMavenPath, "maven-path", settings, vm);
 	parseAndSetValue(&ApplicationSettings::setJavaPath, "jvm-path", settings, vm);
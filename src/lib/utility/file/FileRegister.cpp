@@ -1,26 +1,32 @@
 #include "FileRegister.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "FilePath.h"
 #include "FilePathFilter.h"
 
-FileRegister::FileRegister(
-	const FilePath& currentPath,
-	const std::set<FilePath>& indexedPaths,
-	const std::set<FilePathFilter>& excludeFilters)
-	: m_currentPath(currentPath)
-	, m_indexedPaths(indexedPaths)
-	, m_excludeFilters(excludeFilters)
-	, m_hasFilePathCache([&](const std::wstring& f) {
-		const FilePath filePath(f);
-		bool ret = false;
+namespace
+{
+template <typename T>
+bool isSame(const T& a, const T& b)
+{
+	return !(a < b) && !(b < a);
+}
+}	 // namespace
 
-		if (filePath == m_currentPath)
-		{
-			ret = true;
-		}
+// The indexed paths and exclude filters without the current path, which is always indexed.
+class FileRegister::IndexedFiles
+{
+public:
+	IndexedFiles(
+		const FilePath& currentPath,
+		const std::set<FilePath>& indexedPaths,
+		const std::set<FilePathFilter>& excludeFilters)
+		: m_excludeFilters(excludeFilters), m_isIndexedCache([&](const std::wstring& f) {
+			const FilePath filePath(f);
+			bool ret = false;
 
-		if (!ret)
-		{
 			for (const FilePath& indexedPath: m_indexedPaths)
 			{
 				if (indexedPath.isDirectory())
@@ -40,21 +46,85 @@ FileRegister::FileRegister(
 					}
 				}
 			}
+
+			return ret && !isExcluded(filePath);
+		})
+	{
+		for (const FilePath& indexedPath: indexedPaths)
+		{
+			if (!isSame(indexedPath, currentPath))
+			{
+				m_indexedPaths.push_back(indexedPath);
+			}
 		}
+	}
 
-		if (ret)
+	bool isIndexed(const FilePath& filePath)
+	{
+		return m_isIndexedCache.getValue(filePath.wstr());
+	}
+
+	bool isExcluded(const FilePath& filePath) const
+	{
+		for (const FilePathFilter& excludeFilter: m_excludeFilters)
 		{
-			for (const FilePathFilter& excludeFilter: m_excludeFilters)
+			if (excludeFilter.isMatching(filePath))
 			{
-				if (excludeFilter.isMatching(filePath))
-				{
-					ret = false;
-					break;
-				}
+				return true;
 			}
 		}
-		return ret;
-	})
+		return false;
+	}
+
+	bool isSameAs(
+		const FilePath& currentPath,
+		const std::set<FilePath>& indexedPaths,
+		const std::set<FilePathFilter>& excludeFilters) const
+	{
+		if (excludeFilters.size() != m_excludeFilters.size() ||
+			!std::equal(
+				excludeFilters.begin(),
+				excludeFilters.end(),
+				m_excludeFilters.begin(),
+				isSame<FilePathFilter>))
+		{
+			return false;
+		}
+
+		auto it = m_indexedPaths.begin();
+		for (const FilePath& indexedPath: indexedPaths)
+		{
+			if (isSame(indexedPath, currentPath))
+			{
+				continue;
+			}
+
+			if (it == m_indexedPaths.end() || !isSame(indexedPath, *it))
+			{
+				return false;
+			}
+			it++;
+		}
+		return it == m_indexedPaths.end();
+	}
+
+private:
+	std::vector<FilePath> m_indexedPaths;
+	const std::set<FilePathFilter> m_excludeFilters;
+	UnorderedCache<std::wstring, bool> m_isIndexedCache;
+};
+
+FileRegister::FileRegister(
+	const FilePath& currentPath,
+	const std::set<FilePath>& indexedPaths,
+	const std::set<FilePathFilter>& excludeFilters)
+	: FileRegister(
+		  currentPath, std::make_shared<IndexedFiles>(currentPath, indexedPaths, excludeFilters))
+{
+}
+
+FileRegister::FileRegister(const FilePath& currentPath, const FileRegister& other)
+	: FileRegister(currentPath, other.m_indexedFiles)
 {
 }
 
@@ -64,3 +134,25 @@ bool FileRegister::hasFilePath(const FilePath& filePath) const
 {
 	return m_hasFilePathCache.getValue(filePath.wstr());
 }
+
+bool FileRegister::hasSameIndexedFiles(
+	const FilePath& currentPath,
+	const std::set<FilePath>& indexedPaths,
+	const std::set<FilePathFilter>& excludeFilters) const
+{
+	return m_indexedFiles->isSameAs(currentPath, indexedPaths, excludeFilters);
+}
+
+FileRegister::FileRegister(const FilePath& currentPath, std::shared_ptr<IndexedFiles> indexedFiles)
+	: m_currentPath(currentPath)
+	, m_indexedFiles(indexedFiles)
+	, m_hasFilePathCache([this](const std::wstring& f) {
+		const FilePath filePath(f);
+		if (filePath == m_currentPath)
+		{
+			return !m_indexedFiles->isExcluded(filePath);
+		}
+		return m_indexedFiles->isIndexed(filePath);
+	})
+{
+}
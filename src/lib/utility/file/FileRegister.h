@@ -1,6 +1,7 @@
 #ifndef FILE_REGISTER_H
 #define FILE_REGISTER_H
 
+#include <memory>
 #include <set>
 
 #include "FilePath.h"
@@ -15,14 +16,28 @@ public:
 		const FilePath& currentPath,
 		const std::set<FilePath>& indexedPaths,
 		const std::set<FilePathFilter>& excludeFilters);
+
+	// Shares the indexed paths and exclude filters of other and what it found out about files other
+	// than its current path, so headers are not checked again for every translation unit.
+	FileRegister(const FilePath& currentPath, const FileRegister& other);
+
 	virtual ~FileRegister();
 
 	virtual bool hasFilePath(const FilePath& filePath) const;
 
+	// Returns whether a register created from these arguments can share its indexed files.
+	bool hasSameIndexedFiles(
+		const FilePath& currentPath,
+		const std::set<FilePath>& indexedPaths,
+		const std::set<FilePathFilter>& excludeFilters) const;
+
 private:
-	const FilePath& m_currentPath;
-	const std::set<FilePath> m_indexedPaths;
-	const std::set<FilePathFilter> m_excludeFilters;
+	class IndexedFiles;
+
+	FileRegister(const FilePath& currentPath, std::shared_ptr<IndexedFiles> indexedFiles);
+
+	const FilePath m_currentPath;
+	std::shared_ptr<IndexedFiles> m_indexedFiles;
 	mutable UnorderedCache<std::wstring, bool> m_hasFilePathCache;
 };
 
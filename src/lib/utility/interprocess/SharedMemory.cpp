@@ -1,13 +1,17 @@
 #include "SharedMemory.h"
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
 #include "SharedMemoryGarbageCollector.h"
 #include "logging.h"
 
 const char* SharedMemory::s_memoryNamePrefix = "srctrlmem_";
 const char* SharedMemory::s_mutexNamePrefix = "srctrlmtx_";
+const char* SharedMemory::s_conditionNamePrefix = "srctrlcnd_";
 
 SharedMemory::ScopedAccess::ScopedAccess(SharedMemory* memory)
 	: boost::interprocess::scoped_lock<boost::interprocess::named_mutex>(memory->getMutex())
+	, m_sharedMemory(memory)
 	//, m_memory(boost::interprocess::open_only, memory->getMemoryName().c_str())
 	, m_memoryName(memory->getMemoryName())
 	, m_minimumMemorySize(memory->getInitialMemorySize())
@@ -95,6 +99,26 @@ std::string SharedMemory::ScopedAccess::logString() const
 	return log;
 }
 
+void SharedMemory::ScopedAccess::notifyAll()
+{
+	m_sharedMemory->getCondition().notify_all();
+}
+
+bool SharedMemory::ScopedAccess::waitForNotification(size_t timeoutMs)
+{
+	const bool notified = m_sharedMemory->getCondition().timed_wait(
+		*this,
+		boost::posix_time::microsec_clock::universal_time() +
+			boost::posix_time::milliseconds(timeoutMs));
+
+	// another process may have grown the memory in the meantime
+	m_memory = boost::interprocess::managed_shared_memory();
+	m_memory = boost::interprocess::managed_shared_memory(
+		boost::interprocess::open_only, m_memoryName.c_str());
+
+	return notified;
+}
+
 
 std::string SharedMemory::checkName(const std::string& name)
 {
@@ -122,6 +146,7 @@ void SharedMemory::deleteSharedMemory(const std::string& name)
 {
 	boost::interprocess::shared_memory_object::remove((s_memoryNamePrefix + name).c_str());
 	boost::interprocess::named_mutex::remove((s_mutexNamePrefix + name).c_str());
+	boost::interprocess::named_condition::remove((s_conditionNamePrefix + name).c_str());
 }
 
 SharedMemory::SharedMemory(const std::string& name, size_t initialMemorySize, AccessMode mode)
@@ -265,6 +290,11 @@ std::string SharedMemory::getMutexName() const
 	return s_mutexNamePrefix + m_name;
 }
 
+std::string SharedMemory::getConditionName() const
+{
+	return s_conditionNamePrefix + m_name;
+}
+
 boost::interprocess::named_mutex& SharedMemory::getMutex()
 {
 	if (!m_mutex)
@@ -276,6 +306,21 @@ boost::interprocess::named_mutex& SharedMemory::getMutex()
 	return *m_mutex.get();
 }
 
+boost::interprocess::named_condition& SharedMemory::getCondition()
+{
+	if (!m_condition)
+	{
+		boost::interprocess::permissions permissions;
+		permissions.set_unrestricted();
+
+		// created on first use, so processes opening the memory do not depend on its creator
+		m_condition = std::make_shared<boost::interprocess::named_condition>(
+			boost::interprocess::open_or_create, getConditionName().c_str(), permissions);
+	}
+
+	return *m_condition.get();
+}
+
 size_t SharedMemory::getInitialMemorySize() const
 {
 	return m_initialMemorySize;
@@ -9,6 +9,7 @@
 #include <boost/interprocess/containers/string.hpp>
 #include <boost/interprocess/containers/vector.hpp>
 #include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/sync/named_condition.hpp>
 #include <boost/interprocess/sync/named_mutex.hpp>
 #include <boost/interprocess/sync/scoped_lock.hpp>
 
@@ -96,7 +97,15 @@ public:
 
 		std::string logString() const;
 
+		// Wakes up all threads and processes waiting for a notification of this shared memory.
+		void notifyAll();
+
+		// Unlocks the memory until a notification arrives or timeoutMs passed, returns false on
+		// timeout. Pointers into the memory have to be accessed again afterwards.
+		bool waitForNotification(size_t timeoutMs);
+
 	private:
+		SharedMemory* m_sharedMemory;
 		boost::interprocess::managed_shared_memory m_memory;
 		std::string m_memoryName;
 		size_t m_minimumMemorySize;
@@ -107,15 +116,19 @@ public:
 private:
 	static const char* s_memoryNamePrefix;
 	static const char* s_mutexNamePrefix;
+	static const char* s_conditionNamePrefix;
 
 	std::string getMemoryName() const;
 	std::string getMutexName() const;
+	std::string getConditionName() const;
 
 	boost::interprocess::named_mutex& getMutex();
+	boost::interprocess::named_condition& getCondition();
 
 	size_t getInitialMemorySize() const;
 
 	std::shared_ptr<boost::interprocess::named_mutex> m_mutex;
+	std::shared_ptr<boost::interprocess::named_condition> m_condition;
 	std::string m_name;
 	AccessMode m_mode;
 
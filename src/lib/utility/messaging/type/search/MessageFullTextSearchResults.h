@@ -0,0 +1,46 @@
+#ifndef MESSAGE_FULLTEXT_SEARCH_RESULTS_H
+#define MESSAGE_FULLTEXT_SEARCH_RESULTS_H
+
+#include <memory>
+
+#include "Message.h"
+#include "types.h"
+
+class SourceLocationCollection;
+
+// Carries one batch of fulltext search results from the search running in the background to the
+// code view of the tab. Batches of a search with a different id are stale and get dropped.
+class MessageFullTextSearchResults: public Message<MessageFullTextSearchResults>
+{
+public:
+	MessageFullTextSearchResults(
+		Id searchId,
+		std::shared_ptr<SourceLocationCollection> collection,
+		bool isLastBatch,
+		Id schedulerId)
+		: searchId(searchId), collection(collection), isLastBatch(isLastBatch)
+	{
+		setSchedulerId(schedulerId);
+		setIsLogged(false);
+	}
+
+	static const std::string getStaticType()
+	{
+		return "MessageFullTextSearchResults";
+	}
+
+	virtual void print(std::wostream& os) const
+	{
+		os << searchId;
+		if (isLastBatch)
+		{
+			os << L" last";
+		}
+	}
+
+	const Id searchId;
+	const std::shared_ptr<SourceLocationCollection> collection;
+	const bool isLastBatch;
+};
+
+#endif	  // MESSAGE_FULLTEXT_SEARCH_RESULTS_H
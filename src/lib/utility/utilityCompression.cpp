@@ -0,0 +1,66 @@
+#include "utilityCompression.h"
+
+#include <zlib.h>
+
+namespace
+{
+const size_t s_sizeByteCount = 4;
+}
+
+namespace utility
+{
+std::string compress(const std::string& data)
+{
+	std::string out(s_sizeByteCount, '\0');
+	for (size_t i = 0; i < s_sizeByteCount; i++)
+	{
+		out[i] = char((data.size() >> (8 * i)) & 0xFF);
+	}
+
+	uLongf compressedSize = compressBound(static_cast<uLong>(data.size()));
+	out.resize(s_sizeByteCount + compressedSize);
+	if (compress2(
+			reinterpret_cast<Bytef*>(&out[s_sizeByteCount]),
+			&compressedSize,
+			reinterpret_cast<const Bytef*>(data.data()),
+			static_cast<uLong>(data.size()),
+			Z_DEFAULT_COMPRESSION) != Z_OK)
+	{
+		return "";
+	}
+	out.resize(s_sizeByteCount + compressedSize);
+
+	return out;
+}
+
+bool decompress(const std::string& data, std::string* result)
+{
+	result->clear();
+
+	if (data.size() <= s_sizeByteCount)
+	{
+		return false;
+	}
+
+	size_t size = 0;
+	for (size_t i = 0; i < s_sizeByteCount; i++)
+	{
+		size |= size_t(static_cast<unsigned char>(data[i])) << (8 * i);
+	}
+
+	std::string out(size, '\0');
+	uLongf decompressedSize = static_cast<uLongf>(size);
+	if (uncompress(
+			reinterpret_cast<Bytef*>(&out[0]),
+			&decompressedSize,
+			reinterpret_cast<const Bytef*>(data.data() + s_sizeByteCount),
+			static_cast<uLong>(data.size() - s_sizeByteCount)) != Z_OK ||
+		decompressedSize != size)
+	{
+		return false;
+	}
+
+	*result = std::move(out);
+	return true;
+}
+}	 // namespace utility
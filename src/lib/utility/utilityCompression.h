@@ -0,0 +1,16 @@
+#ifndef UTILITY_COMPRESSION_H
+#define UTILITY_COMPRESSION_H
+
+#include <string>
+
+namespace utility
+{
+// Compresses text that is stored in the database with zlib. The output starts with the uncompressed
+// size, followed by the zlib stream.
+std::string compress(const std::string& data);
+
+// Returns false and leaves result empty if data was not produced by compress().
+bool decompress(const std::string& data, std::string* result);
+}	 // namespace utility
+
+#endif	  // UTILITY_COMPRESSION_H
@@ -1,5 +1,7 @@
 #include "CxxIndexerCommandProvider.h"
 
+#include <algorithm>
+
 #include "IndexerCommandCxx.h"
 #include "logging.h"
 
@@ -176,6 +178,17 @@ size_t CxxIndexerCommandProvider::size() const
 	return m_commands.size();
 }
 
+size_t CxxIndexerCommandProvider::getCompilerFlagCount(const FilePath& filePath) const
+{
+	size_t compilerFlagCount = 0;
+	const auto range = m_commands.equal_range(filePath);
+	for (auto it = range.first; it != range.second; it++)
+	{
+		compilerFlagCount = std::max(compilerFlagCount, it->second->m_compilerFlagIds.size());
+	}
+	return compilerFlagCount;
+}
+
 void CxxIndexerCommandProvider::logStats() const
 {
 	LOG_INFO("CxxIndexerCommandProvider stats:");
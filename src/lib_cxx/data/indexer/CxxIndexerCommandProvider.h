@@ -22,6 +22,7 @@ public:
 	std::vector<std::shared_ptr<IndexerCommand>> consumeAllCommands() override;
 	void clear() override;
 	size_t size() const override;
+	size_t getCompilerFlagCount(const FilePath& filePath) const override;
 	void logStats() const;
 
 private:
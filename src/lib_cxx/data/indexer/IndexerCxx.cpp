@@ -1,20 +1,103 @@
 #include "IndexerCxx.h"
 
+#include <algorithm>
+#include <thread>
+
+#include "ApplicationSettings.h"
+#include "CxxFileCache.h"
 #include "CxxParser.h"
 #include "FileRegister.h"
+#include "HeaderClaimRegistry.h"
+#include "IntermediateStorage.h"
+
+namespace
+{
+// the setting covers all indexers, which run in parallel threads or processes
+size_t getFileCacheByteCount()
+{
+	std::shared_ptr<ApplicationSettings> appSettings = ApplicationSettings::getInstance();
+
+	int indexerCount = appSettings->getIndexerThreadCount();
+	if (indexerCount <= 0)
+	{
+		indexerCount = int(std::thread::hardware_concurrency());
+	}
+
+	return size_t(std::max(appSettings->getCxxFileCacheSize(), 0)) * 1024 * 1024 /
+		size_t(std::max(indexerCount, 1));
+}
+}	 // namespace
+
+IndexerCxx::IndexerCxx()
+	: m_fileCache(
+		  std::make_shared<CxxFileCache>(llvm::vfs::getRealFileSystem(), getFileCacheByteCount()))
+{
+}
+
+void IndexerCxx::setHeaderClaimRegistry(std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry)
+{
+	m_headerClaimRegistry = headerClaimRegistry;
+}
 
 void IndexerCxx::doIndex(
 	std::shared_ptr<IndexerCommandCxx> indexerCommand,
 	std::shared_ptr<ParserClientImpl> parserClient,
 	std::shared_ptr<IndexerStateInfo> m_indexerStateInfo)
 {
-	CxxParser parser(
-		parserClient,
-		std::make_shared<FileRegister>(
+	if (m_fileRegister &&
+		m_fileRegister->hasSameIndexedFiles(
+			indexerCommand->getSourceFilePath(),
+			indexerCommand->getIndexedPaths(),
+			indexerCommand->getExcludeFilters()))
+	{
+		m_fileRegister = std::make_shared<FileRegister>(
+			indexerCommand->getSourceFilePath(), *m_fileRegister);
+	}
+	else
+	{
+		m_fileRegister = std::make_shared<FileRegister>(
 			indexerCommand->getSourceFilePath(),
 			indexerCommand->getIndexedPaths(),
-			indexerCommand->getExcludeFilters()),
-		m_indexerStateInfo);
+			indexerCommand->getExcludeFilters());
+	}
+
+	CxxParser parser(parserClient, m_fileRegister, m_indexerStateInfo);
+	parser.setHeaderClaimRegistry(m_headerClaimRegistry);
+	parser.setFileCache(m_fileCache);
 
 	parser.buildIndex(indexerCommand);
+
+	m_preprocessorContextHashes = parser.getPreprocessorContextHashes();
+}
+
+void IndexerCxx::doFinishIndex(
+	std::shared_ptr<IndexerCommandCxx> indexerCommand,
+	std::shared_ptr<const IntermediateStorage> storage)
+{
+	if (!m_headerClaimRegistry)
+	{
+		return;
+	}
+
+	// files with errors may be recorded differently by other translation units, the source file is
+	// never skipped, files without a single context hash are not claimed
+	std::map<size_t, std::vector<FilePath>> filePathsByContextHash;
+	for (const StorageFile& file: storage->getStorageFiles())
+	{
+		if (file.indexed && file.complete)
+		{
+			const FilePath filePath(file.filePath);
+			auto it = m_preprocessorContextHashes.find(filePath);
+			if (filePath != indexerCommand->getSourceFilePath() &&
+				it != m_preprocessorContextHashes.end())
+			{
+				filePathsByContextHash[it->second].push_back(filePath);
+			}
+		}
+	}
+
+	for (const auto& p: filePathsByContextHash)
+	{
+		m_headerClaimRegistry->claimHeaders(p.second, p.first);
+	}
 }
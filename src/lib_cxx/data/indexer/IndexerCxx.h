@@ -1,16 +1,43 @@
 #ifndef INDEXER_CXX_H
 #define INDEXER_CXX_H
 
+#include <map>
+
+#include "FilePath.h"
 #include "Indexer.h"
 #include "IndexerCommandCxx.h"
 
+class CxxFileCache;
+class FileRegister;
+
 class IndexerCxx: public Indexer<IndexerCommandCxx>
 {
+public:
+	IndexerCxx();
+
+	void setHeaderClaimRegistry(std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry) override;
+
 private:
 	void doIndex(
 		std::shared_ptr<IndexerCommandCxx> indexerCommand,
 		std::shared_ptr<ParserClientImpl> parserClient,
 		std::shared_ptr<IndexerStateInfo> m_indexerStateInfo) override;
+
+	// claims the complete files of the storage for translation units indexed later
+	void doFinishIndex(
+		std::shared_ptr<IndexerCommandCxx> indexerCommand,
+		std::shared_ptr<const IntermediateStorage> storage) override;
+
+	// register of the previous command, commands of the same source group share its indexed files
+	std::shared_ptr<FileRegister> m_fileRegister;
+
+	std::shared_ptr<HeaderClaimRegistry> m_headerClaimRegistry;
+
+	// context hashes of the files of the command indexed last
+	std::map<FilePath, size_t> m_preprocessorContextHashes;
+
+	// lives as long as the indexer, which indexes all commands of an indexer process
+	std::shared_ptr<CxxFileCache> m_fileCache;
 };
 
 #endif	  // INDEXER_CXX_H
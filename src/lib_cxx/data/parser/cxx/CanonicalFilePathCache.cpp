@@ -1,12 +1,23 @@
 #include "CanonicalFilePathCache.h"
 
+#include <set>
+
 #include <clang/AST/ASTContext.h>
 
+#include "CxxFileCache.h"
+#include "HeaderClaimRegistry.h"
 #include "utilityClang.h"
 #include "utilityString.h"
 
-CanonicalFilePathCache::CanonicalFilePathCache(std::shared_ptr<FileRegister> fileRegister)
+CanonicalFilePathCache::CanonicalFilePathCache(
+	std::shared_ptr<FileRegister> fileRegister,
+	std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry,
+	size_t preprocessorContextHash,
+	std::shared_ptr<CxxFileCache> fileCache)
 	: m_fileRegister(fileRegister)
+	, m_headerClaimRegistry(headerClaimRegistry)
+	, m_preprocessorContextHash(preprocessorContextHash)
+	, m_fileCache(fileCache)
 {
 }
 
@@ -56,7 +67,9 @@ FilePath CanonicalFilePathCache::getCanonicalFilePath(const std::wstring& path)
 		return it->second;
 	}
 
-	const FilePath canonicalPath = FilePath(path).makeCanonical();
+	// the file cache keeps canonical paths across translation units
+	const FilePath canonicalPath = m_fileCache ? m_fileCache->getCanonicalFilePath(path)
+											   : FilePath(path).makeCanonical();
 	const std::wstring lowercaseCanonicalPath = utility::toLowerCase(canonicalPath.wstr());
 
 	m_fileStringMap.emplace(std::move(lowercasePath), canonicalPath);
@@ -157,3 +170,61 @@ bool CanonicalFilePathCache::isProjectFile(
 	m_isProjectFileMap.emplace(fileId, ret);
 	return ret;
 }
+
+void CanonicalFilePathCache::addToPreprocessorContextHash(const clang::FileID& fileId, size_t hash)
+{
+	auto it = m_preprocessorContextHashes.emplace(fileId, m_preprocessorContextHash).first;
+	it->second = it->second * 31 + hash;
+}
+
+size_t CanonicalFilePathCache::getPreprocessorContextHash(const clang::FileID& fileId) const
+{
+	auto it = m_preprocessorContextHashes.find(fileId);
+	if (it != m_preprocessorContextHashes.end())
+	{
+		return it->second;
+	}
+	return m_preprocessorContextHash;
+}
+
+std::map<FilePath, size_t> CanonicalFilePathCache::getPreprocessorContextHashes() const
+{
+	std::map<FilePath, size_t> contextHashes;
+	std::set<FilePath> ambiguousFilePaths;
+	for (const auto& p: m_fileIdMap)
+	{
+		const size_t contextHash = getPreprocessorContextHash(p.first);
+		auto it = contextHashes.emplace(p.second, contextHash).first;
+		if (it->second != contextHash)
+		{
+			ambiguousFilePaths.insert(p.second);
+		}
+	}
+
+	for (const FilePath& filePath: ambiguousFilePaths)
+	{
+		contextHashes.erase(filePath);
+	}
+	return contextHashes;
+}
+
+bool CanonicalFilePathCache::isClaimedFile(
+	const clang::FileID& fileId, const clang::SourceManager& sourceManager)
+{
+	if (!m_headerClaimRegistry || !fileId.isValid() || fileId == sourceManager.getMainFileID())
+	{
+		return false;
+	}
+
+	auto it = m_isClaimedFileMap.find(fileId);
+	if (it != m_isClaimedFileMap.end())
+	{
+		return it->second;
+	}
+
+	bool ret = isProjectFile(fileId, sourceManager) &&
+		m_headerClaimRegistry->isHeaderClaimed(
+			getCanonicalFilePath(fileId, sourceManager), getPreprocessorContextHash(fileId));
+	m_isClaimedFileMap.emplace(fileId, ret);
+	return ret;
+}
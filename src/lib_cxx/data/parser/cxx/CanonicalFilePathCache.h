@@ -12,10 +12,17 @@
 #include "FileRegister.h"
 #include "types.h"
 
+class CxxFileCache;
+class HeaderClaimRegistry;
+
 class CanonicalFilePathCache
 {
 public:
-	CanonicalFilePathCache(std::shared_ptr<FileRegister> fileRegister);
+	CanonicalFilePathCache(
+		std::shared_ptr<FileRegister> fileRegister,
+		std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry = nullptr,
+		size_t preprocessorContextHash = 0,
+		std::shared_ptr<CxxFileCache> fileCache = nullptr);
 
 	std::shared_ptr<FileRegister> getFileRegister() const;
 
@@ -34,8 +41,24 @@ public:
 
 	bool isProjectFile(const clang::FileID& fileId, const clang::SourceManager& sourceManager);
 
+	// Adds to the hash of what the preprocessor made of the file, which starts at the flags hash.
+	void addToPreprocessorContextHash(const clang::FileID& fileId, size_t hash);
+	size_t getPreprocessorContextHash(const clang::FileID& fileId) const;
+
+	// Context hashes of the files preprocessed in a single context, files included several times
+	// with different results are left out.
+	std::map<FilePath, size_t> getPreprocessorContextHashes() const;
+
+	// Returns whether another translation unit already recorded the project file completely in the
+	// same preprocessor context. The file is still indexed, but only code generated for this
+	// translation unit needs recording. Only valid after preprocessing finished.
+	bool isClaimedFile(const clang::FileID& fileId, const clang::SourceManager& sourceManager);
+
 private:
 	std::shared_ptr<FileRegister> m_fileRegister;
+	std::shared_ptr<HeaderClaimRegistry> m_headerClaimRegistry;
+	const size_t m_preprocessorContextHash;
+	std::shared_ptr<CxxFileCache> m_fileCache;
 
 	std::map<clang::FileID, FilePath> m_fileIdMap;
 	std::unordered_map<std::wstring, FilePath> m_fileStringMap;
@@ -45,6 +68,8 @@ private:
 	std::unordered_map<std::wstring, Id> m_fileStringSymbolIdMap;
 
 	std::map<clang::FileID, bool> m_isProjectFileMap;
+	std::map<clang::FileID, bool> m_isClaimedFileMap;
+	std::map<clang::FileID, size_t> m_preprocessorContextHashes;
 };
 
 #endif	  // CANONICAL_FILE_PATH_CACHE_H
@@ -3,8 +3,10 @@
 #include <clang/AST/ASTContext.h>
 #include <clang/Lex/Preprocessor.h>
 
+#include "ApplicationSettings.h"
 #include "CanonicalFilePathCache.h"
 #include "CxxDeclNameResolver.h"
+#include "CxxNameCache.h"
 #include "CxxTypeNameResolver.h"
 #include "IndexerStateInfo.h"
 #include "ParseLocation.h"
@@ -24,6 +26,10 @@ CxxAstVisitor::CxxAstVisitor(
 	, m_client(client)
 	, m_indexerStateInfo(indexerStateInfo)
 	, m_canonicalFilePathCache(canonicalFilePathCache)
+	, m_nameCache(
+		  ApplicationSettings::getInstance()->getCxxNameCacheEnabled()
+			  ? std::make_shared<CxxNameCache>()
+			  : nullptr)
 	, m_contextComponent(this)
 	, m_declRefKindComponent(this)
 	, m_typeRefKindComponent(this)
@@ -62,10 +68,19 @@ CanonicalFilePathCache* CxxAstVisitor::getCanonicalFilePathCache() const
 	return m_canonicalFilePathCache.get();
 }
 
+CxxNameCache* CxxAstVisitor::getNameCache() const
+{
+	return m_nameCache.get();
+}
+
 void CxxAstVisitor::indexDecl(clang::Decl* d)
 {
 	LOG_INFO("starting AST traversal");
 	this->TraverseDecl(d);
+	if (m_nameCache)
+	{
+		LOG_INFO(m_nameCache->getStatsString());
+	}
 }
 
 bool CxxAstVisitor::shouldVisitTemplateInstantiations() const
@@ -145,6 +160,7 @@ bool CxxAstVisitor::checkIgnoresTypeLoc(const clang::TypeLoc& tl) const
 bool CxxAstVisitor::TraverseDecl(clang::Decl* decl)
 {
 	bool traverse = true;
+	bool isClaimedImplicitDecl = false;
 	if (decl)
 	{
 		const clang::SourceManager& sourceManager = m_astContext->getSourceManager();
@@ -171,14 +187,32 @@ bool CxxAstVisitor::TraverseDecl(clang::Decl* decl)
 			}
 
 			traverse = isLocatedInProjectFile(loc);
+
+			if (traverse && m_claimedImplicitDeclDepth == 0 && isLocatedInClaimedFile(loc))
+			{
+				// claimed files only lack what clang generated for this translation unit, like
+				// template instantiations and implicit methods, which function bodies never contain
+				isClaimedImplicitDecl = utility::isImplicit(decl);
+				traverse = isClaimedImplicitDecl || !clang::isa<clang::FunctionDecl>(decl);
+			}
 		}
 	}
 
 	if (traverse)
 	{
+		if (isClaimedImplicitDecl)
+		{
+			m_claimedImplicitDeclDepth++;
+		}
+
 		FOREACH_COMPONENT(beginTraverseDecl(decl));
 		Base::TraverseDecl(decl);
 		FOREACH_COMPONENT(endTraverseDecl(decl));
+
+		if (isClaimedImplicitDecl)
+		{
+			m_claimedImplicitDeclDepth--;
+		}
 	}
 
 	if (m_indexerStateInfo && m_indexerStateInfo->indexingInterrupted)
@@ -659,7 +693,7 @@ bool CxxAstVisitor::shouldVisitStmt(const clang::Stmt* s) const
 			loc = s->getBeginLoc();
 		}
 
-		if (isLocatedInProjectFile(loc))
+		if (isLocatedInRecordedFile(loc))
 		{
 			return true;
 		}
@@ -679,7 +713,7 @@ bool CxxAstVisitor::shouldVisitDecl(const clang::Decl* decl) const
 			loc = decl->getLocation();
 		}
 
-		if (isLocatedInProjectFile(loc))
+		if (isLocatedInRecordedFile(loc))
 		{
 			return true;
 		}
@@ -695,7 +729,7 @@ bool CxxAstVisitor::shouldVisitReference(const clang::SourceLocation& referenceL
 		loc = referenceLocation;
 	}
 
-	if (isLocatedInProjectFile(loc))
+	if (isLocatedInRecordedFile(loc))
 	{
 		return true;
 	}
@@ -713,3 +747,20 @@ bool CxxAstVisitor::isLocatedInProjectFile(clang::SourceLocation loc) const
 	const clang::SourceManager& sourceManager = m_astContext->getSourceManager();
 	return m_canonicalFilePathCache->isProjectFile(sourceManager.getFileID(loc), sourceManager);
 }
+
+bool CxxAstVisitor::isLocatedInClaimedFile(clang::SourceLocation loc) const
+{
+	if (loc.isInvalid())
+	{
+		return false;
+	}
+
+	const clang::SourceManager& sourceManager = m_astContext->getSourceManager();
+	return m_canonicalFilePathCache->isClaimedFile(sourceManager.getFileID(loc), sourceManager);
+}
+
+bool CxxAstVisitor::isLocatedInRecordedFile(clang::SourceLocation loc) const
+{
+	return isLocatedInProjectFile(loc) &&
+		(m_claimedImplicitDeclDepth > 0 || !isLocatedInClaimedFile(loc));
+}
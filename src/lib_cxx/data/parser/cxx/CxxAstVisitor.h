@@ -14,6 +14,7 @@
 #include "CxxContext.h"
 
 class CanonicalFilePathCache;
+class CxxNameCache;
 class ParserClient;
 class FilePath;
 
@@ -46,6 +47,7 @@ public:
 	T* getComponent();
 
 	CanonicalFilePathCache* getCanonicalFilePathCache() const;
+	CxxNameCache* getNameCache() const;
 
 	// Indexing entry point
 	void indexDecl(clang::Decl* d);
@@ -164,6 +166,10 @@ public:
 	bool shouldVisitReference(const clang::SourceLocation& referenceLocation) const;
 
 	bool isLocatedInProjectFile(clang::SourceLocation loc) const;
+	bool isLocatedInClaimedFile(clang::SourceLocation loc) const;
+
+	// Project files are recorded unless claimed, within implicit decls claimed files are recorded.
+	bool isLocatedInRecordedFile(clang::SourceLocation loc) const;
 
 protected:
 	typedef clang::RecursiveASTVisitor<CxxAstVisitor> Base;
@@ -173,6 +179,7 @@ protected:
 	std::shared_ptr<ParserClient> m_client;
 	std::shared_ptr<IndexerStateInfo> m_indexerStateInfo;
 	std::shared_ptr<CanonicalFilePathCache> m_canonicalFilePathCache;
+	std::shared_ptr<CxxNameCache> m_nameCache;
 
 	CxxAstVisitorComponentContext m_contextComponent;
 	CxxAstVisitorComponentDeclRefKind m_declRefKindComponent;
@@ -180,6 +187,9 @@ protected:
 	CxxAstVisitorComponentImplicitCode m_implicitCodeComponent;
 	CxxAstVisitorComponentIndexer m_indexerComponent;
 	CxxAstVisitorComponentBraceRecorder m_braceRecorderComponent;
+
+	// number of implicit decls of claimed files the traversal is currently in
+	size_t m_claimedImplicitDeclDepth = 0;
 };
 
 template <>
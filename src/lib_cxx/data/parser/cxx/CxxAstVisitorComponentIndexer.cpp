@@ -986,7 +986,9 @@ Id CxxAstVisitorComponentIndexer::getOrCreateSymbolId(const clang::NamedDecl* de
 	if (decl)
 	{
 		std::unique_ptr<CxxDeclName> declName =
-			CxxDeclNameResolver(getAstVisitor()->getCanonicalFilePathCache()).getName(decl);
+			CxxDeclNameResolver(
+				getAstVisitor()->getCanonicalFilePathCache(), getAstVisitor()->getNameCache())
+				.getName(decl);
 		if (declName)
 		{
 			symbolName = declName->toNameHierarchy();
@@ -1023,7 +1025,9 @@ Id CxxAstVisitorComponentIndexer::getOrCreateSymbolId(const clang::Type* type)
 	if (type)
 	{
 		std::unique_ptr<CxxTypeName> typeName =
-			CxxTypeNameResolver(getAstVisitor()->getCanonicalFilePathCache()).getName(type);
+			CxxTypeNameResolver(
+				getAstVisitor()->getCanonicalFilePathCache(), getAstVisitor()->getNameCache())
+				.getName(type);
 		if (typeName)
 		{
 			symbolName = typeName->toNameHierarchy();
@@ -0,0 +1,248 @@
+#include "CxxFileCache.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/Path.h>
+
+#include "utilityString.h"
+
+namespace
+{
+class CachedFile: public llvm::vfs::File
+{
+public:
+	CachedFile(const llvm::vfs::Status& status, const llvm::MemoryBuffer& content)
+		: m_status(status), m_content(content.getBuffer())
+	{
+	}
+
+	llvm::ErrorOr<llvm::vfs::Status> status() override
+	{
+		return m_status;
+	}
+
+	llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> getBuffer(
+		const llvm::Twine& name,
+		int64_t fileSize,
+		bool requiresNullTerminator,
+		bool isVolatile) override
+	{
+		// the cached content stays alive until the translation unit is finished
+		return llvm::MemoryBuffer::getMemBuffer(m_content, name.str(), requiresNullTerminator);
+	}
+
+	std::error_code close() override
+	{
+		return std::error_code();
+	}
+
+private:
+	const llvm::vfs::Status m_status;
+	const llvm::StringRef m_content;
+};
+
+bool isSameFile(
+	const std::error_code& error,
+	const llvm::vfs::Status& status,
+	const llvm::ErrorOr<llvm::vfs::Status>& newStatus)
+{
+	if (error || !newStatus)
+	{
+		return error && !newStatus;
+	}
+
+	return status.getType() == newStatus->getType() && status.getSize() == newStatus->getSize() &&
+		status.getLastModificationTime() == newStatus->getLastModificationTime();
+}
+
+std::string getPercentString(size_t count, size_t totalCount)
+{
+	return std::to_string(totalCount ? count * 100 / totalCount : 0) + "%";
+}
+}	 // namespace
+
+class CxxFileCache::CachingFileSystem: public llvm::vfs::ProxyFileSystem
+{
+public:
+	explicit CachingFileSystem(CxxFileCache* cache)
+		: llvm::vfs::ProxyFileSystem(cache->m_baseFileSystem), m_cache(cache)
+	{
+	}
+
+	llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path) override
+	{
+		return m_cache->status(path);
+	}
+
+	llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(
+		const llvm::Twine& path) override
+	{
+		return m_cache->openFileForRead(path);
+	}
+
+private:
+	CxxFileCache* m_cache;
+};
+
+CxxFileCache::CxxFileCache(
+	llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> baseFileSystem, size_t maximumCachedByteCount)
+	: m_baseFileSystem(baseFileSystem), m_maximumCachedByteCount(maximumCachedByteCount)
+{
+}
+
+void CxxFileCache::startTranslationUnit()
+{
+	m_translationUnitIndex++;
+}
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> CxxFileCache::getFileSystem()
+{
+	return new CachingFileSystem(this);
+}
+
+FilePath CxxFileCache::getCanonicalFilePath(const std::wstring& path)
+{
+	m_stats.canonicalPathRequestCount++;
+
+	// only existing files are cached, their canonical path is dropped with their content
+	Entry& entry = getEntry(utility::encodeToUtf8(path));
+	if (entry.error)
+	{
+		return FilePath(path).makeCanonical();
+	}
+
+	if (entry.canonicalPath.empty())
+	{
+		entry.canonicalPath = FilePath(path).makeCanonical();
+	}
+	else
+	{
+		m_stats.canonicalPathHitCount++;
+	}
+	return entry.canonicalPath;
+}
+
+const CxxFileCache::Stats& CxxFileCache::getStats() const
+{
+	return m_stats;
+}
+
+std::string CxxFileCache::getStatsString() const
+{
+	return "File cache: " + getPercentString(m_stats.statusHitCount, m_stats.statusRequestCount) +
+		" of " + std::to_string(m_stats.statusRequestCount) + " stats, " +
+		getPercentString(m_stats.readHitCount, m_stats.readRequestCount) + " of " +
+		std::to_string(m_stats.readRequestCount) + " reads, " +
+		getPercentString(m_stats.canonicalPathHitCount, m_stats.canonicalPathRequestCount) +
+		" of " + std::to_string(m_stats.canonicalPathRequestCount) +
+		" canonical paths cached; " + std::to_string(m_stats.savedByteCount) +
+		" bytes not read again, " + std::to_string(m_cachedByteCount) + " bytes cached";
+}
+
+CxxFileCache::Entry& CxxFileCache::getEntry(const llvm::Twine& path, bool* wasChecked)
+{
+	llvm::SmallString<256> absolutePath;
+	path.toVector(absolutePath);
+	m_baseFileSystem->makeAbsolute(absolutePath);
+	llvm::sys::path::remove_dots(absolutePath);
+
+	Entry& entry = m_entries[absolutePath.str().str()];
+	if (entry.translationUnitIndex == m_translationUnitIndex)
+	{
+		if (wasChecked)
+		{
+			*wasChecked = true;
+		}
+		return entry;
+	}
+
+	const llvm::ErrorOr<llvm::vfs::Status> status = m_baseFileSystem->status(absolutePath);
+	if (!isSameFile(entry.error, entry.status, status))
+	{
+		if (entry.content)
+		{
+			m_cachedByteCount -= entry.content->getBufferSize();
+			entry.content.reset();
+		}
+		entry.canonicalPath = FilePath();
+	}
+
+	if (status)
+	{
+		entry.error = std::error_code();
+		entry.status = *status;
+	}
+	else
+	{
+		entry.error = status.getError();
+		entry.status = llvm::vfs::Status();
+	}
+	entry.translationUnitIndex = m_translationUnitIndex;
+
+	if (wasChecked)
+	{
+		*wasChecked = false;
+	}
+	return entry;
+}
+
+llvm::ErrorOr<llvm::vfs::Status> CxxFileCache::status(const llvm::Twine& path)
+{
+	m_stats.statusRequestCount++;
+
+	bool wasChecked = false;
+	const Entry& entry = getEntry(path, &wasChecked);
+	if (wasChecked)
+	{
+		m_stats.statusHitCount++;
+	}
+
+	if (entry.error)
+	{
+		return entry.error;
+	}
+	return llvm::vfs::Status::copyWithNewName(entry.status, path);
+}
+
+llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> CxxFileCache::openFileForRead(
+	const llvm::Twine& path)
+{
+	m_stats.readRequestCount++;
+
+	Entry& entry = getEntry(path);
+	if (entry.error)
+	{
+		return entry.error;
+	}
+
+	if (!entry.status.isRegularFile())
+	{
+		return m_baseFileSystem->openFileForRead(path);
+	}
+
+	const llvm::vfs::Status status = llvm::vfs::Status::copyWithNewName(entry.status, path);
+	if (entry.content)
+	{
+		m_stats.readHitCount++;
+		m_stats.savedByteCount += entry.content->getBufferSize();
+		return std::unique_ptr<llvm::vfs::File>(new CachedFile(status, *entry.content));
+	}
+
+	llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> file = m_baseFileSystem->openFileForRead(path);
+	if (!file || m_cachedByteCount + entry.status.getSize() > m_maximumCachedByteCount)
+	{
+		return file;
+	}
+
+	llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = (*file)->getBuffer(
+		path, entry.status.getSize(), true, false);
+	if (!buffer)
+	{
+		return buffer.getError();
+	}
+
+	// a copy is not affected by later changes to a memory mapped file
+	entry.content = llvm::MemoryBuffer::getMemBufferCopy((*buffer)->getBuffer(), path.str());
+	m_cachedByteCount += entry.content->getBufferSize();
+
+	return std::unique_ptr<llvm::vfs::File>(new CachedFile(status, *entry.content));
+}
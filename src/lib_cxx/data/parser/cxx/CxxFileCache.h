@@ -0,0 +1,77 @@
+#ifndef CXX_FILE_CACHE_H
+#define CXX_FILE_CACHE_H
+
+#include <memory>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/VirtualFileSystem.h>
+
+#include "FilePath.h"
+
+// Keeps the states, contents and canonical paths of the files opened by clang for the whole
+// lifetime of an indexer, so translation units sharing headers do not read and canonicalize them
+// again. A cached file is checked once per translation unit and dropped when its modification time
+// or size changed.
+class CxxFileCache
+{
+public:
+	struct Stats
+	{
+		size_t statusRequestCount = 0;
+		size_t statusHitCount = 0;
+		size_t readRequestCount = 0;
+		size_t readHitCount = 0;
+		size_t canonicalPathRequestCount = 0;
+		size_t canonicalPathHitCount = 0;
+		unsigned long long savedByteCount = 0;
+	};
+
+	explicit CxxFileCache(
+		llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> baseFileSystem =
+			llvm::vfs::getRealFileSystem(),
+		size_t maximumCachedByteCount = 512 * 1024 * 1024);
+
+	// Cached files are checked against the base file system again on their next use.
+	void startTranslationUnit();
+
+	// File system passing requests to the base file system only for files not yet checked in the
+	// current translation unit. It must not outlive the cache.
+	llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> getFileSystem();
+
+	FilePath getCanonicalFilePath(const std::wstring& path);
+
+	const Stats& getStats() const;
+	std::string getStatsString() const;
+
+private:
+	class CachingFileSystem;
+
+	struct Entry
+	{
+		size_t translationUnitIndex = 0;
+		std::error_code error;
+		llvm::vfs::Status status;
+		std::unique_ptr<llvm::MemoryBuffer> content;
+		FilePath canonicalPath;
+	};
+
+	// The entry is checked against the base file system once per translation unit.
+	Entry& getEntry(const llvm::Twine& path, bool* wasChecked = nullptr);
+
+	llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path);
+	llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(const llvm::Twine& path);
+
+	llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> m_baseFileSystem;
+	const size_t m_maximumCachedByteCount;
+
+	std::unordered_map<std::string, Entry> m_entries;
+	size_t m_translationUnitIndex = 1;
+	size_t m_cachedByteCount = 0;
+
+	Stats m_stats;
+};
+
+#endif	  // CXX_FILE_CACHE_H
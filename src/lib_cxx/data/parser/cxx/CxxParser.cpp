@@ -1,5 +1,7 @@
 #include "CxxParser.h"
 
+#include <set>
+
 #include <clang/Driver/Compilation.h>
 #include <clang/Driver/Driver.h>
 #include <clang/Driver/Options.h>
@@ -15,6 +17,7 @@
 #include "ClangInvocationInfo.h"
 #include "CxxCompilationDatabaseSingle.h"
 #include "CxxDiagnosticConsumer.h"
+#include "CxxFileCache.h"
 #include "FilePath.h"
 #include "FileRegister.h"
 #include "IndexerCommandCxx.h"
@@ -105,6 +108,50 @@ std::vector<std::string> CxxParser::getCommandlineArgumentsEssential(
 	return args;
 }
 
+std::vector<std::wstring> CxxParser::getPreprocessorContextFlags(
+	const std::vector<std::wstring>& compilerFlags, const FilePath& sourceFilePath)
+{
+	const std::set<std::wstring> outputFlags = {L"-o", L"-MF", L"-MT", L"-MQ"};
+
+	std::vector<std::wstring> contextFlags;
+	bool isOutputValue = false;
+	for (const std::wstring& compilerFlag: compilerFlags)
+	{
+		if (isOutputValue)
+		{
+			isOutputValue = false;
+			continue;
+		}
+
+		if (outputFlags.find(compilerFlag) != outputFlags.end())
+		{
+			isOutputValue = true;
+			continue;
+		}
+
+		if (compilerFlag.empty() || utility::isPostfix(compilerFlag, sourceFilePath.wstr()) ||
+			utility::isPrefix<std::wstring>(L"-o", compilerFlag) ||
+			utility::isPrefix<std::wstring>(L"/Fo", compilerFlag))
+		{
+			continue;
+		}
+
+		contextFlags.push_back(compilerFlag);
+	}
+	return contextFlags;
+}
+
+size_t CxxParser::getPreprocessorContextHash(const IndexerCommandCxx& indexerCommand)
+{
+	size_t hash = std::hash<std::wstring>()(indexerCommand.getWorkingDirectory().wstr());
+	for (const std::wstring& compilerFlag: getPreprocessorContextFlags(
+			 indexerCommand.getCompilerFlags(), indexerCommand.getSourceFilePath()))
+	{
+		hash = hash * 31 + std::hash<std::wstring>()(compilerFlag);
+	}
+	return hash;
+}
+
 void CxxParser::initializeLLVM()
 {
 	static bool intialized = false;
@@ -128,6 +175,16 @@ CxxParser::CxxParser(
 	llvm::InitializeNativeTargetAsmParser();
 }
 
+void CxxParser::setHeaderClaimRegistry(std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry)
+{
+	m_headerClaimRegistry = headerClaimRegistry;
+}
+
+void CxxParser::setFileCache(std::shared_ptr<CxxFileCache> fileCache)
+{
+	m_fileCache = fileCache;
+}
+
 void CxxParser::buildIndex(std::shared_ptr<IndexerCommandCxx> indexerCommand)
 {
 	clang::tooling::CompileCommand compileCommand;
@@ -142,7 +199,10 @@ void CxxParser::buildIndex(std::shared_ptr<IndexerCommandCxx> indexerCommand)
 	compileCommand.CommandLine = prependSyntaxOnlyToolArgs(compileCommand.CommandLine);
 
 	CxxCompilationDatabaseSingle compilationDatabase(compileCommand);
-	runTool(&compilationDatabase, indexerCommand->getSourceFilePath());
+	runTool(
+		&compilationDatabase,
+		indexerCommand->getSourceFilePath(),
+		getPreprocessorContextHash(*indexerCommand));
 }
 
 void CxxParser::buildIndex(
@@ -164,17 +224,34 @@ void CxxParser::buildIndex(
 		diagnostics.get(), action, fileContent->getText(), args, utility::encodeToUtf8(fileName));
 }
 
+const std::map<FilePath, size_t>& CxxParser::getPreprocessorContextHashes() const
+{
+	return m_preprocessorContextHashes;
+}
+
 void CxxParser::runTool(
-	clang::tooling::CompilationDatabase* compilationDatabase, const FilePath& sourceFilePath)
+	clang::tooling::CompilationDatabase* compilationDatabase,
+	const FilePath& sourceFilePath,
+	size_t preprocessorContextHash)
 {
 	initializeLLVM();
 
+	llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = llvm::vfs::getRealFileSystem();
+	if (m_fileCache)
+	{
+		m_fileCache->startTranslationUnit();
+		fileSystem = m_fileCache->getFileSystem();
+	}
+
 	clang::tooling::ClangTool tool(
 		*compilationDatabase,
-		std::vector<std::string>(1, utility::encodeToUtf8(sourceFilePath.wstr())));
+		std::vector<std::string>(1, utility::encodeToUtf8(sourceFilePath.wstr())),
+		std::make_shared<clang::PCHContainerOperations>(),
+		fileSystem);
 
 	std::shared_ptr<CanonicalFilePathCache> canonicalFilePathCache =
-		std::make_shared<CanonicalFilePathCache>(m_fileRegister);
+		std::make_shared<CanonicalFilePathCache>(
+			m_fileRegister, m_headerClaimRegistry, preprocessorContextHash, m_fileCache);
 
 	std::shared_ptr<CxxDiagnosticConsumer> diagnostics = getDiagnostics(
 		sourceFilePath, canonicalFilePathCache, true);
@@ -202,6 +279,13 @@ void CxxParser::runTool(
 		m_client, canonicalFilePathCache, m_indexerStateInfo);
 	tool.run(new SingleFrontendActionFactory(action));
 
+	m_preprocessorContextHashes = canonicalFilePathCache->getPreprocessorContextHashes();
+
+	if (m_fileCache)
+	{
+		LOG_INFO(m_fileCache->getStatsString());
+	}
+
 	if (!m_client->hasContent())
 	{
 		if (info.invocation.empty())
@@ -1,15 +1,18 @@
 #ifndef CXX_PARSER_H
 #define CXX_PARSER_H
 
+#include <map>
 #include <string>
 #include <vector>
 
+#include "FilePath.h"
 #include "Parser.h"
 
 class CanonicalFilePathCache;
 class CxxDiagnosticConsumer;
-class FilePath;
+class CxxFileCache;
 class FileRegister;
+class HeaderClaimRegistry;
 class IndexerCommandCxx;
 class TaskParseCxx;
 class TextAccess;
@@ -32,20 +35,40 @@ public:
 		const std::vector<std::wstring>& compilerFlags);
 	static void initializeLLVM();
 
+	// Compiler flags without the source file and the output files, which differ between translation
+	// units without changing how headers get preprocessed.
+	static std::vector<std::wstring> getPreprocessorContextFlags(
+		const std::vector<std::wstring>& compilerFlags, const FilePath& sourceFilePath);
+
+	// Hash of the flags that change how headers get preprocessed, the start of the context hash of
+	// every file of the translation unit.
+	static size_t getPreprocessorContextHash(const IndexerCommandCxx& indexerCommand);
+
 	CxxParser(
 		std::shared_ptr<ParserClient> client,
 		std::shared_ptr<FileRegister> fileRegister,
 		std::shared_ptr<IndexerStateInfo> indexerStateInfo);
 
+	// Headers claimed in the context of an indexer command are not recorded for it.
+	void setHeaderClaimRegistry(std::shared_ptr<HeaderClaimRegistry> headerClaimRegistry);
+
+	// Files read for an indexer command are kept in the cache for the following commands.
+	void setFileCache(std::shared_ptr<CxxFileCache> fileCache);
+
 	void buildIndex(std::shared_ptr<IndexerCommandCxx> indexerCommand);
 	void buildIndex(
 		const std::wstring& fileName,
 		std::shared_ptr<TextAccess> fileContent,
 		std::vector<std::wstring> compilerFlags = {});
 
+	// Context hashes of the files of the last indexer command, see CanonicalFilePathCache.
+	const std::map<FilePath, size_t>& getPreprocessorContextHashes() const;
+
 private:
 	void runTool(
-		clang::tooling::CompilationDatabase* compilationDatabase, const FilePath& sourceFilePath);
+		clang::tooling::CompilationDatabase* compilationDatabase,
+		const FilePath& sourceFilePath,
+		size_t preprocessorContextHash);
 
 	std::shared_ptr<CxxDiagnosticConsumer> getDiagnostics(
 		const FilePath& sourceFilePath,
@@ -56,6 +79,9 @@ private:
 
 	std::shared_ptr<FileRegister> m_fileRegister;
 	std::shared_ptr<IndexerStateInfo> m_indexerStateInfo;
+	std::shared_ptr<HeaderClaimRegistry> m_headerClaimRegistry;
+	std::shared_ptr<CxxFileCache> m_fileCache;
+	std::map<FilePath, size_t> m_preprocessorContextHashes;
 };
 
 #endif	  // CXX_PARSER_H
@@ -113,6 +113,23 @@ void PreprocessorCallbacks::MacroUndefined(
 	onMacroUsage(macroNameToken);
 }
 
+void PreprocessorCallbacks::If(
+	clang::SourceLocation location,
+	clang::SourceRange conditionRange,
+	ConditionValueKind conditionValue)
+{
+	addToPreprocessorContextHash(location, conditionValue);
+}
+
+void PreprocessorCallbacks::Elif(
+	clang::SourceLocation location,
+	clang::SourceRange conditionRange,
+	ConditionValueKind conditionValue,
+	clang::SourceLocation ifLocation)
+{
+	addToPreprocessorContextHash(location, conditionValue);
+}
+
 void PreprocessorCallbacks::Defined(
 	const clang::Token& macroNameToken,
 	const clang::MacroDefinition& macroDefinition,
@@ -126,6 +143,7 @@ void PreprocessorCallbacks::Ifdef(
 	const clang::Token& macroNameToken,
 	const clang::MacroDefinition& macroDefinition)
 {
+	addToPreprocessorContextHash(location, macroDefinition ? 1 : 0);
 	onMacroUsage(macroNameToken);
 }
 void PreprocessorCallbacks::Ifndef(
@@ -133,6 +151,7 @@ void PreprocessorCallbacks::Ifndef(
 	const clang::Token& macroNameToken,
 	const clang::MacroDefinition& macroDefinition)
 {
+	addToPreprocessorContextHash(location, macroDefinition ? 1 : 0);
 	onMacroUsage(macroNameToken);
 }
 
@@ -142,6 +161,8 @@ void PreprocessorCallbacks::MacroExpands(
 	clang::SourceRange range,
 	const clang::MacroArgs* args)
 {
+	addToPreprocessorContextHash(
+		macroNameToken.getLocation(), getMacroDefinitionHash(macroDirective));
 	onMacroUsage(macroNameToken);
 }
 
@@ -160,6 +181,42 @@ void PreprocessorCallbacks::onMacroUsage(const clang::Token& macroNameToken)
 	}
 }
 
+void PreprocessorCallbacks::addToPreprocessorContextHash(
+	clang::SourceLocation location, size_t hash)
+{
+	// nested expansions count for the file the outermost macro is expanded in
+	const clang::SourceLocation expansionLocation = m_sourceManager.getExpansionLoc(location);
+	if (expansionLocation.isValid())
+	{
+		m_canonicalFilePathCache->addToPreprocessorContextHash(
+			m_sourceManager.getFileID(expansionLocation),
+			m_sourceManager.getFileOffset(expansionLocation) * 31 + hash);
+	}
+}
+
+size_t PreprocessorCallbacks::getMacroDefinitionHash(const clang::MacroDefinition& macroDefinition)
+{
+	const clang::MacroInfo* macroInfo = macroDefinition.getMacroInfo();
+	if (!macroInfo || macroInfo->isBuiltinMacro() || macroInfo->getDefinitionLoc().isInvalid())
+	{
+		return 1;
+	}
+
+	// the location identifies the definition, definitions outside of files come from the flags
+	const clang::SourceLocation location = m_sourceManager.getSpellingLoc(
+		macroInfo->getDefinitionLoc());
+	const clang::FileID fileId = m_sourceManager.getFileID(location);
+
+	auto it = m_filePathHashes.find(fileId);
+	if (it == m_filePathHashes.end())
+	{
+		const FilePath filePath = m_canonicalFilePathCache->getCanonicalFilePath(
+			fileId, m_sourceManager);
+		it = m_filePathHashes.emplace(fileId, std::hash<std::wstring>()(filePath.wstr())).first;
+	}
+	return it->second * 31 + m_sourceManager.getFileOffset(location);
+}
+
 ParseLocation PreprocessorCallbacks::getParseLocation(const clang::Token& macroNameTok) const
 {
 	const clang::SourceLocation& location = m_sourceManager.getSpellingLoc(macroNameTok.getLocation());
@@ -1,6 +1,7 @@
 #ifndef PREPROCESSOR_CALLBACKS_H
 #define PREPROCESSOR_CALLBACKS_H
 
+#include <map>
 #include <memory>
 #include <set>
 
@@ -50,6 +51,16 @@ public:
 		const clang::MacroDefinition& macroDefinition,
 		const clang::MacroDirective* macroUndefinition) override;
 
+	void If(
+		clang::SourceLocation location,
+		clang::SourceRange conditionRange,
+		ConditionValueKind conditionValue) override;
+	void Elif(
+		clang::SourceLocation location,
+		clang::SourceRange conditionRange,
+		ConditionValueKind conditionValue,
+		clang::SourceLocation ifLocation) override;
+
 	void Defined(
 		const clang::Token& macroNameToken,
 		const clang::MacroDefinition& macroDefinition,
@@ -72,6 +83,11 @@ public:
 private:
 	void onMacroUsage(const clang::Token& macroNameToken);
 
+	// The tokens of a file only depend on the flags, the taken branches and the expanded macro
+	// definitions, so files with equal hashes get recorded the same way.
+	void addToPreprocessorContextHash(clang::SourceLocation location, size_t hash);
+	size_t getMacroDefinitionHash(const clang::MacroDefinition& macroDefinition);
+
 	ParseLocation getParseLocation(const clang::Token& macroNameToc) const;
 	ParseLocation getParseLocation(const clang::MacroInfo* macroNameToc) const;
 	ParseLocation getParseLocation(const clang::SourceRange& sourceRange) const;
@@ -85,6 +101,7 @@ private:
 	bool m_currentPathIsProjectFile = false;
 
 	std::set<clang::FileID> m_fileWasRecorded;
+	std::map<clang::FileID, size_t> m_filePathHashes;
 };
 
 #endif	  // PREPROCESSOR_CALLBACKS_H
@@ -4,6 +4,7 @@
 
 #include "CanonicalFilePathCache.h"
 #include "CxxFunctionDeclName.h"
+#include "CxxNameCache.h"
 #include "CxxSpecifierNameResolver.h"
 #include "CxxStaticFunctionDeclName.h"
 #include "CxxTemplateArgumentNameResolver.h"
@@ -14,8 +15,9 @@
 #include "utilityClang.h"
 #include "utilityString.h"
 
-CxxDeclNameResolver::CxxDeclNameResolver(CanonicalFilePathCache* canonicalFilePathCache)
-	: CxxNameResolver(canonicalFilePathCache), m_currentDecl(nullptr)
+CxxDeclNameResolver::CxxDeclNameResolver(
+	CanonicalFilePathCache* canonicalFilePathCache, CxxNameCache* nameCache)
+	: CxxNameResolver(canonicalFilePathCache, nameCache), m_currentDecl(nullptr)
 {
 }
 
@@ -72,9 +74,29 @@ std::unique_ptr<CxxDeclName> CxxDeclNameResolver::getName(const clang::NamedDecl
 	return declName;
 }
 
-std::unique_ptr<CxxName> CxxDeclNameResolver::getContextName(const clang::DeclContext* declContext)
+std::shared_ptr<CxxName> CxxDeclNameResolver::getContextName(const clang::DeclContext* declContext)
 {
-	std::unique_ptr<CxxName> contextDeclName;
+	CxxNameCache* nameCache = getNameCache();
+	if (!declContext || !nameCache)
+	{
+		return getUncachedContextName(declContext);
+	}
+
+	std::shared_ptr<CxxName> contextName;
+	if (!nameCache->getContextName(declContext, getIgnoredContextDecls(), contextName))
+	{
+		nameCache->startResolving();
+		contextName = getUncachedContextName(declContext);
+		nameCache->addContextName(
+			declContext, getIgnoredContextDecls(), nameCache->finishResolving(), contextName);
+	}
+	return contextName;
+}
+
+std::shared_ptr<CxxName> CxxDeclNameResolver::getUncachedContextName(
+	const clang::DeclContext* declContext)
+{
+	std::shared_ptr<CxxName> contextDeclName;
 
 	if (declContext && !ignoresContext(declContext))
 	{
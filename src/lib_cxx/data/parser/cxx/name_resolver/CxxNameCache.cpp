@@ -0,0 +1,144 @@
+#include "CxxNameCache.h"
+
+#include <algorithm>
+
+namespace
+{
+std::string getPercentString(size_t count, size_t totalCount)
+{
+	return std::to_string(totalCount ? count * 100 / totalCount : 0) + "%";
+}
+}	 // namespace
+
+bool CxxNameCache::getContextName(
+	const clang::DeclContext* declContext,
+	const std::vector<const clang::Decl*>& ignoredContextDecls,
+	std::shared_ptr<CxxName>& contextName)
+{
+	m_stats.contextNameRequestCount++;
+
+	auto it = m_contextNames.find(declContext);
+	if (it == m_contextNames.end() || ignoresAny(ignoredContextDecls, it->second.contextDecls))
+	{
+		return false;
+	}
+
+	m_stats.contextNameHitCount++;
+	recordContextDecls(it->second.contextDecls);
+	contextName = it->second.name;
+	return true;
+}
+
+void CxxNameCache::addContextName(
+	const clang::DeclContext* declContext,
+	const std::vector<const clang::Decl*>& ignoredContextDecls,
+	const std::vector<const clang::Decl*>& contextDecls,
+	std::shared_ptr<CxxName> contextName)
+{
+	if (!ignoresAny(ignoredContextDecls, contextDecls))
+	{
+		m_contextNames[declContext] = {std::move(contextName), contextDecls};
+	}
+}
+
+bool CxxNameCache::getTypeName(
+	const clang::Type* type,
+	const std::vector<const clang::Decl*>& ignoredContextDecls,
+	std::unique_ptr<CxxTypeName>& typeName)
+{
+	m_stats.typeNameRequestCount++;
+
+	auto it = m_typeNames.find(type);
+	if (it == m_typeNames.end() || ignoresAny(ignoredContextDecls, it->second.contextDecls))
+	{
+		return false;
+	}
+
+	m_stats.typeNameHitCount++;
+	recordContextDecls(it->second.contextDecls);
+	if (it->second.name)
+	{
+		typeName = std::make_unique<CxxTypeName>(*it->second.name);
+	}
+	else
+	{
+		typeName.reset();
+	}
+	return true;
+}
+
+void CxxNameCache::addTypeName(
+	const clang::Type* type,
+	const std::vector<const clang::Decl*>& ignoredContextDecls,
+	const std::vector<const clang::Decl*>& contextDecls,
+	const CxxTypeName* typeName)
+{
+	if (!ignoresAny(ignoredContextDecls, contextDecls))
+	{
+		m_typeNames[type] = {
+			typeName ? std::make_shared<const CxxTypeName>(*typeName) : nullptr, contextDecls};
+	}
+}
+
+void CxxNameCache::startResolving()
+{
+	m_recordedContextDecls.emplace_back();
+}
+
+std::vector<const clang::Decl*> CxxNameCache::finishResolving()
+{
+	std::vector<const clang::Decl*> contextDecls = std::move(m_recordedContextDecls.back());
+	m_recordedContextDecls.pop_back();
+
+	std::sort(contextDecls.begin(), contextDecls.end());
+	contextDecls.erase(std::unique(contextDecls.begin(), contextDecls.end()), contextDecls.end());
+
+	// the enclosing name depends on the same contexts
+	recordContextDecls(contextDecls);
+	return contextDecls;
+}
+
+void CxxNameCache::recordContextDecl(const clang::Decl* decl)
+{
+	if (!m_recordedContextDecls.empty())
+	{
+		m_recordedContextDecls.back().push_back(decl);
+	}
+}
+
+const CxxNameCache::Stats& CxxNameCache::getStats() const
+{
+	return m_stats;
+}
+
+std::string CxxNameCache::getStatsString() const
+{
+	return "Name cache: " +
+		getPercentString(m_stats.contextNameHitCount, m_stats.contextNameRequestCount) + " of " +
+		std::to_string(m_stats.contextNameRequestCount) + " context names, " +
+		getPercentString(m_stats.typeNameHitCount, m_stats.typeNameRequestCount) + " of " +
+		std::to_string(m_stats.typeNameRequestCount) + " type names cached";
+}
+
+bool CxxNameCache::ignoresAny(
+	const std::vector<const clang::Decl*>& ignoredContextDecls,
+	const std::vector<const clang::Decl*>& contextDecls)
+{
+	for (const clang::Decl* ignoredDecl: ignoredContextDecls)
+	{
+		if (std::binary_search(contextDecls.begin(), contextDecls.end(), ignoredDecl))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void CxxNameCache::recordContextDecls(const std::vector<const clang::Decl*>& decls)
+{
+	if (!m_recordedContextDecls.empty())
+	{
+		std::vector<const clang::Decl*>& recordedDecls = m_recordedContextDecls.back();
+		recordedDecls.insert(recordedDecls.end(), decls.begin(), decls.end());
+	}
+}
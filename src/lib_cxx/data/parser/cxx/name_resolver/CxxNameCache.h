@@ -0,0 +1,84 @@
+#ifndef CXX_NAME_CACHE_H
+#define CXX_NAME_CACHE_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <clang/AST/Decl.h>
+
+#include "CxxName.h"
+#include "CxxTypeName.h"
+
+// Keeps the names of decl contexts and types resolved within one translation unit, so the context
+// chains and template arguments shared by many symbols are only resolved once. Names are keyed by
+// pointers into the translation unit's AST, so the cache must not outlive its translation unit.
+//
+// Along with each name the cache records the context decls consulted while resolving it, a resolver
+// ignoring one of these contexts would resolve a different name and does not use the cached one.
+class CxxNameCache
+{
+public:
+	struct Stats
+	{
+		size_t contextNameRequestCount = 0;
+		size_t contextNameHitCount = 0;
+		size_t typeNameRequestCount = 0;
+		size_t typeNameHitCount = 0;
+	};
+
+	// Context names are shared by all names resolved within the context and must not be modified.
+	bool getContextName(
+		const clang::DeclContext* declContext,
+		const std::vector<const clang::Decl*>& ignoredContextDecls,
+		std::shared_ptr<CxxName>& contextName);
+	void addContextName(
+		const clang::DeclContext* declContext,
+		const std::vector<const clang::Decl*>& ignoredContextDecls,
+		const std::vector<const clang::Decl*>& contextDecls,
+		std::shared_ptr<CxxName> contextName);
+
+	// Type names are returned as copies, so the caller may add qualifiers and modifiers.
+	bool getTypeName(
+		const clang::Type* type,
+		const std::vector<const clang::Decl*>& ignoredContextDecls,
+		std::unique_ptr<CxxTypeName>& typeName);
+	void addTypeName(
+		const clang::Type* type,
+		const std::vector<const clang::Decl*>& ignoredContextDecls,
+		const std::vector<const clang::Decl*>& contextDecls,
+		const CxxTypeName* typeName);
+
+	// Calls to startResolving and finishResolving enclose the resolution of a name, finishResolving
+	// returns the context decls consulted since the matching startResolving.
+	void startResolving();
+	std::vector<const clang::Decl*> finishResolving();
+	void recordContextDecl(const clang::Decl* decl);
+
+	const Stats& getStats() const;
+	std::string getStatsString() const;
+
+private:
+	template <typename NameType>
+	struct Entry
+	{
+		NameType name;
+		std::vector<const clang::Decl*> contextDecls;
+	};
+
+	static bool ignoresAny(
+		const std::vector<const clang::Decl*>& ignoredContextDecls,
+		const std::vector<const clang::Decl*>& contextDecls);
+
+	void recordContextDecls(const std::vector<const clang::Decl*>& decls);
+
+	std::unordered_map<const clang::DeclContext*, Entry<std::shared_ptr<CxxName>>> m_contextNames;
+	std::unordered_map<const clang::Type*, Entry<std::shared_ptr<const CxxTypeName>>> m_typeNames;
+
+	std::vector<std::vector<const clang::Decl*>> m_recordedContextDecls;
+
+	Stats m_stats;
+};
+
+#endif	  // CXX_NAME_CACHE_H
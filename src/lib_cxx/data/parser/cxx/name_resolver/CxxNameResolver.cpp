@@ -1,12 +1,16 @@
 #include "CxxNameResolver.h"
 
-CxxNameResolver::CxxNameResolver(CanonicalFilePathCache* canonicalFilePathCache)
-	: m_canonicalFilePathCache(canonicalFilePathCache)
+#include "CxxNameCache.h"
+
+CxxNameResolver::CxxNameResolver(
+	CanonicalFilePathCache* canonicalFilePathCache, CxxNameCache* nameCache)
+	: m_canonicalFilePathCache(canonicalFilePathCache), m_nameCache(nameCache)
 {
 }
 
 CxxNameResolver::CxxNameResolver(const CxxNameResolver* other)
 	: m_canonicalFilePathCache(other->getCanonicalFilePathCache())
+	, m_nameCache(other->getNameCache())
 	, m_ignoredContextDecls(other->getIgnoredContextDecls())
 {
 }
@@ -23,6 +27,12 @@ bool CxxNameResolver::ignoresContext(const clang::Decl* decl) const
 {
 	if (decl)
 	{
+		if (m_nameCache)
+		{
+			// the resolved name depends on whether this context is ignored
+			m_nameCache->recordContextDecl(decl);
+		}
+
 		for (const clang::Decl* ignoredDecl: m_ignoredContextDecls)
 		{
 			if (decl == ignoredDecl)
@@ -48,6 +58,11 @@ CanonicalFilePathCache* CxxNameResolver::getCanonicalFilePathCache() const
 	return m_canonicalFilePathCache;
 }
 
+CxxNameCache* CxxNameResolver::getNameCache() const
+{
+	return m_nameCache;
+}
+
 const std::vector<const clang::Decl*>& CxxNameResolver::getIgnoredContextDecls() const
 {
 	return m_ignoredContextDecls;
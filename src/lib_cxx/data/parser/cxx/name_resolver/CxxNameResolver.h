@@ -6,11 +6,13 @@
 #include <clang/AST/Decl.h>
 
 class CanonicalFilePathCache;
+class CxxNameCache;
 
 class CxxNameResolver
 {
 public:
-	CxxNameResolver(CanonicalFilePathCache* canonicalFilePathCache);
+	CxxNameResolver(
+		CanonicalFilePathCache* canonicalFilePathCache, CxxNameCache* nameCache = nullptr);
 	CxxNameResolver(const CxxNameResolver* other);
 
 	void ignoreContextDecl(const clang::Decl* decl);
@@ -19,10 +21,12 @@ public:
 
 protected:
 	CanonicalFilePathCache* getCanonicalFilePathCache() const;
+	CxxNameCache* getNameCache() const;
 	const std::vector<const clang::Decl*>& getIgnoredContextDecls() const;
 
 private:
 	CanonicalFilePathCache* m_canonicalFilePathCache;
+	CxxNameCache* m_nameCache;
 	std::vector<const clang::Decl*> m_ignoredContextDecls;
 };
 
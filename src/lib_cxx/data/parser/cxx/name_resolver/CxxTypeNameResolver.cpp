@@ -5,13 +5,15 @@
 #include <clang/AST/PrettyPrinter.h>
 
 #include "CxxDeclNameResolver.h"
+#include "CxxNameCache.h"
 #include "CxxSpecifierNameResolver.h"
 #include "CxxTemplateArgumentNameResolver.h"
 #include "logging.h"
 #include "utilityString.h"
 
-CxxTypeNameResolver::CxxTypeNameResolver(CanonicalFilePathCache* canonicalFilePathCache)
-	: CxxNameResolver(canonicalFilePathCache)
+CxxTypeNameResolver::CxxTypeNameResolver(
+	CanonicalFilePathCache* canonicalFilePathCache, CxxNameCache* nameCache)
+	: CxxNameResolver(canonicalFilePathCache, nameCache)
 {
 }
 
@@ -28,6 +30,26 @@ std::unique_ptr<CxxTypeName> CxxTypeNameResolver::getName(const clang::QualType&
 }
 
 std::unique_ptr<CxxTypeName> CxxTypeNameResolver::getName(const clang::Type* type)
+{
+	CxxNameCache* nameCache = getNameCache();
+	if (!type || !nameCache)
+	{
+		return getUncachedName(type);
+	}
+
+	// types are keyed including their sugar, which is part of the resolved name
+	std::unique_ptr<CxxTypeName> typeName;
+	if (!nameCache->getTypeName(type, getIgnoredContextDecls(), typeName))
+	{
+		nameCache->startResolving();
+		typeName = getUncachedName(type);
+		nameCache->addTypeName(
+			type, getIgnoredContextDecls(), nameCache->finishResolving(), typeName.get());
+	}
+	return typeName;
+}
+
+std::unique_ptr<CxxTypeName> CxxTypeNameResolver::getUncachedName(const clang::Type* type)
 {
 	if (type)
 	{
@@ -7,11 +7,15 @@
 class CxxTypeNameResolver: public CxxNameResolver
 {
 public:
-	CxxTypeNameResolver(CanonicalFilePathCache* canonicalFilePathCache);
+	CxxTypeNameResolver(
+		CanonicalFilePathCache* canonicalFilePathCache, CxxNameCache* nameCache = nullptr);
 	CxxTypeNameResolver(const CxxNameResolver* other);
 
 	std::unique_ptr<CxxTypeName> getName(const clang::QualType& qualType);
 	std::unique_ptr<CxxTypeName> getName(const clang::Type* type);
+
+private:
+	std::unique_ptr<CxxTypeName> getUncachedName(const clang::Type* type);
 };
 
 #endif	  // CXX_TYPE_NAME_RESOLVER_H
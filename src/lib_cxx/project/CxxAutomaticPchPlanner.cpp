@@ -0,0 +1,254 @@
+#include "CxxAutomaticPchPlanner.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "CxxParser.h"
+#include "IncludeDirective.h"
+#include "IncludeProcessing.h"
+#include "TextAccess.h"
+#include "utility.h"
+
+namespace
+{
+const size_t s_noCluster = ~size_t(0);
+}
+
+std::vector<std::wstring> CxxAutomaticPchPlanner::getLeadingIncludeLines(
+	const FilePath& sourceFilePath)
+{
+	if (!sourceFilePath.exists())
+	{
+		return {};
+	}
+	return getLeadingIncludeLines(TextAccess::createFromFile(sourceFilePath));
+}
+
+std::vector<std::wstring> CxxAutomaticPchPlanner::getLeadingIncludeLines(
+	std::shared_ptr<TextAccess> textAccess)
+{
+	std::vector<std::wstring> includeLines;
+
+	const FilePath directoryPath = textAccess->getFilePath().getParentDirectory();
+	for (const IncludeDirective& includeDirective:
+		 IncludeProcessing::getLeadingIncludeDirectives(textAccess))
+	{
+		if (!includeDirective.getUsesBrackets() && !directoryPath.empty())
+		{
+			const FilePath includedFilePath = directoryPath.getConcatenated(
+				includeDirective.getIncludedFile());
+			if (includedFilePath.exists())
+			{
+				includeLines.push_back(
+					L"#include \"" + includedFilePath.getCanonical().wstr() + L"\"");
+				continue;
+			}
+		}
+		includeLines.push_back(includeDirective.getDirective());
+	}
+
+	return includeLines;
+}
+
+CxxAutomaticPchPlanner::CxxAutomaticPchPlanner(const FilePath& outputDirectoryPath)
+	: m_outputDirectoryPath(outputDirectoryPath)
+{
+}
+
+size_t CxxAutomaticPchPlanner::addTranslationUnit(
+	const FilePath& sourceFilePath,
+	const FilePath& workingDirectory,
+	const std::vector<std::wstring>& compilerFlags,
+	const std::vector<std::wstring>& leadingIncludeLines)
+{
+	const size_t translationUnitId = m_translationUnits.size();
+	m_translationUnits.push_back({leadingIncludeLines, s_noCluster});
+
+	const std::wstring headerExtension = getHeaderExtension(sourceFilePath);
+	if (leadingIncludeLines.empty() || headerExtension.empty())
+	{
+		return translationUnitId;
+	}
+
+	const std::vector<std::wstring> contextFlags = CxxParser::getPreprocessorContextFlags(
+		compilerFlags, sourceFilePath);
+
+	std::wstring contextKey = workingDirectory.wstr() + L'\n' + headerExtension;
+	for (const std::wstring& contextFlag: contextFlags)
+	{
+		contextKey += L'\n' + contextFlag;
+	}
+
+	auto it = m_contextIds.find(contextKey);
+	if (it == m_contextIds.end())
+	{
+		it = m_contextIds.emplace(contextKey, m_contexts.size()).first;
+		m_contexts.push_back({workingDirectory, contextFlags, headerExtension, {}});
+	}
+	m_contexts[it->second].translationUnitIds.push_back(translationUnitId);
+
+	return translationUnitId;
+}
+
+void CxxAutomaticPchPlanner::createClusters(size_t minSourceFileCount)
+{
+	m_clusters.clear();
+	for (TranslationUnit& translationUnit: m_translationUnits)
+	{
+		translationUnit.clusterIndex = s_noCluster;
+	}
+
+	for (const Context& context: m_contexts)
+	{
+		createClusters(context, minSourceFileCount);
+	}
+}
+
+const std::vector<CxxAutomaticPchPlanner::Cluster>& CxxAutomaticPchPlanner::getClusters() const
+{
+	return m_clusters;
+}
+
+std::vector<std::wstring> CxxAutomaticPchPlanner::getIncludePchFlags(size_t translationUnitId) const
+{
+	if (translationUnitId >= m_translationUnits.size() ||
+		m_translationUnits[translationUnitId].clusterIndex == s_noCluster)
+	{
+		return {};
+	}
+
+	const Cluster& cluster = m_clusters[m_translationUnits[translationUnitId].clusterIndex];
+	// clang replaces the include by the precompiled header next to it, so the translation unit is
+	// still parsed if the precompiled header could not be generated
+	return {L"-fallow-pch-with-compiler-errors", L"-include", cluster.prefixHeaderFilePath.wstr()};
+}
+
+std::wstring CxxAutomaticPchPlanner::getHeaderExtension(const FilePath& sourceFilePath)
+{
+	// the prefix header is parsed in the language of the source file
+	const std::wstring extension = sourceFilePath.extension();
+	if (extension == L".c")
+	{
+		return L".h";
+	}
+	if (sourceFilePath.hasExtension({L".cpp", L".cxx", L".cc", L".c++", L".cp", L".C"}))
+	{
+		return L".hpp";
+	}
+	return L"";
+}
+
+void CxxAutomaticPchPlanner::createClusters(const Context& context, size_t minSourceFileCount)
+{
+	// the leading includes of all translation units form a trie, every node is a candidate prefix
+	std::vector<TrieNode> nodes(1);
+	std::map<size_t, std::vector<size_t>> nodeTranslationUnitIds;
+	for (size_t translationUnitId: context.translationUnitIds)
+	{
+		size_t nodeIndex = 0;
+		nodes[nodeIndex].translationUnitCount++;
+
+		for (const std::wstring& includeLine: m_translationUnits[translationUnitId].includeLines)
+		{
+			auto it = nodes[nodeIndex].children.find(includeLine);
+			if (it != nodes[nodeIndex].children.end())
+			{
+				nodeIndex = it->second;
+			}
+			else
+			{
+				const size_t childIndex = nodes.size();
+				nodes[nodeIndex].children.emplace(includeLine, childIndex);
+
+				TrieNode child;
+				child.depth = nodes[nodeIndex].depth + 1;
+				child.firstTranslationUnitId = translationUnitId;
+				nodes.push_back(child);
+
+				nodeIndex = childIndex;
+			}
+			nodes[nodeIndex].translationUnitCount++;
+		}
+
+		nodeTranslationUnitIds[nodeIndex].push_back(translationUnitId);
+	}
+
+	for (size_t nodeIndex: chooseClusters(nodes, 0, minSourceFileCount).nodeIndices)
+	{
+		const TrieNode& node = nodes[nodeIndex];
+		const std::vector<std::wstring>& includeLines =
+			m_translationUnits[node.firstTranslationUnitId].includeLines;
+
+		Cluster cluster;
+		cluster.workingDirectory = context.workingDirectory;
+		cluster.compilerFlags = context.compilerFlags;
+		cluster.includeLines.assign(includeLines.begin(), includeLines.begin() + node.depth);
+		cluster.sourceFileCount = node.translationUnitCount;
+
+		size_t hash = std::hash<std::wstring>()(
+			context.workingDirectory.wstr() + context.headerExtension);
+		for (const std::wstring& s: utility::concat(cluster.compilerFlags, cluster.includeLines))
+		{
+			hash = hash * 31 + std::hash<std::wstring>()(s);
+		}
+
+		const std::wstring fileName = L"automatic_" + std::to_wstring(hash);
+		cluster.prefixHeaderFilePath = m_outputDirectoryPath.getConcatenated(
+			fileName + context.headerExtension);
+		// the name that lets clang use the precompiled header when the prefix header is included
+		cluster.pchFilePath = FilePath(cluster.prefixHeaderFilePath.wstr() + L".pch");
+
+		assignToCluster(nodes, nodeIndex, nodeTranslationUnitIds, m_clusters.size());
+		m_clusters.push_back(cluster);
+	}
+}
+
+CxxAutomaticPchPlanner::ClusterChoice CxxAutomaticPchPlanner::chooseClusters(
+	const std::vector<TrieNode>& nodes, size_t nodeIndex, size_t minSourceFileCount) const
+{
+	ClusterChoice childrenChoice;
+	for (const auto& child: nodes[nodeIndex].children)
+	{
+		ClusterChoice childChoice = chooseClusters(nodes, child.second, minSourceFileCount);
+		childrenChoice.savedIncludeCount += childChoice.savedIncludeCount;
+		utility::append(childrenChoice.nodeIndices, childChoice.nodeIndices);
+	}
+
+	const TrieNode& node = nodes[nodeIndex];
+	if (node.depth > 0 && node.translationUnitCount >= std::max<size_t>(2, minSourceFileCount))
+	{
+		// building the precompiled header parses the includes once, all translation units of the
+		// cluster skip them
+		const size_t savedIncludeCount = (node.translationUnitCount - 1) * node.depth;
+		if (savedIncludeCount >= childrenChoice.savedIncludeCount)
+		{
+			ClusterChoice choice;
+			choice.savedIncludeCount = savedIncludeCount;
+			choice.nodeIndices.push_back(nodeIndex);
+			return choice;
+		}
+	}
+
+	return childrenChoice;
+}
+
+void CxxAutomaticPchPlanner::assignToCluster(
+	const std::vector<TrieNode>& nodes,
+	size_t nodeIndex,
+	const std::map<size_t, std::vector<size_t>>& nodeTranslationUnitIds,
+	size_t clusterIndex)
+{
+	auto it = nodeTranslationUnitIds.find(nodeIndex);
+	if (it != nodeTranslationUnitIds.end())
+	{
+		for (size_t translationUnitId: it->second)
+		{
+			m_translationUnits[translationUnitId].clusterIndex = clusterIndex;
+		}
+	}
+
+	for (const auto& child: nodes[nodeIndex].children)
+	{
+		assignToCluster(nodes, child.second, nodeTranslationUnitIds, clusterIndex);
+	}
+}
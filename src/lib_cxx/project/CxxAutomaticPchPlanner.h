@@ -0,0 +1,99 @@
+#ifndef CXX_AUTOMATIC_PCH_PLANNER_H
+#define CXX_AUTOMATIC_PCH_PLANNER_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FilePath.h"
+
+class TextAccess;
+
+// Groups translation units that are parsed with the same flags and start with the same include
+// directives into clusters. The translation units of a cluster share a generated prefix header
+// holding these includes, which gets precompiled once before indexing.
+class CxxAutomaticPchPlanner
+{
+public:
+	struct Cluster
+	{
+		FilePath workingDirectory;
+		std::vector<std::wstring> compilerFlags;
+		std::vector<std::wstring> includeLines;
+		FilePath prefixHeaderFilePath;
+		FilePath pchFilePath;
+		size_t sourceFileCount = 0;
+	};
+
+	// Quoted includes found next to the including file are made absolute, because the prefix header
+	// is not located next to it.
+	static std::vector<std::wstring> getLeadingIncludeLines(const FilePath& sourceFilePath);
+	static std::vector<std::wstring> getLeadingIncludeLines(std::shared_ptr<TextAccess> textAccess);
+
+	explicit CxxAutomaticPchPlanner(const FilePath& outputDirectoryPath);
+
+	// returns the id of the translation unit
+	size_t addTranslationUnit(
+		const FilePath& sourceFilePath,
+		const FilePath& workingDirectory,
+		const std::vector<std::wstring>& compilerFlags,
+		const std::vector<std::wstring>& leadingIncludeLines);
+
+	void createClusters(size_t minSourceFileCount);
+
+	const std::vector<Cluster>& getClusters() const;
+
+	// flags for including the prefix header of the translation unit's cluster, which uses the
+	// precompiled header if it exists, empty if the translation unit is not part of any cluster
+	std::vector<std::wstring> getIncludePchFlags(size_t translationUnitId) const;
+
+private:
+	struct TranslationUnit
+	{
+		std::vector<std::wstring> includeLines;
+		size_t clusterIndex;
+	};
+
+	struct Context
+	{
+		FilePath workingDirectory;
+		std::vector<std::wstring> compilerFlags;
+		std::wstring headerExtension;
+		std::vector<size_t> translationUnitIds;
+	};
+
+	struct TrieNode
+	{
+		std::map<std::wstring, size_t> children;
+		size_t depth = 0;
+		size_t translationUnitCount = 0;
+		size_t firstTranslationUnitId = 0;
+	};
+
+	struct ClusterChoice
+	{
+		size_t savedIncludeCount = 0;
+		std::vector<size_t> nodeIndices;
+	};
+
+	static std::wstring getHeaderExtension(const FilePath& sourceFilePath);
+
+	void createClusters(const Context& context, size_t minSourceFileCount);
+	ClusterChoice chooseClusters(
+		const std::vector<TrieNode>& nodes, size_t nodeIndex, size_t minSourceFileCount) const;
+	void assignToCluster(
+		const std::vector<TrieNode>& nodes,
+		size_t nodeIndex,
+		const std::map<size_t, std::vector<size_t>>& nodeTranslationUnitIds,
+		size_t clusterIndex);
+
+	const FilePath m_outputDirectoryPath;
+
+	std::vector<TranslationUnit> m_translationUnits;
+	std::vector<Context> m_contexts;
+	std::map<std::wstring, size_t> m_contextIds;
+	std::vector<Cluster> m_clusters;
+};
+
+#endif	  // CXX_AUTOMATIC_PCH_PLANNER_H
@@ -6,11 +6,14 @@
 #include "Application.h"
 #include "ApplicationSettings.h"
 #include "ClangInvocationInfo.h"
+#include "CxxAutomaticPchPlanner.h"
 #include "CxxCompilationDatabaseSingle.h"
 #include "CxxIndexerCommandProvider.h"
 #include "IndexerCommandCxx.h"
 #include "MessageStatus.h"
 #include "SourceGroupSettingsCxxCdb.h"
+#include "TaskBuildAutomaticPch.h"
+#include "TaskGroupSequence.h"
 #include "TaskLambda.h"
 #include "logging.h"
 #include "utility.h"
@@ -108,6 +111,13 @@ std::shared_ptr<IndexerCommandProvider> SourceGroupCxxCdb::getIndexerCommandProv
 		m_settings->getExcludeFiltersExpandedAndAbsolute());
 	const std::set<FilePath>& sourceFilePaths = getAllSourceFilePaths(cdb);
 
+	const bool useAutomaticPch = m_settings->getUseAutomaticPch();
+	CxxAutomaticPchPlanner automaticPchPlanner(m_settings->getAutomaticPchDirectoryPath());
+
+	std::vector<std::shared_ptr<IndexerCommandCxx>> indexerCommands;
+	// pairs of translation unit id and command index
+	std::vector<std::pair<size_t, size_t>> automaticPchCandidates;
+
 	for (const clang::tooling::CompileCommand& command: cdb->getAllCompileCommands())
 	{
 		FilePath sourcePath = FilePath(utility::decodeFromUtf8(command.Filename)).makeCanonical();
@@ -129,19 +139,67 @@ std::shared_ptr<IndexerCommandProvider> SourceGroupCxxCdb::getIndexerCommandProv
 
 			utility::removeIncludePchFlag(cdbFlags);
 
+			bool usesPch = false;
 			if (command.CommandLine.size() != cdbFlags.size())
 			{
 				utility::append(cdbFlags, includePchFlags);
+				usesPch = !includePchFlags.empty();
 			}
 
-			provider->addCommand(std::make_shared<IndexerCommandCxx>(
+			indexerCommands.push_back(std::make_shared<IndexerCommandCxx>(
 				sourcePath,
 				utility::concat(indexedHeaderPaths, {sourcePath}),
 				excludeFilters,
 				std::set<FilePathFilter>(),
 				FilePath(utility::decodeFromUtf8(command.Directory)),
 				utility::concat(cdbFlags, compilerFlags)));
+
+			if (useAutomaticPch && !usesPch)
+			{
+				const std::shared_ptr<IndexerCommandCxx>& indexerCommand = indexerCommands.back();
+				automaticPchCandidates.emplace_back(
+					automaticPchPlanner.addTranslationUnit(
+						sourcePath,
+						indexerCommand->getWorkingDirectory(),
+						indexerCommand->getCompilerFlags(),
+						CxxAutomaticPchPlanner::getLeadingIncludeLines(sourcePath)),
+					indexerCommands.size() - 1);
+			}
+		}
+	}
+
+	if (useAutomaticPch)
+	{
+		automaticPchPlanner.createClusters(2);
+
+		for (const std::pair<size_t, size_t>& candidate: automaticPchCandidates)
+		{
+			const std::vector<std::wstring> automaticPchFlags =
+				automaticPchPlanner.getIncludePchFlags(candidate.first);
+			if (!automaticPchFlags.empty())
+			{
+				const std::shared_ptr<IndexerCommandCxx> indexerCommand =
+					indexerCommands[candidate.second];
+				indexerCommands[candidate.second] = std::make_shared<IndexerCommandCxx>(
+					indexerCommand->getSourceFilePath(),
+					indexerCommand->getIndexedPaths(),
+					indexerCommand->getExcludeFilters(),
+					indexerCommand->getIncludeFilters(),
+					indexerCommand->getWorkingDirectory(),
+					utility::concat(indexerCommand->getCompilerFlags(), automaticPchFlags));
+			}
 		}
+
+		LOG_INFO(
+			"Automatic precompiled headers: " +
+			std::to_string(automaticPchPlanner.getClusters().size()) + " clusters for " +
+			std::to_string(automaticPchCandidates.size()) + " candidate source files");
+	}
+	m_automaticPchClusters = automaticPchPlanner.getClusters();
+
+	for (const std::shared_ptr<IndexerCommandCxx>& indexerCommand: indexerCommands)
+	{
+		provider->addCommand(indexerCommand);
 	}
 
 	provider->logStats();
@@ -157,6 +215,29 @@ std::vector<std::shared_ptr<IndexerCommand>> SourceGroupCxxCdb::getIndexerComman
 
 std::shared_ptr<Task> SourceGroupCxxCdb::getPreIndexTask(
 	std::shared_ptr<StorageProvider> storageProvider, std::shared_ptr<DialogView> dialogView) const
+{
+	std::shared_ptr<Task> buildPchTask = getBuildPchTask(storageProvider, dialogView);
+	if (m_automaticPchClusters.empty())
+	{
+		return buildPchTask;
+	}
+
+	return std::make_shared<TaskGroupSequence>()->addChildTasks(
+		buildPchTask, std::make_shared<TaskBuildAutomaticPch>(m_automaticPchClusters, dialogView));
+}
+
+std::shared_ptr<SourceGroupSettings> SourceGroupCxxCdb::getSourceGroupSettings()
+{
+	return m_settings;
+}
+
+std::shared_ptr<const SourceGroupSettings> SourceGroupCxxCdb::getSourceGroupSettings() const
+{
+	return m_settings;
+}
+
+std::shared_ptr<Task> SourceGroupCxxCdb::getBuildPchTask(
+	std::shared_ptr<StorageProvider> storageProvider, std::shared_ptr<DialogView> dialogView) const
 {
 	if (m_settings->getPchInputFilePath().empty())
 	{
@@ -227,16 +308,6 @@ std::shared_ptr<Task> SourceGroupCxxCdb::getPreIndexTask(
 	return utility::createBuildPchTask(m_settings.get(), compilerFlags, storageProvider, dialogView);
 }
 
-std::shared_ptr<SourceGroupSettings> SourceGroupCxxCdb::getSourceGroupSettings()
-{
-	return m_settings;
-}
-
-std::shared_ptr<const SourceGroupSettings> SourceGroupCxxCdb::getSourceGroupSettings() const
-{
-	return m_settings;
-}
-
 std::vector<std::wstring> SourceGroupCxxCdb::getBaseCompilerFlags() const
 {
 	std::vector<std::wstring> compilerFlags;
@@ -5,6 +5,7 @@
 #include <set>
 #include <vector>
 
+#include "CxxAutomaticPchPlanner.h"
 #include "SourceGroup.h"
 
 class FilePath;
@@ -38,9 +39,15 @@ public:
 private:
 	std::shared_ptr<SourceGroupSettings> getSourceGroupSettings() override;
 	std::shared_ptr<const SourceGroupSettings> getSourceGroupSettings() const override;
+	std::shared_ptr<Task> getBuildPchTask(
+		std::shared_ptr<StorageProvider> storageProvider,
+		std::shared_ptr<DialogView> dialogView) const;
 	std::vector<std::wstring> getBaseCompilerFlags() const;
 
 	std::shared_ptr<SourceGroupSettingsCxxCdb> m_settings;
+
+	// planned while creating the indexer commands, built by the pre index task
+	mutable std::vector<CxxAutomaticPchPlanner::Cluster> m_automaticPchClusters;
 };
 
 #endif	  // SOURCE_GROUP_CXX_CDB_H
@@ -0,0 +1,124 @@
+#include "TaskBuildAutomaticPch.h"
+
+#include <fstream>
+
+#include "Blackboard.h"
+#include "DialogView.h"
+#include "FileSystem.h"
+#include "TimeStamp.h"
+#include "logging.h"
+#include "utilitySourceGroupCxx.h"
+#include "utilityString.h"
+
+TaskBuildAutomaticPch::TaskBuildAutomaticPch(
+	const std::vector<CxxAutomaticPchPlanner::Cluster>& clusters,
+	std::shared_ptr<DialogView> dialogView)
+	: m_clusters(clusters), m_dialogView(dialogView)
+{
+}
+
+void TaskBuildAutomaticPch::doEnter(std::shared_ptr<Blackboard> blackboard) {}
+
+Task::TaskState TaskBuildAutomaticPch::doUpdate(std::shared_ptr<Blackboard> blackboard)
+{
+	if (m_clusters.empty())
+	{
+		return STATE_SUCCESS;
+	}
+
+	TimeStamp start = TimeStamp::now();
+
+	int sourceFileCount = 0;
+	double pchBuildTime = 0.0;
+	for (size_t i = 0; i < m_clusters.size(); i++)
+	{
+		const CxxAutomaticPchPlanner::Cluster& cluster = m_clusters[i];
+
+		m_dialogView->showProgressDialog(
+			L"Preparing Indexing",
+			L"Building Automatic Precompiled Headers\n" + std::to_wstring(i + 1) + L" of " +
+				std::to_wstring(m_clusters.size()),
+			i * 100 / m_clusters.size());
+
+		if (!writePrefixHeader(cluster))
+		{
+			continue;
+		}
+
+		// the compiler executable of the compile command is not an argument
+		std::vector<std::wstring> compilerFlags = cluster.compilerFlags;
+		if (!compilerFlags.empty() && !utility::isPrefix<std::wstring>(L"-", compilerFlags.front()))
+		{
+			compilerFlags.erase(compilerFlags.begin());
+		}
+
+		FileSystem::remove(cluster.pchFilePath);
+
+		TimeStamp clusterStart = TimeStamp::now();
+		if (!utility::generatePch(
+				cluster.prefixHeaderFilePath,
+				cluster.pchFilePath,
+				cluster.workingDirectory,
+				compilerFlags,
+				nullptr))
+		{
+			LOG_ERROR(
+				L"Failed to generate automatic precompiled header \"" + cluster.pchFilePath.wstr() +
+				L"\"");
+			continue;
+		}
+
+		const double duration = TimeStamp::durationSeconds(clusterStart);
+		sourceFileCount += static_cast<int>(cluster.sourceFileCount);
+		pchBuildTime += duration;
+
+		LOG_INFO(
+			L"Generated automatic precompiled header \"" + cluster.pchFilePath.wstr() + L"\" of " +
+			std::to_wstring(cluster.includeLines.size()) + L" includes for " +
+			std::to_wstring(cluster.sourceFileCount) + L" source files in " +
+			utility::decodeFromUtf8(TimeStamp::secondsToString(duration)));
+	}
+
+	m_dialogView->hideProgressDialog();
+
+	const float buildTime = static_cast<float>(TimeStamp::durationSeconds(start));
+	blackboard->update<float>(
+		"index_time", [buildTime](float currentDuration) { return currentDuration + buildTime; });
+	blackboard->update<int>("automatic_pch_source_file_count", [sourceFileCount](int count) {
+		return count + sourceFileCount;
+	});
+	blackboard->update<float>("automatic_pch_build_time", [pchBuildTime](float currentTime) {
+		return currentTime + static_cast<float>(pchBuildTime);
+	});
+
+	return STATE_SUCCESS;
+}
+
+void TaskBuildAutomaticPch::doExit(std::shared_ptr<Blackboard> blackboard) {}
+
+void TaskBuildAutomaticPch::doReset(std::shared_ptr<Blackboard> blackboard) {}
+
+bool TaskBuildAutomaticPch::writePrefixHeader(const CxxAutomaticPchPlanner::Cluster& cluster) const
+{
+	if (!cluster.prefixHeaderFilePath.getParentDirectory().exists())
+	{
+		FileSystem::createDirectory(cluster.prefixHeaderFilePath.getParentDirectory());
+	}
+
+	std::ofstream fileStream;
+	fileStream.open(cluster.prefixHeaderFilePath.str(), std::ios::out | std::ios::trunc);
+	for (const std::wstring& includeLine: cluster.includeLines)
+	{
+		fileStream << utility::encodeToUtf8(includeLine) << "\n";
+	}
+	fileStream.close();
+
+	if (fileStream.fail())
+	{
+		LOG_ERROR(
+			L"Unable to write automatic precompiled header input file \"" +
+			cluster.prefixHeaderFilePath.wstr() + L"\"");
+		return false;
+	}
+	return true;
+}
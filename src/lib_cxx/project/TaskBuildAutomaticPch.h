@@ -0,0 +1,32 @@
+#ifndef TASK_BUILD_AUTOMATIC_PCH_H
+#define TASK_BUILD_AUTOMATIC_PCH_H
+
+#include <vector>
+
+#include "CxxAutomaticPchPlanner.h"
+#include "Task.h"
+
+class DialogView;
+
+// Writes the prefix headers of the automatic precompiled header clusters and precompiles them. The
+// parse time the precompiled headers save is stored on the blackboard for the indexing summary.
+class TaskBuildAutomaticPch: public Task
+{
+public:
+	TaskBuildAutomaticPch(
+		const std::vector<CxxAutomaticPchPlanner::Cluster>& clusters,
+		std::shared_ptr<DialogView> dialogView);
+
+private:
+	void doEnter(std::shared_ptr<Blackboard> blackboard) override;
+	TaskState doUpdate(std::shared_ptr<Blackboard> blackboard) override;
+	void doExit(std::shared_ptr<Blackboard> blackboard) override;
+	void doReset(std::shared_ptr<Blackboard> blackboard) override;
+
+	bool writePrefixHeader(const CxxAutomaticPchPlanner::Cluster& cluster) const;
+
+	const std::vector<CxxAutomaticPchPlanner::Cluster> m_clusters;
+	std::shared_ptr<DialogView> m_dialogView;
+};
+
+#endif	  // TASK_BUILD_AUTOMATIC_PCH_H
@@ -47,10 +47,6 @@ std::shared_ptr<Task> createBuildPchTask(
 										   .replaceExtension(L"pch");
 
 	utility::removeIncludePchFlag(compilerFlags);
-	compilerFlags.push_back(pchInputFilePath.wstr());
-	compilerFlags.push_back(L"-emit-pch");
-	compilerFlags.push_back(L"-o");
-	compilerFlags.push_back(pchOutputFilePath.wstr());
 
 	return std::make_shared<TaskLambda>(
 		[dialogView, storageProvider, pchInputFilePath, pchOutputFilePath, compilerFlags]() {
@@ -60,46 +56,69 @@ std::shared_ptr<Task> createBuildPchTask(
 				L"Generating precompiled header output for input file \"" +
 				pchInputFilePath.wstr() + L"\" at location \"" + pchOutputFilePath.wstr() + L"\"");
 
-			CxxParser::initializeLLVM();
+			generatePch(
+				pchInputFilePath,
+				pchOutputFilePath,
+				pchOutputFilePath.getParentDirectory(),
+				compilerFlags,
+				storageProvider);
+		});
+}
 
-			if (!pchOutputFilePath.getParentDirectory().exists())
-			{
-				FileSystem::createDirectory(pchOutputFilePath.getParentDirectory());
-			}
+bool generatePch(
+	const FilePath& pchInputFilePath,
+	const FilePath& pchOutputFilePath,
+	const FilePath& workingDirectory,
+	std::vector<std::wstring> compilerFlags,
+	std::shared_ptr<StorageProvider> storageProvider)
+{
+	compilerFlags.push_back(pchInputFilePath.wstr());
+	compilerFlags.push_back(L"-emit-pch");
+	compilerFlags.push_back(L"-o");
+	compilerFlags.push_back(pchOutputFilePath.wstr());
 
-			std::shared_ptr<IntermediateStorage> storage = std::make_shared<IntermediateStorage>();
-			std::shared_ptr<ParserClientImpl> client = std::make_shared<ParserClientImpl>(
-				storage.get());
+	CxxParser::initializeLLVM();
 
-			std::shared_ptr<FileRegister> fileRegister = std::make_shared<FileRegister>(
-				pchInputFilePath, std::set<FilePath> {pchInputFilePath}, std::set<FilePathFilter> {});
+	if (!pchOutputFilePath.getParentDirectory().exists())
+	{
+		FileSystem::createDirectory(pchOutputFilePath.getParentDirectory());
+	}
 
-			std::shared_ptr<CanonicalFilePathCache> canonicalFilePathCache =
-				std::make_shared<CanonicalFilePathCache>(fileRegister);
+	std::shared_ptr<IntermediateStorage> storage = std::make_shared<IntermediateStorage>();
+	std::shared_ptr<ParserClientImpl> client = std::make_shared<ParserClientImpl>(storage.get());
 
-			clang::tooling::CompileCommand pchCommand;
-			pchCommand.Filename = utility::encodeToUtf8(pchInputFilePath.fileName());
-			pchCommand.Directory = pchOutputFilePath.getParentDirectory().str();
-			// DON'T use "-fsyntax-only" here because it will cause the output file to be erased
-			pchCommand.CommandLine = utility::concat(
-				{"clang-tool"}, CxxParser::getCommandlineArgumentsEssential(compilerFlags));
+	std::shared_ptr<FileRegister> fileRegister = std::make_shared<FileRegister>(
+		pchInputFilePath, std::set<FilePath> {pchInputFilePath}, std::set<FilePathFilter> {});
 
-			CxxCompilationDatabaseSingle compilationDatabase(pchCommand);
-			clang::tooling::ClangTool tool(
-				compilationDatabase, {utility::encodeToUtf8(pchInputFilePath.wstr())});
-			GeneratePCHAction* action = new GeneratePCHAction(client, canonicalFilePathCache);
+	std::shared_ptr<CanonicalFilePathCache> canonicalFilePathCache =
+		std::make_shared<CanonicalFilePathCache>(fileRegister);
 
-			llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> options =
-				new clang::DiagnosticOptions();
-			CxxDiagnosticConsumer diagnostics(
-				llvm::errs(), &*options, client, canonicalFilePathCache, pchInputFilePath, true);
+	clang::tooling::CompileCommand pchCommand;
+	pchCommand.Filename = utility::encodeToUtf8(pchInputFilePath.fileName());
+	pchCommand.Directory = workingDirectory.str();
+	// DON'T use "-fsyntax-only" here because it will cause the output file to be erased
+	pchCommand.CommandLine = utility::concat(
+		{"clang-tool"}, CxxParser::getCommandlineArgumentsEssential(compilerFlags));
 
-			tool.setDiagnosticConsumer(&diagnostics);
-			tool.clearArgumentsAdjusters();
-			tool.run(new SingleFrontendActionFactory(action));
+	CxxCompilationDatabaseSingle compilationDatabase(pchCommand);
+	clang::tooling::ClangTool tool(
+		compilationDatabase, {utility::encodeToUtf8(pchInputFilePath.wstr())});
+	GeneratePCHAction* action = new GeneratePCHAction(client, canonicalFilePathCache);
 
-			storageProvider->insert(storage);
-		});
+	llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> options = new clang::DiagnosticOptions();
+	CxxDiagnosticConsumer diagnostics(
+		llvm::errs(), &*options, client, canonicalFilePathCache, pchInputFilePath, true);
+
+	tool.setDiagnosticConsumer(&diagnostics);
+	tool.clearArgumentsAdjusters();
+	tool.run(new SingleFrontendActionFactory(action));
+
+	if (storageProvider)
+	{
+		storageProvider->insert(storage);
+	}
+
+	return pchOutputFilePath.exists();
 }
 
 std::shared_ptr<clang::tooling::JSONCompilationDatabase> loadCDB(
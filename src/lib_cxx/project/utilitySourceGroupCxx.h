@@ -27,6 +27,15 @@ std::shared_ptr<Task> createBuildPchTask(
 	std::shared_ptr<StorageProvider> storageProvider,
 	std::shared_ptr<DialogView> dialogView);
 
+// Returns whether the precompiled header was written. The records of the input file are only
+// stored if a storage provider is passed.
+bool generatePch(
+	const FilePath& pchInputFilePath,
+	const FilePath& pchOutputFilePath,
+	const FilePath& workingDirectory,
+	std::vector<std::wstring> compilerFlags,
+	std::shared_ptr<StorageProvider> storageProvider);
+
 std::shared_ptr<clang::tooling::JSONCompilationDatabase> loadCDB(
 	const FilePath& cdbPath, std::string* error = nullptr);
 bool containsIncludePchFlags(std::shared_ptr<clang::tooling::JSONCompilationDatabase> cdb);
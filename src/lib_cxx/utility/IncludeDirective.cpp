@@ -32,3 +32,8 @@ unsigned int IncludeDirective::getLineNumber() const
 {
 	return m_lineNumber;
 }
+
+bool IncludeDirective::getUsesBrackets() const
+{
+	return m_usesBrackets;
+}
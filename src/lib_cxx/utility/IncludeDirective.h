@@ -16,6 +16,7 @@ public:
 	FilePath getIncludingFile() const;
 	std::wstring getDirective() const;
 	unsigned int getLineNumber() const;
+	bool getUsesBrackets() const;
 
 private:
 	const FilePath m_includedFilePath;
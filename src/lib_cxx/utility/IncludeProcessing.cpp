@@ -22,6 +22,52 @@ struct IncludeDirectiveComparator
 		return a.getIncludedFile() < b.getIncludedFile();
 	}
 };
+
+bool isCommentOrEmptyLine(const std::string& line, bool& inBlockComment)
+{
+	std::string rest = utility::trim(line);
+	while (true)
+	{
+		if (inBlockComment)
+		{
+			const size_t pos = rest.find("*/");
+			if (pos == std::string::npos)
+			{
+				return true;
+			}
+			rest = utility::trim(rest.substr(pos + 2));
+			inBlockComment = false;
+		}
+
+		if (rest.empty() || utility::isPrefix<std::string>("//", rest))
+		{
+			return true;
+		}
+
+		if (!utility::isPrefix<std::string>("/*", rest))
+		{
+			return false;
+		}
+		rest = rest.substr(2);
+		inBlockComment = true;
+	}
+}
+
+bool isIncludeLine(const std::string& line)
+{
+	const std::string lineTrimmedToHash = utility::trim(line);
+	if (!utility::isPrefix<std::string>("#", lineTrimmedToHash))
+	{
+		return false;
+	}
+
+	// rules out "#include_next" and the like
+	const std::string lineTrimmedToInclude = utility::trim(lineTrimmedToHash.substr(1));
+	const std::string keyword = "include";
+	return utility::isPrefix(keyword, lineTrimmedToInclude) &&
+		lineTrimmedToInclude.size() > keyword.size() &&
+		std::string(" \t<\"").find(lineTrimmedToInclude[keyword.size()]) != std::string::npos;
+}
 }	 // namespace
 
 std::vector<IncludeDirective> IncludeProcessing::getUnresolvedIncludeDirectives(
@@ -194,6 +240,38 @@ std::vector<IncludeDirective> IncludeProcessing::getIncludeDirectives(
 	return includeDirectives;
 }
 
+std::vector<IncludeDirective> IncludeProcessing::getLeadingIncludeDirectives(
+	std::shared_ptr<TextAccess> textAccess)
+{
+	std::vector<IncludeDirective> leadingIncludeDirectives;
+
+	const std::vector<std::string> lines = textAccess->getAllLines();
+	bool inBlockComment = false;
+	size_t lineIndex = 0;
+	for (const IncludeDirective& includeDirective: getIncludeDirectives(textAccess))
+	{
+		// lines are 1 based
+		const size_t includeLineIndex = includeDirective.getLineNumber() - 1;
+		for (; lineIndex < includeLineIndex; lineIndex++)
+		{
+			if (!isCommentOrEmptyLine(lines[lineIndex], inBlockComment))
+			{
+				return leadingIncludeDirectives;
+			}
+		}
+
+		if (inBlockComment || !isIncludeLine(lines[includeLineIndex]))
+		{
+			break;
+		}
+
+		leadingIncludeDirectives.push_back(includeDirective);
+		lineIndex = includeLineIndex + 1;
+	}
+
+	return leadingIncludeDirectives;
+}
+
 std::vector<IncludeDirective> IncludeProcessing::doGetUnresolvedIncludeDirectives(
 	std::set<FilePath> filePathsToProcess,
 	std::unordered_set<std::wstring>& processedFilePaths,
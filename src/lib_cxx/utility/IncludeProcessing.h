@@ -33,6 +33,11 @@ public:
 
 	static std::vector<IncludeDirective> getIncludeDirectives(std::shared_ptr<TextAccess> textAccess);
 
+	// Include directives at the start of the file that are only preceded by comments and other
+	// include directives.
+	static std::vector<IncludeDirective> getLeadingIncludeDirectives(
+		std::shared_ptr<TextAccess> textAccess);
+
 private:
 	static std::vector<IncludeDirective> doGetUnresolvedIncludeDirectives(
 		std::set<FilePath> filePathsToProcess,
@@ -56,18 +56,55 @@ void QtProjectWizardContentCxxPchFlags::populate(QGridLayout* layout, int& row)
 	m_list = new QtStringListBox(this, labelText);
 	layout->addWidget(m_list, row, QtProjectWizardWindow::BACK_COL);
 	row++;
+
+	if (m_isCDB)
+	{
+		layout->addWidget(
+			createFormLabel(QStringLiteral("Automatic Precompiled Headers")),
+			row,
+			QtProjectWizardWindow::FRONT_COL,
+			Qt::AlignRight);
+
+		addHelpButton(
+			QStringLiteral("Automatic Precompiled Headers"),
+			QStringLiteral(
+				"<p>Check to let Sourcetrail generate precompiled headers on its own.</p>"
+				"<p>Source files of the Compilation Database that use the same compiler flags and "
+				"start with the same include directives share a precompiled header of these "
+				"includes, which is built before indexing starts. This speeds up indexing of "
+				"projects whose source files all include the same large set of headers.</p>"
+				"<p>Source files that already use the precompiled header specified above are not "
+				"affected.</p>"),
+			layout,
+			row);
+
+		m_useAutomaticPch = new QCheckBox(
+			QStringLiteral("Precompile common includes of source files"));
+		layout->addWidget(m_useAutomaticPch, row, QtProjectWizardWindow::BACK_COL);
+		row++;
+	}
 }
 
 void QtProjectWizardContentCxxPchFlags::load()
 {
 	m_useCompilerFlags->setChecked(m_settings->getUseCompilerFlags());
 	m_list->setStrings(m_settings->getPchFlags());
+
+	if (m_useAutomaticPch)
+	{
+		m_useAutomaticPch->setChecked(m_settings->getUseAutomaticPch());
+	}
 }
 
 void QtProjectWizardContentCxxPchFlags::save()
 {
 	m_settings->setUseCompilerFlags(m_useCompilerFlags->isChecked());
 	m_settings->setPchFlags(m_list->getStrings());
+
+	if (m_useAutomaticPch)
+	{
+		m_settings->setUseAutomaticPch(m_useAutomaticPch->isChecked());
+	}
 }
 
 bool QtProjectWizardContentCxxPchFlags::check()
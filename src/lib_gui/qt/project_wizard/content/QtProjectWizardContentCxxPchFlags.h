@@ -30,6 +30,7 @@ private:
 
 	QCheckBox* m_useCompilerFlags;
 	QtStringListBox* m_list;
+	QCheckBox* m_useAutomaticPch = nullptr;
 };
 
 #endif	  // QT_PROJECT_WIZARD_CONTENT_CXX_PCH_FLAGS_H
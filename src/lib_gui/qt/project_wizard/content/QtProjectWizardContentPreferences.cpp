@@ -126,6 +126,16 @@ void QtProjectWizardContentPreferences::populate(QGridLayout* layout, int& row)
 		row);
 	layout->setRowMinimumHeight(row - 1, 30);
 
+	// fulltext search results
+	m_fullTextSearchMaxResultCount = addLineEdit(
+		QStringLiteral("Full Text Search Results"),
+		QStringLiteral(
+			"<p>Set the maximum number of results shown for a full text search. The search stops "
+			"once this many results were found.</p>"
+			"<p>Use 0 to show all results.</p>"),
+		layout,
+		row);
+
 	addGap(layout, row);
 
 
@@ -508,6 +518,8 @@ void QtProjectWizardContentPreferences::load()
 	m_useAnimations->setChecked(appSettings->getUseAnimations());
 	m_showBuiltinTypes->setChecked(appSettings->getShowBuiltinTypesInGraph());
 	m_showDirectoryInCode->setChecked(appSettings->getShowDirectoryInCodeFileTitle());
+	m_fullTextSearchMaxResultCount->setText(
+		QString::number(appSettings->getCodeFullTextSearchMaxResultCount()));
 
 	if (m_screenAutoScaling)
 	{
@@ -578,6 +590,12 @@ void QtProjectWizardContentPreferences::save()
 	appSettings->setShowBuiltinTypesInGraph(m_showBuiltinTypes->isChecked());
 	appSettings->setShowDirectoryInCodeFileTitle(m_showDirectoryInCode->isChecked());
 
+	bool isValidMaxResultCount = false;
+	int fullTextSearchMaxResultCount = m_fullTextSearchMaxResultCount->text().toInt(
+		&isValidMaxResultCount);
+	if (isValidMaxResultCount && fullTextSearchMaxResultCount >= 0)
+		appSettings->setCodeFullTextSearchMaxResultCount(fullTextSearchMaxResultCount);
+
 	if (m_screenAutoScaling)
 	{
 		appSettings->setScreenAutoScaling(m_screenAutoScaling->currentData().toInt());
@@ -111,6 +111,7 @@ private:
 	QCheckBox* m_useAnimations;
 	QCheckBox* m_showBuiltinTypes;
 	QCheckBox* m_showDirectoryInCode;
+	QLineEdit* m_fullTextSearchMaxResultCount;
 
 	QComboBox* m_screenAutoScaling;
 	QLabel* m_screenAutoScalingInfoLabel;
@@ -261,6 +261,7 @@ DatabasePolicy QtDialogView::finishedIndexingDialog(
 	size_t totalFileCount,
 	float time,
 	ErrorCountInfo errorInfo,
+	const IndexingScheduleInfo& scheduleInfo,
 	bool interrupted,
 	bool shallow)
 {
@@ -277,6 +278,7 @@ DatabasePolicy QtDialogView::finishedIndexingDialog(
 			completedFileCount,
 			totalFileCount,
 			time,
+			scheduleInfo,
 			interrupted,
 			shallow);
 		window->updateErrorCount(errorInfo.total, errorInfo.fatal);
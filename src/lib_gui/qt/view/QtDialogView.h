@@ -62,6 +62,7 @@ public:
 		size_t totalFileCount,
 		float time,
 		ErrorCountInfo errorInfo,
+		const IndexingScheduleInfo& scheduleInfo,
 		bool interrupted,
 		bool shallow) override;
 
@@ -6,6 +6,7 @@
 #include "MessageErrorsHelpMessage.h"
 #include "MessageIndexingShowDialog.h"
 #include "MessageRefresh.h"
+#include "FilePath.h"
 #include "TimeStamp.h"
 
 QtIndexingReportDialog::QtIndexingReportDialog(
@@ -14,6 +15,7 @@ QtIndexingReportDialog::QtIndexingReportDialog(
 	size_t completedFileCount,
 	size_t totalFileCount,
 	float time,
+	const IndexingScheduleInfo& scheduleInfo,
 	bool interrupted,
 	bool shallow,
 	QWidget* parent)
@@ -48,6 +50,24 @@ QtIndexingReportDialog::QtIndexingReportDialog(
 	QtIndexingDialog::createMessageLabel(m_layout)->setText(
 		QStringLiteral("Time:   ") + QString::fromStdString(TimeStamp::secondsToString(time)));
 
+	if (scheduleInfo.longestFileDuration > 0.0f)
+	{
+		QtIndexingDialog::createMessageLabel(m_layout)->setText(
+			QStringLiteral("Longest source file:   ") +
+			QString::fromStdString(TimeStamp::secondsToString(scheduleInfo.longestFileDuration)) +
+			QStringLiteral(" (") +
+			QString::fromStdWString(FilePath(scheduleInfo.longestFilePath).fileName()) +
+			QStringLiteral(")"));
+	}
+
+	if (scheduleInfo.scheduledFileCount)
+	{
+		QtIndexingDialog::createMessageLabel(m_layout)->setText(
+			QStringLiteral("Started by recorded duration:   ") +
+			QString::number(scheduleInfo.recordedFileCount) + "/" +
+			QString::number(scheduleInfo.scheduledFileCount));
+	}
+
 	m_layout->addSpacing(12);
 	m_errorWidget = QtIndexingDialog::createErrorWidget(m_layout);
 
@@ -108,7 +128,7 @@ QtIndexingReportDialog::QtIndexingReportDialog(
 
 QSize QtIndexingReportDialog::sizeHint() const
 {
-	return QSize(m_interrupted ? 400 : 430, 280);
+	return QSize(m_interrupted ? 400 : 430, 320);
 }
 
 void QtIndexingReportDialog::updateErrorCount(size_t errorCount, size_t fatalCount)
@@ -1,6 +1,7 @@
 #ifndef QT_INDEXING_REPORT_DIALOG_H
 #define QT_INDEXING_REPORT_DIALOG_H
 
+#include "IndexingScheduleInfo.h"
 #include "QtIndexingDialog.h"
 
 class QtIndexingReportDialog: public QtIndexingDialog
@@ -17,6 +18,7 @@ public:
 		size_t completedFileCount,
 		size_t totalFileCount,
 		float time,
+		const IndexingScheduleInfo& scheduleInfo,
 		bool interrupted,
 		bool shallow,
 		QWidget* parent = 0);
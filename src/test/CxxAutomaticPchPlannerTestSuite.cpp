@@ -0,0 +1,150 @@
+#include "catch.hpp"
+
+#include "language_packages.h"
+
+#if BUILD_CXX_LANGUAGE_PACKAGE
+
+#	include "CxxAutomaticPchPlanner.h"
+#	include "TextAccess.h"
+
+namespace
+{
+const FilePath s_outputDirectoryPath(L"/pch/automatic");
+const FilePath s_workingDirectory(L"/project");
+
+size_t addTranslationUnit(
+	CxxAutomaticPchPlanner& planner,
+	const std::wstring& sourceFileName,
+	const std::vector<std::wstring>& includeLines,
+	const std::wstring& define = L"-DFOO")
+{
+	const FilePath sourceFilePath = s_workingDirectory.getConcatenated(sourceFileName);
+	return planner.addTranslationUnit(
+		sourceFilePath,
+		s_workingDirectory,
+		{L"clang++", define, L"-c", sourceFilePath.wstr(), L"-o", sourceFileName + L".o"},
+		includeLines);
+}
+}	 // namespace
+
+TEST_CASE("automatic pch clusters source files with common leading includes")
+{
+	CxxAutomaticPchPlanner planner(s_outputDirectoryPath);
+	const size_t a = addTranslationUnit(
+		planner, L"a.cpp", {L"#include <vector>", L"#include <map>", L"#include <string>"});
+	const size_t b = addTranslationUnit(
+		planner, L"b.cpp", {L"#include <vector>", L"#include <map>", L"#include <set>"});
+	const size_t c = addTranslationUnit(
+		planner, L"c.cpp", {L"#include <vector>", L"#include <map>"});
+
+	planner.createClusters(2);
+
+	REQUIRE(planner.getClusters().size() == 1);
+
+	const CxxAutomaticPchPlanner::Cluster& cluster = planner.getClusters().front();
+	REQUIRE(cluster.sourceFileCount == 3);
+	REQUIRE(cluster.workingDirectory == s_workingDirectory);
+	REQUIRE(
+		cluster.includeLines ==
+		std::vector<std::wstring>({L"#include <vector>", L"#include <map>"}));
+	REQUIRE(cluster.prefixHeaderFilePath.extension() == L".hpp");
+	REQUIRE(cluster.pchFilePath.getParentDirectory() == s_outputDirectoryPath);
+	REQUIRE(cluster.pchFilePath.wstr() == cluster.prefixHeaderFilePath.wstr() + L".pch");
+
+	// the output file and the source file are no flags of the cluster
+	REQUIRE(cluster.compilerFlags == std::vector<std::wstring>({L"clang++", L"-DFOO", L"-c"}));
+
+	const std::vector<std::wstring> expectedFlags = {
+		L"-fallow-pch-with-compiler-errors", L"-include", cluster.prefixHeaderFilePath.wstr()};
+	REQUIRE(planner.getIncludePchFlags(a) == expectedFlags);
+	REQUIRE(planner.getIncludePchFlags(b) == expectedFlags);
+	REQUIRE(planner.getIncludePchFlags(c) == expectedFlags);
+}
+
+TEST_CASE("automatic pch does not cluster source files with different flags")
+{
+	CxxAutomaticPchPlanner planner(s_outputDirectoryPath);
+	const size_t a = addTranslationUnit(planner, L"a.cpp", {L"#include <vector>"}, L"-DFOO");
+	const size_t b = addTranslationUnit(planner, L"b.cpp", {L"#include <vector>"}, L"-DBAR");
+
+	planner.createClusters(2);
+
+	REQUIRE(planner.getClusters().empty());
+	REQUIRE(planner.getIncludePchFlags(a).empty());
+	REQUIRE(planner.getIncludePchFlags(b).empty());
+}
+
+TEST_CASE("automatic pch does not cluster source files with different first include")
+{
+	CxxAutomaticPchPlanner planner(s_outputDirectoryPath);
+	const size_t a = addTranslationUnit(planner, L"a.cpp", {L"#include <vector>"});
+	const size_t b = addTranslationUnit(planner, L"b.cpp", {L"#include <map>"});
+	const size_t c = addTranslationUnit(planner, L"c.cpp", {});
+
+	planner.createClusters(2);
+
+	REQUIRE(planner.getClusters().empty());
+	REQUIRE(planner.getIncludePchFlags(a).empty());
+	REQUIRE(planner.getIncludePchFlags(b).empty());
+	REQUIRE(planner.getIncludePchFlags(c).empty());
+}
+
+TEST_CASE("automatic pch splits cluster if longer prefixes save more")
+{
+	CxxAutomaticPchPlanner planner(s_outputDirectoryPath);
+	std::vector<size_t> ids;
+	for (const wchar_t* name: {L"a", L"b", L"c"})
+	{
+		ids.push_back(addTranslationUnit(
+			planner,
+			std::wstring(name) + L".cpp",
+			{L"#include <base.h>", L"#include <gui_1.h>", L"#include <gui_2.h>"}));
+	}
+	for (const wchar_t* name: {L"d", L"e", L"f"})
+	{
+		ids.push_back(addTranslationUnit(
+			planner,
+			std::wstring(name) + L".cpp",
+			{L"#include <base.h>", L"#include <db_1.h>", L"#include <db_2.h>"}));
+	}
+
+	planner.createClusters(2);
+
+	REQUIRE(planner.getClusters().size() == 2);
+	for (const CxxAutomaticPchPlanner::Cluster& cluster: planner.getClusters())
+	{
+		REQUIRE(cluster.sourceFileCount == 3);
+		REQUIRE(cluster.includeLines.size() == 3);
+	}
+	REQUIRE(planner.getIncludePchFlags(ids[0]) == planner.getIncludePchFlags(ids[2]));
+	REQUIRE(planner.getIncludePchFlags(ids[3]) == planner.getIncludePchFlags(ids[5]));
+	REQUIRE(planner.getIncludePchFlags(ids[0]) != planner.getIncludePchFlags(ids[3]));
+}
+
+TEST_CASE("automatic pch uses c header for c source files")
+{
+	CxxAutomaticPchPlanner planner(s_outputDirectoryPath);
+	addTranslationUnit(planner, L"a.c", {L"#include <stdio.h>"});
+	addTranslationUnit(planner, L"b.c", {L"#include <stdio.h>"});
+	const size_t c = addTranslationUnit(planner, L"c.cpp", {L"#include <stdio.h>"});
+
+	planner.createClusters(2);
+
+	REQUIRE(planner.getClusters().size() == 1);
+	REQUIRE(planner.getClusters().front().prefixHeaderFilePath.extension() == L".h");
+	REQUIRE(planner.getIncludePchFlags(c).empty());
+}
+
+TEST_CASE("automatic pch keeps unresolved quoted includes of leading includes")
+{
+	const std::vector<std::wstring> includeLines = CxxAutomaticPchPlanner::getLeadingIncludeLines(
+		TextAccess::createFromString(
+			"#include <vector>\n#include \"not_existing.h\"\nint i;\n#include <map>\n",
+			FilePath(L"/project/a.cpp")));
+
+	REQUIRE(
+		includeLines ==
+		std::vector<std::wstring>({L"#include <vector>", L"#include \"not_existing.h\""}));
+}
+
+#endif	  // BUILD_CXX_LANGUAGE_PACKAGE
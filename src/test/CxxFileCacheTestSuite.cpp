@@ -0,0 +1,103 @@
+#include "catch.hpp"
+
+#include "language_packages.h"
+
+#if BUILD_CXX_LANGUAGE_PACKAGE
+
+#	include "CxxFileCache.h"
+
+namespace
+{
+std::string readFile(llvm::vfs::FileSystem& fileSystem, const std::string& path)
+{
+	llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> file = fileSystem.openFileForRead(path);
+	if (!file)
+	{
+		return "";
+	}
+
+	llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = (*file)->getBuffer(path);
+	if (!buffer)
+	{
+		return "";
+	}
+	return (*buffer)->getBuffer().str();
+}
+}	 // namespace
+
+TEST_CASE("file cache reads files once for all translation units")
+{
+	llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> baseFileSystem(
+		new llvm::vfs::InMemoryFileSystem());
+	baseFileSystem->addFile("/src/a.h", 1, llvm::MemoryBuffer::getMemBuffer("int a;"));
+
+	CxxFileCache cache(baseFileSystem);
+	for (int i = 0; i < 3; i++)
+	{
+		cache.startTranslationUnit();
+		llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = cache.getFileSystem();
+
+		REQUIRE(fileSystem->status("/src/a.h"));
+		REQUIRE(!fileSystem->status("/src/missing.h"));
+		REQUIRE(readFile(*fileSystem, "/src/a.h") == "int a;");
+	}
+
+	const CxxFileCache::Stats& stats = cache.getStats();
+	REQUIRE(stats.statusRequestCount == 6);
+	REQUIRE(stats.statusHitCount == 0);
+	REQUIRE(stats.readRequestCount == 3);
+	REQUIRE(stats.readHitCount == 2);
+	REQUIRE(stats.savedByteCount == 12);
+}
+
+TEST_CASE("file cache answers repeated requests of a translation unit from memory")
+{
+	llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> baseFileSystem(
+		new llvm::vfs::InMemoryFileSystem());
+	baseFileSystem->addFile("/src/a.h", 1, llvm::MemoryBuffer::getMemBuffer("int a;"));
+
+	CxxFileCache cache(baseFileSystem);
+	cache.startTranslationUnit();
+	llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = cache.getFileSystem();
+
+	REQUIRE(!fileSystem->status("/src/missing.h"));
+	REQUIRE(!fileSystem->status("/src/missing.h"));
+	REQUIRE(fileSystem->status("/src/a.h"));
+
+	llvm::ErrorOr<llvm::vfs::Status> status = fileSystem->status("/src/./a.h");
+	REQUIRE(status);
+	REQUIRE(status->getName() == "/src/./a.h");
+
+	REQUIRE(cache.getStats().statusRequestCount == 4);
+	REQUIRE(cache.getStats().statusHitCount == 2);
+}
+
+TEST_CASE("file cache reads files again after their modification time changed")
+{
+	llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> oldFileSystem(
+		new llvm::vfs::InMemoryFileSystem());
+	oldFileSystem->addFile("/src/a.h", 1, llvm::MemoryBuffer::getMemBuffer("int a;"));
+
+	llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> baseFileSystem(
+		new llvm::vfs::OverlayFileSystem(oldFileSystem));
+
+	CxxFileCache cache(baseFileSystem);
+	cache.startTranslationUnit();
+	REQUIRE(readFile(*cache.getFileSystem(), "/src/a.h") == "int a;");
+
+	llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> newFileSystem(
+		new llvm::vfs::InMemoryFileSystem());
+	newFileSystem->addFile("/src/a.h", 2, llvm::MemoryBuffer::getMemBuffer("int b;"));
+	baseFileSystem->pushOverlay(newFileSystem);
+
+	// the file is not checked again within the same translation unit
+	REQUIRE(readFile(*cache.getFileSystem(), "/src/a.h") == "int a;");
+
+	cache.startTranslationUnit();
+	REQUIRE(readFile(*cache.getFileSystem(), "/src/a.h") == "int b;");
+
+	REQUIRE(cache.getStats().readRequestCount == 3);
+	REQUIRE(cache.getStats().readHitCount == 1);
+}
+
+#endif	  // BUILD_CXX_LANGUAGE_PACKAGE
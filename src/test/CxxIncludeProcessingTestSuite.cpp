@@ -67,6 +67,58 @@ TEST_CASE("include detection does not find include in file without include prepr
 			.empty());
 }
 
+TEST_CASE("leading include detection finds includes preceded by comments")
+{
+	std::vector<IncludeDirective> includeDirectives = IncludeProcessing::getLeadingIncludeDirectives(
+		TextAccess::createFromString(
+			"// license\n"
+			"/* multi\n"
+			"   line */\n"
+			"#include <foo.h>\n"
+			"\n"
+			"#include \"bar.h\" // bar\n",
+			FilePath(L"foo.cpp")));
+
+	REQUIRE(includeDirectives.size() == 2);
+	REQUIRE(L"foo.h" == includeDirectives[0].getIncludedFile().wstr());
+	REQUIRE(includeDirectives[0].getUsesBrackets());
+	REQUIRE(L"bar.h" == includeDirectives[1].getIncludedFile().wstr());
+	REQUIRE(!includeDirectives[1].getUsesBrackets());
+}
+
+TEST_CASE("leading include detection stops at first line of code")
+{
+	std::vector<IncludeDirective> includeDirectives = IncludeProcessing::getLeadingIncludeDirectives(
+		TextAccess::createFromString(
+			"#include <foo.h>\n"
+			"#define BAR\n"
+			"#include <bar.h>\n",
+			FilePath(L"foo.cpp")));
+
+	REQUIRE(includeDirectives.size() == 1);
+	REQUIRE(L"foo.h" == includeDirectives[0].getIncludedFile().wstr());
+}
+
+TEST_CASE("leading include detection stops at include next directive")
+{
+	std::vector<IncludeDirective> includeDirectives = IncludeProcessing::getLeadingIncludeDirectives(
+		TextAccess::createFromString(
+			"#include <foo.h>\n"
+			"#include_next <bar.h>\n"
+			"#include <baz.h>\n",
+			FilePath(L"foo.cpp")));
+
+	REQUIRE(includeDirectives.size() == 1);
+	REQUIRE(L"foo.h" == includeDirectives[0].getIncludedFile().wstr());
+}
+
+TEST_CASE("leading include detection does not find include inside block comment")
+{
+	REQUIRE(IncludeProcessing::getLeadingIncludeDirectives(
+				TextAccess::createFromString("/*\n#include <foo.h>\n*/\n", FilePath(L"foo.cpp")))
+				.empty());
+}
+
 TEST_CASE("header search path detection does not find path relative to including file")
 {
 	std::vector<FilePath> headerSearchDirectories = utility::toVector(
@@ -0,0 +1,120 @@
+#include "catch.hpp"
+
+#include "language_packages.h"
+
+#if BUILD_CXX_LANGUAGE_PACKAGE
+
+#	include <clang/AST/ASTContext.h>
+#	include <clang/AST/DeclTemplate.h>
+#	include <clang/Frontend/ASTUnit.h>
+#	include <clang/Tooling/Tooling.h>
+
+#	include "CanonicalFilePathCache.h"
+#	include "CxxDeclNameResolver.h"
+#	include "CxxNameCache.h"
+#	include "CxxTypeNameResolver.h"
+
+namespace
+{
+void collectNamedDecls(
+	const clang::DeclContext* declContext, std::vector<const clang::NamedDecl*>& decls)
+{
+	for (const clang::Decl* decl: declContext->decls())
+	{
+		if (const clang::NamedDecl* namedDecl = clang::dyn_cast<clang::NamedDecl>(decl))
+		{
+			decls.push_back(namedDecl);
+		}
+
+		if (const clang::ClassTemplateDecl* templateDecl = clang::dyn_cast<clang::ClassTemplateDecl>(
+				decl))
+		{
+			for (const clang::ClassTemplateSpecializationDecl* specializationDecl:
+				 templateDecl->specializations())
+			{
+				decls.push_back(specializationDecl);
+				collectNamedDecls(specializationDecl, decls);
+			}
+		}
+
+		if (const clang::DeclContext* childContext = clang::dyn_cast<clang::DeclContext>(decl))
+		{
+			collectNamedDecls(childContext, decls);
+		}
+	}
+}
+
+std::vector<std::wstring> resolveNames(
+	const std::vector<const clang::NamedDecl*>& decls,
+	CanonicalFilePathCache* canonicalFilePathCache,
+	CxxNameCache* nameCache)
+{
+	std::vector<std::wstring> names;
+	for (const clang::NamedDecl* decl: decls)
+	{
+		std::unique_ptr<CxxDeclName> declName =
+			CxxDeclNameResolver(canonicalFilePathCache, nameCache).getName(decl);
+		names.push_back(
+			declName ? declName->toNameHierarchy().getQualifiedNameWithSignature() : L"");
+
+		if (const clang::ValueDecl* valueDecl = clang::dyn_cast<clang::ValueDecl>(decl))
+		{
+			std::unique_ptr<CxxTypeName> typeName =
+				CxxTypeNameResolver(canonicalFilePathCache, nameCache).getName(valueDecl->getType());
+			names.push_back(typeName ? typeName->toString() : L"");
+		}
+	}
+	return names;
+}
+
+void requireCachedNamesMatch(const std::string& code, CxxNameCache& nameCache)
+{
+	std::unique_ptr<clang::ASTUnit> ast = clang::tooling::buildASTFromCodeWithArgs(
+		code, {"-std=c++14"}, "input.cc");
+	REQUIRE(ast);
+
+	std::vector<const clang::NamedDecl*> decls;
+	collectNamedDecls(ast->getASTContext().getTranslationUnitDecl(), decls);
+
+	CanonicalFilePathCache canonicalFilePathCache(nullptr);
+	const std::vector<std::wstring> names = resolveNames(decls, &canonicalFilePathCache, nullptr);
+
+	// the second pass resolves all names from the cache filled by the first one
+	REQUIRE(resolveNames(decls, &canonicalFilePathCache, &nameCache) == names);
+	REQUIRE(resolveNames(decls, &canonicalFilePathCache, &nameCache) == names);
+}
+}	 // namespace
+
+TEST_CASE("name cache resolves the names of template heavy code like uncached resolvers")
+{
+	CxxNameCache nameCache;
+	requireCachedNamesMatch(
+		"namespace n {\n"
+		"	template <typename T, typename U = int> struct pair { T first; U second; };\n"
+		"	template <typename T> struct box { pair<T, box*> value; T get() const; };\n"
+		"	typedef box<pair<long>> long_box;\n"
+		"}\n"
+		"n::long_box a;\n"
+		"n::box<n::box<char>> b;\n"
+		"void f(n::box<n::pair<long>>* p, const n::long_box& q);\n"
+		"template <typename T> void g(n::pair<T, n::box<T>> p) {}\n"
+		"void h() { g<float>(n::pair<float, n::box<float>>()); }\n",
+		nameCache);
+
+	const CxxNameCache::Stats& stats = nameCache.getStats();
+	REQUIRE(stats.contextNameHitCount > 0);
+	REQUIRE(stats.typeNameHitCount > 0);
+	REQUIRE(stats.typeNameHitCount < stats.typeNameRequestCount);
+}
+
+TEST_CASE("name cache does not reuse names resolved within ignored contexts")
+{
+	CxxNameCache nameCache;
+	requireCachedNamesMatch(
+		"auto f() { struct local { int i; }; return local(); }\n"
+		"decltype(f()) a;\n"
+		"auto g() { struct local { decltype(f()) l; }; return local(); }\n",
+		nameCache);
+}
+
+#endif	  // BUILD_CXX_LANGUAGE_PACKAGE
@@ -9,8 +9,11 @@
 #	include "utilityString.h"
 
 #	include "CxxParser.h"
+#	include "HeaderClaimRegistry.h"
 #	include "IndexerCommandCxx.h"
+#	include "IndexerCxx.h"
 #	include "IndexerStateInfo.h"
+#	include "IntermediateStorage.h"
 #	include "ParserClientImpl.h"
 
 #	include "TestFileRegister.h"
@@ -32,6 +35,37 @@ std::shared_ptr<TestStorage> parseCode(std::string code, std::vector<std::wstrin
 
 	return TestStorage::create(storage);
 }
+
+class TestHeaderClaimRegistry: public HeaderClaimRegistry
+{
+public:
+	bool isHeaderClaimed(const FilePath& filePath, size_t contextHash) override
+	{
+		return m_claims.find(std::make_pair(filePath.wstr(), contextHash)) != m_claims.end();
+	}
+
+	void claimHeaders(const std::vector<FilePath>& filePaths, size_t contextHash) override
+	{
+		for (const FilePath& filePath: filePaths)
+		{
+			m_claims.emplace(filePath.wstr(), contextHash);
+		}
+	}
+
+private:
+	std::set<std::pair<std::wstring, size_t>> m_claims;
+};
+
+std::set<std::string> getMergedLines(
+	std::shared_ptr<IntermediateStorage> storage, std::shared_ptr<IntermediateStorage> otherStorage)
+{
+	std::shared_ptr<IntermediateStorage> mergedStorage = std::make_shared<IntermediateStorage>();
+	mergedStorage->inject(storage.get());
+	mergedStorage->inject(otherStorage.get());
+
+	const std::vector<std::string> lines = TestStorage::create(mergedStorage)->m_lines;
+	return std::set<std::string>(lines.begin(), lines.end());
+}
 }	 // namespace
 
 TEST_CASE("cxx parser finds global variable declaration")
@@ -3989,6 +4023,75 @@ TEST_CASE("cxx parser parses multiple files")
 	REQUIRE(testStorage->includes.size() == 1);
 }
 
+TEST_CASE("cxx parser skips headers claimed by previous translation units")
+{
+	const FilePath sourceFilePath(L"data/CxxParserTestSuite/code.cpp");
+
+	std::shared_ptr<IndexerCommandCxx> indexerCommand = std::make_shared<IndexerCommandCxx>(
+		sourceFilePath,
+		std::set<FilePath> {FilePath(L"data/CxxParserTestSuite/").getCanonical()},
+		std::set<FilePathFilter>(),
+		std::set<FilePathFilter>(),
+		FilePath(L"."),
+		std::vector<std::wstring> {
+			L"--target=x86_64-pc-windows-msvc", L"-std=c++1z", sourceFilePath.wstr()});
+
+	IndexerCxx claimingIndexer;
+	claimingIndexer.setHeaderClaimRegistry(std::make_shared<TestHeaderClaimRegistry>());
+	std::shared_ptr<IntermediateStorage> claimingStorage = claimingIndexer.index(indexerCommand);
+	std::shared_ptr<IntermediateStorage> skippingStorage = claimingIndexer.index(indexerCommand);
+
+	IndexerCxx indexer;
+	std::shared_ptr<IntermediateStorage> fullStorage = indexer.index(indexerCommand);
+
+	REQUIRE(claimingStorage);
+	REQUIRE(skippingStorage);
+	REQUIRE(fullStorage);
+
+	REQUIRE(claimingStorage->getSourceLocationCount() == fullStorage->getSourceLocationCount());
+	REQUIRE(skippingStorage->getSourceLocationCount() < fullStorage->getSourceLocationCount());
+
+	REQUIRE(
+		getMergedLines(claimingStorage, skippingStorage) ==
+		getMergedLines(claimingStorage, fullStorage));
+}
+
+TEST_CASE("cxx parser does not skip headers claimed with different macro definitions")
+{
+	const std::set<FilePath> indexedPaths = {FilePath(L"data/CxxParserTestSuite/").getCanonical()};
+	const auto createIndexerCommand = [&indexedPaths](const FilePath& sourceFilePath) {
+		return std::make_shared<IndexerCommandCxx>(
+			sourceFilePath,
+			indexedPaths,
+			std::set<FilePathFilter>(),
+			std::set<FilePathFilter>(),
+			FilePath(L"."),
+			std::vector<std::wstring> {
+				L"--target=x86_64-pc-windows-msvc", L"-std=c++1z", sourceFilePath.wstr()});
+	};
+
+	std::shared_ptr<IndexerCommandCxx> plainCommand = createIndexerCommand(
+		FilePath(L"data/CxxParserTestSuite/conditional_plain.cpp"));
+	std::shared_ptr<IndexerCommandCxx> definingCommand = createIndexerCommand(
+		FilePath(L"data/CxxParserTestSuite/conditional_defining.cpp"));
+
+	IndexerCxx claimingIndexer;
+	claimingIndexer.setHeaderClaimRegistry(std::make_shared<TestHeaderClaimRegistry>());
+	std::shared_ptr<IntermediateStorage> plainStorage = claimingIndexer.index(plainCommand);
+	std::shared_ptr<IntermediateStorage> definingStorage = claimingIndexer.index(definingCommand);
+
+	IndexerCxx indexer;
+	std::shared_ptr<IntermediateStorage> fullStorage = indexer.index(definingCommand);
+
+	REQUIRE(plainStorage);
+	REQUIRE(definingStorage);
+	REQUIRE(fullStorage);
+
+	REQUIRE(definingStorage->getSourceLocationCount() == fullStorage->getSourceLocationCount());
+	REQUIRE(
+		getMergedLines(plainStorage, definingStorage) == getMergedLines(plainStorage, fullStorage));
+}
+
 
 TEST_CASE("cxx parser finds braces of class decl")
 {
@@ -5,6 +5,8 @@
 #include <string>
 #include <vector>
 
+#include "FilePathFilter.h"
+#include "FileRegister.h"
 #include "FileSystem.h"
 #include "utility.h"
 
@@ -143,3 +145,25 @@ TEST_CASE("find symlinked directories")
 	REQUIRE(dirs.size() == 2);
 #endif
 }
+
+TEST_CASE("file register shares indexed files between translation units")
+{
+	const FilePath mainPath(L"data/FileSystemTestSuite/main.cpp");
+	const FilePath updatePath(L"data/FileSystemTestSuite/update.c");
+	const std::set<FilePath> indexedPaths = {FilePath(L"data/FileSystemTestSuite/src")};
+	const std::set<FilePathFilter> excludeFilters = {FilePathFilter(L"**/test.cpp")};
+
+	const FileRegister mainRegister(
+		mainPath, utility::concat(indexedPaths, {mainPath}), excludeFilters);
+	REQUIRE(mainRegister.hasSameIndexedFiles(
+		updatePath, utility::concat(indexedPaths, {updatePath}), excludeFilters));
+	REQUIRE(!mainRegister.hasSameIndexedFiles(updatePath, indexedPaths, {}));
+
+	const FileRegister updateRegister(updatePath, mainRegister);
+	REQUIRE(mainRegister.hasFilePath(mainPath));
+	REQUIRE(!mainRegister.hasFilePath(updatePath));
+	REQUIRE(updateRegister.hasFilePath(updatePath));
+	REQUIRE(!updateRegister.hasFilePath(mainPath));
+	REQUIRE(updateRegister.hasFilePath(FilePath(L"data/FileSystemTestSuite/src/main.cpp")));
+	REQUIRE(!updateRegister.hasFilePath(FilePath(L"data/FileSystemTestSuite/src/test.cpp")));
+}
@@ -0,0 +1,260 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <random>
+
+#include "FileSystem.h"
+#include "FullTextSearchIndex.h"
+#include "FullTextSearchQuery.h"
+#include "SuffixArray.h"
+#include "TrigramIndex.h"
+
+namespace
+{
+std::vector<int> getPositions(const std::vector<FullTextSearchResult>& results, Id fileId)
+{
+	for (const FullTextSearchResult& result: results)
+	{
+		if (result.fileId == fileId)
+		{
+			return result.positions;
+		}
+	}
+	return {};
+}
+
+void addFile(TrigramIndex& index, Id fileId, const std::wstring& content)
+{
+	const std::string text = FullTextSearchIndex::encodeLowercase(content);
+	index.addFile(fileId, text.data(), text.data() + text.size());
+}
+
+std::vector<std::string> encodeLiterals(const std::vector<std::wstring>& literals)
+{
+	std::vector<std::string> encodedLiterals;
+	for (const std::wstring& literal: literals)
+	{
+		encodedLiterals.push_back(FullTextSearchIndex::encodeLowercase(literal));
+	}
+	return encodedLiterals;
+}
+}	 // namespace
+
+TEST_CASE("suffix array sorts suffixes like a naive sort")
+{
+	std::mt19937 random(42);
+	for (int i = 0; i < 200; i++)
+	{
+		std::string text;
+		const size_t alphabetSize = i % 2 ? 3 : 256;
+		for (size_t j = random() % 2000; j > 0; j--)
+		{
+			text.push_back(static_cast<char>(random() % alphabetSize));
+		}
+
+		std::vector<int> expectedArray(text.size());
+		for (size_t j = 0; j < text.size(); j++)
+		{
+			expectedArray[j] = static_cast<int>(j);
+		}
+		std::sort(expectedArray.begin(), expectedArray.end(), [&text](int a, int b) {
+			return std::lexicographical_compare(
+				text.begin() + a, text.end(), text.begin() + b, text.end(), [](char x, char y) {
+					return static_cast<unsigned char>(x) < static_cast<unsigned char>(y);
+				});
+		});
+
+		const SuffixArray array(text);
+		const std::vector<int> suffixes(array.getArray(), array.getArray() + array.getSize());
+		REQUIRE(suffixes == expectedArray);
+	}
+}
+
+TEST_CASE("suffix array finds all occurrences of a term")
+{
+	std::vector<int> positions = SuffixArray("abababa").searchForTerm("aba");
+	std::sort(positions.begin(), positions.end());
+
+	REQUIRE(positions == std::vector<int>({0, 2, 4}));
+	REQUIRE(SuffixArray("abababa").searchForTerm("abc").empty());
+	REQUIRE(SuffixArray("ab").searchForTerm("abab").empty());
+}
+
+TEST_CASE("fulltext search index finds case insensitive character positions in all files")
+{
+	FullTextSearchIndex index;
+	index.addFile(1, L"int foo = 0;\nFoo bar;");
+	index.addFile(2, L"\u00e4\u00f6\u00fc foo");
+	index.addFile(3, L"nothing here");
+
+	const std::vector<FullTextSearchResult> results = index.searchForTerm(L"FOO");
+
+	REQUIRE(results.size() == 2);
+	REQUIRE(getPositions(results, 1) == std::vector<int>({4, 13}));
+	REQUIRE(getPositions(results, 2) == std::vector<int>({4}));
+	REQUIRE(getPositions(index.searchForTerm(L"\u00f6\u00fc"), 2) == std::vector<int>({1}));
+}
+
+TEST_CASE("fulltext search index does not find matches across files")
+{
+	FullTextSearchIndex index;
+	index.addFile(1, L"abc");
+	index.addFile(2, L"def");
+
+	REQUIRE(index.searchForTerm(L"cd").empty());
+	REQUIRE(index.searchForTerm(L"de").size() == 1);
+}
+
+TEST_CASE("fulltext search index keeps remaining files of shards with removed files")
+{
+	FullTextSearchIndex index(0);
+	index.addFile(1, L"foo");
+	index.addFile(2, L"a foo");
+	index.addFile(3, L"foo foo");
+
+	REQUIRE(index.searchForTerm(L"foo").size() == 3);
+
+	index.removeFiles({2});
+	index.addFile(4, L"  foo");
+
+	const std::vector<FullTextSearchResult> results = index.searchForTerm(L"foo");
+	REQUIRE(index.fileCount() == 3);
+	REQUIRE(results.size() == 3);
+	REQUIRE(getPositions(results, 1) == std::vector<int>({0}));
+	REQUIRE(getPositions(results, 3) == std::vector<int>({0, 4}));
+	REQUIRE(getPositions(results, 4) == std::vector<int>({2}));
+}
+
+TEST_CASE("fulltext search index finds the same positions after saving and loading")
+{
+	const FilePath indexPath(L"data/FullTextSearchIndexTestSuite/index_fulltext");
+	FileSystem::remove(indexPath);
+
+	{
+		FullTextSearchIndex index(0);
+		index.addFile(1, L"int foo = 0;\nFoo bar;");
+		index.addFile(2, L"\u00e4\u00f6\u00fc foo");
+		REQUIRE(index.save(indexPath, "2020-01-01 10:00:00", "UTF-8"));
+		REQUIRE(FileSystem::getFileByteSize(indexPath) == index.getFileByteSize());
+	}
+
+	FullTextSearchIndex index(0);
+	REQUIRE(index.load(indexPath, "2020-01-01 10:00:00", "UTF-8"));
+	REQUIRE(index.fileCount() == 2);
+
+	const std::vector<FullTextSearchResult> results = index.searchForTerm(L"foo");
+	REQUIRE(results.size() == 2);
+	REQUIRE(getPositions(results, 1) == std::vector<int>({4, 13}));
+	REQUIRE(getPositions(results, 2) == std::vector<int>({4}));
+
+	// loaded shards are updated like built ones
+	index.removeFiles({1});
+	index.addFile(3, L"  foo");
+	REQUIRE(getPositions(index.searchForTerm(L"foo"), 3) == std::vector<int>({2}));
+	REQUIRE(getPositions(index.searchForTerm(L"foo"), 1).empty());
+
+	index.clear();
+	FileSystem::remove(indexPath);
+}
+
+TEST_CASE("fulltext search index does not load index saved for other timestamp or codec")
+{
+	const FilePath indexPath(L"data/FullTextSearchIndexTestSuite/index_fulltext");
+	FileSystem::remove(indexPath);
+
+	{
+		FullTextSearchIndex index;
+		index.addFile(1, L"foo");
+		REQUIRE(index.save(indexPath, "2020-01-01 10:00:00", "UTF-8"));
+	}
+
+	FullTextSearchIndex index;
+	REQUIRE(!index.load(indexPath, "2020-01-01 10:00:01", "UTF-8"));
+	REQUIRE(!index.load(indexPath, "2020-01-01 10:00:00", "ISO 8859-1"));
+	REQUIRE(!index.load(
+		FilePath(L"data/FullTextSearchIndexTestSuite/missing"), "2020-01-01 10:00:00", "UTF-8"));
+	REQUIRE(index.fileCount() == 0);
+
+	FileSystem::remove(indexPath);
+}
+
+TEST_CASE("trigram index returns files containing all trigrams of the literals")
+{
+	TrigramIndex index;
+	addFile(index, 3, L"// TODO(someone): fix this");
+	addFile(index, 1, L"int foo = bar;");
+	addFile(index, 2, L"void Foo();");
+
+	REQUIRE(index.getCandidateFileIds(encodeLiterals({L"foo"})) == std::vector<Id>({1, 2}));
+	REQUIRE(index.getCandidateFileIds(encodeLiterals({L"foo", L"bar"})) == std::vector<Id>({1}));
+	REQUIRE(index.getCandidateFileIds(encodeLiterals({L"todo("})) == std::vector<Id>({3}));
+	REQUIRE(index.getCandidateFileIds(encodeLiterals({L"baz"})).empty());
+
+	// literals without trigrams do not narrow the files down
+	REQUIRE(index.getCandidateFileIds(encodeLiterals({L"fo"})) == std::vector<Id>({1, 2, 3}));
+
+	index.removeFiles({1});
+	REQUIRE(index.getCandidateFileIds(encodeLiterals({L"foo"})) == std::vector<Id>({2}));
+	REQUIRE(index.fileCount() == 2);
+}
+
+TEST_CASE("fulltext search query interprets term delimiters")
+{
+	REQUIRE(FullTextSearchQuery(L"foo", false).getMode() == FullTextSearchQuery::MODE_SUBSTRING);
+	REQUIRE(FullTextSearchQuery(L"/", false).getMode() == FullTextSearchQuery::MODE_SUBSTRING);
+	REQUIRE(FullTextSearchQuery(L"/fo+/", false).getMode() == FullTextSearchQuery::MODE_REGEX);
+	REQUIRE(FullTextSearchQuery(L"/fo+/", false).getText() == L"fo+");
+	REQUIRE(
+		FullTextSearchQuery(L"\"foo\"", false).getMode() == FullTextSearchQuery::MODE_WHOLE_WORD);
+	REQUIRE(!FullTextSearchQuery(L"/fo(/", false).isValid());
+}
+
+TEST_CASE("fulltext search query extracts literals required by regular expressions")
+{
+	REQUIRE(
+		FullTextSearchQuery(L"/TODO\\(.*\\)/", false).getRequiredLiterals() ==
+		std::vector<std::wstring>({L"TODO(", L")"}));
+	REQUIRE(
+		FullTextSearchQuery(L"/get\\w+Name/", false).getRequiredLiterals() ==
+		std::vector<std::wstring>({L"get", L"Name"}));
+	REQUIRE(
+		FullTextSearchQuery(L"/colou?r/", false).getRequiredLiterals() ==
+		std::vector<std::wstring>({L"colo", L"r"}));
+	REQUIRE(
+		FullTextSearchQuery(L"/(foo|bar)baz[0-9]+/", false).getRequiredLiterals() ==
+		std::vector<std::wstring>({L"baz"}));
+	REQUIRE(FullTextSearchQuery(L"/foo|bar/", false).getRequiredLiterals().empty());
+}
+
+TEST_CASE("fulltext search query finds regular expression and whole word matches in lines")
+{
+	const std::wstring line = L"int foo = foobar(Foo); // TODO(foo)";
+
+	REQUIRE(
+		FullTextSearchQuery(L"\"foo\"", false).findMatches(line) ==
+		std::vector<std::pair<int, int>>({{4, 3}, {17, 3}, {31, 3}}));
+	REQUIRE(
+		FullTextSearchQuery(L"\"foo\"", true).findMatches(line) ==
+		std::vector<std::pair<int, int>>({{4, 3}, {31, 3}}));
+	REQUIRE(
+		FullTextSearchQuery(L"/TODO\\(.*\\)/", true).findMatches(line) ==
+		std::vector<std::pair<int, int>>({{26, 9}}));
+	REQUIRE(
+		FullTextSearchQuery(L"/^int/", true).findMatches(line) ==
+		std::vector<std::pair<int, int>>({{0, 3}}));
+}
+
+TEST_CASE("fulltext search query finds matches in long lines with non ascii characters")
+{
+	const std::wstring line = L"\u00e4 TODO(" + std::wstring(300000, L'x') + L") \u00e4 TODO";
+
+	REQUIRE(
+		FullTextSearchQuery(L"/TODO\\(.*\\)/", true).findMatches(line) ==
+		std::vector<std::pair<int, int>>({{2, 300006}}));
+	REQUIRE(
+		FullTextSearchQuery(L"\"TODO\"", true).findMatches(line) ==
+		std::vector<std::pair<int, int>>({{2, 4}, {300011, 4}}));
+	REQUIRE(
+		FullTextSearchQuery(L"/x*/", true).findMatches(L"\u00e4x") ==
+		std::vector<std::pair<int, int>>({{1, 1}}));
+}
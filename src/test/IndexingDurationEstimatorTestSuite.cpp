@@ -0,0 +1,77 @@
+#include "catch.hpp"
+
+#include "IndexingDurationEstimator.h"
+#include "IndexingScheduleInfo.h"
+
+TEST_CASE("indexing duration estimator orders recorded source files longest first")
+{
+	IndexingDurationEstimator estimator(
+		{StorageIndexingDuration(L"/src/a.cpp", 1.0f, 10),
+		 StorageIndexingDuration(L"/src/b.cpp", 8.0f, 200),
+		 StorageIndexingDuration(L"/src/c.cpp", 2.0f, 30)});
+
+	const std::vector<FilePath> orderedFilePaths = estimator.orderByEstimatedDuration(
+		{FilePath(L"/src/a.cpp"), FilePath(L"/src/b.cpp"), FilePath(L"/src/c.cpp")}, nullptr);
+
+	REQUIRE(
+		orderedFilePaths ==
+		std::vector<FilePath>(
+			{FilePath(L"/src/b.cpp"), FilePath(L"/src/c.cpp"), FilePath(L"/src/a.cpp")}));
+}
+
+TEST_CASE("indexing duration estimator estimates unrecorded source files from compiler flags")
+{
+	IndexingDurationEstimator estimator({});
+
+	const std::vector<FilePath> orderedFilePaths = estimator.orderByEstimatedDuration(
+		{FilePath(L"/src/a.cpp"), FilePath(L"/src/b.cpp"), FilePath(L"/src/c.cpp")},
+		[](const FilePath& filePath) -> size_t {
+			if (filePath.wstr() == L"/src/b.cpp")
+			{
+				return 40;
+			}
+			return filePath.wstr() == L"/src/c.cpp" ? 5 : 0;
+		});
+
+	REQUIRE(
+		orderedFilePaths ==
+		std::vector<FilePath>(
+			{FilePath(L"/src/b.cpp"), FilePath(L"/src/c.cpp"), FilePath(L"/src/a.cpp")}));
+	REQUIRE(estimator.getRecordedFileCount(orderedFilePaths) == 0);
+}
+
+TEST_CASE("indexing duration estimator scales unrecorded source files to recorded durations")
+{
+	// none of the files exists, so the cost only differs by the flags: the unrecorded file has four
+	// times the flags of the faster recorded file and is estimated to take about 4 seconds
+	IndexingDurationEstimator estimator(
+		{StorageIndexingDuration(L"/src/a.cpp", 1.0f, 10),
+		 StorageIndexingDuration(L"/src/b.cpp", 5.0f, 10)});
+
+	const std::vector<FilePath> orderedFilePaths = estimator.orderByEstimatedDuration(
+		{FilePath(L"/src/a.cpp"), FilePath(L"/src/b.cpp"), FilePath(L"/src/new.cpp")},
+		[](const FilePath& filePath) -> size_t {
+			return filePath.wstr() == L"/src/new.cpp" ? 40 : 10;
+		});
+
+	REQUIRE(
+		orderedFilePaths ==
+		std::vector<FilePath>(
+			{FilePath(L"/src/b.cpp"), FilePath(L"/src/new.cpp"), FilePath(L"/src/a.cpp")}));
+	REQUIRE(estimator.getRecordedFileCount(orderedFilePaths) == 2);
+}
+
+TEST_CASE("indexing schedule info reports the longest source file")
+{
+	const IndexingScheduleInfo info(
+		2,
+		3,
+		{StorageIndexingDuration(L"/src/a.cpp", 1.0f, 10),
+		 StorageIndexingDuration(L"/src/b.cpp", 8.0f, 200),
+		 StorageIndexingDuration(L"/src/c.cpp", 2.0f, 30)});
+
+	REQUIRE(2 == info.recordedFileCount);
+	REQUIRE(3 == info.scheduledFileCount);
+	REQUIRE(L"/src/b.cpp" == info.longestFilePath);
+	REQUIRE(8.0f == info.longestFileDuration);
+}
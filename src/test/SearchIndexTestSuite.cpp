@@ -55,6 +55,26 @@ TEST_CASE("search index does not find anything after clear")
 	REQUIRE(0 == results.size());
 }
 
+TEST_CASE("search index finds elements added and removed after setup")
+{
+	SearchIndex index;
+	index.addNode(1, L"foo");
+	index.addNode(2, L"foobar");
+	index.finishSetup();
+
+	index.addNode(3, L"fozzy");
+	index.removeNode(1, L"foo");
+
+	std::vector<SearchResult> results = index.search(L"fz", NodeTypeSet::all(), 0);
+	REQUIRE(1 == results.size());
+	REQUIRE(utility::containsElement<Id>(results[0].elementIds, 3));
+
+	results = index.search(L"fo", NodeTypeSet::all(), 0);
+	REQUIRE(2 == results.size());
+	REQUIRE(!utility::containsElement<Id>(results[0].elementIds, 1));
+	REQUIRE(!utility::containsElement<Id>(results[1].elementIds, 1));
+}
+
 TEST_CASE("search index does not find all results when max amount is limited")
 {
 	SearchIndex index;
@@ -91,3 +111,16 @@ TEST_CASE("search index rates higher on consecutive letters")
 	REQUIRE(L"ocbcabc" == results[0].text);
 	REQUIRE(L"oaabbcc" == results[1].text);
 }
+
+TEST_CASE("search index distinguishes non ascii characters")
+{
+	SearchIndex index;
+	index.addNode(1, L"bär");
+	index.addNode(2, L"bąk");
+	index.finishSetup();
+	std::vector<SearchResult> results = index.search(L"ą", NodeTypeSet::all(), 0);
+
+	REQUIRE(1 == results.size());
+	REQUIRE(L"bąk" == results[0].text);
+	REQUIRE(index.search(L"ąr", NodeTypeSet::all(), 0).empty());
+}
@@ -1,9 +1,29 @@
 #include "catch.hpp"
 
+#include <atomic>
 #include <memory>
 #include <thread>
 
+#include "language_packages.h"
+
+#include "AccessKind.h"
+#include "DefinitionKind.h"
+#include "Edge.h"
+#include "FlatIntermediateStorage.h"
+#include "IntermediateStorage.h"
+#include "InterprocessIndexerCommandManager.h"
+#include "InterprocessIndexingStatusManager.h"
+#include "InterprocessIntermediateStorageManager.h"
+#include "LocationType.h"
+#include "NodeKind.h"
 #include "SharedMemory.h"
+#include "TimeStamp.h"
+#include "utility.h"
+#include "utilityString.h"
+
+#if BUILD_CXX_LANGUAGE_PACKAGE
+#	include "IndexerCommandCxx.h"
+#endif	  // BUILD_CXX_LANGUAGE_PACKAGE
 
 TEST_CASE("shared memory")
 {
@@ -96,3 +116,433 @@ TEST_CASE("shared memory")
 		}
 	}
 }
+
+namespace
+{
+std::shared_ptr<IntermediateStorage> createIntermediateStorage(size_t fileCount, size_t symbolCount)
+{
+	std::shared_ptr<IntermediateStorage> storage = std::make_shared<IntermediateStorage>();
+	for (size_t i = 0; i < fileCount; i++)
+	{
+		const std::wstring filePath = L"/path/to/file" + std::to_wstring(i) + L".h";
+		const Id fileId =
+			storage->addNode(StorageNodeData(nodeKindToInt(NODE_FILE), filePath)).first;
+		storage->addFile(StorageFile(fileId, filePath, L"cpp", "2020-01-01 10:00:00", true, true));
+
+		Id previousId = 0;
+		for (size_t j = 0; j < symbolCount; j++)
+		{
+			const std::wstring name =
+				L"\tmfile" + std::to_wstring(i) + L"::function" + std::to_wstring(j);
+			const Id id =
+				storage->addNode(StorageNodeData(nodeKindToInt(NODE_FUNCTION), name)).first;
+			storage->addSymbol(StorageSymbol(id, definitionKindToInt(DEFINITION_EXPLICIT)));
+			storage->addComponentAccess(StorageComponentAccess(id, accessKindToInt(ACCESS_PUBLIC)));
+
+			const Id locationId = storage->addSourceLocation(StorageSourceLocationData(
+				fileId, j + 1, 1, j + 1, 10, locationTypeToInt(LOCATION_TOKEN)));
+			storage->addOccurrence(StorageOccurrence(id, locationId));
+
+			if (previousId)
+			{
+				const Id edgeId = storage->addEdge(
+					StorageEdgeData(Edge::typeToInt(Edge::EDGE_CALL), previousId, id));
+				storage->addElementComponent(StorageElementComponent(edgeId, 1, L"component"));
+			}
+			previousId = id;
+		}
+
+		storage->addLocalSymbol(StorageLocalSymbolData(filePath + L"<1:2>"));
+	}
+	storage->addError(StorageErrorData(L"error", L"/path/to/file0.h", true, true));
+	return storage;
+}
+
+std::vector<std::wstring> getElementStrings(const IntermediateStorage& storage)
+{
+	std::vector<std::wstring> strings;
+	for (const StorageNode& node: storage.getStorageNodes())
+	{
+		strings.push_back(
+			L"node " + std::to_wstring(node.id) + L" " + std::to_wstring(node.type) + L" " +
+			node.serializedName);
+	}
+	for (const StorageFile& file: storage.getStorageFiles())
+	{
+		strings.push_back(
+			L"file " + std::to_wstring(file.id) + L" " + file.filePath + L" " +
+			file.languageIdentifier + L" " + utility::decodeFromUtf8(file.modificationTime) +
+			L" " + std::to_wstring(file.indexed) + std::to_wstring(file.complete));
+	}
+	for (const StorageSymbol& symbol: storage.getStorageSymbols())
+	{
+		strings.push_back(
+			L"symbol " + std::to_wstring(symbol.id) + L" " + std::to_wstring(symbol.definitionKind));
+	}
+	for (const StorageEdge& edge: storage.getStorageEdges())
+	{
+		strings.push_back(
+			L"edge " + std::to_wstring(edge.id) + L" " + std::to_wstring(edge.type) + L" " +
+			std::to_wstring(edge.sourceNodeId) + L" " + std::to_wstring(edge.targetNodeId));
+	}
+	for (const StorageLocalSymbol& localSymbol: storage.getStorageLocalSymbols())
+	{
+		strings.push_back(L"local " + std::to_wstring(localSymbol.id) + L" " + localSymbol.name);
+	}
+	for (const StorageSourceLocation& location: storage.getStorageSourceLocations())
+	{
+		strings.push_back(
+			L"location " + std::to_wstring(location.id) + L" " +
+			std::to_wstring(location.fileNodeId) + L" " + std::to_wstring(location.startLine) +
+			L":" + std::to_wstring(location.startCol) + L" " + std::to_wstring(location.endLine) +
+			L":" + std::to_wstring(location.endCol) + L" " + std::to_wstring(location.type));
+	}
+	for (const StorageOccurrence& occurrence: storage.getStorageOccurrences())
+	{
+		strings.push_back(
+			L"occurrence " + std::to_wstring(occurrence.elementId) + L" " +
+			std::to_wstring(occurrence.sourceLocationId));
+	}
+	for (const StorageComponentAccess& access: storage.getComponentAccesses())
+	{
+		strings.push_back(
+			L"access " + std::to_wstring(access.nodeId) + L" " + std::to_wstring(access.type));
+	}
+	for (const StorageElementComponent& component: storage.getElementComponents())
+	{
+		strings.push_back(
+			L"component " + std::to_wstring(component.elementId) + L" " +
+			std::to_wstring(component.type) + L" " + component.data);
+	}
+	for (const StorageError& error: storage.getErrors())
+	{
+		strings.push_back(
+			L"error " + std::to_wstring(error.id) + L" " + error.message + L" " +
+			error.translationUnit + L" " + std::to_wstring(error.fatal) +
+			std::to_wstring(error.indexed));
+	}
+	strings.push_back(L"next id " + std::to_wstring(storage.getNextId()));
+	return strings;
+}
+}	 // namespace
+
+TEST_CASE("intermediate storage keeps its content when passed through shared memory")
+{
+	InterprocessIntermediateStorageManager manager("test", 0, true);
+
+	std::shared_ptr<IntermediateStorage> storage = createIntermediateStorage(3, 20);
+	manager.pushIntermediateStorage(storage);
+	manager.pushIntermediateStorage(std::make_shared<IntermediateStorage>());
+	REQUIRE(manager.getIntermediateStorageCount() == 2);
+
+	std::shared_ptr<IntermediateStorage> received = manager.popIntermediateStorage();
+	REQUIRE(received);
+	REQUIRE(getElementStrings(*received) == getElementStrings(*storage));
+
+	std::shared_ptr<IntermediateStorage> expected = createIntermediateStorage(3, 20);
+	expected->inject(storage.get());
+	received->inject(storage.get());
+	REQUIRE(getElementStrings(*received) == getElementStrings(*expected));
+
+	received = manager.popIntermediateStorage();
+	REQUIRE(received);
+	REQUIRE(received->getStorageNodes().empty());
+	REQUIRE(!manager.popIntermediateStorage());
+}
+
+TEST_CASE("flat intermediate storage rejects truncated data")
+{
+	std::shared_ptr<IntermediateStorage> storage = createIntermediateStorage(1, 5);
+	const FlatIntermediateStorage flatStorage(*storage);
+	std::string data(flatStorage.getSize(), '\0');
+	flatStorage.encode(&data[0]);
+	REQUIRE(FlatIntermediateStorage::decode(data.data(), data.size()));
+
+	for (size_t size: {size_t(0), size_t(10), data.size() / 2, data.size() - 1})
+	{
+		REQUIRE(!FlatIntermediateStorage::decode(data.data(), size));
+	}
+}
+
+TEST_CASE("shared memory wakes up threads waiting for a notification")
+{
+	SharedMemory memory("notification", 1000, SharedMemory::CREATE_AND_DELETE);
+
+	{
+		SharedMemory::ScopedAccess access(&memory);
+		*access.accessValue<bool>("ready") = false;
+
+		REQUIRE(!access.waitForNotification(10));
+	}
+
+	std::thread notifier([]() {
+		SharedMemory memory("notification", 0, SharedMemory::OPEN_ONLY);
+
+		SharedMemory::ScopedAccess access(&memory);
+		*access.accessValue<bool>("ready") = true;
+		access.notifyAll();
+	});
+
+	const TimeStamp start = TimeStamp::now();
+	{
+		SharedMemory::ScopedAccess access(&memory);
+		while (!*access.accessValue<bool>("ready"))
+		{
+			access.waitForNotification(10000);
+		}
+	}
+	notifier.join();
+
+	REQUIRE(TimeStamp::now().deltaMS(start) < 5000);
+}
+
+TEST_CASE("indexing status manager wakes up waiters on finished files and interrupts")
+{
+	InterprocessIndexingStatusManager manager("status", 0, true);
+	InterprocessIndexingStatusManager indexerManager("status", 1, false);
+
+	REQUIRE(!manager.waitForFinishedProcessOrInterrupt(10));
+	REQUIRE(!indexerManager.waitForIndexingInterrupted(10));
+
+	std::thread indexer([&]() {
+		indexerManager.startIndexingSourceFile(FilePath(L"/path/to/file.cpp"));
+		indexerManager.finishIndexingSourceFile(1.0f, 0);
+	});
+	REQUIRE(manager.waitForFinishedProcessOrInterrupt(10000));
+	indexer.join();
+
+	REQUIRE(manager.getNextFinishedProcessId() == 1);
+	REQUIRE(!manager.waitForFinishedProcessOrInterrupt(10));
+
+	std::thread interrupter([&]() { manager.setIndexingInterrupted(true); });
+	REQUIRE(indexerManager.waitForIndexingInterrupted(10000));
+	interrupter.join();
+
+	REQUIRE(manager.waitForFinishedProcessOrInterrupt(10));
+}
+
+TEST_CASE("indexing status manager collects indexing durations of finished files")
+{
+	InterprocessIndexingStatusManager manager("status", 0, true);
+	InterprocessIndexingStatusManager indexerManager("status", 1, false);
+
+	indexerManager.startIndexingSourceFile(FilePath(L"/path/to/a.cpp"));
+	indexerManager.finishIndexingSourceFile(2.5f, 12);
+	indexerManager.startIndexingSourceFile(FilePath(L"/path/to/b.cpp"));
+	indexerManager.finishIndexingSourceFile(0.5f, 3);
+
+	// a crashed file has no duration
+	indexerManager.startIndexingSourceFile(FilePath(L"/path/to/c.cpp"));
+
+	std::vector<StorageIndexingDuration> durations = manager.getIndexingDurations();
+	REQUIRE(durations.size() == 2);
+	REQUIRE(durations[0].filePath == L"/path/to/a.cpp");
+	REQUIRE(durations[0].duration == 2.5f);
+	REQUIRE(durations[0].includedFileCount == 12);
+	REQUIRE(durations[1].filePath == L"/path/to/b.cpp");
+	REQUIRE(durations[1].duration == 0.5f);
+	REQUIRE(durations[1].includedFileCount == 3);
+
+	REQUIRE(manager.getIndexingDurations().empty());
+}
+
+#if BUILD_CXX_LANGUAGE_PACKAGE
+TEST_CASE("indexer commands keep their content when sharing an indexing context")
+{
+	const std::set<FilePath> indexedPaths = {
+		FilePath(L"/path/to/include"), FilePath(L"/path/to/src")};
+	const std::set<FilePathFilter> excludeFilters = {FilePathFilter(L"/path/to/src/generated/**")};
+	const std::vector<std::wstring> compilerFlags = {L"-std=c++17", L"-DNDEBUG"};
+
+	std::vector<std::shared_ptr<IndexerCommand>> commands;
+	for (size_t i = 0; i < 50; i++)
+	{
+		const FilePath sourceFilePath(L"/path/to/src/file" + std::to_wstring(i) + L".cpp");
+		commands.push_back(std::make_shared<IndexerCommandCxx>(
+			sourceFilePath,
+			i % 10 ? utility::concat(indexedPaths, {sourceFilePath}) : indexedPaths,
+			excludeFilters,
+			std::set<FilePathFilter>(),
+			FilePath(L"/path/to/build"),
+			i % 2 ? compilerFlags : utility::concat(compilerFlags, {sourceFilePath.wstr()})));
+	}
+
+	auto getStrings = [](const std::shared_ptr<IndexerCommand>& command) {
+		std::shared_ptr<IndexerCommandCxx> cxxCommand =
+			std::dynamic_pointer_cast<IndexerCommandCxx>(command);
+		REQUIRE(cxxCommand);
+
+		std::vector<std::wstring> strings = {cxxCommand->getSourceFilePath().wstr()};
+		for (const FilePath& path: cxxCommand->getIndexedPaths())
+		{
+			strings.push_back(L"indexed " + path.wstr());
+		}
+		for (const FilePathFilter& filter: cxxCommand->getExcludeFilters())
+		{
+			strings.push_back(L"exclude " + filter.wstr());
+		}
+		for (const FilePathFilter& filter: cxxCommand->getIncludeFilters())
+		{
+			strings.push_back(L"include " + filter.wstr());
+		}
+		strings.push_back(cxxCommand->getWorkingDirectory().wstr());
+		utility::append(strings, cxxCommand->getCompilerFlags());
+		return strings;
+	};
+
+	InterprocessIndexerCommandManager manager("test", 0, true);
+	InterprocessIndexerCommandManager indexerManager("test", 1, false);
+
+	manager.pushIndexerCommands(commands);
+	manager.pushIndexerCommands(commands);
+	REQUIRE(manager.indexerCommandCount() == 2 * commands.size());
+
+	for (size_t i = 0; i < 2 * commands.size(); i++)
+	{
+		std::shared_ptr<IndexerCommand> command = i % 3 ? indexerManager.popIndexerCommand()
+														: manager.popIndexerCommand();
+		REQUIRE(getStrings(command) == getStrings(commands[i % commands.size()]));
+	}
+	REQUIRE(!indexerManager.popIndexerCommand());
+
+	manager.pushIndexerCommands(commands);
+	manager.clearIndexerCommands();
+	manager.pushIndexerCommands({commands.back()});
+	REQUIRE(getStrings(indexerManager.popIndexerCommand()) == getStrings(commands.back()));
+}
+#endif	  // BUILD_CXX_LANGUAGE_PACKAGE
+
+TEST_CASE("intermediate storage transfer benchmark", "[.][benchmark]")
+{
+	InterprocessIntermediateStorageManager manager("bench", 0, true);
+
+	std::vector<std::shared_ptr<IntermediateStorage>> storages;
+	for (size_t i = 0; i < 20; i++)
+	{
+		storages.push_back(createIntermediateStorage(20, 500));
+	}
+
+	BENCHMARK("push and pop 20 intermediate storages")
+	{
+		for (const std::shared_ptr<IntermediateStorage>& storage: storages)
+		{
+			manager.pushIntermediateStorage(storage);
+		}
+
+		while (manager.popIntermediateStorage())
+			;
+	}
+}
+
+#if BUILD_CXX_LANGUAGE_PACKAGE
+TEST_CASE("indexing pipeline benchmark", "[.][benchmark]")
+{
+	// mirrors the interplay of TaskFillIndexerCommandsQueue, TaskBuildIndex and the indexers with
+	// translation units that take no time to index, so only the coordination overhead is measured
+	const size_t commandCount = 10000;
+	const size_t maximumQueueSize = 20;
+	const Id indexerCount = 4;
+
+	std::vector<std::shared_ptr<IndexerCommand>> commands;
+	for (size_t i = 0; i < commandCount; i++)
+	{
+		commands.push_back(std::make_shared<IndexerCommandCxx>(
+			FilePath(L"/path/to/src/file" + std::to_wstring(i) + L".cpp"),
+			std::set<FilePath>(),
+			std::set<FilePathFilter>(),
+			std::set<FilePathFilter>(),
+			FilePath(L"/path/to/build"),
+			std::vector<std::wstring>()));
+	}
+
+	InterprocessIndexerCommandManager commandManager("bench", 0, true);
+	InterprocessIndexingStatusManager statusManager("bench", 0, true);
+	std::vector<std::shared_ptr<InterprocessIntermediateStorageManager>> storageManagers;
+	for (Id processId = 1; processId <= indexerCount; processId++)
+	{
+		storageManagers.push_back(
+			std::make_shared<InterprocessIntermediateStorageManager>("bench", processId, true));
+	}
+
+	BENCHMARK("index 10000 tiny translation units with 4 indexers")
+	{
+		std::atomic<bool> commandsQueued(false);
+
+		std::thread filler([&]() {
+			size_t nextCommand = 0;
+			while (nextCommand < commands.size())
+			{
+				const size_t refillAmount = std::min(
+					maximumQueueSize - commandManager.indexerCommandCount(),
+					commands.size() - nextCommand);
+				if (refillAmount)
+				{
+					auto begin = commands.begin() + nextCommand;
+					commandManager.pushIndexerCommands(
+						std::vector<std::shared_ptr<IndexerCommand>>(begin, begin + refillAmount));
+					nextCommand += refillAmount;
+				}
+				else
+				{
+					commandManager.waitForIndexerCommandCountBelow(maximumQueueSize / 2 + 1, 200);
+				}
+			}
+			commandsQueued = true;
+		});
+
+		std::vector<std::shared_ptr<std::thread>> indexers;
+		for (Id processId = 1; processId <= indexerCount; processId++)
+		{
+			indexers.push_back(std::make_shared<std::thread>([&commandsQueued, processId]() {
+				InterprocessIndexerCommandManager commandManager("bench", processId, false);
+				InterprocessIndexingStatusManager statusManager("bench", processId, false);
+				InterprocessIntermediateStorageManager storageManager("bench", processId, false);
+
+				while (true)
+				{
+					std::shared_ptr<IndexerCommand> command = commandManager.popIndexerCommand();
+					if (!command)
+					{
+						if (commandsQueued)
+						{
+							break;
+						}
+						commandManager.waitForIndexerCommands(200);
+						continue;
+					}
+
+					while (!storageManager.waitForIntermediateStorageCountBelow(2, 200))
+						;
+
+					statusManager.startIndexingSourceFile(command->getSourceFilePath());
+					storageManager.pushIntermediateStorage(createIntermediateStorage(1, 1));
+					statusManager.finishIndexingSourceFile(0.5f, 1);
+				}
+			}));
+		}
+
+		size_t fetchedCount = 0;
+		while (fetchedCount < commandCount)
+		{
+			statusManager.getCurrentlyIndexedSourceFilePaths();
+
+			const Id finishedProcessId = statusManager.getNextFinishedProcessId();
+			if (finishedProcessId)
+			{
+				storageManagers[finishedProcessId - 1]->popIntermediateStorage();
+				fetchedCount++;
+			}
+			else
+			{
+				statusManager.waitForFinishedProcessOrInterrupt(50);
+			}
+		}
+
+		filler.join();
+		for (const std::shared_ptr<std::thread>& indexer: indexers)
+		{
+			indexer->join();
+		}
+	};
+}
+#endif	  // BUILD_CXX_LANGUAGE_PACKAGE
@@ -1,7 +1,18 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <thread>
+
+#include "Edge.h"
 #include "FileSystem.h"
+#include "IndexSnapshot.h"
+#include "NodeKind.h"
+#include "SourceLocation.h"
+#include "SourceLocationFile.h"
 #include "SqliteIndexStorage.h"
+#include "utilityString.h"
 
 TEST_CASE("storage adds node successfully")
 {
@@ -76,3 +87,797 @@ TEST_CASE("storage removes edge successfully")
 
 	REQUIRE(0 == edgeCount);
 }
+
+TEST_CASE("storage finds elements for id lists larger than one lookup batch")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	std::vector<Id> nodeIds;
+	std::vector<StorageNode> nodes;
+	std::vector<StorageEdge> edges;
+	std::vector<StorageEdge> typedEdges;
+	StorageNode firstNode;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.beginTransaction();
+		Id rootNodeId = storage.addNode(StorageNodeData(0, L"root"));
+		for (int i = 0; i < 1000; i++)
+		{
+			Id nodeId = storage.addNode(StorageNodeData(0, L"node" + std::to_wstring(i)));
+			storage.addEdge(StorageEdgeData(i % 2 ? 1 : 2, nodeId, rootNodeId));
+			nodeIds.push_back(nodeId);
+		}
+		storage.commitTransaction();
+
+		// duplicates must not return elements twice
+		std::vector<Id> requestedIds = nodeIds;
+		requestedIds.insert(requestedIds.end(), nodeIds.begin(), nodeIds.begin() + 10);
+		requestedIds.push_back(0);
+
+		nodes = storage.getAllByIds<StorageNode>(requestedIds);
+		edges = storage.getEdgesBySourceIds(requestedIds);
+		typedEdges = storage.getEdgesBySourcesType(requestedIds, 1);
+		firstNode = storage.getFirstById<StorageNode>(nodeIds.front());
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(1000 == nodes.size());
+	REQUIRE(1000 == edges.size());
+	REQUIRE(500 == typedEdges.size());
+	REQUIRE(L"node0" == firstNode.serializedName);
+}
+
+TEST_CASE("storage keeps elements located in other files when clearing files")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	bool sharedNodeKeptFirst = false;
+	bool ownNodeKeptFirst = true;
+	bool sharedNodeKeptSecond = true;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.setMode(SqliteIndexStorage::STORAGE_MODE_CLEAR);
+		storage.beginTransaction();
+		Id firstFileId = storage.addNode(StorageNodeData(0, L"first"));
+		Id secondFileId = storage.addNode(StorageNodeData(0, L"second"));
+		Id sharedNodeId = storage.addNode(StorageNodeData(0, L"a"));
+		Id ownNodeId = storage.addNode(StorageNodeData(0, L"b"));
+		std::vector<Id> locationIds = storage.addSourceLocations(
+			{StorageSourceLocation(0, firstFileId, 1, 1, 1, 2, 0),
+			 StorageSourceLocation(0, firstFileId, 2, 1, 2, 2, 0),
+			 StorageSourceLocation(0, secondFileId, 1, 1, 1, 2, 0)});
+		storage.addOccurrences(
+			{StorageOccurrence(sharedNodeId, locationIds[0]),
+			 StorageOccurrence(ownNodeId, locationIds[1]),
+			 StorageOccurrence(sharedNodeId, locationIds[2])});
+		storage.commitTransaction();
+
+		storage.removeElementsWithLocationInFiles({firstFileId}, nullptr);
+		sharedNodeKeptFirst = storage.isNode(sharedNodeId);
+		ownNodeKeptFirst = storage.isNode(ownNodeId);
+
+		storage.removeElementsWithLocationInFiles({secondFileId}, nullptr);
+		sharedNodeKeptSecond = storage.isNode(sharedNodeId);
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(sharedNodeKeptFirst);
+	REQUIRE(!ownNodeKeptFirst);
+	REQUIRE(!sharedNodeKeptSecond);
+}
+
+TEST_CASE("storage replaces indexing durations of source files")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	std::vector<StorageIndexingDuration> durations;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.addIndexingDurations(
+			{StorageIndexingDuration(L"/src/a.cpp", 1.5f, 10),
+			 StorageIndexingDuration(L"/src/b.cpp", 0.25f, 2)});
+		storage.addIndexingDurations({StorageIndexingDuration(L"/src/a.cpp", 3.0f, 20)});
+		durations = storage.getIndexingDurations();
+	}
+	FileSystem::remove(databasePath);
+
+	std::sort(
+		durations.begin(),
+		durations.end(),
+		[](const StorageIndexingDuration& a, const StorageIndexingDuration& b) {
+			return a.filePath < b.filePath;
+		});
+
+	REQUIRE(2 == durations.size());
+	REQUIRE(L"/src/a.cpp" == durations[0].filePath);
+	REQUIRE(3.0f == durations[0].duration);
+	REQUIRE(20 == durations[0].includedFileCount);
+	REQUIRE(L"/src/b.cpp" == durations[1].filePath);
+	REQUIRE(0.25f == durations[1].duration);
+	REQUIRE(2 == durations[1].includedFileCount);
+}
+
+TEST_CASE("storage removes indexing durations of removed source files")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	std::vector<StorageIndexingDuration> durations;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.setMode(SqliteIndexStorage::STORAGE_MODE_WRITE);
+		Id fileId = storage.addNode(StorageNodeData(0, L"a.cpp"));
+		storage.addFile(StorageFile(fileId, L"/src/a.cpp", L"cpp", "", true, true));
+		storage.addIndexingDurations(
+			{StorageIndexingDuration(L"/src/a.cpp", 1.5f, 10),
+			 StorageIndexingDuration(L"/src/b.cpp", 0.25f, 2)});
+		storage.removeIndexingDurationsOfRemovedFiles();
+		durations = storage.getIndexingDurations();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(1 == durations.size());
+	REQUIRE(L"/src/a.cpp" == durations[0].filePath);
+}
+
+TEST_CASE("storage reads last committed state on other threads while writing")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	int nodeCountWhileWriting = -1;
+	int nodeCountOutsideReadTransactionWhileWriting = -1;
+	int nodeCountAfterCommitInSameTransaction = -1;
+	int nodeCountAfterCommit = -1;
+	int nodeCountOnWritingThread = -1;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.enableConcurrentReads();
+		storage.addNode(StorageNodeData(0, L"a"));
+
+		storage.beginTransaction();
+		storage.addNode(StorageNodeData(0, L"b"));
+
+		std::promise<void> readStarted;
+		std::promise<void> writeCommitted;
+		std::thread reader([&]() {
+			nodeCountOutsideReadTransactionWhileWriting = storage.getNodeCount();
+
+			storage.beginReadTransaction();
+			nodeCountWhileWriting = storage.getNodeCount();
+			readStarted.set_value();
+
+			writeCommitted.get_future().wait();
+			nodeCountAfterCommitInSameTransaction = storage.getNodeCount();
+			storage.endReadTransaction();
+
+			storage.beginReadTransaction();
+			nodeCountAfterCommit = storage.getNodeCount();
+			storage.endReadTransaction();
+		});
+
+		readStarted.get_future().wait();
+
+		storage.beginReadTransaction();
+		nodeCountOnWritingThread = storage.getNodeCount();
+		storage.endReadTransaction();
+
+		storage.commitTransaction();
+		writeCommitted.set_value();
+		reader.join();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(1 == nodeCountWhileWriting);
+	REQUIRE(1 == nodeCountOutsideReadTransactionWhileWriting);
+	REQUIRE(1 == nodeCountAfterCommitInSameTransaction);
+	REQUIRE(2 == nodeCountAfterCommit);
+	REQUIRE(2 == nodeCountOnWritingThread);
+	REQUIRE(!FilePath(databasePath.wstr() + L"-wal").exists());
+}
+
+TEST_CASE("storage hands write transaction to nested transactions of other threads")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	int nodeCountInNestedTransaction = -1;
+	int nodeCountAfterNestedTransaction = -1;
+	int nodeCountOnOuterThread = -1;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.enableConcurrentReads();
+		storage.addNode(StorageNodeData(0, L"a"));
+
+		storage.beginTransaction();
+		storage.addNode(StorageNodeData(0, L"b"));
+
+		std::thread writer([&]() {
+			storage.beginTransaction();
+			storage.addNode(StorageNodeData(0, L"c"));
+			nodeCountInNestedTransaction = storage.getNodeCount();
+			storage.commitTransaction();
+
+			nodeCountAfterNestedTransaction = storage.getNodeCount();
+		});
+		writer.join();
+
+		nodeCountOnOuterThread = storage.getNodeCount();
+		storage.commitTransaction();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(3 == nodeCountInNestedTransaction);
+	REQUIRE(1 == nodeCountAfterNestedTransaction);
+	REQUIRE(3 == nodeCountOnOuterThread);
+}
+
+TEST_CASE("storage opens database that another storage uses with write-ahead logging")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	int nodeCount = -1;
+	bool walExistsAfterOtherStorage = false;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.enableConcurrentReads();
+		storage.addNode(StorageNodeData(0, L"a"));
+
+		{
+			SqliteIndexStorage otherStorage(databasePath);
+			otherStorage.setup();
+			nodeCount = otherStorage.getNodeCount();
+		}
+
+		walExistsAfterOtherStorage = FilePath(databasePath.wstr() + L"-wal").exists();
+		storage.addNode(StorageNodeData(0, L"b"));
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(1 == nodeCount);
+	REQUIRE(walExistsAfterOtherStorage);
+	REQUIRE(!FilePath(databasePath.wstr() + L"-wal").exists());
+}
+
+TEST_CASE("storage lookups of other threads on the same connection do not interfere")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	size_t interruptedLookupCount = 0;
+	size_t interleavedLookupCount = 0;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.beginTransaction();
+		std::vector<Id> nodeIds;
+		for (int i = 0; i < 1000; i++)
+		{
+			nodeIds.push_back(storage.addNode(StorageNodeData(0, L"node" + std::to_wstring(i))));
+		}
+		storage.commitTransaction();
+
+		// without concurrent reads all threads look up on the main connection
+		std::promise<void> interruptedLookupStarted;
+		std::promise<void> interleavedLookupDone;
+		std::thread reader;
+
+		bool readerStarted = false;
+		storage.forEachByIds<StorageNode>(nodeIds, [&](StorageNode&&) {
+			if (!readerStarted)
+			{
+				readerStarted = true;
+				reader = std::thread([&]() {
+					bool waited = false;
+					storage.forEachByIds<StorageNode>(nodeIds, [&](StorageNode&&) {
+						if (!waited)
+						{
+							waited = true;
+							interruptedLookupStarted.set_value();
+							interleavedLookupDone.get_future().wait();
+						}
+						interruptedLookupCount++;
+					});
+				});
+				interruptedLookupStarted.get_future().wait();
+			}
+		});
+
+		// starts while the reader is still in the middle of its lookup
+		storage.forEachByIds<StorageNode>(
+			std::vector<Id>(nodeIds.begin(), nodeIds.begin() + 600),
+			[&](StorageNode&&) { interleavedLookupCount++; });
+
+		interleavedLookupDone.set_value();
+		reader.join();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(1000 == interruptedLookupCount);
+	REQUIRE(600 == interleavedLookupCount);
+}
+
+TEST_CASE("storage does not reuse ids written by another connection between transactions")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	Id otherNodeId = 0;
+	Id nodeId = 0;
+	int nodeCount = -1;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.beginTransaction();
+		storage.addNode(StorageNodeData(0, L"a"));
+		storage.commitTransaction();
+
+		{
+			SqliteIndexStorage otherStorage(databasePath);
+			otherStorage.setup();
+			otherStorage.beginTransaction();
+			otherNodeId = otherStorage.addNode(StorageNodeData(0, L"b"));
+			otherStorage.commitTransaction();
+		}
+
+		storage.beginTransaction();
+		nodeId = storage.addNode(StorageNodeData(0, L"c"));
+		storage.commitTransaction();
+		nodeCount = storage.getNodeCount();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(otherNodeId != nodeId);
+	REQUIRE(3 == nodeCount);
+}
+
+TEST_CASE("storage generates ids after the writes of other connections")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	std::vector<Id> ids;
+	size_t nodeCount = 0;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+
+		storage.beginTransaction();
+		ids.push_back(storage.addNode(StorageNodeData(0, L"a")));
+		storage.commitTransaction();
+
+		{
+			SqliteIndexStorage otherStorage(databasePath);
+			otherStorage.setup();
+			otherStorage.beginTransaction();
+			ids.push_back(otherStorage.addNode(StorageNodeData(0, L"b")));
+			otherStorage.commitTransaction();
+		}
+
+		storage.beginTransaction();
+		ids.push_back(storage.addNode(StorageNodeData(0, L"c")));
+		storage.commitTransaction();
+
+		nodeCount = storage.getAll<StorageNode>().size();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(nodeCount == 3);
+	REQUIRE(ids[0] != ids[1]);
+	REQUIRE(ids[1] != ids[2]);
+	REQUIRE(ids[0] != ids[2]);
+}
+
+TEST_CASE("index snapshot contains stored nodes, files, symbols and edges")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	FilePath snapshotPath = IndexSnapshot::getSnapshotFilePath(databasePath);
+	std::vector<StorageNode> nodes;
+	std::vector<StorageFile> files;
+	std::vector<StorageSymbol> symbols;
+	std::vector<StorageEdge> edges;
+	bool loaded = false;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.beginTransaction();
+		Id sourceNodeId = storage.addNode(StorageNodeData(1, L"a"));
+		Id targetNodeId = storage.addNode(StorageNodeData(2, L"b"));
+		Id fileNodeId = storage.addNode(StorageNodeData(3, L"main.cpp"));
+		storage.addSymbol(StorageSymbol(sourceNodeId, 2));
+		storage.addFile(StorageFile(fileNodeId, L"main.cpp", L"cpp", "", true, false));
+		storage.addEdge(StorageEdgeData(8, sourceNodeId, targetNodeId));
+		storage.commitTransaction();
+
+		{
+			IndexSnapshot snapshot;
+			snapshot.build(storage, SqliteIndexStorage::getStorageVersion(), "2020-01-01 10:00:00");
+			snapshot.save(snapshotPath);
+		}
+
+		IndexSnapshot snapshot;
+		loaded = snapshot.load(
+			snapshotPath, SqliteIndexStorage::getStorageVersion(), "2020-01-01 10:00:00");
+		snapshot.forEach<StorageNode>([&nodes](StorageNode&& node) { nodes.push_back(node); });
+		snapshot.forEach<StorageFile>([&files](StorageFile&& file) { files.push_back(file); });
+		snapshot.forEach<StorageSymbol>(
+			[&symbols](StorageSymbol&& symbol) { symbols.push_back(symbol); });
+		snapshot.forEachOfType<StorageEdge>(
+			8, [&edges](StorageEdge&& edge) { edges.push_back(edge); });
+	}
+	FileSystem::remove(databasePath);
+	FileSystem::remove(snapshotPath);
+
+	REQUIRE(loaded);
+
+	REQUIRE(3 == nodes.size());
+	REQUIRE(L"a" == nodes[0].serializedName);
+	REQUIRE(2 == nodes[1].type);
+	REQUIRE(L"main.cpp" == nodes[2].serializedName);
+
+	REQUIRE(1 == files.size());
+	REQUIRE(nodes[2].id == files[0].id);
+	REQUIRE(L"main.cpp" == files[0].filePath);
+	REQUIRE(L"cpp" == files[0].languageIdentifier);
+	REQUIRE(files[0].indexed);
+	REQUIRE(!files[0].complete);
+
+	REQUIRE(1 == symbols.size());
+	REQUIRE(2 == symbols[0].definitionKind);
+
+	REQUIRE(1 == edges.size());
+	REQUIRE(nodes[0].id == edges[0].sourceNodeId);
+	REQUIRE(nodes[1].id == edges[0].targetNodeId);
+}
+
+TEST_CASE("index snapshot is rejected if timestamp does not match")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	FilePath snapshotPath = IndexSnapshot::getSnapshotFilePath(databasePath);
+	bool loaded = true;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.beginTransaction();
+		storage.addNode(StorageNodeData(1, L"a"));
+		storage.commitTransaction();
+
+		IndexSnapshot snapshot;
+		snapshot.build(storage, SqliteIndexStorage::getStorageVersion(), "2020-01-01 10:00:00");
+		snapshot.save(snapshotPath);
+
+		loaded = snapshot.load(
+			snapshotPath, SqliteIndexStorage::getStorageVersion(), "2020-01-01 10:00:01");
+	}
+	FileSystem::remove(databasePath);
+	FileSystem::remove(snapshotPath);
+
+	REQUIRE(!loaded);
+}
+
+TEST_CASE("storage reads lines of file content across content blocks")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	FilePath filePath(L"data/SQLiteTestSuite/content.cpp");
+
+	std::vector<std::string> lines;
+	for (size_t i = 0; i < 200; i++)
+	{
+		lines.push_back("int value" + std::to_string(i) + " = " + std::to_string(i * i) + ";\n");
+	}
+	{
+		std::ofstream file(filePath.str());
+		for (const std::string& line: lines)
+		{
+			file << line;
+		}
+	}
+
+	std::string text;
+	std::vector<std::string> blockBorderLines;
+	std::vector<std::string> outOfRangeLines;
+	size_t lineCount = 0;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.setMode(SqliteIndexStorage::STORAGE_MODE_WRITE);
+		Id fileId = storage.addNode(StorageNodeData(0, L"content"));
+		storage.addFile(StorageFile(fileId, filePath.wstr(), L"cpp", "", true, true));
+
+		text = storage.getFileContentTextById(fileId);
+		blockBorderLines = storage.getFileContentLinesById(fileId, 60, 70);
+		outOfRangeLines = storage.getFileContentLinesById(fileId, 199, 201);
+		lineCount = storage.getFileContentLineCountById(fileId);
+	}
+	FileSystem::remove(databasePath);
+	FileSystem::remove(filePath);
+
+	REQUIRE(text == utility::join(lines, ""));
+	REQUIRE(blockBorderLines == std::vector<std::string>(lines.begin() + 59, lines.begin() + 70));
+	REQUIRE(outOfRangeLines.empty());
+	REQUIRE(200 == lineCount);
+}
+
+namespace
+{
+std::vector<std::string> getLocationStrings(std::shared_ptr<SourceLocationFile> file)
+{
+	std::vector<std::string> strings;
+	file->forEachSourceLocation([&strings](SourceLocation* location) {
+		strings.push_back(
+			std::to_string(location->getLocationId()) + ":" + std::to_string(location->getType()) +
+			":" + std::to_string(location->getLineNumber()) + ":" +
+			std::to_string(location->getColumnNumber()) + ":" +
+			utility::join(utility::toStrings(location->getTokenIds()), ','));
+	});
+	std::sort(strings.begin(), strings.end());
+	return strings;
+}
+}	 // namespace
+
+TEST_CASE("storage reads the same source locations after packing them")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	FilePath filePath(L"data/SQLiteTestSuite/packed.cpp");
+
+	std::vector<std::vector<std::string>> rowLocations;
+	std::vector<std::vector<std::string>> packedLocations;
+	size_t locationCountAfterAdding = 0;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.setMode(SqliteIndexStorage::STORAGE_MODE_READ);
+		Id fileId = storage.addNode(StorageNodeData(0, L"packed"));
+		storage.addFile(
+			StorageFile(fileId, filePath.wstr(), L"cpp", "2020-01-01 00:00:00", false, true));
+		Id firstNodeId = storage.addNode(StorageNodeData(0, L"a"));
+		Id secondNodeId = storage.addNode(StorageNodeData(0, L"b"));
+
+		std::vector<StorageSourceLocation> locations;
+		for (size_t i = 1; i <= 100; i++)
+		{
+			locations.emplace_back(0, fileId, i, 1, i, 5, locationTypeToInt(LOCATION_TOKEN));
+			if (i % 10 == 1)
+			{
+				locations.emplace_back(0, fileId, i, 1, i + 9, 1, locationTypeToInt(LOCATION_SCOPE));
+			}
+		}
+		std::vector<Id> locationIds = storage.addSourceLocations(locations);
+
+		std::vector<StorageOccurrence> occurrences;
+		for (size_t i = 0; i < locationIds.size(); i++)
+		{
+			occurrences.emplace_back(firstNodeId, locationIds[i]);
+			if (i % 3 == 0)
+			{
+				occurrences.emplace_back(secondNodeId, locationIds[i]);
+			}
+		}
+		storage.addOccurrences(occurrences);
+
+		auto readLocations = [&]() {
+			return std::vector<std::vector<std::string>> {
+				getLocationStrings(storage.getSourceLocationsForFile(filePath)),
+				getLocationStrings(storage.getSourceLocationsForLinesInFile(filePath, 45, 55)),
+				getLocationStrings(
+					storage.getSourceLocationsOfTypeInFile(filePath, LOCATION_SCOPE))};
+		};
+
+		rowLocations = readLocations();
+		storage.packSourceLocations();
+		packedLocations = readLocations();
+
+		storage.addSourceLocations(
+			{StorageSourceLocation(0, fileId, 101, 1, 101, 5, locationTypeToInt(LOCATION_TOKEN))});
+		locationCountAfterAdding = getLocationStrings(storage.getSourceLocationsForFile(filePath))
+									   .size();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(220 == rowLocations[0].size());
+	REQUIRE(26 == rowLocations[1].size());
+	REQUIRE(20 == rowLocations[2].size());
+	REQUIRE(rowLocations == packedLocations);
+	REQUIRE(222 == locationCountAfterAdding);
+}
+
+TEST_CASE("storage does not read packed source locations of files written by other connections")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	FilePath filePath(L"data/SQLiteTestSuite/packed.cpp");
+
+	size_t locationCountAfterExternalInsert = 0;
+	size_t locationCountAfterExternalDelete = 0;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.setMode(SqliteIndexStorage::STORAGE_MODE_READ);
+		Id fileId = storage.addNode(StorageNodeData(0, L"packed"));
+		storage.addFile(
+			StorageFile(fileId, filePath.wstr(), L"cpp", "2020-01-01 00:00:00", false, true));
+
+		std::vector<StorageSourceLocation> locations;
+		for (size_t i = 1; i <= 100; i++)
+		{
+			locations.emplace_back(0, fileId, i, 1, i, 5, locationTypeToInt(LOCATION_TOKEN));
+		}
+		storage.addSourceLocations(locations);
+		storage.packSourceLocations();
+
+		CppSQLite3DB database;
+		database.open(utility::encodeToUtf8(databasePath.getCanonical().wstr()).c_str());
+		database.execDML(
+			("INSERT INTO source_location(file_node_id, start_line, start_column, end_line, "
+			 "end_column, type) VALUES(" +
+			 std::to_string(fileId) + ", 101, 1, 101, 5, 0);")
+				.c_str());
+		locationCountAfterExternalInsert =
+			getLocationStrings(storage.getSourceLocationsForFile(filePath)).size();
+
+		database.execDML(
+			("DELETE FROM source_location WHERE file_node_id = " + std::to_string(fileId) +
+			 " AND start_line = 1;")
+				.c_str());
+		database.close();
+		locationCountAfterExternalDelete =
+			getLocationStrings(storage.getSourceLocationsForFile(filePath)).size();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(202 == locationCountAfterExternalInsert);
+	REQUIRE(200 == locationCountAfterExternalDelete);
+}
+
+TEST_CASE("storage of interrupted bulk load is incompatible")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	bool incompatibleWhileLoading = false;
+	bool incompatibleAfterReopening = false;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.setVersion(storage.getStaticVersion());
+		storage.beginBulkLoad();
+		storage.beginTransaction();
+		storage.addNode(StorageNodeData(0, L"a"));
+		storage.commitTransaction();
+		incompatibleWhileLoading = storage.isIncompatible();
+	}
+	{
+		SqliteIndexStorage storage(databasePath);
+		incompatibleAfterReopening = storage.isIncompatible();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(incompatibleWhileLoading);
+	REQUIRE(incompatibleAfterReopening);
+}
+
+TEST_CASE("storage restores foreign keys when bulk load is finished")
+{
+	FilePath databasePath(L"data/SQLiteTestSuite/test.sqlite");
+	int lastProgress = 0;
+	bool incompatible = true;
+	int edgeCount = -1;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.setVersion(storage.getStaticVersion());
+		storage.beginBulkLoad();
+		storage.beginTransaction();
+		Id sourceNodeId = storage.addNode(StorageNodeData(0, L"a"));
+		Id targetNodeId = storage.addNode(StorageNodeData(0, L"b"));
+		storage.addEdge(StorageEdgeData(0, sourceNodeId, targetNodeId));
+		storage.commitTransaction();
+		storage.finishBulkLoad([&lastProgress](int progress) { lastProgress = progress; });
+		incompatible = storage.isIncompatible();
+
+		storage.beginTransaction();
+		storage.removeElement(sourceNodeId);
+		storage.commitTransaction();
+		edgeCount = storage.getEdgeCount();
+	}
+	FileSystem::remove(databasePath);
+
+	REQUIRE(100 == lastProgress);
+	REQUIRE(!incompatible);
+	REQUIRE(0 == edgeCount);
+}
+
+TEST_CASE("clearing files benchmark", "[.][benchmark]")
+{
+	const FilePath databasePath(L"data/SQLiteTestSuite/benchmark.sqlite");
+	const FilePath clearedDatabasePath(L"data/SQLiteTestSuite/benchmark_cleared.sqlite");
+	const size_t fileCount = 1000;
+	const size_t nodesPerFile = 200;
+	const size_t locationsPerNode = 4;
+	const size_t sharedNodeCount = 10000;
+
+	// every file has 1000 locations: its own nodes and one call of a shared node per own node
+	std::vector<Id> fileIds;
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.setMode(SqliteIndexStorage::STORAGE_MODE_WRITE);
+		storage.beginTransaction();
+
+		std::vector<StorageNode> sharedNodes;
+		for (size_t i = 0; i < sharedNodeCount; i++)
+		{
+			sharedNodes.emplace_back(
+				0, nodeKindToInt(NODE_FUNCTION), L"shared" + std::to_wstring(i));
+		}
+		const std::vector<Id> sharedNodeIds = storage.addNodes(sharedNodes);
+
+		uint32_t random = 42;
+		for (size_t i = 0; i < fileCount; i++)
+		{
+			const std::wstring fileName = L"file" + std::to_wstring(i);
+			const Id fileId = storage.addNode(StorageNodeData(nodeKindToInt(NODE_FILE), fileName));
+			fileIds.push_back(fileId);
+
+			std::vector<StorageNode> nodes;
+			for (size_t j = 0; j < nodesPerFile; j++)
+			{
+				nodes.emplace_back(
+					0, nodeKindToInt(NODE_FUNCTION), fileName + L"::node" + std::to_wstring(j));
+			}
+			const std::vector<Id> nodeIds = storage.addNodes(nodes);
+
+			std::vector<StorageEdge> edges;
+			std::vector<StorageSourceLocation> locations;
+			for (size_t j = 0; j < nodesPerFile; j++)
+			{
+				random = random * 1664525 + 1013904223;
+				edges.emplace_back(
+					0,
+					Edge::typeToInt(Edge::EDGE_CALL),
+					nodeIds[j],
+					sharedNodeIds[random % sharedNodeCount]);
+
+				for (size_t k = 0; k <= locationsPerNode; k++)
+				{
+					const size_t line = j * (locationsPerNode + 1) + k + 1;
+					locations.emplace_back(0, fileId, line, 1, line, 10, 0);
+				}
+			}
+			const std::vector<Id> edgeIds = storage.addEdges(edges);
+			const std::vector<Id> locationIds = storage.addSourceLocations(locations);
+
+			std::vector<StorageOccurrence> occurrences;
+			for (size_t j = 0; j < nodesPerFile; j++)
+			{
+				const size_t firstLocation = j * (locationsPerNode + 1);
+				for (size_t k = 0; k < locationsPerNode; k++)
+				{
+					occurrences.emplace_back(nodeIds[j], locationIds[firstLocation + k]);
+				}
+				const Id callLocationId = locationIds[firstLocation + locationsPerNode];
+				occurrences.emplace_back(edges[j].targetNodeId, callLocationId);
+				occurrences.emplace_back(edgeIds[j], callLocationId);
+			}
+			storage.addOccurrences(occurrences);
+		}
+		storage.commitTransaction();
+		REQUIRE(storage.getSourceLocationCount() == 1000000);
+	}
+
+	for (size_t percentage: {1, 10, 50})
+	{
+		FileSystem::remove(clearedDatabasePath);
+		FileSystem::copyFile(databasePath, clearedDatabasePath);
+		{
+			SqliteIndexStorage storage(clearedDatabasePath);
+			storage.setup();
+			storage.setMode(SqliteIndexStorage::STORAGE_MODE_CLEAR);
+			const int nodeCount = storage.getNodeCount();
+
+			const std::vector<Id> clearedFileIds(
+				fileIds.begin(), fileIds.begin() + fileCount * percentage / 100);
+
+			storage.beginTransaction();
+			BENCHMARK("clearing " + std::to_string(percentage) + "% of files")
+			{
+				storage.removeElementsWithLocationInFiles(clearedFileIds, nullptr);
+			}
+			storage.commitTransaction();
+
+			REQUIRE(
+				storage.getNodeCount() <=
+				nodeCount - static_cast<int>(clearedFileIds.size() * nodesPerFile));
+		}
+		FileSystem::remove(clearedDatabasePath);
+	}
+	FileSystem::remove(databasePath);
+}
@@ -0,0 +1,82 @@
+#include "catch.hpp"
+
+#include "Blackboard.h"
+#include "IntermediateStorage.h"
+#include "NodeKind.h"
+#include "StorageProvider.h"
+#include "TaskMergeStorages.h"
+
+namespace
+{
+std::shared_ptr<IntermediateStorage> createStorage(
+	const std::wstring& fileName, size_t sourceLocationCount)
+{
+	std::shared_ptr<IntermediateStorage> storage = std::make_shared<IntermediateStorage>();
+	const Id fileId = storage->addNode(StorageNodeData(nodeKindToInt(NODE_FILE), fileName)).first;
+	for (size_t i = 0; i < sourceLocationCount; i++)
+	{
+		storage->addSourceLocation(StorageSourceLocationData(fileId, i + 1, 1, i + 1, 2, 0));
+	}
+	return storage;
+}
+}	 // namespace
+
+TEST_CASE("storage provider consumes smallest storages and leaves largest one")
+{
+	StorageProvider provider;
+	provider.insert(createStorage(L"a", 1));
+	provider.insert(createStorage(L"b", 3));
+	provider.insert(createStorage(L"c", 2));
+
+	std::shared_ptr<IntermediateStorage> first = provider.consumeSmallestStorage();
+	std::shared_ptr<IntermediateStorage> second = provider.consumeSmallestStorage();
+	std::shared_ptr<IntermediateStorage> third = provider.consumeSmallestStorage();
+
+	REQUIRE(first);
+	REQUIRE(1 == first->getSourceLocationCount());
+	REQUIRE(second);
+	REQUIRE(2 == second->getSourceLocationCount());
+	REQUIRE(!third);
+	REQUIRE(1 == provider.getStorageCount());
+	REQUIRE(3 == provider.consumeLargestStorage()->getSourceLocationCount());
+}
+
+TEST_CASE("merge storages stops merging into target after source location budget")
+{
+	std::shared_ptr<StorageProvider> provider = std::make_shared<StorageProvider>();
+	provider->insert(createStorage(L"largest", 100));
+	provider->insert(createStorage(L"target", 50));
+	for (int i = 0; i < 4; i++)
+	{
+		provider->insert(createStorage(L"small" + std::to_wstring(i), 10));
+	}
+
+	TaskMergeStorages task(provider, 25);
+	const Task::TaskState state = task.update(std::make_shared<Blackboard>());
+
+	REQUIRE(Task::STATE_SUCCESS == state);
+	REQUIRE(3 == provider->getStorageCount());
+	REQUIRE(100 == provider->consumeLargestStorage()->getSourceLocationCount());
+	REQUIRE(80 == provider->consumeLargestStorage()->getSourceLocationCount());
+	REQUIRE(10 == provider->consumeLargestStorage()->getSourceLocationCount());
+}
+
+TEST_CASE("merge storages fails if there is nothing to merge")
+{
+	std::shared_ptr<StorageProvider> provider = std::make_shared<StorageProvider>();
+	provider->insert(createStorage(L"largest", 100));
+	provider->insert(createStorage(L"target", 50));
+
+	TaskMergeStorages task(provider);
+
+	REQUIRE(Task::STATE_FAILURE == task.update(std::make_shared<Blackboard>()));
+	REQUIRE(2 == provider->getStorageCount());
+}
+
+TEST_CASE("merge worker count is taken from setting or derived from indexer threads")
+{
+	REQUIRE(3 == TaskMergeStorages::getWorkerCount(3, 16));
+	REQUIRE(2 == TaskMergeStorages::getWorkerCount(0, 16));
+	REQUIRE(1 == TaskMergeStorages::getWorkerCount(0, 4));
+	REQUIRE(1 == TaskMergeStorages::getWorkerCount(-1, 0));
+}
@@ -1,18 +1,29 @@
 #include "catch.hpp"
 
+#include <algorithm>
+#include <fstream>
+#include <map>
+
 #include "utilityString.h"
 
+#include "AccessKind.h"
+#include "AdjacencyIndex.h"
+#include "FileSystem.h"
+#include "Graph.h"
 #include "IntermediateStorage.h"
 #include "ParseLocation.h"
 #include "PersistentStorage.h"
+#include "SourceLocationCollection.h"
+#include "SourceLocationFile.h"
+#include "SqliteIndexStorage.h"
 
 namespace
 {
 class TestStorage: public PersistentStorage
 {
 public:
-	TestStorage()
-		: PersistentStorage(FilePath(L"data/test.sqlite"), FilePath(L"data/testBookmarks.sqlite"))
+	TestStorage(const FilePath& dbFilePath = FilePath(L"data/test.sqlite"))
+		: PersistentStorage(dbFilePath, FilePath(L"data/testBookmarks.sqlite"))
 	{
 		clear();
 	}
@@ -52,6 +63,106 @@ NameHierarchy createFunctionNameHierarchy(std::wstring ret, std::wstring name, s
 	nameHierarchy.push(NameElement(lastName, ret, parameters));
 	return nameHierarchy;
 }
+
+std::shared_ptr<IntermediateStorage> createFileStorage(
+	const std::wstring& filePath,
+	const std::vector<std::wstring>& functionNames,
+	const std::vector<std::pair<std::wstring, std::wstring>>& calls)
+{
+	std::shared_ptr<IntermediateStorage> intermetiateStorage = std::make_shared<IntermediateStorage>();
+
+	const NameHierarchy fileNameHierarchy(filePath, NAME_DELIMITER_FILE);
+	const Id fileId = intermetiateStorage
+						  ->addNode(StorageNodeData(
+							  nodeKindToInt(NODE_FILE), NameHierarchy::serialize(fileNameHierarchy)))
+						  .first;
+	intermetiateStorage->addFile(StorageFile(fileId, filePath, L"cpp", "", true, true));
+	intermetiateStorage->addSymbol(StorageSymbol(fileId, definitionKindToInt(DEFINITION_EXPLICIT)));
+
+	std::map<std::wstring, Id> functionIds;
+	auto addOccurrence = [&](Id elementId) {
+		const int line = static_cast<int>(functionIds.size()) + 1;
+		const Id locationId = intermetiateStorage->addSourceLocation(StorageSourceLocationData(
+			fileId, line, 1, line, 5, locationTypeToInt(LOCATION_TOKEN)));
+		intermetiateStorage->addOccurrence(StorageOccurrence(elementId, locationId));
+	};
+	auto addFunction = [&](const std::wstring& name) {
+		auto it = functionIds.find(name);
+		if (it != functionIds.end())
+		{
+			return it->second;
+		}
+
+		const Id id = intermetiateStorage
+						  ->addNode(StorageNodeData(
+							  nodeKindToInt(NODE_FUNCTION),
+							  NameHierarchy::serialize(createNameHierarchy(name))))
+						  .first;
+		addOccurrence(id);
+		functionIds.emplace(name, id);
+		return id;
+	};
+
+	for (const std::wstring& name: functionNames)
+	{
+		intermetiateStorage->addSymbol(
+			StorageSymbol(addFunction(name), definitionKindToInt(DEFINITION_EXPLICIT)));
+	}
+
+	for (const std::pair<std::wstring, std::wstring>& call: calls)
+	{
+		addOccurrence(intermetiateStorage->addEdge(StorageEdgeData(
+			Edge::typeToInt(Edge::EDGE_CALL), addFunction(call.first), addFunction(call.second))));
+	}
+
+	return intermetiateStorage;
+}
+
+void injectFile(
+	PersistentStorage& storage,
+	const std::wstring& filePath,
+	const std::vector<std::wstring>& functionNames,
+	const std::vector<std::pair<std::wstring, std::wstring>>& calls)
+{
+	storage.inject(createFileStorage(filePath, functionNames, calls).get());
+}
+
+// Storages like the indexers produce them, one per file. Functions are picked from a shared pool,
+// so most of them are already stored when a storage gets injected.
+std::vector<std::shared_ptr<IntermediateStorage>> recordStorageStream(
+	size_t fileCount, size_t functionCount, size_t callCount, size_t functionPoolSize)
+{
+	std::vector<std::shared_ptr<IntermediateStorage>> storages;
+	uint32_t random = 42;
+	auto randomFunctionName = [&]() {
+		random = random * 1664525 + 1013904223;
+		return L"function" + std::to_wstring(random % functionPoolSize);
+	};
+
+	for (size_t i = 0; i < fileCount; i++)
+	{
+		std::vector<std::wstring> functionNames;
+		for (size_t j = 0; j < functionCount; j++)
+		{
+			functionNames.push_back(randomFunctionName());
+		}
+
+		std::vector<std::pair<std::wstring, std::wstring>> calls;
+		for (size_t j = 0; j < callCount; j++)
+		{
+			calls.emplace_back(functionNames[j % functionCount], randomFunctionName());
+		}
+
+		const std::wstring filePath = L"data/StorageTestSuite/file" + std::to_wstring(i) + L".cpp";
+		storages.push_back(createFileStorage(filePath, functionNames, calls));
+		if (i % 5 == 0)
+		{
+			storages.back()->addError(StorageErrorData(
+				L"error in file " + std::to_wstring(i % 3), filePath, false, true));
+		}
+	}
+	return storages;
+}
 }	 // namespace
 
 TEST_CASE("storage saves file")
@@ -146,6 +257,37 @@ TEST_CASE("storage saves method static")
 	// TS_ASSERT(node->getComponent<TokenComponentStatic>());
 }
 
+TEST_CASE("intermediate storage keeps one copy of equal elements")
+{
+	IntermediateStorage storage;
+
+	const StorageNodeData nodeData(nodeKindToInt(NODE_TYPE), L"A");
+	const Id nodeId = storage.addNode(nodeData).first;
+	REQUIRE(storage.addNode(StorageNodeData(nodeKindToInt(NODE_CLASS), L"A")) ==
+			std::make_pair(nodeId, false));
+	REQUIRE(storage.getStorageNodes().size() == 1);
+	REQUIRE(storage.getStorageNodes()[0].type == nodeKindToInt(NODE_CLASS));
+
+	const StorageSourceLocationData locationData(nodeId, 1, 1, 1, 5, 0);
+	const Id locationId = storage.addSourceLocation(locationData);
+	REQUIRE(storage.getStorageSourceLocations().size() == 1);
+	REQUIRE(storage.addSourceLocation(locationData) == locationId);
+
+	for (size_t i = 0; i < 5000; i++)
+	{
+		storage.addOccurrence(StorageOccurrence(i % 100, locationId));
+	}
+
+	const std::vector<StorageOccurrence>& occurrences = storage.getStorageOccurrences();
+	REQUIRE(occurrences.size() == 100);
+	REQUIRE(std::is_sorted(occurrences.begin(), occurrences.end()));
+
+	storage.addComponentAccess(StorageComponentAccess(nodeId, accessKindToInt(ACCESS_PUBLIC)));
+	storage.addComponentAccess(StorageComponentAccess(nodeId, accessKindToInt(ACCESS_PRIVATE)));
+	REQUIRE(storage.getComponentAccesses().size() == 1);
+	REQUIRE(storage.getComponentAccesses()[0].type == accessKindToInt(ACCESS_PUBLIC));
+}
+
 TEST_CASE("storage clears single file data of single file storage")
 {
 	/*
@@ -283,3 +425,305 @@ TEST_CASE("storage finds and removes depending file nodes")
 	// TS_ASSERT(!storage.getEdgeWithId(id4));
 	// TS_ASSERT(!storage.getEdgeWithId(id5));
 }
+
+TEST_CASE("storage finds trail through edges injected after building caches")
+{
+	NameHierarchy a = createNameHierarchy(L"a");
+	NameHierarchy b = createNameHierarchy(L"b");
+	NameHierarchy c = createNameHierarchy(L"c");
+	NameHierarchy d = createNameHierarchy(L"d");
+
+	TestStorage storage;
+
+	{
+		std::shared_ptr<IntermediateStorage> intermetiateStorage =
+			std::make_shared<IntermediateStorage>();
+		Id aId = intermetiateStorage
+					 ->addNode(StorageNodeData(
+						 nodeKindToInt(NODE_FUNCTION), NameHierarchy::serialize(a)))
+					 .first;
+		Id bId = intermetiateStorage
+					 ->addNode(StorageNodeData(
+						 nodeKindToInt(NODE_FUNCTION), NameHierarchy::serialize(b)))
+					 .first;
+		Id cId = intermetiateStorage
+					 ->addNode(StorageNodeData(
+						 nodeKindToInt(NODE_FUNCTION), NameHierarchy::serialize(c)))
+					 .first;
+		intermetiateStorage->addEdge(StorageEdgeData(Edge::typeToInt(Edge::EDGE_CALL), aId, bId));
+		intermetiateStorage->addEdge(StorageEdgeData(Edge::typeToInt(Edge::EDGE_CALL), bId, cId));
+		storage.inject(intermetiateStorage.get());
+	}
+
+	storage.buildCaches();
+
+	{
+		std::shared_ptr<IntermediateStorage> intermetiateStorage =
+			std::make_shared<IntermediateStorage>();
+		Id cId = intermetiateStorage
+					 ->addNode(StorageNodeData(
+						 nodeKindToInt(NODE_FUNCTION), NameHierarchy::serialize(c)))
+					 .first;
+		Id dId = intermetiateStorage
+					 ->addNode(StorageNodeData(
+						 nodeKindToInt(NODE_FUNCTION), NameHierarchy::serialize(d)))
+					 .first;
+		intermetiateStorage->addEdge(StorageEdgeData(Edge::typeToInt(Edge::EDGE_CALL), cId, dId));
+		storage.inject(intermetiateStorage.get());
+	}
+
+	const Id aId = storage.getNodeIdForNameHierarchy(a);
+	const Id dId = storage.getNodeIdForNameHierarchy(d);
+
+	std::shared_ptr<Graph> graph =
+		storage.getGraphForTrail(aId, 0, NODE_FUNCTION, Edge::EDGE_CALL, true, 0, true);
+	REQUIRE(graph->getNodeCount() == 4);
+	REQUIRE(graph->getNodeById(dId) != nullptr);
+
+	std::shared_ptr<Graph> shallowGraph =
+		storage.getGraphForTrail(aId, 0, NODE_FUNCTION, Edge::EDGE_CALL, true, 2, true);
+	REQUIRE(shallowGraph->getNodeCount() == 3);
+	REQUIRE(shallowGraph->getNodeById(dId) == nullptr);
+
+	storage.removeElement(dId);
+
+	std::shared_ptr<Graph> reducedGraph =
+		storage.getGraphForTrail(aId, 0, NODE_FUNCTION, Edge::EDGE_CALL, true, 0, true);
+	REQUIRE(reducedGraph->getNodeCount() == 3);
+}
+
+TEST_CASE("storage refreshed in place matches full re-index")
+{
+	const std::wstring fileA = L"data/StorageTestSuite/a.cpp";
+	const std::wstring fileB = L"data/StorageTestSuite/b.cpp";
+
+	TestStorage storage;
+	injectFile(storage, fileA, {L"a"}, {{L"a", L"b"}});
+	injectFile(storage, fileB, {L"b", L"old"}, {{L"old", L"b"}});
+	storage.buildCaches();
+
+	storage.startIncrementalRefresh();
+	storage.clearFileElements({FilePath(fileA), FilePath(fileB)}, [](int) {});
+	injectFile(storage, fileA, {L"a"}, {{L"a", L"b"}});
+	injectFile(storage, fileB, {L"b", L"c"}, {{L"b", L"c"}});
+
+	storage.finishIncrementalRefresh();
+
+	TestStorage indexedStorage(FilePath(L"data/test_full.sqlite"));
+	injectFile(indexedStorage, fileA, {L"a"}, {{L"a", L"b"}});
+	injectFile(indexedStorage, fileB, {L"b", L"c"}, {{L"b", L"c"}});
+	indexedStorage.buildCaches();
+
+	auto requireRefreshedState = [&](const PersistentStorage& s) {
+		REQUIRE(s.getNodeIdForNameHierarchy(createNameHierarchy(L"old")) == 0);
+		REQUIRE(s.getAutocompletionMatches(L"old", NodeTypeSet::all(), false).empty());
+		REQUIRE(
+			s.getAutocompletionMatches(L"c", NodeTypeSet::all(), false).size() ==
+			indexedStorage.getAutocompletionMatches(L"c", NodeTypeSet::all(), false).size());
+		REQUIRE(s.getNodeIdForFileNode(FilePath(fileB)) != 0);
+
+		const Id aId = s.getNodeIdForNameHierarchy(createNameHierarchy(L"a"));
+		const Id cId = s.getNodeIdForNameHierarchy(createNameHierarchy(L"c"));
+		REQUIRE(cId != 0);
+
+		std::shared_ptr<Graph> graph =
+			s.getGraphForTrail(aId, 0, NODE_FUNCTION, Edge::EDGE_CALL, true, 0, true);
+		REQUIRE(graph->getNodeCount() == 3);
+		REQUIRE(graph->getNodeById(cId) != nullptr);
+	};
+
+	requireRefreshedState(indexedStorage);
+	requireRefreshedState(storage);
+
+	FileSystem::remove(FilePath(L"data/test_full.sqlite"));
+}
+
+TEST_CASE("storage passes fulltext search results in batches of files ordered by path")
+{
+	const FilePath directoryPath(L"data/StorageTestSuite/fulltext");
+	FileSystem::createDirectory(directoryPath);
+
+	const size_t fileCount = 40;
+	TestStorage storage;
+	for (size_t i = 0; i < fileCount; i++)
+	{
+		const FilePath filePath = directoryPath.getConcatenated(
+			L"file" + std::wstring(i < 10 ? L"0" : L"") + std::to_wstring(i) + L".cpp");
+		std::ofstream file;
+		file.open(filePath.str());
+		file << "int value" << i << " = 0;\nint other;\n";
+		file.close();
+
+		injectFile(storage, filePath.wstr(), {L"value" + std::to_wstring(i)}, {});
+	}
+	storage.buildCaches();
+
+	std::vector<std::shared_ptr<SourceLocationCollection>> batches;
+	auto collectBatch = [&batches](std::shared_ptr<SourceLocationCollection> batch) {
+		batches.push_back(batch);
+		return true;
+	};
+	auto getResultFilePaths = [&batches]() {
+		std::vector<FilePath> filePaths;
+		for (const std::shared_ptr<SourceLocationCollection>& batch: batches)
+		{
+			batch->forEachSourceLocationFile(
+				[&filePaths](std::shared_ptr<SourceLocationFile> file) {
+					filePaths.push_back(file->getFilePath());
+				});
+		}
+		return filePaths;
+	};
+	auto getResultCount = [&batches]() {
+		size_t resultCount = 0;
+		for (const std::shared_ptr<SourceLocationCollection>& batch: batches)
+		{
+			resultCount += batch->getSourceLocationCount();
+		}
+		return resultCount;
+	};
+
+	SECTION("all results without limit")
+	{
+		REQUIRE(storage.searchFullTextLocations(L"int", false, 0, collectBatch));
+		REQUIRE(getResultCount() == 2 * fileCount);
+
+		const std::vector<FilePath> filePaths = getResultFilePaths();
+		REQUIRE(filePaths.size() == fileCount);
+		REQUIRE(std::is_sorted(filePaths.begin(), filePaths.end()));
+	}
+
+	SECTION("regex results without limit")
+	{
+		REQUIRE(storage.searchFullTextLocations(L"/value[0-9]+/", false, 0, collectBatch));
+		REQUIRE(getResultCount() == fileCount);
+		REQUIRE(getResultFilePaths().size() == fileCount);
+	}
+
+	SECTION("results up to limit")
+	{
+		REQUIRE(storage.searchFullTextLocations(L"int", false, 5, collectBatch));
+		REQUIRE(getResultCount() == 5);
+
+		const std::vector<FilePath> filePaths = getResultFilePaths();
+		REQUIRE(filePaths.size() == 3);
+		REQUIRE(filePaths.front().fileName() == L"file00.cpp");
+	}
+
+	SECTION("no results after cancelling")
+	{
+		REQUIRE_FALSE(storage.searchFullTextLocations(
+			L"int", false, 0, [&batches](std::shared_ptr<SourceLocationCollection> batch) {
+				batches.push_back(batch);
+				return false;
+			}));
+		REQUIRE(batches.size() == 1);
+	}
+
+	for (const FilePath& path: FileSystem::getFilePathsFromDirectory(directoryPath))
+	{
+		FileSystem::remove(path);
+	}
+	FileSystem::remove(directoryPath);
+}
+
+TEST_CASE("storage injection benchmark for recorded storages", "[.][benchmark]")
+{
+	const FilePath databasePath(L"data/StorageTestSuite/benchmark.sqlite");
+	const std::vector<std::shared_ptr<IntermediateStorage>> storages = recordStorageStream(
+		500, 40, 80, 10000);
+
+	BENCHMARK("serial injection")
+	{
+		TestStorage storage(databasePath);
+		storage.beginBulkLoad();
+		for (const std::shared_ptr<IntermediateStorage>& intermediateStorage: storages)
+		{
+			storage.inject(intermediateStorage.get());
+		}
+	}
+	FileSystem::remove(databasePath);
+}
+
+TEST_CASE("adjacency index benchmark for trail depths", "[.][benchmark]")
+{
+	const FilePath databasePath(L"data/SQLiteTestSuite/benchmark.sqlite");
+	const size_t nodeCount = 50000;
+	const size_t edgesPerNode = 4;
+
+	{
+		SqliteIndexStorage storage(databasePath);
+		storage.setup();
+		storage.beginTransaction();
+
+		std::vector<StorageNode> nodes;
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			nodes.emplace_back(0, nodeKindToInt(NODE_FUNCTION), L"node" + std::to_wstring(i));
+		}
+		const std::vector<Id> nodeIds = storage.addNodes(nodes);
+
+		std::vector<StorageEdge> edges;
+		uint32_t random = 42;
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			for (size_t j = 0; j < edgesPerNode; j++)
+			{
+				random = random * 1664525 + 1013904223;
+				edges.emplace_back(
+					0, Edge::typeToInt(Edge::EDGE_CALL), nodeIds[i], nodeIds[random % nodeCount]);
+			}
+		}
+		storage.addEdges(edges);
+		storage.commitTransaction();
+		storage.setMode(SqliteIndexStorage::STORAGE_MODE_READ);
+
+		AdjacencyIndex adjacencyIndex;
+		adjacencyIndex.build(storage.getAll<StorageEdge>());
+
+		// walks the call graph breadth first, one query per depth level like the trail search does
+		auto walk = [&nodeIds](
+						size_t depth,
+						std::function<std::vector<StorageEdge>(const std::vector<Id>&)> getEdges) {
+			std::set<Id> visitedIds = {nodeIds[0]};
+			std::vector<Id> idsToProcess = {nodeIds[0]};
+			for (size_t i = 0; idsToProcess.size() && (!depth || i < depth); i++)
+			{
+				std::vector<Id> nextIds;
+				for (const StorageEdge& edge: getEdges(idsToProcess))
+				{
+					if (visitedIds.insert(edge.targetNodeId).second)
+					{
+						nextIds.push_back(edge.targetNodeId);
+					}
+				}
+				idsToProcess = nextIds;
+			}
+			return visitedIds.size();
+		};
+
+		for (size_t depth: {1, 2, 3, 4, 5, 6, 0})
+		{
+			const std::string depthName = depth ? std::to_string(depth) : "infinite";
+
+			size_t databaseNodeCount = 0;
+			BENCHMARK("database trail depth " + depthName)
+			{
+				databaseNodeCount = walk(depth, [&storage](const std::vector<Id>& ids) {
+					return storage.getEdgesBySourceIds(ids);
+				});
+			}
+
+			size_t indexNodeCount = 0;
+			BENCHMARK("adjacency index trail depth " + depthName)
+			{
+				indexNodeCount = walk(depth, [&adjacencyIndex](const std::vector<Id>& ids) {
+					return adjacencyIndex.getEdgesBySourceIds(ids);
+				});
+			}
+
+			REQUIRE(databaseNodeCount == indexNodeCount);
+		}
+	}
+	FileSystem::remove(databasePath);
+}
@@ -1,6 +1,7 @@
 #include "catch.hpp"
 
 #include "utility.h"
+#include "utilityCompression.h"
 
 TEST_CASE("trim blank spaces of string")
 {
@@ -11,3 +12,28 @@ TEST_CASE("trim blank spaces of wstring")
 {
 	REQUIRE(utility::trim(L" foo  ") == L"foo");
 }
+
+TEST_CASE("compressed text is decompressed to original text")
+{
+	std::string text;
+	for (int i = 0; i < 1000; i++)
+	{
+		text += "line " + std::to_string(i % 17) + std::string(i % 40, ' ') + "\n";
+	}
+
+	const std::string compressed = utility::compress(text);
+	std::string decompressed;
+
+	REQUIRE(compressed.size() < text.size() / 2);
+	REQUIRE(utility::decompress(compressed, &decompressed));
+	REQUIRE(decompressed == text);
+}
+
+TEST_CASE("truncated compressed text is not decompressed")
+{
+	const std::string compressed = utility::compress(std::string(100, 'a') + "b");
+	std::string decompressed;
+
+	REQUIRE(!utility::decompress(compressed.substr(0, compressed.size() - 1), &decompressed));
+	REQUIRE(decompressed.empty());
+}